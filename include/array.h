@@ -32,7 +32,10 @@
 #include <iostream>
 #include <fstream>
 #include <typeinfo>
+#include <new>
 #include "error.h"
+#include "mem_tracker.h"
+#include "mem_pool.h"
 
 #ifdef _GPU
 #include "cuda.h"
@@ -63,6 +66,21 @@ public:
 
   array<T>& operator=(const array<T>& in_array);
 
+#if __cplusplus >= 201103L
+  // move constructor (takes over the storage; in_array is left empty). Compiled out before
+  // C++11, where by-value returns are copied unless elided; hot call sites use swap instead
+
+  array(array<T>&& in_array);
+
+  // move assignment
+
+  array<T>& operator=(array<T>&& in_array);
+#endif
+
+  // exchange storage with in_array without copying (also without C++11, e.g. the gnu++98 MPI build)
+
+  void swap(array<T>& in_array);
+
   // destructor
 
   ~array();
@@ -146,8 +164,16 @@ public:
   /*! Initialize array to given value */
   void initialize_to_value(const T val);
 
+  /*! Name the array for memory accounting; its current and future allocations are charged to this tag */
+  void set_tag(const char* in_name);
+
 protected:
 
+  // allocate/free cpu storage, with memory accounting
+
+  void alloc_cpu(int in_size);
+  void free_cpu(void);
+
   int dim_0;
   int dim_1;
   int dim_2;
@@ -159,6 +185,9 @@ protected:
   int cpu_flag;
   int gpu_flag;
 
+  int mem_tag;
+  size_t mem_bytes;
+
 };
 
 // definitions
@@ -179,10 +208,12 @@ array<T>::array()
   dim_2=1;
   dim_3=1;
 
-  cpu_data = new T[dim_0*dim_1*dim_2*dim_3];
+  mem_tag=0;
+  alloc_cpu(dim_0*dim_1*dim_2*dim_3);
 
   cpu_flag=1;
   gpu_flag=0;
+  gpu_data=NULL;
 }
 
 // constructor 1
@@ -195,11 +226,13 @@ array<T>::array(int in_dim_0, int in_dim_1, int in_dim_2, int in_dim_3)
   dim_2=in_dim_2;
   dim_3=in_dim_3;
 
-  cpu_data = new T[dim_0*dim_1*dim_2*dim_3];
+  mem_tag=0;
+  alloc_cpu(dim_0*dim_1*dim_2*dim_3);
 
 
   cpu_flag=1;
   gpu_flag=0;
+  gpu_data=NULL;
 }
 
 // copy constructor
@@ -214,12 +247,17 @@ array<T>::array(const array<T>& in_array)
   dim_2=in_array.dim_2;
   dim_3=in_array.dim_3;
 
-  cpu_data = new T[dim_0*dim_1*dim_2*dim_3];
+  mem_tag=0;
+  alloc_cpu(dim_0*dim_1*dim_2*dim_3);
 
   for(i=0; i<dim_0*dim_1*dim_2*dim_3; i++)
     {
       cpu_data[i]=in_array.cpu_data[i];
     }
+
+  cpu_flag=1;
+  gpu_flag=0;
+  gpu_data=NULL;
 }
 
 // assignment
@@ -235,14 +273,14 @@ array<T>& array<T>::operator=(const array<T>& in_array)
     }
   else
     {
-      delete[] cpu_data;
+      free_cpu();
 
       dim_0=in_array.dim_0;
       dim_1=in_array.dim_1;
       dim_2=in_array.dim_2;
       dim_3=in_array.dim_3;
 
-      cpu_data = new T[dim_0*dim_1*dim_2*dim_3];
+      alloc_cpu(dim_0*dim_1*dim_2*dim_3);
       //NOTE: THIS COPIES POINTERS; NOT VALUES
       for(i=0; i<dim_0*dim_1*dim_2*dim_3; i++)
         {
@@ -256,32 +294,162 @@ array<T>& array<T>::operator=(const array<T>& in_array)
     }
 }
 
+#if __cplusplus >= 201103L
+
+// move constructor
+
+template <typename T>
+array<T>::array(array<T>&& in_array)
+{
+  mem_tag=0;
+  mem_bytes=0;
+  cpu_data=NULL;
+
+  *this = static_cast<array<T>&&>(in_array);
+}
+
+// move assignment
+
+template <typename T>
+array<T>& array<T>::operator=(array<T>&& in_array)
+{
+  if(this == &in_array)
+    return (*this);
+
+  free_cpu();
+
+  dim_0=in_array.dim_0;
+  dim_1=in_array.dim_1;
+  dim_2=in_array.dim_2;
+  dim_3=in_array.dim_3;
+
+  cpu_data=in_array.cpu_data;
+  gpu_data=in_array.gpu_data;
+  cpu_flag=in_array.cpu_flag;
+  gpu_flag=in_array.gpu_flag;
+
+  // the storage is now charged to this array's tag
+  mem_bytes=in_array.mem_bytes;
+  mem_track_free(in_array.mem_tag, mem_bytes);
+  mem_track_alloc(mem_tag, mem_bytes);
+
+  // leave in_array empty (zero elements) but valid for setup, assignment and destruction
+  in_array.dim_0=0;
+  in_array.dim_1=1;
+  in_array.dim_2=1;
+  in_array.dim_3=1;
+  in_array.cpu_data=NULL;
+  in_array.mem_bytes=0;
+  in_array.cpu_flag=1;
+  in_array.gpu_flag=0;
+
+  return (*this);
+}
+
+#endif
+
+// swap
+
+template <typename T>
+void array<T>::swap(array<T>& in_array)
+{
+  int itmp;
+  T* ptmp;
+  size_t btmp;
+
+  if(this == &in_array)
+    return;
+
+  // each tag stays charged with the storage its array holds
+  mem_track_free(mem_tag, mem_bytes);
+  mem_track_free(in_array.mem_tag, in_array.mem_bytes);
+
+  itmp=dim_0; dim_0=in_array.dim_0; in_array.dim_0=itmp;
+  itmp=dim_1; dim_1=in_array.dim_1; in_array.dim_1=itmp;
+  itmp=dim_2; dim_2=in_array.dim_2; in_array.dim_2=itmp;
+  itmp=dim_3; dim_3=in_array.dim_3; in_array.dim_3=itmp;
+
+  ptmp=cpu_data; cpu_data=in_array.cpu_data; in_array.cpu_data=ptmp;
+  ptmp=gpu_data; gpu_data=in_array.gpu_data; in_array.gpu_data=ptmp;
+
+  itmp=cpu_flag; cpu_flag=in_array.cpu_flag; in_array.cpu_flag=itmp;
+  itmp=gpu_flag; gpu_flag=in_array.gpu_flag; in_array.gpu_flag=itmp;
+
+  btmp=mem_bytes; mem_bytes=in_array.mem_bytes; in_array.mem_bytes=btmp;
+
+  mem_track_alloc(mem_tag, mem_bytes);
+  mem_track_alloc(in_array.mem_tag, in_array.mem_bytes);
+}
+
 // destructor
 
 template <typename T>
 array<T>::~array()
 {
-  delete[] cpu_data;
+  free_cpu();
   // do we need to deallocate gpu memory here as well?
 }
 
 // #### methods ####
 
+// allocate aligned cpu storage from the memory pool and charge it to the array's memory tag
+
+template <typename T>
+void array<T>::alloc_cpu(int in_size)
+{
+  mem_bytes = in_size*sizeof(T);
+  cpu_data = (T*) mem_pool_alloc(mem_bytes);
+
+  // default-initialize, as new T[] would (a no-op for numeric types)
+  for(int i=0; i<in_size; i++)
+    new (cpu_data+i) T;
+
+  mem_track_alloc(mem_tag, mem_bytes);
+}
+
+// free cpu storage and release it from the array's memory tag
+
+template <typename T>
+void array<T>::free_cpu(void)
+{
+  int n = mem_bytes/sizeof(T);
+
+  for(int i=0; i<n; i++)
+    cpu_data[i].~T();
+
+  mem_pool_free(cpu_data, mem_bytes);
+  mem_track_free(mem_tag, mem_bytes);
+  mem_bytes = 0;
+}
+
+// name the array for memory accounting
+
+template <typename T>
+void array<T>::set_tag(const char* in_name)
+{
+  int new_tag = mem_tag_id(in_name);
+
+  mem_track_free(mem_tag, mem_bytes);
+  mem_track_alloc(new_tag, mem_bytes);
+  mem_tag = new_tag;
+}
+
 // setup
 
 template <typename T>
 void array<T>::setup(int in_dim_0, int in_dim_1, int in_dim_2, int in_dim_3)
 {
-  delete[] cpu_data;
+  free_cpu();
 
   dim_0=in_dim_0;
   dim_1=in_dim_1;
   dim_2=in_dim_2;
   dim_3=in_dim_3;
 
-  cpu_data=new T[dim_0*dim_1*dim_2*dim_3];
+  alloc_cpu(dim_0*dim_1*dim_2*dim_3);
   cpu_flag=1;
   gpu_flag=0;
+  gpu_data=NULL;
 }
 
 template <typename T>
@@ -488,8 +656,8 @@ void array<T>::mv_cpu_gpu(void)
   cudaMalloc((void**) &gpu_data,dim_0*dim_1*dim_2*dim_3*sizeof(T));
   cudaMemcpy(gpu_data,cpu_data,dim_0*dim_1*dim_2*dim_3*sizeof(T),cudaMemcpyHostToDevice);
 
-  delete[] cpu_data;
-  cpu_data = new T[1];
+  free_cpu();
+  alloc_cpu(1);
 
   cpu_flag=0;
   gpu_flag=1;
@@ -507,8 +675,8 @@ void array<T>::mv_gpu_cpu(void)
 #ifdef _GPU
 
   check_cuda_error("mv_gpu_cpu before",__FILE__, __LINE__);
-  delete[] cpu_data;
-  cpu_data = new T[dim_0*dim_1*dim_2*dim_3];
+  free_cpu();
+  alloc_cpu(dim_0*dim_1*dim_2*dim_3);
 
   cudaMemcpy(cpu_data,gpu_data,dim_0*dim_1*dim_2*dim_3*sizeof(T),cudaMemcpyDeviceToHost);
   cudaFree(gpu_data);
@@ -536,7 +704,8 @@ void array<T>::cp_gpu_cpu(void)
 
   if (cpu_flag==0)
     {
-      cpu_data = new T[dim_0*dim_1*dim_2*dim_3];
+      free_cpu();
+      alloc_cpu(dim_0*dim_1*dim_2*dim_3);
       cpu_flag=1;
     }
 
@@ -578,8 +747,8 @@ void array<T>::rm_cpu(void)
 #ifdef _GPU
 
   check_cuda_error("rm_cpu before",__FILE__, __LINE__);
-  delete[] cpu_data;
-  cpu_data = new T[1];
+  free_cpu();
+  alloc_cpu(1);
 
   cpu_flag=0;
   check_cuda_error("rm_cpu after",__FILE__, __LINE__);
@@ -608,3 +777,52 @@ void array<T>::initialize_to_value(const T val)
     cpu_data[i]=val;
   }
 }
+
+/*!
+ * Non-owning, strided, one-dimensional view of array<T> storage. It is passed by value in
+ * place of small arrays (e.g. the location of a point in the reference element), so that
+ * callers can hand over an existing array, or a column/row of a larger one, without copying.
+ */
+template <typename T>
+class array_view
+{
+public:
+
+  // view of a whole array, as one contiguous vector
+
+  array_view(array<T>& in_array)
+  {
+    data=in_array.get_ptr_cpu();
+    dim_0=in_array.get_dim(0)*in_array.get_dim(1)*in_array.get_dim(2)*in_array.get_dim(3);
+    stride=1;
+  }
+
+  // view of in_dim_0 entries starting at in_data, in_stride apart
+
+  array_view(T* in_data, int in_dim_0, int in_stride=1)
+  {
+    data=in_data;
+    dim_0=in_dim_0;
+    stride=in_stride;
+  }
+
+  // access/set
+
+  T& operator() (int in_pos_0) const
+  {
+    return data[in_pos_0*stride];
+  }
+
+  // return dimension (1 for dimensions other than 0, as for a 1d array)
+
+  int get_dim(int in_dim) const
+  {
+    return (in_dim==0) ? dim_0 : 1;
+  }
+
+protected:
+
+  T* data;
+  int dim_0;
+  int stride;
+};
@@ -75,6 +75,9 @@ public:
   /*! calculate normal transformed continuous viscous flux at the flux points on boundaries*/
   void evaluate_boundaryConditions_viscFlux(double time_bound);
 
+  /*! give each face the multi-rate level of its element */
+  void set_lts_levels(struct solution* FlowSol);
+
 protected:
 
   // #### members ####
@@ -0,0 +1,77 @@
+/*!
+ * \file checkpoint.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <csignal>
+
+/*!
+ * Wall-clock and signal triggered checkpoints, in addition to the restart files of restart_dump_freq. A restart
+ * file is written every checkpoint_interval minutes of wall time, and a last one when the time left before
+ * wall_time_limit falls below wall_time_margin plus the longest step seen so far, after which the run stops.
+ * With checkpoint_signals, SIGUSR1 requests a checkpoint and SIGTERM a checkpoint and a stop; the handlers only
+ * set a flag, which is acted upon at the next step boundary. The requests of all ranks are combined by one
+ * single-integer reduction per step, so that every rank writes (and stops) at the same step.
+ */
+class checkpoint
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  checkpoint();
+
+  // default destructor
+
+  ~checkpoint();
+
+  // #### methods ####
+
+  /*! install the signal handlers, the run started at wall time in_t_run */
+  void setup(double in_t_run);
+
+  /*! at the end of a step (in_dumped: a restart file was written by restart_dump_freq), agree on the action of all ranks: 0 none, 1 checkpoint, 2 checkpoint and stop */
+  int poll(bool in_dumped);
+
+  /*! get whether checkpoints on wall time or on signals are enabled */
+  bool get_active(void);
+
+protected:
+
+  // #### members ####
+
+  bool active;
+
+  /*! wall time of the start of the run, of the last restart file and of the last step boundary */
+  double t_run;
+  double t_last;
+  double t_step;
+
+  /*! longest step (including the files written at its end) */
+  double max_step;
+
+};
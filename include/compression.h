@@ -0,0 +1,48 @@
+/*!
+ * \file compression.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/*!
+ * Compression of the restart and Paraview data (requires zlib, -D_ZLIB). The data is
+ * treated as items of a fixed size; before a restart block is compressed its bytes are
+ * shuffled (all first bytes of the items, then all second bytes, ...), which puts the
+ * slowly varying sign and exponent bytes of neighbouring values next to each other.
+ */
+
+/*! write in_n_bytes of data made of items of in_item_size bytes as a compressed block:
+ a text line with the raw and compressed sizes, then the compressed bytes */
+void write_compressed_block(ostream& out_file, const char* in_data, long in_n_bytes, int in_item_size);
+
+/*! read a block written by write_compressed_block into out_data, which holds in_n_bytes */
+void read_compressed_block(istream& in_file, char* out_data, long in_n_bytes, int in_item_size);
+
+/*! write in_n_bytes of data as the base64 body of a binary VTK DataArray compressed with vtkZLibDataCompressor */
+void write_vtu_binary(ostream& out_file, const char* in_data, long in_n_bytes);
@@ -0,0 +1,83 @@
+/*!
+ * \file dual_time.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "array.h"
+#include "solution.h"
+#include "multigrid.h"
+
+struct solution; // forwards declaration
+
+/*!
+ * Dual time stepping for unsteady problems (dual_time 1). Each physical step of size dt solves
+ * du/dt = R(u) with the BDF2 formula (BDF1 on the first step), by marching the unsteady residual
+ * R(u) - (3u - 4u^n + u^(n-1))/(2 dt) to zero in pseudo time with the explicit RK scheme and local
+ * time stepping, optionally accelerated by p-multigrid. The pseudo time iterations stop when the
+ * unsteady residual has dropped by dual_inner_tol, or after dual_max_inner iterations.
+ */
+class dual_time
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  dual_time();
+
+  // default destructor
+
+  ~dual_time();
+
+  // #### methods ####
+
+  /*! allocate the solution history; in_mg may be NULL */
+  void setup(struct solution* FlowSol, p_multigrid* in_mg);
+
+  /*! perform one physical time step; leaves the unsteady residual of the last RK stage in div_tconf_upts */
+  void advance(struct solution* FlowSol);
+
+protected:
+
+  /*! one pseudo time iteration */
+  void iterate(struct solution* FlowSol);
+
+  /*! global L2 norm of the unsteady residual held in div_tconf_upts */
+  double calc_res_norm(struct solution* FlowSol);
+
+  // #### members ####
+
+  int n_ele_types;
+  int n_rk_steps;
+  int n_steps;
+
+  /*! p-multigrid levels used for the pseudo time iterations, or NULL */
+  p_multigrid* mg;
+
+  /*! solution at the last two physical time levels, (n_upts_per_ele, n_eles, n_fields) per element type */
+  array< array<double> > u_n, u_nm1;
+
+};
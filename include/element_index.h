@@ -0,0 +1,108 @@
+/*!
+ * \file element_index.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "array.h"
+#include "solution.h"
+
+struct solution; // forwards declaration
+
+/*!
+ * Bounding volume hierarchy over the elements of all types, from the bounding boxes of their plot points. Each
+ * node splits its elements at the median of the box centres along the longest axis of its own box. Used to find
+ * the elements crossed by the slices of the extracts and the elements holding the probes.
+ */
+class element_index
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  element_index();
+
+  // default destructor
+
+  ~element_index();
+
+  // #### methods ####
+
+  /*! index the elements of FlowSol */
+  void setup(struct solution* FlowSol);
+
+  /*! number of indexed elements (items) */
+  int get_n_items(void);
+
+  /*! element type of an item */
+  int get_type(int in_item);
+
+  /*! element of an item, within its type */
+  int get_ele(int in_item);
+
+  /*! write the items whose bounding box is crossed by the plane in_norm.x = in_dist to out_items (sized get_n_items) */
+  void query_plane(double* in_norm, double in_dist, array<int>& out_items, int& out_n_items);
+
+  /*! write the items whose bounding box, grown by in_tol times its size, contains in_pos to out_items (sized get_n_items) */
+  void query_point(double* in_pos, double in_tol, array<int>& out_items, int& out_n_items);
+
+protected:
+
+  /*! build the node over items in_first to in_first+in_n-1 of item_order, returns its index */
+  int build(int in_first, int in_n);
+
+  /*! plane query below in_node */
+  void query_plane_node(int in_node, double* in_norm, double in_dist, array<int>& out_items, int& io_n_items);
+
+  /*! point query below in_node */
+  void query_point_node(int in_node, double* in_pos, double in_tol, array<int>& out_items, int& io_n_items);
+
+  // #### members ####
+
+  int n_dims;
+
+  /*! element type and index of each item */
+  int n_items;
+  array<int> item_type;
+  array<int> item_ele;
+
+  /*! bounding box of each item (n_dims x n_items) */
+  array<double> item_lo;
+  array<double> item_hi;
+
+  /*! items ordered so that the items below each node are contiguous */
+  array<int> item_order;
+
+  /*! nodes: bounding box, children (-1 for leaves) and range of item_order */
+  int n_nodes;
+  array<double> node_lo;
+  array<double> node_hi;
+  array<int> node_left;
+  array<int> node_right;
+  array<int> node_first;
+  array<int> node_count;
+
+};
@@ -27,6 +27,7 @@
 
 #include "array.h"
 #include "input.h"
+#include "lsrk.h"
 
 #if defined _GPU
 #include "cuda_runtime_api.h"
@@ -56,10 +57,10 @@ public:
   void set_ics(double& time);
 
   /*! read data from restart file */
-  void read_restart_data(ifstream& restart_file);
+  void read_restart_data(istream& restart_file);
 
   /*! write data to restart file */
-  void write_restart_data(ofstream& restart_file);
+  void write_restart_data(ostream& restart_file);
 
 	/*! move all to from cpu to gpu */
 	void mv_all_cpu_gpu(void);
@@ -132,12 +133,69 @@ public:
   /*! calculate divergence of transformed continuous viscous flux at solution points */
   //void calc_div_tconvisf_upts(int in_div_tconinvf_upts_to);
   
-  /*! advance solution using a runge-kutta scheme */
-  void AdvanceSolution(int in_step, int adv_type);
+  /*! advance solution using a runge-kutta scheme; with res_norm_fused, in_acc_res marks a monitored step whose residual norms are accumulated */
+  void AdvanceSolution(int in_step, int adv_type, int in_acc_res=0);
 
   /*! Calculate element local timestep */
   double calc_dt_local(int in_ele);
 
+  /*! compute the element time steps of dt_type 2 into dt_local, and return the smallest element time step */
+  double calc_dt(void);
+
+  /*! set the global time step of dt_type 1 */
+  void set_dt_global(double in_dt);
+
+  /*! largest embedded error of the last RK step over the solution points, scaled by rk_tol*max(1,|u|) */
+  double calc_rk_error(void);
+
+  /*! restore the solution from before the last RK step */
+  void restore_rk_solution(void);
+
+  /*! time derivative of the solution, -div(F)/|J| + source, at the solution points (same layout as disu_upts) */
+  void calc_rhs_upts(double* out_rhs);
+
+  /*! get CPU pointer to the current solution at the solution points */
+  double* get_disu_upts_ptr_cpu(void);
+
+  /*! add a forcing term (same layout as disu_upts) to the time derivative held in div_tconf_upts */
+  void add_forcing_upts(double* in_forcing);
+
+  /*! set the coefficient of the implicit physical time derivative of dual time stepping */
+  void set_dual_time_coeff(double in_coeff);
+
+  /*! get CPU pointer to the explicit part of the physical time derivative of dual time stepping */
+  double* get_dual_src_upts_ptr_cpu(void);
+
+  /*! add the physical time derivative of dual time stepping, dual_src_upts - dual_coeff*disu_upts, to the time derivative */
+  void add_dual_time_source(void);
+
+  /*! set the multi-rate time stepping level of an element (elements must be numbered by non-decreasing level) */
+  void set_lts_level(int in_ele, int in_level);
+
+  /*! get the multi-rate time stepping level of an element */
+  int get_lts_level(int in_ele);
+
+  /*! set the level of the element on the other side of a face of an element */
+  void set_lts_nb_level(int in_ele, int in_local_inter, int in_level);
+
+  /*! count the elements of each level and allocate the flux registers of the faces with a finer neighbour */
+  void setup_lts(int in_n_levels);
+
+  /*! restrict the residual and update to the elements of level in_max_level and below, -1 for all elements */
+  void set_lts_active(int in_max_level);
+
+  /*! set the element time steps to in_dt_base*2^level */
+  void set_lts_dt(double in_dt_base);
+
+  /*! set the highest active level, base time step and effective RK weight of the current stage, for the flux registers */
+  void set_lts_stage(int in_max_level, double in_dt_base, double in_weight);
+
+  /*! add the common fluxes of the current stage to the flux registers */
+  void accumulate_lts_flux_reg(void);
+
+  /*! correct the elements of level in_max_level and below with their flux registers, and clear them */
+  void apply_lts_flux_reg(int in_max_level);
+
   /*! get number of elements */
   int get_n_eles(void);
 
@@ -180,6 +238,15 @@ public:
   /*!  set global element number */
   void set_ele2global_ele(int in_ele, int in_global_ele);
 
+  /*! set color of element (no two elements of the same color share a residual stencil) */
+  void set_ele_color(int in_ele, int in_color);
+
+  /*! get color of element */
+  int get_ele_color(int in_ele);
+
+  /*! get global cell number of element */
+  int get_ele2global_ele(int in_ele);
+
   /*! get a pointer to the transformed discontinuous solution at a flux point */
   double* get_disu_fpts_ptr(int in_inter_local_fpt, int in_ele_local_inter, int in_field, int in_ele);
   
@@ -208,7 +275,7 @@ public:
   double* get_grad_disu_fpts_ptr(int in_inter_local_fpt, int in_ele_local_inter, int in_dim, int in_field, int in_ele);
 
   /*! get a pointer to gradient of discontinuous solution at a flux point */
-  double* get_normal_disu_fpts_ptr(int in_inter_local_fpt, int in_ele_local_inter, int in_field, int in_ele, array<double> temp_loc, double temp_pos[3]);
+  double* get_normal_disu_fpts_ptr(int in_inter_local_fpt, int in_ele_local_inter, int in_field, int in_ele, array<double>& temp_loc, double temp_pos[3]);
   
   /*! get a pointer to the normal transformed continuous viscous flux at a flux point */
   //double* get_norm_tconvisf_fpts_ptr(int in_inter_local_fpt, int in_ele_local_inter, int in_field, int in_ele);
@@ -249,6 +316,24 @@ public:
   /*! set opp_r */
   void set_opp_r(void);
 
+  /*! polynomial degree out_degree(m) of each of the in_n_modes modes of the modal basis of order in_order */
+  void calc_modal_degree(int in_order, int in_n_modes, array<int>& out_degree);
+
+  /*! modal basis of order in_order (in_n_modes modes) at the points in_loc: out_vandermonde(i,m) is mode m at point i, out_degree(m) its polynomial degree */
+  void calc_modal_vandermonde(array<double>& in_loc, int in_order, int in_n_modes, array<double>& out_vandermonde, array<int>& out_degree);
+
+  /*! modal basis at the solution points and its inverse (tris and tets return their Dubiner vandermonde matrices) */
+  virtual void get_modal_vandermonde(array<double>& out_vandermonde, array<double>& out_inv_vandermonde);
+
+  /*! set the modal transform of the lossy restart compression (restart_compression 2) */
+  void set_modal_quantization(void);
+
+  /*! write the restart data of in_disu as compressed blocks */
+  void write_compressed_restart_data(ostream& restart_file, array<double>& in_disu);
+
+  /*! set an operator like opp_r, from the solution points of in_donor (same element type, any order) to the solution points */
+  void set_opp_mg(eles* in_donor, array<double>& out_opp_mg);
+
   /*! calculate position of the plot points */
   void calc_pos_ppts(int in_ele, array<double>& out_pos_ppts);
 
@@ -263,10 +348,31 @@ public:
   /*! calculate solution at the plot points */
   void calc_disu_ppts(int in_ele, array<double>& out_disu_ppts);
 
+  /*! calculate solution at the plot points of elements in_ele to in_ele+in_n_eles-1 (out: n_ppts_per_ele x in_n_eles x n_fields) */
+  void calc_disu_ppts(int in_ele, int in_n_eles, array<double>& out_disu_ppts);
+
   /*! calculate gradient of solution at the plot points */
   void calc_grad_disu_ppts(int in_ele, array<double>& out_grad_disu_ppts);
 
-  /*! calculate diagnostic fields at the plot points */
+  /*! calculate gradient of solution at the plot points of a block of elements (out: n_ppts_per_ele x in_n_eles x n_fields x n_dims) */
+  void calc_grad_disu_ppts(int in_ele, int in_n_eles, array<double>& out_grad_disu_ppts);
+
+  /*! get the plot point positions of all elements (n_ppts_per_ele x n_eles x n_dims), computed at the first call */
+  array<double>& get_pos_ppts(void);
+
+  /*! solution at in_n_pts points of element in_ele from their basis weights at the solution points (in_weights, n_upts x in_n_pts with leading dimension in_ld_weights), into out_disu (in_n_pts x n_fields with leading dimension in_ld_disu) */
+  void calc_disu_weights(int in_ele, int in_n_pts, double* in_weights, int in_ld_weights, double* out_disu, int in_ld_disu);
+
+  /*! allocate in_n_bufs buffers for the solution snapshots of the background output writer */
+  void setup_output_buffers(int in_n_bufs);
+
+  /*! copy the solution (and its gradient, if viscous) into output buffer in_buf */
+  void stage_output(int in_buf);
+
+  /*! read the plot point and restart data from output buffer in_buf, or from the current solution if in_buf is -1 */
+  void set_output_buffer(int in_buf);
+
+  /*! calculate diagnostic fields at the plot points of element in_ele of a block filled by calc_disu_ppts and calc_grad_disu_ppts */
   void calc_diagnostic_fields_ppts(int in_ele, array<double>& in_disu_ppts, array<double>& in_grad_disu_ppts, array<double>& out_diag_field_ppts);
 
   /*! calculate position of a solution point */
@@ -284,20 +390,26 @@ public:
   /*! set transforms at the volume cubature points */
   void set_transforms_vol_cubpts(void);
 
+  /*! precompute the flux coefficients of the linear advection-diffusion equation (equation 1) */
+  void set_linear_advection(void);
+
 	/*! Calculate distance of solution points to no-slip wall */
-	void calc_wall_distance(int n_seg_noslip_inters, int n_tri_noslip_inters, int n_quad_noslip_inters, array< array<double> > loc_noslip_bdy);
+	void calc_wall_distance(int n_seg_noslip_inters, int n_tri_noslip_inters, int n_quad_noslip_inters, array< array<double> >& loc_noslip_bdy);
 
 	/*! Calculate distance of solution points to no-slip wall in parallel */
-	void calc_wall_distance_parallel(array<int> n_seg_noslip_inters, array<int> n_tri_noslip_inters, array<int> n_quad_noslip_inters, array< array<double> > loc_noslip_bdy_global, int nproc);
+	void calc_wall_distance_parallel(array<int>& n_seg_noslip_inters, array<int>& n_tri_noslip_inters, array<int>& n_quad_noslip_inters, array< array<double> >& loc_noslip_bdy_global, int nproc);
 
   /*! calculate position */
-  void calc_pos(array<double> in_loc, int in_ele, array<double>& out_pos);
+  void calc_pos(array_view<double> in_loc, int in_ele, array<double>& out_pos);
 
   /*! calculate derivative of position */
-  void calc_d_pos(array<double> in_loc, int in_ele, array<double>& out_d_pos);
+  void calc_d_pos(array_view<double> in_loc, int in_ele, array<double>& out_d_pos);
   
   /*! calculate second derivative of position */
-  void calc_dd_pos(array<double> in_loc, int in_ele, array<double>& out_dd_pos);
+  void calc_dd_pos(array_view<double> in_loc, int in_ele, array<double>& out_dd_pos);
+
+  /*! find the reference location of a physical position by Newton iterations on calc_pos, returns false if it is outside element in_ele */
+  bool calc_loc_of_pos(array<double>& in_pos, int in_ele, array<double>& out_loc);
   
   // #### virtual methods ####
 
@@ -306,21 +418,21 @@ public:
   /*! prototype for element reference length calculation */
   virtual double calc_h_ref_specific(int in_eles) = 0;
 
-  virtual int read_restart_info(ifstream& restart_file)=0;
+  virtual int read_restart_info(istream& restart_file)=0;
 
-  virtual void write_restart_info(ofstream& restart_file)=0;
+  virtual void write_restart_info(ostream& restart_file)=0;
 
   /*! Compute interface jacobian determinant on face */
-  virtual double compute_inter_detjac_inters_cubpts(int in_inter, array<double> d_pos)=0;
+  virtual double compute_inter_detjac_inters_cubpts(int in_inter, array<double>& d_pos)=0;
 
   /*! evaluate nodal basis */
-  virtual double eval_nodal_basis(int in_index, array<double> in_loc)=0;
+  virtual double eval_nodal_basis(int in_index, array_view<double> in_loc)=0;
 
   /*! evaluate nodal basis for restart file*/
-  virtual double eval_nodal_basis_restart(int in_index, array<double> in_loc)=0;
+  virtual double eval_nodal_basis_restart(int in_index, array_view<double> in_loc)=0;
 
   /*! evaluate derivative of nodal basis */
-  virtual double eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in_loc)=0;
+  virtual double eval_d_nodal_basis(int in_index, int in_cpnt, array_view<double> in_loc)=0;
 
   virtual void fill_opp_3(array<double>& opp_3)=0;
 
@@ -328,13 +440,13 @@ public:
   //virtual double eval_div_vcjh_basis(int in_index, array<double>& loc)=0;
 
   /*! evaluate nodal shape basis */
-  virtual double eval_nodal_s_basis(int in_index, array<double> in_loc, int in_n_spts)=0;
+  virtual double eval_nodal_s_basis(int in_index, array_view<double> in_loc, int in_n_spts)=0;
 
   /*! evaluate derivative of nodal shape basis */
-  virtual void eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<double> in_loc, int in_n_spts)=0;
+  virtual void eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array_view<double> in_loc, int in_n_spts)=0;
 
   /*! evaluate second derivative of nodal shape basis */
-  virtual void eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array<double> in_loc, int in_n_spts)=0;
+  virtual void eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array_view<double> in_loc, int in_n_spts)=0;
 
   /*! Calculate SGS flux */
   void calc_sgsf_upts(array<double>& temp_u, array<double>& temp_grad_u, double& detjac, int ele, int upt, array<double>& temp_sgsf);
@@ -353,6 +465,12 @@ public:
 
   double compute_res_upts(int in_norm_type, int in_field);
 
+  /*! get the residual sum (or maximum) of a field accumulated by the last RK stage of a monitored step, with res_norm_fused */
+  double get_res_norm_sum(int in_field);
+
+  /*! name the arrays of this element type for the memory report (tags are "<type>/<array>") */
+  void tag_arrays(void);
+
   /*! calculate body forcing at solution points */
   void calc_body_force_upts(array <double>& vis_force, array <double>& body_force);
 
@@ -362,7 +480,19 @@ public:
   /*! Compute volume integral of diagnostic quantities */
   void CalcIntegralQuantities(int n_integral_quantities, array <double>& integral_quantities);
 
-  void compute_wall_forces(array<double>& inv_force, array<double>& vis_force, double& temp_cl, double& temp_cd, ofstream& coeff_file, bool write_forces);
+  void compute_wall_forces(array<double>& inv_force, array<double>& vis_force, double& temp_cl, double& temp_cd, ostream& coeff_file, bool write_forces);
+
+  /*! solution, gradient, normal and pressure at cubature point in_cubpt of interface in_inter of boundary element in_bdy_ele, from the solution in_disu and gradient in_grad_disu at the solution points */
+  void calc_wall_state(int in_bdy_ele, int in_inter, int in_cubpt, array<double>& in_disu, array<double>& in_grad_disu, array<double>& out_u, array<double>& out_grad_u, array<double>& out_norm, double& out_p);
+
+  /*! viscous stresses w.r.t. the normal of a wall point, returns the wall shear stress */
+  double calc_wall_shear(array<double>& in_u, array<double>& in_grad_u, array<double>& in_norm, array<double>& out_taun);
+
+  /*! number of cubature points on the interfaces with a boundary type in in_bctypes */
+  int get_n_surface_pts(array<int>& in_bctypes);
+
+  /*! position, density, velocity, pressure, Cp and (if viscous) Cf at those points (n_vars x n_pts), from the selected output source */
+  void calc_surface_data(array<int>& in_bctypes, array<double>& out_data);
 
   array<double> compute_error(int in_norm_type, double& time);
   
@@ -391,6 +521,9 @@ protected:
   /*! number of elements */
   int n_eles;
 
+  /*! number of elements advanced at the current substep of multi-rate time stepping (a prefix of the elements) */
+  int n_eles_active;
+
   /*! number of elements that have a boundary face*/
   int n_bdy_eles;
 
@@ -447,6 +580,9 @@ protected:
   /*! Global cell number of element */
   array<int> ele2global_ele;
 
+  /*! Color of element, used to probe the element Jacobians of the implicit solver */
+  array<int> ele_color;
+
   /*! Global cell number of element */
   array<int> bdy_ele2ele;
 
@@ -560,6 +696,18 @@ protected:
   /*! Full vector-transform matrix from physical->computational frame, at flux points
    *  [Determinant of Jacobian times inverse of Jacobian] [J*G^-1] */
   array<double> JGinv_fpts;
+
+  /*! transformed wave speed [J*G^-1]*a at solution points (advection-diffusion only) */
+  array<double> tws_upts;
+
+  /*! normal transformed wave speed at flux points, on affine elements (lin_affine) */
+  array<double> ntws_fpts;
+
+  /*! normal transformed diffusion -diff_coeff*n.[J*G^-1] at flux points, on affine elements (lin_affine, viscous only) */
+  array<double> ntdiff_fpts;
+
+  /*! the normal transformed flux at the flux points is taken from the extrapolated solution and gradient */
+  int lin_affine;
 	
   /*! Magnitude of transformed face-area normal vector at flux points
    *  [magntiude of (normal dot inverse transformation matrix)] [ |J*(G^-1)*(n*dA)| ] */
@@ -584,20 +732,20 @@ protected:
         */
   array< array<double> > disu_upts;
 
-	/*!
-	time-averaged diagnostic fields at solution points
-	*/
-	array<double> u_average;
-	array<double> v_average;
-	array<double> w_average;
+  /*! snapshots of disu_upts(0) and grad_disu_upts written out by the background output writer */
+  array< array<double> > disu_upts_out;
+  array< array<double> > grad_disu_upts_out;
+
+  /*! output buffer read by the plot point and restart routines, -1: the current solution */
+  int out_buf;
 
 	/*!
 	filtered solution at solution points for similarity and SVV LES models
 	*/
 	array<double> disuf_upts;
 
-  /*! position at the plot points */
-  array< array<double> > pos_ppts;
+  /*! position at the plot points (n_ppts_per_ele x n_eles x n_dims), cached by get_pos_ppts */
+  array<double> pos_ppts;
 
 	/*!
 	description: transformed discontinuous solution at the flux points \n
@@ -688,6 +836,10 @@ protected:
   array<int> opp_0_e;
   int opp_0_sparse;
 
+  /*! solution point and weight of the single nonzero in each row of opp_0, when the flux points coincide with solution points (opp_0_sparse 2) */
+  array<int> opp_0_inject;
+  array<double> opp_0_inject_wgt;
+
 #ifdef _GPU
   array<double> opp_0_ell_data;
   array<int> opp_0_ell_indices;
@@ -701,6 +853,10 @@ protected:
   array< array<int> > opp_1_b;
   array< array<int> > opp_1_e;
   int opp_1_sparse;
+
+  /*! solution point and weight of the single nonzero in each row of opp_1 (opp_1_sparse 2) */
+  array< array<int> > opp_1_inject;
+  array< array<double> > opp_1_inject_wgt;
 #ifdef _GPU
   array< array<double> > opp_1_ell_data;
   array< array<int> > opp_1_ell_indices;
@@ -766,6 +922,10 @@ protected:
   array<int> opp_6_b;
   array<int> opp_6_e;
   int opp_6_sparse;
+
+  /*! solution point and weight of the single nonzero in each row of opp_6 (opp_6_sparse 2) */
+  array<int> opp_6_inject;
+  array<double> opp_6_inject_wgt;
 #ifdef _GPU
   array<double> opp_6_ell_data;
   array<int> opp_6_ell_indices;
@@ -781,11 +941,25 @@ protected:
   /*! operator to go from discontinuous solution at the restart points to discontinuous solution at the solutoin points */
   array<double> opp_r;
 
+  /*! modal coefficients from the solution at the solution points, degree of each mode, and quantization step of mode 0 relative to the error bound (lossy restart compression) */
+  array<double> inv_modal_vandermonde;
+  array<int> modal_degree;
+  double modal_step_factor;
+
   /*! dimensions for blas calls */
   int Arows, Acols;
   int Brows, Bcols;
   int Astride, Bstride, Cstride;
 
+  /*! C = alpha*A*B + beta*C for dense A, over the active elements of B and C (n_fields blocks of n_eles columns) */
+  void dgemm_active(int in_m, int in_k, double in_alpha, double* in_A, double* in_B, double in_beta, double* out_C);
+
+  /*! C = A*B + beta*C for an A with one nonzero per row, given by its column in_index and value in_wgt, over the active elements */
+  void gather_active(int in_m, int in_k, int* in_index, double* in_wgt, double* in_B, double in_beta, double* out_C);
+
+  /*! find the column and value of the nonzero in each row of in_opp; returns false if a row has more than one */
+  bool find_injection(array<double>& in_opp, array<int>& out_index, array<double>& out_wgt);
+
   /*! general settings for mkl sparse blas */
   char matdescra[6];
 
@@ -812,7 +986,36 @@ protected:
   
   /*! element local timestep */
   array<double> dt_local;
-  double dt_local_new;
-  array<double> dt_local_mpi;
+
+  /*! dual time stepping: coefficient of the solution and explicit part of the BDF physical time derivative */
+  double dual_coeff;
+  array<double> dual_src_upts;
+
+  /*! low-storage RK scheme of adv_type 3 */
+  lsrk rk;
+
+  /*! embedded error estimate of the RK step, and solution before it (adaptive time stepping only) */
+  array<double> rk_err_upts;
+  array<double> rk_save_upts;
+
+  /*! residual sum (or maximum) of each field accumulated by the last RK stage of a monitored step (res_norm_fused only) */
+  array<double> res_norm_sum;
+
+  /*! multi-rate time stepping: level of each element, and of the neighbour across each face (n_inters_per_ele,n_eles) */
+  array<int> lts_level;
+  array<int> lts_nb_level;
+
+  /*! number of elements of each level and below */
+  array<int> lts_n_eles_level;
+
+  /*! element and local face of each face with a finer neighbour, and offset of its first flux point */
+  array<int> lts_reg_ele, lts_reg_inter, lts_reg_fpt;
+
+  /*! time integral of the difference between the fine and coarse common fluxes, (n_fpts_per_ele,n_eles,n_fields) */
+  array<double> lts_flux_reg;
+
+  /*! highest active level, base time step and effective RK weight of the current stage */
+  int lts_max_active;
+  double lts_dt_base, lts_weight;
 
 };
@@ -74,22 +74,22 @@ public:
   void setup_ele_type_specific(void);
 
   /*! read restart info */
-  int read_restart_info(ifstream& restart_file);
+  int read_restart_info(istream& restart_file);
 
   /*! write restart info */
-  void write_restart_info(ofstream& restart_file);
+  void write_restart_info(ostream& restart_file);
 
   /*! Compute interface jacobian determinant on face */
-  double compute_inter_detjac_inters_cubpts(int in_inter, array<double> d_pos);
+  double compute_inter_detjac_inters_cubpts(int in_inter, array<double>& d_pos);
 
   /*! evaluate nodal basis */
-  double eval_nodal_basis(int in_index, array<double> in_loc);
+  double eval_nodal_basis(int in_index, array_view<double> in_loc);
 
   /*! evaluate nodal basis */
-  double eval_nodal_basis_restart(int in_index, array<double> in_loc);
+  double eval_nodal_basis_restart(int in_index, array_view<double> in_loc);
 
   /*! evaluate derivative of nodal basis */
-  double eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in_loc);
+  double eval_d_nodal_basis(int in_index, int in_cpnt, array_view<double> in_loc);
 
   /*! evaluate divergence of vcjh basis */
   double eval_div_vcjh_basis(int in_index, array<double>& loc);
@@ -97,13 +97,13 @@ public:
   void fill_opp_3(array<double>& opp_3);
 
   /*! evaluate nodal shape basis */
-  double eval_nodal_s_basis(int in_index, array<double> in_loc, int in_n_spts);
+  double eval_nodal_s_basis(int in_index, array_view<double> in_loc, int in_n_spts);
 
   /*! evaluate derivative of nodal shape basis */
-  void eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<double> in_loc, int in_n_spts);
+  void eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array_view<double> in_loc, int in_n_spts);
 
   /*! evaluate second derivative of nodal shape basis */
-  void eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array<double> in_loc, int in_n_spts);
+  void eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array_view<double> in_loc, int in_n_spts);
 
   /*! Compute the filter matrix for subgrid-scale models */
   void compute_filter_upts(void);
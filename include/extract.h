@@ -0,0 +1,93 @@
+/*!
+ * \file extract.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <sstream>
+
+#include "array.h"
+#include "solution.h"
+#include "element_index.h"
+
+struct solution; // forwards declaration
+
+/*!
+ * In-situ extracts, written every extract_freq steps instead of (or next to) the volume dumps: the density,
+ * velocity, pressure, Cp and Cf at the wall cubature points of the boundaries named in extract_bcs, and the
+ * solution on the planes given in slices. A slice is cut through the plot sub-cells of the elements whose
+ * bounding box it crosses; these elements are found once, with the element_index.
+ */
+class extractor
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  extractor();
+
+  // default destructor
+
+  ~extractor();
+
+  // #### methods ####
+
+  /*! look up the boundary types, index the elements and find the elements cut by each slice */
+  void setup(struct solution* FlowSol);
+
+  /*! write the surface and slice extracts of step in_file_num */
+  void write(int in_file_num, double in_time, struct solution* FlowSol);
+
+protected:
+
+  /*! write the surface extract */
+  void write_surface(int in_file_num, double in_time, struct solution* FlowSol);
+
+  /*! write the slice extract, one zone per slice */
+  void write_slices(int in_file_num, double in_time, struct solution* FlowSol);
+
+  /*! cut the plot sub-cells of item in_item with slice in_slice, appending points and cells to the zone text */
+  void cut_element(int in_item, int in_slice, array<int>& in_con, array<double>& in_disu_ppts, struct solution* FlowSol, ostringstream& io_pts, ostringstream& io_cells, int& io_n_pts, int& io_n_cells);
+
+  /*! write the text of a file, per rank or shared (mpiio_output) */
+  void write_file(const char* in_name, int in_file_num, const string& in_text, struct solution* FlowSol);
+
+  // #### members ####
+
+  /*! boundary types of the surface extract */
+  array<int> bctypes;
+
+  /*! hierarchy of the element bounding boxes */
+  element_index Index;
+
+  /*! unit normal and distance from the origin of each slice plane */
+  array<double> slice_norm;
+  array<double> slice_dist;
+
+  /*! items of the index crossed by each slice, -1 terminated */
+  array< array<int> > slice_items;
+
+};
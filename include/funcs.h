@@ -211,7 +211,7 @@ inline int calcNumSides(int nNodes)
 // eval_dd_nodal_s_basis_new function: new implementation of function that finds nth derivatives with
 // respect to r or s at each of the triangle nodes
 void eval_dn_nodal_s_basis(array<double> &dd_nodal_s_basis,
-                           array<double> in_loc, int in_n_spts, int n_deriv);
+                           array_view<double> in_loc, int in_n_spts, int n_deriv);
 
 /*! Linear equation solution by Gauss-Jordan elimination from Numerical Recipes (http://www.nr.com/) */
 void gaussj(int n, array<double>& A, array<double>& b);
@@ -92,6 +92,15 @@ void read_boundary_gambit(string& in_file_name, int &in_n_cells, array<int>& in_
 
 void read_boundary_gmsh(string& in_file_name, int &in_n_cells, array<int>& in_ic2icg, array<int>& in_c2v, array<int>& in_c2n_v, array<int>& out_bctype, array<int>& in_iv2ivg, int in_n_verts, array<int>& in_ctype, array<int>& in_icvsta, array<int>& in_icvert, struct solution* FlowSol);
 
+/*! greedy coloring of the cells such that no two cells within in_distance faces of each other share a color */
+void ColorElements(array<int>& in_f2c, int in_n_faces, int in_n_cells, int in_distance, array<int>& out_color, int& out_n_colors);
+
+/*! size of each cell, the smallest distance between two of its corners */
+void CalcCellSize(array<double>& in_xv, array<int>& in_c2v, array<int>& in_c2n_v, array<int>& in_ctype, int in_n_cells, int in_n_dims, array<double>& out_size);
+
+/*! permutation that sorts in_size in increasing order */
+void SortBySize(array<double>& in_size, int in_n, array<int>& out_order);
+
 /*! method to create list of faces from the mesh */
 void CompConnectivity(array<int>& in_c2v, array<int>& in_c2n_v, array<int>& in_ctype, array<int>& out_c2f, array<int>& out_c2e, array<int>& out_f2c, array<int>& out_f2loc_f, array<int>& out_f2v, array<int>& out_f2nv, array<int>& out_rot_tag, array<int>& out_unmatched_faces, int& out_n_unmatched_faces, array<int>& out_icvsta, array<int>& out_icvert, int& out_n_faces, int& out_n_edges, struct solution* FlowSol);
 
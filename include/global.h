@@ -41,3 +41,6 @@ int dgemm(int Arows, int Bcols, int Acols, double alpha, double beta, double* a,
 
 /*! routine that mimics BLAS daxpy */
 int daxpy(int n, double alpha, double *x, double *y);
+
+/*! wall-clock time in seconds, used for the solver phase timers */
+double wall_time(void);
@@ -85,12 +85,32 @@ public:
   double lambda;
 
   double dt;
-  int dt_type;
+  int dt_type; // 0: dt, 1: global minimum CFL time step, 2: element local time step (steady), 3: multi-rate local time stepping
   double CFL;
   int n_steps;
   int plot_freq;
   int restart_dump_freq;
-  int adv_type;
+  int adv_type; // 0: forward Euler, 3: RK45, 4: implicit pseudo-transient Newton-Krylov (steady)
+  int rk_scheme; // low-storage scheme of adv_type 3, 0: forward Euler, 1: RK45, 2: RK3, 3: SSP RK3, 4: four-stage SSP RK3, 5: fourteen-stage RK4 for DG spectra
+  int rk_adapt; // 0: off, 1: adapt dt (dt_type 0) to the embedded error estimate, rejecting steps above rk_tol
+  double rk_tol; // tolerance of the embedded error, relative to max(1,|u|)
+
+  int jfnk_krylov_dim; // GMRES iterations per Newton step
+  double jfnk_lin_tol; // relative GMRES tolerance
+  double jfnk_max_cfl_ratio; // largest ratio of the pseudo time step to the explicit one
+  int jfnk_prec_freq; // Newton steps between element Jacobian updates, 0: no preconditioner
+
+  int p_multigrid; // 0: off, 1: FAS V-cycle over the orders order, order-1, ..., mg_min_order
+  int mg_min_order; // order of the coarsest p-multigrid level
+  int mg_n_pre_smooth; // RK steps on each level before restricting
+  int mg_n_post_smooth; // RK steps on each level after prolongating the correction
+  int mg_n_coarse_smooth; // RK steps on the coarsest level
+
+  int dual_time; // 0: off, 1: BDF2 in the physical time step dt, converged in pseudo time with local time stepping
+  int dual_max_inner; // most pseudo time iterations per physical step
+  double dual_inner_tol; // reduction of the unsteady residual that ends the pseudo time iterations
+
+  int lts_n_levels; // number of power-of-two rate levels of multi-rate time stepping (dt_type 3)
 
   int LES;
   int filter_type;
@@ -102,7 +122,11 @@ public:
   int monitor_res_freq;
   int monitor_integrals_freq;
   int monitor_cp_freq;
+  int monitor_memory; // 0: off, 1: memory summary, 2: summary and per-array breakdown
+  int huge_pages; // 0: regular pages, 1: back large arrays with huge pages
+  int numa_policy; // 0: first touch, 1: interleave over all NUMA nodes, 2: bind each rank to one node
   int res_norm_type; // 0:infinity norm, 1:L1 norm, 2:L2 norm
+  int res_norm_fused; // 0: separate pass over the residual, 1: accumulate the norm in the last RK stage update
   int error_norm_type; // 0:infinity norm, 1:L1 norm, 2:L2 norm
   int res_norm_field;
 
@@ -129,7 +153,34 @@ public:
 
 
   int p_res;
-  int write_type;
+  int write_type; // 0: Paraview, 1: Tecplot ASCII, 2: Tecplot binary through TecIO, one file per rank with one zone per element type
+  int async_output; // 0: write plot and restart files in the time loop, 1: write them from a background thread
+  int mpiio_output; // 0: one plot, restart and cp file per rank, 1: one shared file per dump, written collectively with MPI-IO
+  int mpiio_aggregators; // number of ranks that write to the file system in mpiio_output (MPI-IO hint cb_nodes), 0: MPI default
+
+  int extract_freq; // steps between in-situ surface and slice extracts, 0: off
+  int n_extract_bcs;
+  array<string> extract_bcs; // names of the boundary conditions whose surface data is extracted
+  int n_slices;
+  array<double> slices; // point (x,y,z) and normal (nx,ny,nz) of each slice plane, 6 x n_slices
+
+  int probe_freq; // steps between samples of the point probes, 0: off
+  int probe_flush_freq; // samples buffered before they are appended to the probe files
+  string probe_file; // list of probe positions, one point (x y [z]) per line
+
+  int restart_compression; // 0: text restart data, 1: lossless (byte-shuffled and zlib-compressed), 2: lossy, error-bounded quantization of the modal coefficients, zlib-compressed
+  double restart_compression_tol; // bound of the pointwise error of restart_compression 2, relative to the largest value of the field in the element
+  int vtu_compression; // 0: text Paraview data, 1: zlib-compressed binary data
+
+  int stats_freq; // steps between samples of the running flow statistics, 0: off
+  int stats_moments; // 1: means, 2: means and Reynolds stresses
+  int n_stats_homogeneous;
+  array<int> stats_homogeneous; // directions (0: x, 1: y, 2: z) the statistics are also averaged over
+
+  double checkpoint_interval; // minutes of wall time between restart files, in addition to restart_dump_freq, 0: off
+  double wall_time_limit; // minutes of wall time of the run (job limit), a last restart file is written before it and the run stops, 0: off
+  double wall_time_margin; // minutes kept free before wall_time_limit, on top of the longest step
+  int checkpoint_signals; // 0: default signal handling, 1: SIGUSR1 writes a restart file, SIGTERM writes one and stops, at the next step
 
   int upts_type_tri;
   int fpts_type_tri;
@@ -66,6 +66,9 @@ public:
   /*! calculate delta in transformed discontinuous solution at flux points */
   void calc_delta_disu_fpts(void);
 
+  /*! take the multi-rate level of each face from its finer side, and give each side the level of the other */
+  void set_lts_levels(struct solution* FlowSol);
+
 protected:
 
   // #### members ####
@@ -78,4 +81,7 @@ protected:
   array<double*> tdA_fpts_r;
   array<double*> grad_disu_fpts_r;
 
+  /*! element type, element and local face of the right side of each face */
+  array<int> ele_type_r, ele_r, local_inter_r;
+
 };
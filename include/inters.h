@@ -75,6 +75,12 @@ public:
     /*! Compute common flux at boundaries using convective flux formulation */
     void convective_flux_boundary(array<double> &f_l, array<double> &f_r, array<double> &norm, array<double> &fn, int n_dims, int n_fields);
 
+  /*! make the multi-rate levels of the faces non-decreasing, lowering them where needed, and count the faces of each level */
+  void setup_lts(int in_n_levels);
+
+  /*! restrict the common flux computation to the faces of level in_max_level and below, -1 for all faces */
+  void set_lts_active(int in_max_level);
+
 	protected:
 
 	// #### members ####
@@ -86,6 +92,7 @@ public:
 	int LES;
   int wall_model;
 	int n_inters;
+	int n_inters_active; // faces evaluated at the current substep of multi-rate time stepping (a prefix of the faces)
 	int n_fpts_per_inter;
 	int n_fields;
 	int n_dims;
@@ -131,6 +138,12 @@ public:
 
   array<int> lut;
 
+  /*! element type, element and local face of the left side of each face */
+  array<int> ele_type_l, ele_l, local_inter_l;
+
+  /*! multi-rate level of each face (that of its finer side), and number of faces of each level and below */
+  array<int> lts_level, lts_n_inters_level;
+
   array<double> v_l, v_r, um, du;
 
 };
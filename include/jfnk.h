@@ -0,0 +1,125 @@
+/*!
+ * \file jfnk.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "array.h"
+#include "solution.h"
+
+struct solution; // forwards declaration
+
+/*!
+ * Implicit pseudo-transient Jacobian-free Newton-Krylov solver for steady problems (adv_type 4).
+ * Each step solves (I/dtau - dR/du) du = R(u) with right-preconditioned GMRES, where R is the
+ * time derivative computed by CalcResidual and the Jacobian-vector products are finite differences
+ * of R. The preconditioner is the element block-Jacobi matrix, whose blocks are probed one element
+ * color at a time. The pseudo time step follows the residual (switched evolution relaxation).
+ */
+class jfnk
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  jfnk();
+
+  // default destructor
+
+  ~jfnk();
+
+  // #### methods ####
+
+  /*! allocate the Newton, Krylov and preconditioner storage */
+  void setup(struct solution* FlowSol);
+
+  /*! perform one pseudo-time Newton step; leaves the residual of the new solution in div_tconf_upts */
+  void advance(struct solution* FlowSol);
+
+protected:
+
+  /*! copy between the solution in the elements and a vector */
+  void get_solution(array< array<double> >& out_u, int in_col, struct solution* FlowSol);
+  void set_solution(array< array<double> >& in_u, int in_col, struct solution* FlowSol);
+
+  /*! evaluate the time derivative R at the current solution */
+  void calc_rhs(array< array<double> >& out_f, int in_col, struct solution* FlowSol, int in_mpi_exchange=1);
+
+  /*! global dot product of columns of two vectors */
+  double dot(array< array<double> >& in_a, int in_col_a, array< array<double> >& in_b, int in_col_b);
+
+  /*! global dot products of a vector with the first in_n Krylov vectors, in a single reduction */
+  void dot_krylov(array< array<double> >& in_w, int in_col_w, int in_n, double* out_h);
+
+  /*! pseudo time step of each element for the current solution and CFL ratio */
+  void calc_dtau(struct solution* FlowSol);
+
+  /*! probe the diagonal blocks of dR/du, one element color and unknown at a time */
+  void calc_jacobian_blocks(struct solution* FlowSol);
+
+  /*! form and factorize the blocks I/dtau - dR/du */
+  void factorize_blocks(void);
+
+  /*! z = M^-1 v, with M the block-Jacobi preconditioner */
+  void apply_preconditioner(array< array<double> >& in_v, int in_col_v, array< array<double> >& out_z, int in_col_z);
+
+  /*! w = (I/dtau - dR/du) z, matrix-free */
+  void apply_operator(array< array<double> >& in_z, int in_col_z, array< array<double> >& out_w, int in_col_w, struct solution* FlowSol);
+
+  // #### members ####
+
+  int n_ele_types;
+  int krylov_dim;
+  int n_colors;
+  int n_steps;
+  int jac_age;
+  int f0_valid;
+
+  double cfl_ratio;
+  double res_norm_old;
+  double norm_u0;
+
+  /*! unknowns per element type: (n_upts_per_ele, n_eles, n_fields) */
+  array<int> n_upts, n_eles, n_fields;
+
+  /*! state and time derivative at the start of the Newton step, and two work vectors */
+  array< array<double> > u0, f0, work;
+
+  /*! Krylov basis (n_upts_per_ele, n_eles, n_fields, krylov_dim+1) */
+  array< array<double> > krylov;
+
+  /*! pseudo time step of each element */
+  array< array<double> > dtau;
+
+  /*! diagonal blocks of dR/du, their factorized shifted counterparts and pivots (n_block, n_block, n_eles) */
+  array< array<double> > jac_blocks, lu_blocks;
+  array< array<int> > lu_pivots;
+  array<double> block_rhs;
+
+  /*! Hessenberg matrix, Givens rotations and least-squares right hand side */
+  array<double> hessenberg, givens_c, givens_s, gmres_g, gmres_y, gmres_h;
+
+};
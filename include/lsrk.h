@@ -0,0 +1,97 @@
+/*!
+ * \file lsrk.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "array.h"
+
+/*!
+ * Low-storage explicit Runge-Kutta schemes held as coefficient tables. A 2N scheme (Williamson form) takes the stages
+ *   res = a_s*res + dt*R(u),  u = u + b_s*res
+ * and a 2S* scheme (Shu-Osher form that keeps the first stage) takes the stages
+ *   u = a_s*u_0 + (1-a_s)*u + b_s*dt*R(u)
+ * so both only need one register besides the solution. Each scheme also carries the weights e_s of the difference
+ * between its solution and that of an embedded scheme of one order lower, built from the same stages:
+ * sum_s e_s*dt*R(u_s) estimates the local error of the step for adaptive time stepping.
+ */
+class lsrk
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  lsrk();
+
+  // default destructor
+
+  ~lsrk();
+
+  // #### methods ####
+
+  /*! set up the tables of a scheme: 0: forward Euler, 1: RK45 (Carpenter and Kennedy), 2: RK3 (Williamson),
+      3: SSP RK3, 4: four-stage SSP RK3, 5: fourteen-stage RK4 optimized for DG spectra (Niegemann, Diehl and Busch) */
+  void setup(int in_scheme);
+
+  /*! get number of stages */
+  int get_n_stages(void);
+
+  /*! get order of accuracy (the embedded scheme is one order lower) */
+  int get_order(void);
+
+  /*! get form of the stage update, 0: 2N, 1: 2S* */
+  int get_form(void);
+
+  /*! get coefficient a of a stage */
+  double get_a(int in_stage);
+
+  /*! get coefficient b of a stage */
+  double get_b(int in_stage);
+
+  /*! get weight of the time derivative of a stage in the error estimate */
+  double get_e(int in_stage);
+
+  /*! get weight of the time derivative of a stage in the complete step */
+  double get_weight(int in_stage);
+
+  /*! time step for the next step (or the repeated step if in_err>1) from the error norm of a step of size in_dt */
+  double calc_new_dt(double in_dt, double in_err);
+
+protected:
+
+  // #### members ####
+
+  int scheme;
+  int form;
+  int n_stages;
+  int order;
+
+  array<double> a, b, e, weight;
+
+  /*! error norm of the last accepted step */
+  double err_prev;
+
+};
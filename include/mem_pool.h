@@ -0,0 +1,63 @@
+/*!
+ * \file mem_pool.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*! alignment of all array<T> storage, in bytes (one cache line, one AVX-512 register) */
+#define MEM_ALIGNMENT 64
+
+/*! largest allocation served from the size-class pool; bigger blocks go straight to the system */
+#define MEM_POOL_MAX_BYTES 65536
+
+/*! smallest allocation that is placed on huge pages when huge page mode is on */
+#define MEM_HUGE_PAGE_BYTES 2097152
+
+/*!
+ * Storage for array<T>. Every block is MEM_ALIGNMENT-byte aligned. Small blocks (temporaries
+ * such as positions, rotation matrices or single-element buffers) are recycled through
+ * power-of-two size classes carved from larger slabs, so that they do not reach malloc in
+ * the hot path. The free lists are per thread. Blocks of MEM_HUGE_PAGE_BYTES or more can optionally be backed by huge pages.
+ */
+
+/*! return an aligned block of at least in_bytes bytes */
+void* mem_pool_alloc(size_t in_bytes);
+
+/*! return a block obtained from mem_pool_alloc; in_bytes must match the request */
+void mem_pool_free(void* in_ptr, size_t in_bytes);
+
+/*! back large blocks allocated from now on with (transparent) huge pages */
+void mem_pool_set_huge_pages(int in_huge_pages);
+
+/*!
+ * NUMA placement of the pages this rank touches from now on. 0: system default (first touch),
+ * 1: interleave pages over all nodes, 2: run this rank on node (in_local_rank mod number of
+ * nodes) and allocate there. Policies 1 and 2 need the code to be compiled with -D_NUMA.
+ */
+void mem_pool_set_numa_policy(int in_policy, int in_local_rank);
+
+/*! bytes held in pool slabs (in use or cached for reuse) */
+size_t mem_pool_reserved_bytes(void);
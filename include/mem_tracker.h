@@ -0,0 +1,74 @@
+/*!
+ * \file mem_tracker.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*! maximum number of distinct memory tags */
+#define MAX_MEM_TAGS 512
+
+/*! maximum length of a memory tag name */
+#define MAX_MEM_TAG_LEN 64
+
+/*!
+ * Lightweight accounting of the host memory held by array<T>.
+ * Every array charges its allocation to a tag (tag 0 is 'untagged' and is the default);
+ * arrays are given a name with array<T>::set_tag. The bookkeeping uses plain static
+ * storage only, so that global arrays constructed before main() are accounted for.
+ */
+
+/*! return the id of the tag with the given name, registering it if needed */
+int mem_tag_id(const char* in_name);
+
+/*! charge in_bytes to tag in_tag */
+void mem_track_alloc(int in_tag, size_t in_bytes);
+
+/*! release in_bytes from tag in_tag */
+void mem_track_free(int in_tag, size_t in_bytes);
+
+/*!
+ * stop accounting the arrays of the calling thread, so that the counters need no lock. Only for
+ * helper threads that free every array they allocate (temporaries), and no array of another thread.
+ */
+void mem_track_ignore_thread(void);
+
+/*! number of registered tags (including 'untagged') */
+int mem_n_tags(void);
+
+/*! name of tag in_tag */
+const char* mem_tag_name(int in_tag);
+
+/*! bytes currently held by tag in_tag */
+size_t mem_tag_bytes(int in_tag);
+
+/*! high-water mark of tag in_tag */
+size_t mem_tag_peak(int in_tag);
+
+/*! bytes currently held by all arrays */
+size_t mem_total_bytes(void);
+
+/*! high-water mark of all arrays */
+size_t mem_total_peak(void);
@@ -0,0 +1,108 @@
+/*!
+ * \file monitor.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <ctime>
+
+#include "array.h"
+#include "solution.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+struct solution; // forwards declaration
+
+/*!
+ * Aggregator of the monitoring quantities. The forces, integral quantities and residual sums of a monitoring step
+ * are computed on each rank and packed into one buffer, which is reduced by a single non-blocking collective
+ * (summing the forces and sums, and taking the maximum of the residuals for the infinity norm). The reduction is
+ * completed lazily by finish after the following step, so that it overlaps with that step's computation. The body
+ * force of the periodic channel is computed from the reduced viscous force and used by the following step, so with
+ * body forcing there is no overlap and the reduction is completed right after it is started.
+ */
+class monitor
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  monitor();
+
+  // default destructor
+
+  ~monitor();
+
+  // #### methods ####
+
+  /*! size the buffer and set up the reduction of the monitoring quantities */
+  void setup(struct solution* FlowSol);
+
+  /*! compute the local monitoring quantities of step in_file_num and start their reduction */
+  void start(int in_file_num, struct solution* FlowSol);
+
+  /*! complete the pending reduction, if any, and write the convergence history of its step */
+  void finish(clock_t init, ofstream* write_hist, struct solution* FlowSol);
+
+  /*! get whether a reduction has been started and not finished */
+  bool get_pending(void);
+
+  /*! get whether the reduction may overlap with the following step (false with body forcing) */
+  bool get_overlap(void);
+
+protected:
+
+  // #### members ####
+
+  int n_dims;
+  int n_fields;
+  int n_integral_quantities;
+
+  /*! number of entries of the buffer that are summed, the rest are maxima */
+  int n_sum;
+
+  /*! local and reduced quantities: inviscid and viscous forces, lift and drag, integral quantities, number of solution points and residuals */
+  array<double> buf;
+  array<double> buf_global;
+
+  /*! step and physical time of the pending reduction */
+  int file_num;
+  double time;
+  bool pending;
+
+  /*! whether the reduction may be completed after the following step */
+  bool overlap;
+
+#ifdef _MPI
+  MPI_Datatype buf_type;
+  MPI_Op buf_op;
+  MPI_Request request;
+#endif
+
+};
@@ -74,6 +74,9 @@ public:
 
   void set_mpi(int in_inter, int in_ele_type_l, int in_ele_l, int in_local_inter_l, int rot_tag, struct solution* FlowSol);
 
+  /*! exchange the multi-rate levels of the elements on both sides, and give each local element the level of its remote neighbour */
+  void set_lts_levels(struct solution* FlowSol);
+
   void calculate_common_invFlux(void);
   void calculate_common_viscFlux(void);
 
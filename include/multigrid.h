@@ -0,0 +1,95 @@
+/*!
+ * \file multigrid.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "array.h"
+#include "solution.h"
+
+struct solution; // forwards declaration
+
+/*!
+ * p-multigrid convergence acceleration for steady problems and for the pseudo time iterations of
+ * dual time stepping (p_multigrid 1).
+ * Level 0 is the flow solution at the input order; level l holds the same mesh and partition at
+ * order-l, down to mg_min_order. Each cycle is a full approximation scheme (FAS) V-cycle: the
+ * explicit RK scheme smooths every level, the solution and time derivative are interpolated to the
+ * next coarser order, and the coarse correction is interpolated back, all with opp_r-style operators.
+ */
+class p_multigrid
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  p_multigrid();
+
+  // default destructor
+
+  ~p_multigrid();
+
+  // #### methods ####
+
+  /*! build the coarse levels, the transfer operators and the FAS storage */
+  void setup(struct solution* FlowSol);
+
+  /*! perform one V-cycle; leaves the residual of the last fine smoothing stage in div_tconf_upts */
+  void cycle(struct solution* FlowSol);
+
+  /*! set the coefficient of the implicit physical time derivative of dual time stepping on every level */
+  void set_dual_time_coeff(double in_coeff);
+
+protected:
+
+  /*! V-cycle from in_level down to the coarsest level and back */
+  void v_cycle(int in_level);
+
+  /*! in_n_steps RK steps on a level, including its FAS forcing */
+  void smooth(int in_level, int in_n_steps);
+
+  /*! time derivative on a level, including the dual time source and, if in_add_forcing, the FAS forcing */
+  void calc_residual(int in_level, int in_add_forcing);
+
+  /*! out = alpha*in_opp*in + beta*out for every element and field */
+  void transfer(array<double>& in_opp, double* in_from, double* out_to, int in_n_cols, double in_alpha, double in_beta);
+
+  // #### members ####
+
+  int n_levels;
+  int n_ele_types;
+  int n_rk_steps;
+
+  /*! flow solution of each level; level 0 belongs to the caller */
+  array<struct solution*> level_sol;
+
+  /*! solution interpolation from level l-1 to l and back, (n_levels, n_ele_types) */
+  array< array<double> > opp_restrict, opp_prolong;
+
+  /*! FAS forcing and restricted solution of each coarse level, time derivative of each level */
+  array< array<double> > forcing, u_restricted, rhs;
+
+};
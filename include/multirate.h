@@ -0,0 +1,81 @@
+/*!
+ * \file multirate.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "array.h"
+#include "solution.h"
+
+struct solution; // forwards declaration
+
+/*!
+ * Multi-rate local time stepping for the explicit RK schemes (dt_type 3). The elements are binned by their local
+ * time step into lts_n_levels power-of-two levels; level l advances with the step dt_base*2^l, where dt_base is the
+ * largest base step that keeps every element within its own stable step. One call to advance is a macro step of
+ * 2^(L-1) base steps over L levels: at substep k the levels l with k%2^l==0 take one RK step together, while the
+ * coarser levels stay frozen. Flux registers on the faces between levels replace the common flux a coarse element
+ * saw over its step with the one its finer neighbours saw over their substeps, so the scheme stays conservative.
+ * Elements and faces are numbered from the finest level up, so that the active ones at each substep form a prefix.
+ */
+class multirate
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  multirate();
+
+  // default destructor
+
+  ~multirate();
+
+  // #### methods ####
+
+  /*! bin the elements into levels by their local time step, and set up the interface coupling between levels */
+  void setup(struct solution* FlowSol);
+
+  /*! perform one macro step; returns the time advanced */
+  double advance(struct solution* FlowSol);
+
+protected:
+
+  /*! restrict the residual and update to the levels in_max_level and below, -1 for all */
+  void set_active(struct solution* FlowSol, int in_max_level);
+
+  /*! largest base step for which every element is within its local time step */
+  double calc_dt_base(struct solution* FlowSol);
+
+  // #### members ####
+
+  int n_ele_types;
+  int n_levels;
+  int n_rk_steps;
+
+  /*! weight of the time derivative of each RK stage in the complete step */
+  array<double> rk_weight;
+
+};
@@ -47,29 +47,58 @@
 #include "util.h"
 #endif
 
-/*! write an output file in Tecplot ASCII format */
-void write_tec(int in_file_num, struct solution* FlowSol);
+/*! write an output file of the solution at physical time in_time in Tecplot ASCII format */
+void write_tec(int in_file_num, double in_time, struct solution* FlowSol);
+
+/*! write an output file of the solution at physical time in_time in Tecplot binary format through TecIO, one zone per element type */
+void write_tec_bin(int in_file_num, double in_time, struct solution* FlowSol);
+
+/*! corner vertices (1-based, n_verts x n_cells) of the plot sub-elements of the elements of in_eles, in Tecplot order */
+void calc_tec_connectivity(eles* in_eles, array<int>& out_conn);
 
 /*! write an output file in VTK ASCII format */
 void write_vtu(int in_file_num, struct solution* FlowSol);
 
+/*! write the values of a Float32 DataArray of a Paraview file, as text or compressed binary (vtu_compression) */
+void write_vtu_floats(ostream& write_vtu, array<double>& in_values, int in_n_values);
+
+/*! write the values of an Int32 or UInt8 DataArray of a Paraview file, as text or compressed binary (vtu_compression) */
+void write_vtu_ints(ostream& write_vtu, array<int>& in_values, int in_n_values, int in_n_per_line, int in_uint8);
+
 /*! writing a restart file */
 void write_restart(int in_file_num, struct solution* FlowSol);
 
-/*! compute forces on wall faces*/
+#ifdef _MPI
+/*! write the text of every rank into one file, in rank order, with a collective MPI-IO write (mpiio_output) */
+void write_shared_file(const char* in_file_name, const string& in_text, struct solution* FlowSol);
+
+/*! write the restart text of every rank into one file, behind an index of the sections and of the section holding each cell (see read_shared_restart) */
+void write_shared_restart(const char* in_file_name, const string& in_text, struct solution* FlowSol);
+#endif
+
+/*! compute forces on the wall faces of this rank (reduced by the monitor) */
 void CalcForces(int in_file_num, struct solution* FlowSol);
 
-/*! compute integral diagnostic quantities */
+/*! compute integral diagnostic quantities of this rank's elements (reduced by the monitor) */
 void CalcIntegralQuantities(int in_file_num, struct solution* FlowSol);
 
 /*! compute error */
 void compute_error(int in_file_num, struct solution* FlowSol);
 
-/*! monitor convergence of residual */
-void CalcNormResidual(struct solution* FlowSol);
+/*! sum (or maximum) of the residual of each field over this rank's solution points; returns the number of solution points */
+int CalcResidualSums(double* out_sums, struct solution* FlowSol);
+
+/*! monitor convergence of residual, from the sums reduced over all ranks */
+void CalcNormResidual(double* in_sums, double in_n_upts, struct solution* FlowSol);
 
 /*! monitor convergence of residual */
-void HistoryOutput(int in_file_num, clock_t init, ofstream *write_hist, struct solution* FlowSol);
+void HistoryOutput(int in_file_num, double in_time, clock_t init, ofstream *write_hist, struct solution* FlowSol);
+
+/*! write memory report (bytes per element type, per DOF and the high-water mark) */
+void MemoryReport(const char* in_stage, struct solution* FlowSol);
+
+/*! write summary of the solver phase timers (max over ranks) */
+void TimingOutput(int in_n_steps, double in_t_loop, double in_t_residual, double in_t_update, double in_t_monitor, double in_t_plot, double in_t_restart, struct solution* FlowSol);
 
 /*! check if the solution is bounded !*/
 void check_stability(struct solution* FlowSol);
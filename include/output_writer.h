@@ -0,0 +1,107 @@
+/*!
+ * \file output_writer.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include "solution.h"
+#include "extract.h"
+
+struct solution; // forwards declaration
+
+/*! number of solution snapshots: one being written while the next one is taken */
+#define N_OUTPUT_BUFFERS 2
+
+/*!
+ * Writer of the plot and restart files. With async_output set, the solution (and its gradient, if viscous)
+ * of an output step is copied into one of N_OUTPUT_BUFFERS snapshots held by the elements, and a background
+ * thread interpolates it to the plot points and writes the files while the time stepping carries on. When all
+ * snapshots are still waiting to be written, the time loop blocks until the writer frees one. Otherwise the
+ * files are written in place, as before.
+ */
+class output_writer
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  output_writer();
+
+  // default destructor
+
+  ~output_writer();
+
+  // #### methods ####
+
+  /*! allocate the snapshots and start the writer thread if output is written in the background */
+  void setup(struct solution* FlowSol);
+
+  /*! write the plot file (in_type 0), restart file (in_type 1) or surface and slice extracts (in_type 2) of step in_file_num */
+  void write(int in_file_num, int in_type, struct solution* FlowSol);
+
+  /*! wait for all pending files and stop the writer thread */
+  void finish(void);
+
+  /*! body of the writer thread: write the queued snapshots, oldest first */
+  void run(void);
+
+protected:
+
+  // #### members ####
+
+  /*! solution written by the thread */
+  struct solution* sol;
+
+  /*! writer thread running */
+  bool active;
+
+  /*! no more snapshots will be queued */
+  bool stop;
+
+  /*! state of each snapshot, 0: free, 1: queued, 2: being written */
+  int buf_state[N_OUTPUT_BUFFERS];
+
+  /*! step, physical time, files to write and queue position of each snapshot */
+  int buf_file_num[N_OUTPUT_BUFFERS];
+  double buf_time[N_OUTPUT_BUFFERS];
+  bool buf_plot[N_OUTPUT_BUFFERS];
+  bool buf_restart[N_OUTPUT_BUFFERS];
+  bool buf_extract[N_OUTPUT_BUFFERS];
+  long buf_seq[N_OUTPUT_BUFFERS];
+
+  /*! in-situ surface and slice extracts, written every extract_freq steps */
+  extractor Extract;
+
+  /*! snapshots queued so far */
+  long n_queued;
+
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+
+};
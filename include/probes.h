@@ -0,0 +1,101 @@
+/*!
+ * \file probes.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "array.h"
+#include "solution.h"
+#include "element_index.h"
+
+struct solution; // forwards declaration
+
+/*!
+ * Time series of the solution at fixed points (probe_file), sampled every probe_freq steps. Each probe is located
+ * once: the element_index gives the candidate elements, and a Newton inversion of calc_pos its reference location,
+ * where the nodal basis weights are precomputed. A sample is then one small product per element holding probes.
+ * Samples are buffered and appended every probe_flush_freq samples to the binary file
+ * probe_files/probes_<first step>_p<rank>.bin of the rank owning the probes, made of
+ *   - a header: n_dims, n_fields, n_probes (int), then the index in probe_file (int) and position (n_dims double) of each probe,
+ *   - one record per sample: step (int), time (double), solution (n_probes x n_fields double, probes fastest).
+ */
+class probes
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  probes();
+
+  // default destructor
+
+  ~probes();
+
+  // #### methods ####
+
+  /*! read the probe list, locate the probes and precompute their weights */
+  void setup(struct solution* FlowSol);
+
+  /*! evaluate the solution at the probes of this rank, and append the samples to the file when the buffer is full */
+  void sample(int in_step, struct solution* FlowSol);
+
+  /*! append the buffered samples to the file */
+  void flush(void);
+
+protected:
+
+  // #### members ####
+
+  /*! hierarchy of the element bounding boxes */
+  element_index Index;
+
+  int n_fields;
+
+  /*! probes owned by this rank, ordered by element type and element */
+  int n_probes;
+  array<int> probe_id;
+  array<int> probe_type;
+  array<int> probe_ele;
+  array<double> probe_pos;
+
+  /*! basis weights of each probe at the solution points of its element (max n_upts x n_probes) */
+  array<double> weights;
+
+  /*! runs of probes in the same element: first probe of each run, and the end of the last one */
+  int n_groups;
+  array<int> group_first;
+
+  /*! buffered samples (n_probes x n_fields x probe_flush_freq), with their step and time */
+  int n_buffered;
+  array<double> samples;
+  array<int> sample_step;
+  array<double> sample_time;
+
+  string file_name;
+
+};
@@ -65,6 +65,7 @@ struct solution {
   
   int n_steps;
   int adv_type;
+  lsrk rk; /*!< tables of the explicit RK scheme */
   int plot_freq;
   int restart_dump_freq;
   int ini_iter;
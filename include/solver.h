@@ -46,8 +46,28 @@
 /*!
  * \brief Calculate the residual.
  * \param[in] FlowSol - Structure with the entire solution and mesh information.
+ * \param[in] in_mpi_exchange - 0 to reuse the neighbouring partitions' data from the previous exchange.
  */
-void CalcResidual(struct solution* FlowSol);
+void CalcResidual(struct solution* FlowSol, int in_mpi_exchange=1);
+
+/*!
+ * \brief Wall-clock seconds spent in CalcResidual so far, including the calls made by the implicit, multi-rate, dual time and p-multigrid drivers.
+ */
+double CalcResidualTime(void);
+
+/*!
+ * \brief Set the time steps of the next step: the element time steps (dt_type 2), or their minimum over all element types and partitions (dt_type 1).
+ * \param[in] FlowSol - Structure with the entire solution and mesh information.
+ * \return The time step, run_input.dt unless dt_type is 1.
+ */
+double CalcTimeStep(struct solution* FlowSol);
+
+/*!
+ * \brief Error control of adaptive time stepping: accept or reject the RK step just taken, and set run_input.dt for the next one.
+ * \param[in] FlowSol - Structure with the entire solution and mesh information.
+ * \return The time step taken, 0 if the step was rejected and the solution restored.
+ */
+double AdaptTimeStep(struct solution* FlowSol);
 
 void set_rank_nproc(int in_rank, int in_nproc, struct solution* FlowSol);
 
@@ -82,7 +102,7 @@ double* get_delta_disu_fpts_ptr(int in_ele_type, int in_ele, int in_field, int n
 double* get_grad_disu_fpts_ptr(int in_ele_type, int in_ele, int in_local_inter, int in_field, int in_dim, int in_fpt, struct solution* FlowSol);
 
 /*! get pointer to the closest normal point of the discontinuous solution at a flux point */
-double* get_normal_disu_fpts_ptr(int in_ele_type, int in_ele, int in_local_inter, int in_field, int in_fpt, struct solution* FlowSol, array<double> temp_loc, double temp_pos[3]);
+double* get_normal_disu_fpts_ptr(int in_ele_type, int in_ele, int in_local_inter, int in_field, int in_fpt, struct solution* FlowSol, array<double>& temp_loc, double temp_pos[3]);
 
 // Initialize the solution in the mesh
 void InitSolution(struct solution* FlowSol);
@@ -90,6 +110,18 @@ void InitSolution(struct solution* FlowSol);
 /*! reading a restart file */
 void read_restart(int in_file_num, int in_n_files, struct solution* FlowSol);
 
+/*! size of the text line that starts a shared restart file ("restart_index <n_sections> <n_cells>", padded with blanks) */
+#define SHARED_RESTART_HEADER_BYTES 64
+
+/*! read a shared restart file (mpiio_output), returns false if there is none.
+ After the header line, the file holds the offset and size of the section of each writing rank (long long pairs),
+ then the section holding each global cell (int, by global cell index), then the text of the sections.
+ Each rank reads only the sections that hold its own cells. */
+bool read_shared_restart(int in_file_num, struct solution* FlowSol);
+
+/*! sorted global indices of the cells of this rank, returns their number */
+int get_global_cells(array<int>& out_cells, struct solution* FlowSol);
+
 
 
 
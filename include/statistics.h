@@ -0,0 +1,129 @@
+/*!
+ * \file statistics.h
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "array.h"
+#include "solution.h"
+
+struct solution; // forwards declaration
+
+/*!
+ * Running flow statistics, sampled every stats_freq steps: the means of the primitive variables (rho, velocity and
+ * p, or the scalar of the advection-diffusion equation) and, with stats_moments 2, the covariances of the velocity
+ * components (Reynolds stresses) or the variance of the scalar. The moments are updated in place with Welford's
+ * algorithm, so no snapshots are kept:
+ *   - at every solution point, or
+ *   - with n_stats_homogeneous directions, in bins of the solution points that share their other coordinates. A
+ *     sample then combines the points of a bin, and the bins of all ranks are merged on rank 0 when written.
+ * The statistics are written with the restart files, as a text header followed by binary (double) data, to
+ * stats_files/Stats_<step>_p<rank>.dat (one file per rank) or stats_files/Stats_<step>.dat (bins). A restart
+ * continues the statistics of the restart step.
+ */
+class statistics
+{
+public:
+
+  // #### constructors ####
+
+  // default constructor
+
+  statistics();
+
+  // default destructor
+
+  ~statistics();
+
+  // #### methods ####
+
+  /*! allocate the moments (or set up the bins), and read those of the restart step */
+  void setup(struct solution* FlowSol);
+
+  /*! add the current solution to the statistics */
+  void sample(struct solution* FlowSol);
+
+  /*! write the statistics of step in_file_num */
+  void write(int in_file_num, struct solution* FlowSol);
+
+protected:
+
+  /*! primitive variables of the point whose first field is at in_disu, fields in_stride apart */
+  void calc_vars(double* in_disu, int in_stride, double* out_vars);
+
+  /*! per-point statistics: write one file per rank, read those of a restart */
+  void write_points(int in_file_num, struct solution* FlowSol);
+  void read_points(int in_file_num, struct solution* FlowSol);
+
+  /*! binned statistics: group the solution points, merge the bins of all ranks and write them, read those of a restart */
+  void setup_bins(struct solution* FlowSol);
+  void write_bins(int in_file_num, struct solution* FlowSol);
+  void read_bins(int in_file_num, struct solution* FlowSol);
+
+  /*! combine bins a and b of a list of records (position, count, means, second moments) into a */
+  void merge_records(double* inout_a, double* in_b);
+
+  // #### members ####
+
+  int n_dims;
+  int n_fields;
+
+  /*! variables and their names, and the pairs of variables of the covariances */
+  int n_vars;
+  int n_cov;
+  array<string> var_names;
+  array<int> cov_a;
+  array<int> cov_b;
+
+  /*! samples taken (including those of the restart, for the per-point statistics) */
+  int n_samples;
+
+  /*! per-point statistics of each element type: means (n_vars x n_upts x n_eles) and sums of products of deviations (n_cov x n_upts x n_eles) */
+  array< array<double> > mean;
+  array< array<double> > m2;
+
+  /*! binned statistics: bin of each solution point, position (homogeneous coordinates 0) and number of points of each bin, moments of each bin */
+  int n_bins;
+  double bin_tol;
+  array< array<int> > bin_of_upt;
+  array<double> bin_pos;
+  array<int> bin_n_pts;
+  array<double> bin_mean;
+  array<double> bin_m2;
+
+  /*! moments of the bins of the current sample */
+  array<double> batch_mean;
+  array<double> batch_m2;
+
+  /*! merged bins of the restart step (rank 0), added to the bins of this run when written */
+  int n_prev_bins;
+  int n_prev_samples;
+  array<double> prev_records;
+
+  /*! sample values of one point */
+  array<double> vars;
+
+};
@@ -35,6 +35,15 @@
 #include "../include/solver.h"
 #include "../include/output.h"
 #include "../include/solution.h"
+#include "../include/jfnk.h"
+#include "../include/multigrid.h"
+#include "../include/dual_time.h"
+#include "../include/multirate.h"
+#include "../include/monitor.h"
+#include "../include/output_writer.h"
+#include "../include/probes.h"
+#include "../include/statistics.h"
+#include "../include/checkpoint.h"
 
 #ifdef _MPI
 #include "mpi.h"
@@ -50,11 +59,25 @@ int main(int argc, char *argv[]) {
   
   int rank = 0, error_state = 0;
   int i, j;                           /*!< Loop iterators */
+  int monitor_step;                   /*!< Whether the residual of this step is monitored */
   int i_steps = 0;                    /*!< Iteration index */
   int RKSteps;                        /*!< Number of RK steps */
+  double dt_step;                     /*!< Time step of the current iteration */
   ifstream run_input_file;            /*!< Config input file */
   clock_t init_time, final_time;                /*!< To control the time */
+  double t_start, t_loop, t_run, t_res;      /*!< Wall-clock time of the solver loop and of the start of the run */
+  double t_residual = 0.0, t_update = 0.0, t_monitor = 0.0, t_plot = 0.0, t_restart = 0.0; /*!< Solver phase timers */
   struct solution FlowSol;            /*!< Main structure with the flow solution and geometry */
+  jfnk ImplicitSolver;                /*!< Newton-Krylov solver, used with adv_type 4 */
+  p_multigrid PMultigrid;             /*!< p-multigrid levels, used with p_multigrid 1 */
+  dual_time DualTime;                 /*!< BDF2 dual time stepping, used with dual_time 1 */
+  multirate MultirateLTS;             /*!< Multi-rate local time stepping, used with dt_type 3 */
+  monitor Monitor;                    /*!< Aggregated reduction of the forces, integral quantities and residuals */
+  output_writer Writer;               /*!< Plot and restart files, written in the background with async_output 1 */
+  probes Probes;                      /*!< Time series of the solution at the points of probe_file */
+  statistics Stats;                   /*!< Running means and Reynolds stresses of the solution */
+  checkpoint Checkpoint;              /*!< Restart files on wall time and on signals */
+  int checkpoint_action = 0;          /*!< 0: none, 1: checkpoint, 2: checkpoint and stop */
   ofstream write_hist;                /*!< Output files (forces, statistics, and history) */
   
   /*! Check the command line input. */
@@ -64,12 +87,15 @@ int main(int argc, char *argv[]) {
   /*! Initialize MPI. */
   
 #ifdef _MPI
-  MPI_Init(&argc, &argv);
+  int thread_level;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_level);
   int nproc;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
   MPI_Comm_size(MPI_COMM_WORLD, &nproc);
 #endif
   
+  t_run = wall_time();
+  
   if (rank == 0) {
     cout << " __    __   __   _______  __          __       _______     _______." << endl;
     cout << "|  |  |  | |  | |   ____||  |        |  |     |   ____|   /       |" << endl;
@@ -91,6 +117,29 @@ int main(int argc, char *argv[]) {
   if (!run_input_file) FatalError("Unable to open input file");
   run_input.setup(run_input_file, rank);
   
+  /*! Place the large arrays allocated from here on (mesh and solution storage) on huge pages if requested. */
+  
+  mem_pool_set_huge_pages(run_input.huge_pages);
+  
+  /*! Place the pages of this rank on its NUMA node(s). Everything the rank allocates is also zeroed
+   and computed on by the rank itself, so with the default first-touch policy the element data
+   already ends up on the node the rank runs on, provided the rank is pinned. */
+  
+  if (run_input.numa_policy != 0) {
+    int local_rank = 0;
+#ifdef _MPI
+#if MPI_VERSION >= 3
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &local_rank);
+    MPI_Comm_free(&node_comm);
+#else
+    local_rank = rank;
+#endif
+#endif
+    mem_pool_set_numa_policy(run_input.numa_policy, local_rank);
+  }
+  
   /*! Set the input values in the FlowSol structure. */
   
   SetInput(&FlowSol);
@@ -99,8 +148,23 @@ int main(int argc, char *argv[]) {
   
   GeoPreprocess(&FlowSol);
   
+  if (run_input.monitor_memory) MemoryReport("after preprocessing", &FlowSol);
+  
   InitSolution(&FlowSol);
   
+  if (FlowSol.adv_type == 4) ImplicitSolver.setup(&FlowSol);
+  if (run_input.p_multigrid) PMultigrid.setup(&FlowSol);
+  if (run_input.dual_time) DualTime.setup(&FlowSol, run_input.p_multigrid ? &PMultigrid : NULL);
+  if (run_input.dt_type == 3) MultirateLTS.setup(&FlowSol);
+  
+  Monitor.setup(&FlowSol);
+  if (run_input.probe_freq) Probes.setup(&FlowSol);
+  if (run_input.stats_freq) Stats.setup(&FlowSol);
+  Writer.setup(&FlowSol);
+  Checkpoint.setup(t_run);
+  
+  if (run_input.monitor_memory) MemoryReport("after initialization", &FlowSol);
+  
   init_time = clock();
   
   /////////////////////////////////////////////////
@@ -120,24 +184,20 @@ int main(int argc, char *argv[]) {
     for (i=0; i<5; i++) FlowSol.body_force(i)=0.0;
   }
   
-  /*! Initialize forces, integral quantities, and residuals. */
-
-  if (FlowSol.rank == 0) {
-    
-    FlowSol.inv_force.setup(5);
-    FlowSol.vis_force.setup(5);
-    FlowSol.norm_residual.setup(5);
-    FlowSol.integral_quantities.setup(run_input.n_integral_quantities);
-    
-    for (i=0; i<5; i++) {
-      FlowSol.inv_force(i)=0.0;
-      FlowSol.vis_force(i)=0.0;
-      FlowSol.norm_residual(i)=0.0;
-    }
-    for (i=0; i<run_input.n_integral_quantities; i++)
-      FlowSol.integral_quantities(i)=0.0;
+  /*! Initialize forces, integral quantities, and residuals (local on each rank until reduced by the monitor). */
 
+  FlowSol.inv_force.setup(5);
+  FlowSol.vis_force.setup(5);
+  FlowSol.norm_residual.setup(5);
+  FlowSol.integral_quantities.setup(run_input.n_integral_quantities);
+  
+  for (i=0; i<5; i++) {
+    FlowSol.inv_force(i)=0.0;
+    FlowSol.vis_force(i)=0.0;
+    FlowSol.norm_residual(i)=0.0;
   }
+  for (i=0; i<run_input.n_integral_quantities; i++)
+    FlowSol.integral_quantities(i)=0.0;
   
   /*! Copy solution and gradients from GPU to CPU, ready for the following routines */
 #ifdef _GPU
@@ -148,9 +208,7 @@ int main(int argc, char *argv[]) {
 
   /*! Dump initial Paraview or tecplot file. */
   
-  if (FlowSol.write_type == 0) write_vtu(FlowSol.ini_iter+i_steps, &FlowSol);
-  else if (FlowSol.write_type == 1) write_tec(FlowSol.ini_iter+i_steps, &FlowSol);
-  else FatalError("ERROR: Trying to write unrecognized file format ... ");
+  Writer.write(FlowSol.ini_iter+i_steps, 0, &FlowSol);
   
   if (FlowSol.rank == 0) cout << endl;
   
@@ -160,37 +218,88 @@ int main(int argc, char *argv[]) {
   
   /*! Main solver loop (outer loop). */
   
+  t_loop = wall_time();
+
   while(i_steps < FlowSol.n_steps) {
     
-    if (FlowSol.adv_type == 0) RKSteps = 1;
-    if (FlowSol.adv_type == 3) RKSteps = 5;
+    if (FlowSol.adv_type == 0 || FlowSol.adv_type == 3) RKSteps = FlowSol.rk.get_n_stages();
+    if (FlowSol.adv_type == 4 || run_input.p_multigrid || run_input.dual_time || run_input.dt_type == 3) RKSteps = 0;
+    
+    /*! The monitor runs after i_steps is increased below; with res_norm_fused, only its steps accumulate the residual norms. */
+    
+    monitor_step = (i_steps+1 == 1 || (i_steps+1)%run_input.monitor_res_freq == 0);
+    
+    /*! Time step from the CFL number (dt_type 1 and 2), one global reduction per step. */
+    
+    dt_step = run_input.dt;
+    if (RKSteps > 0) {
+      t_start = wall_time();
+      dt_step = CalcTimeStep(&FlowSol);
+      t_update += wall_time()-t_start;
+    }
     
     for(i=0; i < RKSteps; i++) {
       
       /*! Spatial integration. */
 
+      t_start = wall_time();
       CalcResidual(&FlowSol);
+      t_residual += wall_time()-t_start;
       
       /*! Time integration usign a RK scheme */
       
+      t_start = wall_time();
       for(j=0; j<FlowSol.n_ele_types; j++) {
         
-        FlowSol.mesh_eles(j)->AdvanceSolution(i, FlowSol.adv_type);
+        FlowSol.mesh_eles(j)->AdvanceSolution(i, FlowSol.adv_type, monitor_step);
         
       }
+      t_update += wall_time()-t_start;
+      
+    }
+    
+    /*! The drivers below evaluate the residual themselves; the time spent in CalcResidual goes to the residual timer, the rest to the update timer. */
+    
+    if (RKSteps == 0) {
+      t_start = wall_time();
+      t_res = CalcResidualTime();
       
+      /*! Pseudo-time Newton step of the implicit solver (residual evaluations included). */
+      
+      if (FlowSol.adv_type == 4)
+        ImplicitSolver.advance(&FlowSol);
+      
+      /*! Macro step of multi-rate time stepping (RK stages of all levels included, time updated). */
+      if (run_input.dt_type == 3)
+        MultirateLTS.advance(&FlowSol);
+      
+      /*! Physical time step of dual time stepping (pseudo time iterations included). */
+      if (run_input.dual_time)
+        DualTime.advance(&FlowSol);
+      
+      /*! p-multigrid V-cycle (residual evaluations and RK smoothing on all levels included). */
+      else if (run_input.p_multigrid)
+        PMultigrid.cycle(&FlowSol);
+      
+      t_res = CalcResidualTime()-t_res;
+      t_residual += t_res;
+      t_update += wall_time()-t_start-t_res;
     }
 
     /*! Update total time, and increase the iteration index. */
     
-    FlowSol.time += run_input.dt;
+    if (run_input.rk_adapt) FlowSol.time += AdaptTimeStep(&FlowSol);
+    else if (run_input.dt_type != 3) FlowSol.time += dt_step;
     i_steps++;
     
     /*! Copy solution and gradients from GPU to CPU, ready for the following routines */
 #ifdef _GPU
 
     if(i_steps == 1 || i_steps%FlowSol.plot_freq == 0 ||
-       i_steps%run_input.monitor_res_freq == 0 || i_steps%FlowSol.restart_dump_freq==0) {
+       i_steps%run_input.monitor_res_freq == 0 || i_steps%FlowSol.restart_dump_freq==0 ||
+       (run_input.extract_freq && i_steps%run_input.extract_freq == 0) ||
+       (run_input.probe_freq && i_steps%run_input.probe_freq == 0) ||
+       (run_input.stats_freq && i_steps%run_input.stats_freq == 0)) {
 
       CopyGPUCPU(&FlowSol);
 
@@ -198,41 +307,89 @@ int main(int argc, char *argv[]) {
 
 #endif
 
-    /*! Force, integral quantities, and residual computation and output. */
+    /*! Complete the monitoring reduction started at an earlier step, which overlapped with this step, and output the history file. */
+
+    if (Monitor.get_pending()) {
+      t_start = wall_time();
+      Monitor.finish(init_time, &write_hist, &FlowSol);
+      t_monitor += wall_time()-t_start;
+    }
+
+    /*! Force, integral quantities, and residual computation on each rank, and start of their reduction. */
 
     if( i_steps == 1 || i_steps%run_input.monitor_res_freq == 0 ) {
 
-      /*! Compute the value of the forces. */
-      
-      CalcForces(FlowSol.ini_iter+i_steps, &FlowSol);
+      t_start = wall_time();
+      Monitor.start(FlowSol.ini_iter+i_steps, &FlowSol);
       
-      /*! Compute integral quantities. */
-      
-      CalcIntegralQuantities(FlowSol.ini_iter+i_steps, &FlowSol);
-      
-      /*! Compute the norm of the residual. */
-      
-      CalcNormResidual(&FlowSol);
-      
-      /*! Output the history file. */
-      
-      HistoryOutput(FlowSol.ini_iter+i_steps, init_time, &write_hist, &FlowSol);
-      
-      if (FlowSol.rank == 0) cout << endl;
+      /*! With body forcing, the next step needs the body force of this step's reduction. */
+      if (!Monitor.get_overlap())
+        Monitor.finish(init_time, &write_hist, &FlowSol);
+      t_monitor += wall_time()-t_start;
+    }
+    
+    /*! Sample the point probes. */
+    
+    if(run_input.probe_freq && i_steps%run_input.probe_freq == 0) {
+      t_start = wall_time();
+      Probes.sample(FlowSol.ini_iter+i_steps, &FlowSol);
+      t_monitor += wall_time()-t_start;
     }
     
-    /*! Dump Paraview or Tecplot file. */
+    /*! Update the running statistics. */
+    
+    if(run_input.stats_freq && i_steps%run_input.stats_freq == 0) {
+      t_start = wall_time();
+      Stats.sample(&FlowSol);
+      t_monitor += wall_time()-t_start;
+    }
+    
+    /*! Dump Paraview or Tecplot file (a snapshot queued for the background writer with async_output). */
     
     if(i_steps%FlowSol.plot_freq == 0) {
-      if(FlowSol.write_type == 0) write_vtu(FlowSol.ini_iter+i_steps, &FlowSol);
-      else if(FlowSol.write_type == 1) write_tec(FlowSol.ini_iter+i_steps, &FlowSol);
-      else FatalError("ERROR: Trying to write unrecognized file format ... ");
+      t_start = wall_time();
+      Writer.write(FlowSol.ini_iter+i_steps, 0, &FlowSol);
+      t_plot += wall_time()-t_start;
     }
     
     /*! Dump restart file. */
     
     if(i_steps%FlowSol.restart_dump_freq==0) {
-      write_restart(FlowSol.ini_iter+i_steps, &FlowSol);
+      t_start = wall_time();
+      Writer.write(FlowSol.ini_iter+i_steps, 1, &FlowSol);
+      if (run_input.stats_freq) Stats.write(FlowSol.ini_iter+i_steps, &FlowSol);
+      t_restart += wall_time()-t_start;
+    }
+    
+    /*! Write the in-situ surface and slice extracts. */
+    
+    if(run_input.extract_freq && i_steps%run_input.extract_freq == 0) {
+      t_start = wall_time();
+      Writer.write(FlowSol.ini_iter+i_steps, 2, &FlowSol);
+      t_plot += wall_time()-t_start;
+    }
+    
+    /*! Dump restart file on wall time or on a signal, as agreed by all ranks, and stop before the wall-time limit or on SIGTERM. */
+    
+    if (Checkpoint.get_active()) {
+      checkpoint_action = Checkpoint.poll(i_steps%FlowSol.restart_dump_freq == 0);
+      
+      if (checkpoint_action && i_steps%FlowSol.restart_dump_freq != 0) {
+        if (FlowSol.rank == 0) cout << "Checkpoint at iteration " << FlowSol.ini_iter+i_steps << endl;
+        
+        t_start = wall_time();
+#ifdef _GPU
+        CopyGPUCPU(&FlowSol);
+#endif
+        Writer.write(FlowSol.ini_iter+i_steps, 1, &FlowSol);
+        if (run_input.stats_freq) Stats.write(FlowSol.ini_iter+i_steps, &FlowSol);
+        t_restart += wall_time()-t_start;
+      }
+      
+      if (checkpoint_action == 2) {
+        if (FlowSol.rank == 0) cout << "Stopping at iteration " << FlowSol.ini_iter+i_steps << " (wall-time limit or SIGTERM)" << endl;
+        break;
+      }
     }
     
   }
@@ -241,6 +398,24 @@ int main(int argc, char *argv[]) {
   /// End simulation
   /////////////////////////////////////////////////
   
+  /*! Complete the monitoring reduction of the last step. */
+  
+  Monitor.finish(init_time, &write_hist, &FlowSol);
+  
+  /*! Write the probe samples still buffered. */
+  
+  if (run_input.probe_freq) Probes.flush();
+  
+  /*! Write the statistics, unless written with the restart file of the last step. */
+  
+  if (run_input.stats_freq && i_steps%FlowSol.restart_dump_freq != 0 && !checkpoint_action) Stats.write(FlowSol.ini_iter+i_steps, &FlowSol);
+  
+  /*! Wait for the plot and restart files still being written in the background. */
+  
+  t_start = wall_time();
+  Writer.finish();
+  t_plot += wall_time()-t_start;
+  
   /*! Close convergence history file. */
   
   if (rank == 0)
@@ -251,6 +426,13 @@ int main(int argc, char *argv[]) {
   final_time = clock()-init_time;
   printf("Execution time= %f s\n", (double) final_time/((double) CLOCKS_PER_SEC));
   
+  /*! Report the solver phase timers (used by the performance regression tests). */
+  
+  t_loop = wall_time()-t_loop;
+  TimingOutput(i_steps, t_loop, t_residual, t_update, t_monitor, t_plot, t_restart, &FlowSol);
+  
+  if (run_input.monitor_memory) MemoryReport("end of run", &FlowSol);
+  
   /*! Finalize MPI. */
   
 #ifdef _MPI
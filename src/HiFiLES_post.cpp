@@ -0,0 +1,191 @@
+/*!
+ * \file HiFiLES_post.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/funcs.h"
+#include "../include/input.h"
+#include "../include/geometry.h"
+#include "../include/solver.h"
+#include "../include/output.h"
+#include "../include/solution.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+// number of per-partition restart files of an iteration, which may differ from the partitions of this run
+
+int count_restart_files(int in_file_num)
+{
+  char file_name_s[50];
+  int n_files = 0;
+  
+  while (true) {
+    sprintf(file_name_s,"Rest_%.09d_p%.04d.dat",in_file_num,n_files);
+    ifstream restart_file(file_name_s);
+    if (!restart_file) break;
+    n_files++;
+  }
+  
+  // a shared restart file written with mpiio_output is read without the per-partition files
+  if (n_files == 0) {
+    sprintf(file_name_s,"Rest_%.09d.dat",in_file_num);
+    ifstream restart_file(file_name_s);
+    if (!restart_file) FatalError("Could not open restart file");
+  }
+  
+  return n_files;
+}
+
+/*! Standalone post-processor: rebuilds the elements of the mesh, reads the restart files
+ written by the solver (shared or one per partition) and writes Paraview or Tecplot files
+ of the same iterations, without running the solver.
+ Usage: HiFiLES_post <input file> <first restart> [<last restart> [<restart step> [<p_res>]]] */
+
+int main(int argc, char *argv[]) {
+  
+  int rank = 0;
+  int i, iter;
+  int first_iter, last_iter, iter_step;   /*!< Restart iterations to post-process */
+  ifstream run_input_file;                /*!< Config input file */
+  double t_start, t_read = 0.0, t_grad = 0.0, t_plot = 0.0; /*!< Post-processing phase timers */
+  struct solution FlowSol;                /*!< Main structure with the flow solution and geometry */
+  
+  /*! Check the command line input. */
+  
+  if (argc < 3) {
+    cout << "Usage: HiFiLES_post <input file> <first restart> [<last restart> [<restart step> [<p_res>]]]" << endl;
+    return(0);
+  }
+  
+  first_iter = atoi(argv[2]);
+  last_iter = (argc > 3) ? atoi(argv[3]) : first_iter;
+  iter_step = (argc > 4) ? atoi(argv[4]) : 1;
+  
+  /*! Initialize MPI. */
+  
+#ifdef _MPI
+  int thread_level;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_level);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+  
+  if (iter_step < 1 || last_iter < first_iter) FatalError("Invalid range of restart iterations");
+  
+  /*! Read the config file; the plot resolution may be overridden from the command line. */
+  
+  run_input_file.open(argv[1], ifstream::in);
+  if (!run_input_file) FatalError("Unable to open input file");
+  run_input.setup(run_input_file, rank);
+  
+  if (argc > 5) {
+    run_input.p_res = atoi(argv[5]);
+    if (run_input.p_res < 2) FatalError("p_res must be at least 2");
+  }
+  
+  mem_pool_set_huge_pages(run_input.huge_pages);
+  
+  /*! Set the input values in the FlowSol structure and build the elements (geometry, basis and plot operators). */
+  
+  SetInput(&FlowSol);
+  
+  GeoPreprocess(&FlowSol);
+  
+  /*! Zero body forcing term of the periodic channel, as at the start of a run. */
+  
+  if (run_input.equation == 0 && run_input.forcing == 1) {
+    FlowSol.body_force.setup(5);
+    for (i=0; i<5; i++) FlowSol.body_force(i)=0.0;
+  }
+  
+  FlowSol.inv_force.setup(5);
+  FlowSol.vis_force.setup(5);
+  FlowSol.norm_residual.setup(5);
+  FlowSol.integral_quantities.setup(run_input.n_integral_quantities);
+  
+  /*! Post-process the restart iterations. */
+  
+  for (iter=first_iter; iter<=last_iter; iter+=iter_step) {
+    
+    if (rank == 0) cout << "Post-processing restart " << iter << " ... " << endl;
+    
+    /*! Read the solution at the solution points. */
+    
+    t_start = wall_time();
+    FlowSol.ini_iter = iter;
+    read_restart(iter, count_restart_files(iter), &FlowSol);
+    
+    for (i=0; i<FlowSol.n_ele_types; i++) {
+      if (FlowSol.mesh_eles(i)->get_n_eles()!=0) {
+        FlowSol.mesh_eles(i)->set_disu_upts_to_zero_other_levels();
+#ifdef _GPU
+        FlowSol.mesh_eles(i)->cp_disu_upts_cpu_gpu();
+#endif
+      }
+    }
+    t_read += wall_time()-t_start;
+    
+    /*! The restart files hold no gradients: one residual evaluation computes the corrected
+     gradients of the viscous fields and diagnostics from the solution just read. */
+    
+    if (FlowSol.viscous) {
+      t_start = wall_time();
+      CalcResidual(&FlowSol);
+      t_grad += wall_time()-t_start;
+    }
+    
+#ifdef _GPU
+    CopyGPUCPU(&FlowSol);
+#endif
+    
+    /*! Write the Paraview or Tecplot file, numbered as the restart. */
+    
+    t_start = wall_time();
+    if (FlowSol.write_type == 0) write_vtu(iter, &FlowSol);
+    else if (FlowSol.write_type == 1) write_tec(iter, FlowSol.time, &FlowSol);
+    else if (FlowSol.write_type == 2) write_tec_bin(iter, FlowSol.time, &FlowSol);
+    else FatalError("ERROR: Trying to write unrecognized file format ... ");
+    t_plot += wall_time()-t_start;
+  }
+  
+  if (rank == 0) {
+    cout << "Read restarts: " << t_read << " s, gradients: " << t_grad << " s, plot files: " << t_plot << " s" << endl;
+  }
+  
+  /*! Finalize MPI. */
+  
+#ifdef _MPI
+  MPI_Finalize();
+#endif
+  
+}
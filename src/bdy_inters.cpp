@@ -74,6 +74,16 @@ void bdy_inters::setup(int in_n_inters, int in_inters_type)
 
 }
 
+// multi-rate levels of the faces
+
+void bdy_inters::set_lts_levels(struct solution* FlowSol)
+{
+  lts_level.setup(n_inters);
+
+  for (int i=0;i<n_inters;i++)
+    lts_level(i) = FlowSol->mesh_eles(ele_type_l(i))->get_lts_level(ele_l(i));
+}
+
 void bdy_inters::set_bdy_params()
 {
   max_bdy_params=30;
@@ -105,6 +115,10 @@ void bdy_inters::set_boundary(int in_inter, int bdy_type, int in_ele_type_l, int
 {
   boundary_type(in_inter) = bdy_type;
 
+  ele_type_l(in_inter) = in_ele_type_l;
+  ele_l(in_inter) = in_ele_l;
+  local_inter_l(in_inter) = in_local_inter_l;
+
       for(int i=0;i<n_fields;i++)
         {
           for(int j=0;j<n_fpts_per_inter;j++)
@@ -225,7 +239,7 @@ void bdy_inters::evaluate_boundaryConditions_invFlux(double time_bound) {
   array<double> u_c(n_fields);
 
 
-  for(int i=0;i<n_inters;i++)
+  for(int i=0;i<n_inters_active;i++)
     {
       for(int j=0;j<n_fpts_per_inter;j++)
         {
@@ -769,7 +783,7 @@ void bdy_inters::evaluate_boundaryConditions_viscFlux(double time_bound) {
   int bdy_spec, flux_spec;
   array<double> norm(n_dims), fn(n_fields);
 
-  for(int i=0;i<n_inters;i++)
+  for(int i=0;i<n_inters_active;i++)
     {
       /*! boundary specification */
       bdy_spec = boundary_type(i);
@@ -0,0 +1,133 @@
+/*!
+ * \file checkpoint.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <csignal>
+
+#include "../include/global.h"
+#include "../include/checkpoint.h"
+#include "../include/error.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+/*! signals received since the last checkpoint (SIGUSR1) and since the start of the run (SIGTERM) */
+static volatile sig_atomic_t checkpoint_usr1 = 0;
+static volatile sig_atomic_t checkpoint_term = 0;
+
+// record the signal, to be acted upon at the next step boundary
+
+static void checkpoint_handler(int in_signal)
+{
+  if (in_signal == SIGTERM)
+    checkpoint_term = 1;
+  else
+    checkpoint_usr1 = 1;
+}
+
+// #### constructors ####
+
+// default constructor
+
+checkpoint::checkpoint()
+{
+  active = false;
+  t_run = 0.;
+  t_last = 0.;
+  t_step = 0.;
+  max_step = 0.;
+}
+
+// default destructor
+
+checkpoint::~checkpoint() { }
+
+// #### methods ####
+
+// install the signal handlers
+
+void checkpoint::setup(double in_t_run)
+{
+  active = run_input.checkpoint_interval > 0. || run_input.wall_time_limit > 0. || run_input.checkpoint_signals;
+
+  t_run = in_t_run;
+  t_last = wall_time();
+  t_step = t_last;
+  max_step = 0.;
+
+  if (run_input.checkpoint_signals) {
+      struct sigaction action;
+
+      action.sa_handler = checkpoint_handler;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_RESTART;
+
+      if (sigaction(SIGUSR1, &action, NULL) != 0 || sigaction(SIGTERM, &action, NULL) != 0)
+        FatalError("Unable to install the checkpoint signal handlers");
+    }
+}
+
+// agree on the action of all ranks at the end of a step
+
+int checkpoint::poll(bool in_dumped)
+{
+  int request = 0;
+  double t_now = wall_time();
+
+  max_step = max(max_step,t_now-t_step);
+  t_step = t_now;
+
+  if (in_dumped)
+    t_last = t_now;
+
+  if (checkpoint_usr1 || (run_input.checkpoint_interval > 0. && t_now-t_last >= 60.*run_input.checkpoint_interval))
+    request = 1;
+
+  // Stop while the last checkpoint and a step still fit before the limit
+  if (checkpoint_term || (run_input.wall_time_limit > 0. && 60.*run_input.wall_time_limit-(t_now-t_run) < 60.*run_input.wall_time_margin+max_step))
+    request = 2;
+
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE,&request,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+#endif
+
+  if (request) {
+      checkpoint_usr1 = 0;
+      t_last = t_now;
+    }
+
+  return request;
+}
+
+// get whether checkpoints on wall time or on signals are enabled
+
+bool checkpoint::get_active(void)
+{
+  return active;
+}
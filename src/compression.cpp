@@ -0,0 +1,157 @@
+/*!
+ * \file compression.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#ifdef _ZLIB
+#include <zlib.h>
+#endif
+
+#include "../include/compression.h"
+#include "../include/error.h"
+
+using namespace std;
+
+// shuffle the bytes of in_n_items items of in_item_size bytes, byte k of item i going to k*in_n_items+i
+
+static void shuffle_bytes(const char* in_data, long in_n_items, int in_item_size, char* out_data)
+{
+  for (long i=0;i<in_n_items;i++)
+    for (int k=0;k<in_item_size;k++)
+      out_data[k*in_n_items+i] = in_data[i*in_item_size+k];
+}
+
+// compress in_n_bytes of data with zlib into out_data
+
+static void compress_bytes(const char* in_data, long in_n_bytes, string& out_data)
+{
+#ifdef _ZLIB
+  uLongf n_comp = compressBound(in_n_bytes);
+  out_data.resize(n_comp);
+  if (compress2((Bytef*) &out_data[0], &n_comp, (const Bytef*) in_data, in_n_bytes, Z_BEST_SPEED) != Z_OK)
+    FatalError("zlib compression failed");
+  out_data.resize(n_comp);
+#else
+  FatalError("Compressed output requires HiFiLES to be compiled with zlib (-D_ZLIB)");
+#endif
+}
+
+// write a compressed block
+
+void write_compressed_block(ostream& out_file, const char* in_data, long in_n_bytes, int in_item_size)
+{
+  string shuffled(in_n_bytes,'\0'), compressed;
+  
+  if (in_n_bytes > 0)
+    shuffle_bytes(in_data,in_n_bytes/in_item_size,in_item_size,&shuffled[0]);
+  compress_bytes(shuffled.data(),in_n_bytes,compressed);
+  
+  out_file << in_n_bytes << " " << compressed.size() << endl;
+  out_file.write(compressed.data(),compressed.size());
+  out_file << endl;
+}
+
+#ifdef _ZLIB
+
+// undo shuffle_bytes
+
+static void unshuffle_bytes(const char* in_data, long in_n_items, int in_item_size, char* out_data)
+{
+  for (long i=0;i<in_n_items;i++)
+    for (int k=0;k<in_item_size;k++)
+      out_data[i*in_item_size+k] = in_data[k*in_n_items+i];
+}
+
+#endif
+
+// read a compressed block
+
+void read_compressed_block(istream& in_file, char* out_data, long in_n_bytes, int in_item_size)
+{
+#ifdef _ZLIB
+  long n_raw, n_comp;
+  
+  in_file >> n_raw >> n_comp;
+  if (!in_file || n_raw != in_n_bytes || n_comp < 0)
+    FatalError("Corrupt compressed block in restart file");
+  in_file.ignore(1);
+  
+  string compressed(n_comp,'\0'), shuffled(n_raw,'\0');
+  if (n_comp > 0) in_file.read(&compressed[0],n_comp);
+  if (in_file.gcount() != n_comp)
+    FatalError("Truncated compressed block in restart file");
+  in_file.ignore(1);
+  
+  uLongf n_uncomp = n_raw;
+  if (uncompress((Bytef*) &shuffled[0], &n_uncomp, (const Bytef*) compressed.data(), n_comp) != Z_OK || (long) n_uncomp != n_raw)
+    FatalError("zlib decompression of restart file failed");
+  
+  if (n_raw > 0)
+    unshuffle_bytes(shuffled.data(),n_raw/in_item_size,in_item_size,out_data);
+#else
+  FatalError("Compressed restart files require HiFiLES to be compiled with zlib (-D_ZLIB)");
+#endif
+}
+
+// base64 encode in_n_bytes of data
+
+static void write_base64(ostream& out_file, const unsigned char* in_data, long in_n_bytes)
+{
+  static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  string text((in_n_bytes+2)/3*4,'=');
+  
+  for (long i=0,j=0;i<in_n_bytes;i+=3,j+=4) {
+    unsigned int word = in_data[i] << 16;
+    if (i+1 < in_n_bytes) word |= in_data[i+1] << 8;
+    if (i+2 < in_n_bytes) word |= in_data[i+2];
+    text[j] = table[(word >> 18) & 63];
+    text[j+1] = table[(word >> 12) & 63];
+    if (i+1 < in_n_bytes) text[j+2] = table[(word >> 6) & 63];
+    if (i+2 < in_n_bytes) text[j+3] = table[word & 63];
+  }
+  
+  out_file << text;
+}
+
+// write a binary VTK DataArray body: the header (one block, its raw and compressed sizes) and the compressed block, base64 encoded separately
+
+void write_vtu_binary(ostream& out_file, const char* in_data, long in_n_bytes)
+{
+  string compressed;
+  unsigned int header[4];
+  
+  compress_bytes(in_data,in_n_bytes,compressed);
+  
+  header[0] = 1;
+  header[1] = in_n_bytes;
+  header[2] = in_n_bytes;
+  header[3] = compressed.size();
+  
+  write_base64(out_file,(const unsigned char*) header,sizeof(header));
+  write_base64(out_file,(const unsigned char*) compressed.data(),compressed.size());
+  out_file << endl;
+}
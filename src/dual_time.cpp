@@ -0,0 +1,204 @@
+/*!
+ * \file dual_time.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cmath>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/dual_time.h"
+#include "../include/solver.h"
+#include "../include/error.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+// #### constructors ####
+
+// default constructor
+
+dual_time::dual_time()
+{
+  n_ele_types = 0;
+  n_steps = 0;
+  mg = NULL;
+}
+
+// default destructor
+
+dual_time::~dual_time() { }
+
+// #### methods ####
+
+// allocate storage
+
+void dual_time::setup(struct solution* FlowSol, p_multigrid* in_mg)
+{
+#ifdef _GPU
+  FatalError("Dual time stepping is only implemented on the CPU");
+#endif
+
+  int i, n_dofs;
+
+  if (FlowSol->adv_type != 0 && FlowSol->adv_type != 3)
+    FatalError("Dual time stepping iterates in pseudo time with the explicit RK schemes, use adv_type 0 or 3");
+
+  if (run_input.dt_type != 2)
+    FatalError("Dual time stepping uses local pseudo time steps, use dt_type 2 (dt sets the physical time step)");
+
+  if (run_input.dt <= 0.0)
+    FatalError("Dual time stepping needs a positive physical time step dt");
+
+  if (run_input.dual_max_inner < 1)
+    FatalError("dual_max_inner must be at least 1");
+
+  n_ele_types = FlowSol->n_ele_types;
+  n_rk_steps = FlowSol->rk.get_n_stages();
+  n_steps = 0;
+  mg = in_mg;
+
+  u_n.setup(n_ele_types);
+  u_nm1.setup(n_ele_types);
+
+  for (i=0;i<n_ele_types;i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0) {
+        n_dofs = FlowSol->mesh_eles(i)->get_n_upts_per_ele()*FlowSol->mesh_eles(i)->get_n_eles()*FlowSol->mesh_eles(i)->get_n_fields();
+
+        u_n(i).setup(n_dofs);
+        u_nm1(i).setup(n_dofs);
+        u_n(i).set_tag("dual/history");
+        u_nm1(i).set_tag("dual/history");
+      }
+}
+
+// one physical time step
+
+void dual_time::advance(struct solution* FlowSol)
+{
+  int i, j, k, n_dofs;
+  double coeff, res_norm = 0.0, res_norm_0 = 0.0;
+  double dt = run_input.dt;
+
+  n_steps++;
+
+  // Shift the time levels, and form the explicit part of the BDF time derivative,
+  // (4u^n - u^(n-1))/(2 dt) for BDF2 or u^n/dt for BDF1 on the first step
+  for (i=0;i<n_ele_types;i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0) {
+        double* u = FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu();
+        double* src = FlowSol->mesh_eles(i)->get_dual_src_upts_ptr_cpu();
+        n_dofs = u_n(i).get_dim(0);
+
+        for (j=0;j<n_dofs;j++) {
+            if (n_steps > 1)
+              u_nm1(i)(j) = u_n(i)(j);
+            u_n(i)(j) = u[j];
+          }
+
+        if (n_steps > 1)
+          for (j=0;j<n_dofs;j++)
+            src[j] = (2.0*u_n(i)(j)-0.5*u_nm1(i)(j))/dt;
+        else
+          for (j=0;j<n_dofs;j++)
+            src[j] = u_n(i)(j)/dt;
+      }
+
+  coeff = (n_steps > 1) ? 1.5/dt : 1.0/dt;
+
+  if (mg != NULL)
+    mg->set_dual_time_coeff(coeff);
+  else
+    for (i=0;i<n_ele_types;i++)
+      if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+        FlowSol->mesh_eles(i)->set_dual_time_coeff(coeff);
+
+  // Pseudo time iterations, measured against the residual after the first one
+  for (k=0;k<run_input.dual_max_inner;k++)
+    {
+      iterate(FlowSol);
+
+      res_norm = calc_res_norm(FlowSol);
+      if (isnan(res_norm))
+        FatalError("NaN residual encountered in the dual time iterations. Exiting");
+
+      if (k == 0)
+        res_norm_0 = res_norm;
+      else if (res_norm <= run_input.dual_inner_tol*res_norm_0)
+        break;
+    }
+
+  if (FlowSol->rank == 0 && (n_steps == 1 || n_steps%run_input.monitor_res_freq == 0))
+    cout << "Dual time step " << n_steps << ": " << min(k+1,run_input.dual_max_inner) << " pseudo time iterations, unsteady residual "
+         << res_norm_0 << " -> " << res_norm << endl;
+}
+
+// one pseudo time iteration: a p-multigrid cycle, or one step of the RK scheme on the unsteady residual
+
+void dual_time::iterate(struct solution* FlowSol)
+{
+  int i, j;
+
+  if (mg != NULL) {
+      mg->cycle(FlowSol);
+      return;
+    }
+
+  CalcTimeStep(FlowSol);
+
+  for (i=0;i<n_rk_steps;i++)
+    {
+      CalcResidual(FlowSol);
+
+      for (j=0;j<n_ele_types;j++)
+        if (FlowSol->mesh_eles(j)->get_n_eles() != 0) {
+            FlowSol->mesh_eles(j)->add_dual_time_source();
+            FlowSol->mesh_eles(j)->AdvanceSolution(i,FlowSol->adv_type);
+          }
+    }
+}
+
+// global L2 norm of the unsteady residual
+
+double dual_time::calc_res_norm(struct solution* FlowSol)
+{
+  int i, j;
+  double sum = 0.0;
+
+  for (i=0;i<n_ele_types;i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      for (j=0;j<FlowSol->mesh_eles(i)->get_n_fields();j++)
+        sum += FlowSol->mesh_eles(i)->compute_res_upts(2,j);
+
+#ifdef _MPI
+  double sum_global = 0.0;
+  MPI_Allreduce(&sum, &sum_global, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  sum = sum_global;
+#endif
+
+  return sqrt(sum);
+}
@@ -0,0 +1,274 @@
+/*!
+ * \file element_index.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/element_index.h"
+#include "../include/error.h"
+
+using namespace std;
+
+/*! largest number of items in a leaf of the hierarchy */
+#define INDEX_LEAF_SIZE 8
+
+// orders items by the centre of their bounding box along one axis
+
+struct index_centre_less
+{
+  const double* lo;
+  const double* hi;
+  int n_dims;
+  int axis;
+
+  bool operator()(int a, int b) const
+  {
+    return lo[a*n_dims+axis]+hi[a*n_dims+axis] < lo[b*n_dims+axis]+hi[b*n_dims+axis];
+  }
+};
+
+// #### constructors ####
+
+// default constructor
+
+element_index::element_index()
+{
+  n_dims = 0;
+  n_items = 0;
+  n_nodes = 0;
+}
+
+// default destructor
+
+element_index::~element_index() { }
+
+// #### methods ####
+
+// index the elements by the bounding boxes of their plot points
+
+void element_index::setup(struct solution* FlowSol)
+{
+  int item;
+
+  n_dims = FlowSol->n_dims;
+
+  n_items = 0;
+  for (int i=0; i<FlowSol->n_ele_types; i++)
+    n_items += FlowSol->mesh_eles(i)->get_n_eles();
+
+  if (n_items == 0)
+    return;
+
+  item_type.setup(n_items);
+  item_ele.setup(n_items);
+  item_order.setup(n_items);
+  item_lo.setup(n_dims,n_items);
+  item_hi.setup(n_dims,n_items);
+
+  item = 0;
+  for (int i=0; i<FlowSol->n_ele_types; i++) {
+      int n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+      if (n_eles == 0)
+        continue;
+
+      int n_ppts = FlowSol->mesh_eles(i)->get_n_ppts_per_ele();
+      array<double>& pos = FlowSol->mesh_eles(i)->get_pos_ppts();
+
+      for (int j=0; j<n_eles; j++) {
+          item_type(item) = i;
+          item_ele(item) = j;
+          item_order(item) = item;
+          for (int m=0; m<n_dims; m++) {
+              item_lo(m,item) = DBL_MAX;
+              item_hi(m,item) = -DBL_MAX;
+              for (int k=0; k<n_ppts; k++) {
+                  item_lo(m,item) = min(item_lo(m,item),pos(k,j,m));
+                  item_hi(m,item) = max(item_hi(m,item),pos(k,j,m));
+                }
+            }
+          item++;
+        }
+    }
+
+  // a binary tree has fewer than 2*n_items nodes
+  node_lo.setup(n_dims,2*n_items);
+  node_hi.setup(n_dims,2*n_items);
+  node_left.setup(2*n_items);
+  node_right.setup(2*n_items);
+  node_first.setup(2*n_items);
+  node_count.setup(2*n_items);
+
+  n_nodes = 0;
+  build(0,n_items);
+}
+
+// number of indexed elements
+
+int element_index::get_n_items(void)
+{
+  return n_items;
+}
+
+// element type of an item
+
+int element_index::get_type(int in_item)
+{
+  return item_type(in_item);
+}
+
+// element of an item, within its type
+
+int element_index::get_ele(int in_item)
+{
+  return item_ele(in_item);
+}
+
+// build the node over a range of item_order, splitting at the median along the longest axis
+
+int element_index::build(int in_first, int in_n)
+{
+  int node = n_nodes++;
+  int axis = 0;
+
+  for (int m=0; m<n_dims; m++) {
+      node_lo(m,node) = DBL_MAX;
+      node_hi(m,node) = -DBL_MAX;
+      for (int k=in_first; k<in_first+in_n; k++) {
+          node_lo(m,node) = min(node_lo(m,node),item_lo(m,item_order(k)));
+          node_hi(m,node) = max(node_hi(m,node),item_hi(m,item_order(k)));
+        }
+      if (node_hi(m,node)-node_lo(m,node) > node_hi(axis,node)-node_lo(axis,node))
+        axis = m;
+    }
+
+  node_first(node) = in_first;
+  node_count(node) = in_n;
+  node_left(node) = -1;
+  node_right(node) = -1;
+
+  if (in_n <= INDEX_LEAF_SIZE)
+    return node;
+
+  index_centre_less less;
+  less.lo = item_lo.get_ptr_cpu();
+  less.hi = item_hi.get_ptr_cpu();
+  less.n_dims = n_dims;
+  less.axis = axis;
+
+  int* order = item_order.get_ptr_cpu();
+  nth_element(order+in_first,order+in_first+in_n/2,order+in_first+in_n,less);
+
+  int left = build(in_first,in_n/2);
+  int right = build(in_first+in_n/2,in_n-in_n/2);
+  node_left(node) = left;
+  node_right(node) = right;
+
+  return node;
+}
+
+// items whose bounding box is crossed by a plane
+
+void element_index::query_plane(double* in_norm, double in_dist, array<int>& out_items, int& out_n_items)
+{
+  out_n_items = 0;
+  if (n_items > 0)
+    query_plane_node(0,in_norm,in_dist,out_items,out_n_items);
+}
+
+// items whose grown bounding box contains a point
+
+void element_index::query_point(double* in_pos, double in_tol, array<int>& out_items, int& out_n_items)
+{
+  out_n_items = 0;
+  if (n_items > 0)
+    query_point_node(0,in_pos,in_tol,out_items,out_n_items);
+}
+
+// plane query below a node: a plane crosses a box when the distance of its centre is within the projection of its half extent
+
+void element_index::query_plane_node(int in_node, double* in_norm, double in_dist, array<int>& out_items, int& io_n_items)
+{
+  double centre, radius;
+
+  centre = -in_dist;
+  radius = 0.;
+  for (int m=0; m<n_dims; m++) {
+      centre += in_norm[m]*0.5*(node_lo(m,in_node)+node_hi(m,in_node));
+      radius += fabs(in_norm[m])*0.5*(node_hi(m,in_node)-node_lo(m,in_node));
+    }
+  if (fabs(centre) > radius)
+    return;
+
+  if (node_left(in_node) >= 0) {
+      query_plane_node(node_left(in_node),in_norm,in_dist,out_items,io_n_items);
+      query_plane_node(node_right(in_node),in_norm,in_dist,out_items,io_n_items);
+      return;
+    }
+
+  for (int k=node_first(in_node); k<node_first(in_node)+node_count(in_node); k++) {
+      int item = item_order(k);
+      centre = -in_dist;
+      radius = 0.;
+      for (int m=0; m<n_dims; m++) {
+          centre += in_norm[m]*0.5*(item_lo(m,item)+item_hi(m,item));
+          radius += fabs(in_norm[m])*0.5*(item_hi(m,item)-item_lo(m,item));
+        }
+      if (fabs(centre) <= radius)
+        out_items(io_n_items++) = item;
+    }
+}
+
+// point query below a node
+
+void element_index::query_point_node(int in_node, double* in_pos, double in_tol, array<int>& out_items, int& io_n_items)
+{
+  for (int m=0; m<n_dims; m++) {
+      double grow = in_tol*(node_hi(m,in_node)-node_lo(m,in_node));
+      if (in_pos[m] < node_lo(m,in_node)-grow || in_pos[m] > node_hi(m,in_node)+grow)
+        return;
+    }
+
+  if (node_left(in_node) >= 0) {
+      query_point_node(node_left(in_node),in_pos,in_tol,out_items,io_n_items);
+      query_point_node(node_right(in_node),in_pos,in_tol,out_items,io_n_items);
+      return;
+    }
+
+  for (int k=node_first(in_node); k<node_first(in_node)+node_count(in_node); k++) {
+      int item = item_order(k);
+      bool inside = true;
+      for (int m=0; m<n_dims; m++) {
+          double grow = in_tol*(item_hi(m,item)-item_lo(m,item));
+          if (in_pos[m] < item_lo(m,item)-grow || in_pos[m] > item_hi(m,item)+grow)
+            inside = false;
+        }
+      if (inside)
+        out_items(io_n_items++) = item;
+    }
+}
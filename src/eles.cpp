@@ -26,6 +26,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <cstring>
 
 #if defined _ACCELERATE_BLAS
 #include <Accelerate/Accelerate.h>
@@ -61,6 +62,7 @@ extern "C"
 #include "../include/flux.h"
 #include "../include/eles.h"
 #include "../include/funcs.h"
+#include "../include/compression.h"
 
 using namespace std;
 
@@ -84,6 +86,9 @@ void eles::setup(int in_n_eles, int in_max_n_spts_per_ele)
 {
   
   n_eles=in_n_eles;
+  n_eles_active=in_n_eles;
+  lin_affine=0;
+  out_buf=-1;
   
   if (n_eles!=0)
   {
@@ -124,11 +129,18 @@ void eles::setup(int in_n_eles, int in_max_n_spts_per_ele)
     {
       n_adv_levels=2;
     }
+    else if(run_input.adv_type==4)
+    {
+      n_adv_levels=1;
+    }
     else
     {
       cout << "ERROR: Type of time integration scheme not recongized ... " << endl;
     }
     
+    // Coefficient tables of the RK scheme
+    rk.setup(run_input.adv_type == 3 ? run_input.rk_scheme : 0);
+    
     // Allocate storage for solution
     disu_upts.setup(n_adv_levels);
     for(int i=0;i<n_adv_levels;i++)
@@ -136,6 +148,20 @@ void eles::setup(int in_n_eles, int in_max_n_spts_per_ele)
       disu_upts(i).setup(n_upts_per_ele,n_eles,n_fields);
     }
     
+    // Residual norms accumulated by the time step
+    if (run_input.res_norm_fused)
+    {
+      res_norm_sum.setup(n_fields);
+      res_norm_sum.initialize_to_zero();
+    }
+    
+    // Error estimate of adaptive time stepping, and the solution to return to if the step is rejected
+    if (run_input.rk_adapt)
+    {
+      rk_err_upts.setup(n_upts_per_ele,n_eles,n_fields);
+      rk_save_upts.setup(n_upts_per_ele,n_eles,n_fields);
+    }
+    
     // Allocate storage for timestep
     // If using global minimum, only one timestep
     if (run_input.dt_type == 1)
@@ -144,39 +170,21 @@ void eles::setup(int in_n_eles, int in_max_n_spts_per_ele)
     else
       dt_local.setup(n_eles);
     
-    // If in parallel and using global minumum timestep, allocate storage
-    // for minimum timesteps in each partition
-#ifdef _MPI
-    if (run_input.dt_type == 1)
-    {
-      MPI_Comm_size(MPI_COMM_WORLD,&nproc);
-      dt_local_mpi.setup(nproc);
-      dt_local_mpi.initialize_to_zero();
-    }
-#endif
-    
     // Initialize to zero
     for (int m=0;m<n_adv_levels;m++)
       disu_upts(m).initialize_to_zero();
     
-    // Allocate storage for time-averaged diagnostic fields
-    n_diagnostic_fields = run_input.n_diagnostic_fields;
-    
-    for(int i=0;i<n_diagnostic_fields;++i) {
-      if(run_input.diagnostic_fields(i) == "u_average") {
-        u_average.setup(n_upts_per_ele,n_eles);
-        u_average.initialize_to_zero();
-      }
-      else if(run_input.diagnostic_fields(i) == "v_average") {
-        v_average.setup(n_upts_per_ele,n_eles);
-        v_average.initialize_to_zero();
-      }
-      else if(run_input.diagnostic_fields(i) == "w_average") {
-        w_average.setup(n_upts_per_ele,n_eles);
-        w_average.initialize_to_zero();
-      }
+    // Allocate storage for the physical time derivative of dual time stepping
+    dual_coeff = 0.;
+    if (run_input.dual_time)
+    {
+      dual_src_upts.setup(n_upts_per_ele,n_eles,n_fields);
+      dual_src_upts.initialize_to_zero();
     }
     
+    // Time-averaged fields are kept by the running statistics (stats_freq), not as diagnostic fields
+    n_diagnostic_fields = run_input.n_diagnostic_fields;
+    
     // Allocate extra arrays for LES models
     if(LES) {
       
@@ -246,8 +254,22 @@ void eles::setup(int in_n_eles, int in_max_n_spts_per_ele)
     
     set_shape(in_max_n_spts_per_ele);
     ele2global_ele.setup(n_eles);
+    ele_color.setup(n_eles);
+    ele_color.initialize_to_zero();
     bctype.setup(n_eles,n_inters_per_ele);
     
+    // Allocate the levels of multi-rate time stepping, all elements at level 0 until set
+    lts_max_active = -1;
+    lts_dt_base = 0.;
+    lts_weight = 0.;
+    if (run_input.dt_type == 3)
+    {
+      lts_level.setup(n_eles);
+      lts_level.initialize_to_zero();
+      lts_nb_level.setup(n_inters_per_ele,n_eles);
+      lts_nb_level.initialize_to_zero();
+    }
+    
     // for mkl sparse blas
     matdescra[0]='G';
     matdescra[3]='F';
@@ -287,6 +309,10 @@ void eles::setup(int in_n_eles, int in_max_n_spts_per_ele)
       connectivity_plot.setup(n_verts_per_ele,n_peles_per_ele);
     
     set_connectivity_plot();
+    
+    // Modal transform of the lossy restart compression
+    if (run_input.restart_compression == 2)
+      set_modal_quantization();
   }
   
 }
@@ -492,7 +518,7 @@ void eles::set_ics(double& time)
 // set initial conditions
 
 
-void eles::read_restart_data(ifstream& restart_file)
+void eles::read_restart_data(istream& restart_file)
 {
   
   if (n_eles==0) return;
@@ -531,32 +557,93 @@ void eles::read_restart_data(ifstream& restart_file)
   array<double> disu_upts_rest;
   disu_upts_rest.setup(n_upts_per_ele_rest,n_fields);
   
+  // Compressed data follows a "compressed_data <mode>" line in place of "data"
+  int compression = 0;
+  array<int> ele_rest;
+  array<double> data_rest, step_rest, vandermonde_rest;
+  array<long long> quant_rest;
+  array<int> degree_rest;
+  
+  if (str.compare(0,15,"compressed_data") == 0)
+  {
+    compression = atoi(str.c_str()+15);
+    
+    ele_rest.setup(num_eles_to_read);
+    read_compressed_block(restart_file,(char*) ele_rest.get_ptr_cpu(),num_eles_to_read*sizeof(int),sizeof(int));
+    
+    if (compression == 1)
+    {
+      data_rest.setup(n_upts_per_ele_rest,n_fields,num_eles_to_read);
+      read_compressed_block(restart_file,(char*) data_rest.get_ptr_cpu(),num_eles_to_read*n_fields*n_upts_per_ele_rest*sizeof(double),sizeof(double));
+    }
+    else if (compression == 2)
+    {
+      step_rest.setup(n_fields,num_eles_to_read);
+      quant_rest.setup(n_upts_per_ele_rest,n_fields,num_eles_to_read);
+      read_compressed_block(restart_file,(char*) step_rest.get_ptr_cpu(),num_eles_to_read*n_fields*sizeof(double),sizeof(double));
+      read_compressed_block(restart_file,(char*) quant_rest.get_ptr_cpu(),num_eles_to_read*n_fields*n_upts_per_ele_rest*sizeof(long long),sizeof(long long));
+      calc_modal_vandermonde(loc_upts,order_rest,n_upts_per_ele_rest,vandermonde_rest,degree_rest);
+    }
+    else
+      FatalError("Unknown compression of restart file");
+  }
+  
   for (int i=0;i<num_eles_to_read;i++)
   {
-    restart_file >> ele ;
+    if (compression) ele = ele_rest(i);
+    else restart_file >> ele ;
     index = index_locate_int(ele,ele2global_ele.get_ptr_cpu(),n_eles);
     
     if (index!=-1) // Ele belongs to processor
     {
-      for (int j=0;j<n_upts_per_ele_rest;j++)
+      if (compression == 2)
+      {
+        // Dequantize the modal coefficients, mode m in steps of step*2^degree(m), and evaluate the
+        // polynomial of the restart order at the solution points (which is what opp_r does for nodal data)
         for (int k=0;k<n_fields;k++)
-          restart_file >> disu_upts_rest(j,k);
-      
-      // Now compute transformed solution at solution points using opp_r
-      for (int m=0;m<n_fields;m++)
+          for (int j=0;j<n_upts_per_ele;j++)
+          {
+            double value = 0.;
+            for (int m=0;m<n_upts_per_ele_rest;m++)
+            {
+              unsigned long long zigzag = quant_rest(m,k,i);
+              long long quant = (long long) (zigzag >> 1) ^ -(long long) (zigzag & 1);
+              value += vandermonde_rest(j,m)*ldexp(step_rest(k,i)*quant,degree_rest(m));
+            }
+            disu_upts(0)(j,index,k) = value;
+          }
+      }
+      else
       {
-        for (int j=0;j<n_upts_per_ele;j++)
+        if (compression == 1)
         {
-          double value = 0.;
-          for (int k=0;k<n_upts_per_ele_rest;k++)
-            value += opp_r(j,k)*disu_upts_rest(k,m);
-          
-          disu_upts(0)(j,index,m) = value;
+          for (int j=0;j<n_upts_per_ele_rest;j++)
+            for (int k=0;k<n_fields;k++)
+              disu_upts_rest(j,k) = data_rest(j,k,i);
+        }
+        else
+        {
+          for (int j=0;j<n_upts_per_ele_rest;j++)
+            for (int k=0;k<n_fields;k++)
+              restart_file >> disu_upts_rest(j,k);
+        }
+        
+        // Now compute transformed solution at solution points using opp_r
+        for (int m=0;m<n_fields;m++)
+        {
+          for (int j=0;j<n_upts_per_ele;j++)
+          {
+            double value = 0.;
+            for (int k=0;k<n_upts_per_ele_rest;k++)
+              value += opp_r(j,k)*disu_upts_rest(k,m);
+            
+            disu_upts(0)(j,index,m) = value;
+          }
         }
       }
       
     }
-    else // Skip the data (doesn't belong to current processor)
+    else if (!compression) // Skip the data (doesn't belong to current processor)
     {
       // Skip rest of ele line
       getline(restart_file,str);
@@ -579,8 +666,10 @@ void eles::read_restart_data(ifstream& restart_file)
 }
 
 
-void eles::write_restart_data(ofstream& restart_file)
+void eles::write_restart_data(ostream& restart_file)
 {
+  array<double>& disu_src = (out_buf < 0) ? disu_upts(0) : disu_upts_out(out_buf);
+  
   restart_file << "n_eles" << endl;
   restart_file << n_eles << endl;
   restart_file << "ele2global_ele array" << endl;
@@ -588,6 +677,12 @@ void eles::write_restart_data(ofstream& restart_file)
     restart_file << ele2global_ele(i) << " ";
   restart_file << endl;
   
+  if (run_input.restart_compression)
+  {
+    write_compressed_restart_data(restart_file,disu_src);
+    return;
+  }
+  
   restart_file << "data" << endl;
   
   for (int i=0;i<n_eles;i++)
@@ -597,7 +692,7 @@ void eles::write_restart_data(ofstream& restart_file)
     {
       for (int k=0;k<n_fields;k++)
       {
-        restart_file << disu_upts(0)(j,i,k) << " ";
+        restart_file << disu_src(j,i,k) << " ";
       }
       restart_file << endl;
     }
@@ -605,6 +700,172 @@ void eles::write_restart_data(ofstream& restart_file)
   restart_file << endl;
 }
 
+// write the restart data as compressed blocks: the element numbers, then the solution (lossless), or the quantization steps and quantized modal coefficients (lossy)
+
+void eles::write_compressed_restart_data(ostream& restart_file, array<double>& in_disu)
+{
+  int i,j,k,m;
+  
+  restart_file << "compressed_data " << run_input.restart_compression << endl;
+  
+  write_compressed_block(restart_file,(char*) ele2global_ele.get_ptr_cpu(),n_eles*sizeof(int),sizeof(int));
+  
+  if (run_input.restart_compression == 1)
+  {
+    array<double> data(n_upts_per_ele,n_fields,n_eles);
+    
+    for (i=0;i<n_eles;i++)
+      for (k=0;k<n_fields;k++)
+        for (j=0;j<n_upts_per_ele;j++)
+          data(j,k,i) = in_disu(j,i,k);
+    
+    write_compressed_block(restart_file,(char*) data.get_ptr_cpu(),n_eles*n_fields*n_upts_per_ele*sizeof(double),sizeof(double));
+  }
+  else
+  {
+    array<double> step(n_fields,n_eles);
+    array<long long> quant(n_upts_per_ele,n_fields,n_eles);
+    
+    for (i=0;i<n_eles;i++)
+    {
+      for (k=0;k<n_fields;k++)
+      {
+        // Step of mode 0, from the error bound relative to the largest value of the field in the element
+        double max_value = 0.;
+        for (j=0;j<n_upts_per_ele;j++)
+          max_value = max(max_value,fabs(in_disu(j,i,k)));
+        step(k,i) = run_input.restart_compression_tol*max_value*modal_step_factor;
+        
+        for (m=0;m<n_upts_per_ele;m++)
+        {
+          long long value = 0;
+          if (step(k,i) > 0.)
+          {
+            double coeff = 0.;
+            for (j=0;j<n_upts_per_ele;j++)
+              coeff += inv_modal_vandermonde(m,j)*in_disu(j,i,k);
+            value = llround(ldexp(coeff/step(k,i),-modal_degree(m)));
+          }
+          
+          // Zigzag encoding keeps small coefficients of either sign small
+          quant(m,k,i) = (long long) (((unsigned long long) value << 1) ^ (unsigned long long) (value >> 63));
+        }
+      }
+    }
+    
+    write_compressed_block(restart_file,(char*) step.get_ptr_cpu(),n_eles*n_fields*sizeof(double),sizeof(double));
+    write_compressed_block(restart_file,(char*) quant.get_ptr_cpu(),n_eles*n_fields*n_upts_per_ele*sizeof(long long),sizeof(long long));
+  }
+  restart_file << endl;
+}
+
+// polynomial degree of each mode of the modal (orthogonal polynomial) basis of order in_order
+
+void eles::calc_modal_degree(int in_order, int in_n_modes, array<int>& out_degree)
+{
+  int m,a,b,c;
+  int n_tri = ((in_order+1)*(in_order+2))/2;
+  
+  out_degree.setup(in_n_modes);
+  
+  for (m=0;m<in_n_modes;m++)
+  {
+    if (ele_type==0 || ele_type==2) // tris and tets: Dubiner basis ordered by degree
+    {
+      a = 0;
+      for (b=0,c=0;c<=m;b++)
+      {
+        a = b;
+        c += (ele_type==0) ? b+1 : ((b+1)*(b+2))/2;
+      }
+      out_degree(m) = a;
+    }
+    else if (ele_type==1 || ele_type==4) // quads and hexas: tensor products of Legendre polynomials
+    {
+      a = m%(in_order+1);
+      b = (m/(in_order+1))%(in_order+1);
+      c = (ele_type==4) ? m/((in_order+1)*(in_order+1)) : 0;
+      out_degree(m) = max(a,max(b,c));
+    }
+    else // prisms: Dubiner basis of the triangle times Legendre polynomial
+    {
+      a = 0;
+      for (b=0,c=0;c<=m%n_tri;b++)
+      {
+        a = b;
+        c += b+1;
+      }
+      out_degree(m) = max(a,m/n_tri);
+    }
+  }
+}
+
+// modal (orthogonal polynomial) basis of order in_order at the points in_loc (the restart order
+// at the current solution points when decoding, which the square vandermonde matrices do not cover)
+
+void eles::calc_modal_vandermonde(array<double>& in_loc, int in_order, int in_n_modes, array<double>& out_vandermonde, array<int>& out_degree)
+{
+  int i,m;
+  int n_pts = in_loc.get_dim(1);
+  int n_tri = ((in_order+1)*(in_order+2))/2;
+  
+  calc_modal_degree(in_order,in_n_modes,out_degree);
+  out_vandermonde.setup(n_pts,in_n_modes);
+  
+  for (m=0;m<in_n_modes;m++)
+  {
+    for (i=0;i<n_pts;i++)
+    {
+      if (ele_type==0)
+        out_vandermonde(i,m) = eval_dubiner_basis_2d(in_loc(0,i),in_loc(1,i),m,in_order);
+      else if (ele_type==2)
+        out_vandermonde(i,m) = eval_dubiner_basis_3d(in_loc(0,i),in_loc(1,i),in_loc(2,i),m,in_order);
+      else if (ele_type==3)
+        out_vandermonde(i,m) = eval_dubiner_basis_2d(in_loc(0,i),in_loc(1,i),m%n_tri,in_order)*eval_legendre(in_loc(2,i),m/n_tri);
+      else
+      {
+        out_vandermonde(i,m) = eval_legendre(in_loc(0,i),m%(in_order+1))*eval_legendre(in_loc(1,i),(m/(in_order+1))%(in_order+1));
+        if (ele_type==4)
+          out_vandermonde(i,m) *= eval_legendre(in_loc(2,i),m/((in_order+1)*(in_order+1)));
+      }
+    }
+  }
+}
+
+// modal basis at the solution points and its inverse; quads, hexas and prisms only keep 1D or triangle vandermonde matrices
+
+void eles::get_modal_vandermonde(array<double>& out_vandermonde, array<double>& out_inv_vandermonde)
+{
+  array<int> degree;
+  
+  calc_modal_vandermonde(loc_upts,order,n_upts_per_ele,out_vandermonde,degree);
+  out_inv_vandermonde = inv_array(out_vandermonde);
+}
+
+// set the modal transform of the lossy restart compression
+
+void eles::set_modal_quantization(void)
+{
+  int i,m;
+  array<double> vandermonde;
+  
+  calc_modal_degree(order,n_upts_per_ele,modal_degree);
+  get_modal_vandermonde(vandermonde,inv_modal_vandermonde);
+  
+  // Mode m is quantized in steps of step*2^degree(m), so the high modes keep fewer bits. With
+  // rounding errors of at most half a step, the error at solution point i is bounded by
+  // step/2*sum_m |V(i,m)|*2^degree(m), and the step is chosen to make this the tolerance.
+  double error_factor = 0.;
+  for (i=0;i<n_upts_per_ele;i++)
+  {
+    double sum = 0.;
+    for (m=0;m<n_upts_per_ele;m++)
+      sum += ldexp(fabs(vandermonde(i,m)),modal_degree(m));
+    error_factor = max(error_factor,sum);
+  }
+  modal_step_factor = 2./error_factor;
+}
+
 // move all to from cpu to gpu
 
 void eles::mv_all_cpu_gpu(void)
@@ -744,9 +1005,31 @@ void eles::rm_detjac_upts_cpu(void)
 #endif
 }
 
+// add the residual at a solution point to a cell's infinity norm (0), sum of magnitudes (1) or sum of squares (2)
+
+static inline void add_res_norm(double& inout_sum, double in_res, int in_norm_type)
+{
+  if (in_norm_type == 0)
+    inout_sum = max(inout_sum,fabs(in_res));
+  else if (in_norm_type == 1)
+    inout_sum += fabs(in_res);
+  else
+    inout_sum += in_res*in_res;
+}
+
+// add a cell's contribution to a field's residual norm
+
+static inline void add_cell_res_norm(double& inout_sum, double in_cell_sum, int in_norm_type)
+{
+  if (in_norm_type == 0)
+    inout_sum = max(inout_sum,in_cell_sum);
+  else
+    inout_sum += in_cell_sum;
+}
+
 // advance solution
 
-void eles::AdvanceSolution(int in_step, int adv_type) {
+void eles::AdvanceSolution(int in_step, int adv_type, int in_acc_res) {
   
   if (n_eles!=0)
   {
@@ -763,47 +1046,24 @@ void eles::AdvanceSolution(int in_step, int adv_type) {
        */
       
 #ifdef _CPU
-      // If using global minimum timestep based on CFL, determine
-      // global minimum
-      if (run_input.dt_type == 1)
-      {
-        // Find minimum timestep
-        dt_local(0) = 1e12; // Set to large value
-        
-        for (int ic=0; ic<n_eles; ic++)
-        {
-          dt_local_new = calc_dt_local(ic);
-          
-          if (dt_local_new < dt_local(0))
-            dt_local(0) = dt_local_new;
-        }
-        
-        // If running in parallel, gather minimum timestep values from
-        // each partition and find global minumum across partitions
-#ifdef _MPI
-        MPI_Barrier(MPI_COMM_WORLD);
-        MPI_Allgather(&dt_local(0),1,MPI_DOUBLE,dt_local_mpi.get_ptr_cpu(),
-                      1, MPI_DOUBLE, MPI_COMM_WORLD);
-        MPI_Barrier(MPI_COMM_WORLD);
-        
-        dt_local(0) = dt_local_mpi.get_min();
-#endif
-      }
+      // The time steps of dt_type 1 and 2 are set by CalcTimeStep before the step
       
-      // If using local timestepping, just compute and store all local
-      // timesteps
-      if (run_input.dt_type == 2)
-      {
-        for (int ic=0; ic<n_eles; ic++)
-          dt_local(ic) = calc_dt_local(ic);
-      }
+      // Residual norms of a monitored step, accumulated while the update streams the residual
+      int acc_res = (run_input.res_norm_fused && in_acc_res);
+      double cell_res;
+      if (acc_res)
+        res_norm_sum.initialize_to_zero();
       
       for (int i=0;i<n_fields;i++)
       {
-        for (int ic=0;ic<n_eles;ic++)
+        for (int ic=0;ic<n_eles_active;ic++)
         {
+          cell_res = 0.;
           for (int inp=0;inp<n_upts_per_ele;inp++)
           {
+            if (acc_res)
+              add_res_norm(cell_res,div_tconf_upts(0)(inp,ic,i)/detjac_upts(inp,ic),run_input.res_norm_type);
+            
             // User supplied timestep
             if (run_input.dt_type == 0)
               disu_upts(0)(inp,ic,i) -= run_input.dt*(div_tconf_upts(0)(inp,ic,i)/detjac_upts(inp,ic) - run_input.const_src_term);
@@ -812,13 +1072,15 @@ void eles::AdvanceSolution(int in_step, int adv_type) {
             else if (run_input.dt_type == 1)
               disu_upts(0)(inp,ic,i) -= dt_local(0)*(div_tconf_upts(0)(inp,ic,i)/detjac_upts(inp,ic) - run_input.const_src_term);
             
-            // Element local timestep
-            else if (run_input.dt_type == 2)
+            // Element local timestep, or multi-rate time step of the element's level
+            else if (run_input.dt_type == 2 || run_input.dt_type == 3)
               disu_upts(0)(inp,ic,i) -= dt_local(ic)*(div_tconf_upts(0)(inp,ic,i)/detjac_upts(inp,ic) - run_input.const_src_term);
             else
               FatalError("ERROR: dt_type not recognized!")
               
               }
+          if (acc_res)
+            add_cell_res_norm(res_norm_sum(i),cell_res,run_input.res_norm_type);
         }
       }
       
@@ -830,92 +1092,73 @@ void eles::AdvanceSolution(int in_step, int adv_type) {
       
     }
     
-    /*! Time integration using a RK45 method. */
+    /*! Time integration using a low-storage RK scheme from the tables of rk (RK45 by default). */
     
     else if (adv_type == 3) {
       
-      double rk4a, rk4b;
-      if (in_step==0) {
-        rk4a=    0.0;
-        rk4b=   0.149659021999229;
-      }
-      else if (in_step==1) {
-        rk4a=   -0.417890474499852;
-        rk4b=   0.379210312999627;
-      }
-      else if (in_step==2) {
-        rk4a=   -1.192151694642677;
-        rk4b=   0.822955029386982;
-      }
-      else if (in_step==3) {
-        rk4a=   -1.697784692471528;
-        rk4b=   0.699450455949122;
-      }
-      else if (in_step==4) {
-        rk4a=   -1.514183444257156;
-        rk4b=   0.153057247968152;
-      }
+      double rk_a = rk.get_a(in_step);
+      double rk_b = rk.get_b(in_step);
+      double rk_e = rk.get_e(in_step);
+      int rk_form = rk.get_form();
+      
+      // Residual norms of a monitored step, accumulated in the last stage while the update streams the residual
+      int acc_res = (run_input.res_norm_fused && in_acc_res && in_step == rk.get_n_stages()-1);
+      double cell_res;
+      if (acc_res)
+        res_norm_sum.initialize_to_zero();
       
 #ifdef _CPU
-      // for first stage only, compute timestep
-      if (in_step == 0)
-      {
-        // For global timestepping, find minimum timestep
-        if (run_input.dt_type == 1)
-        {
-          dt_local(0) = 1e12;
-          
-          for (int ic=0; ic<n_eles; ic++)
-          {
-            dt_local_new = calc_dt_local(ic);
-            
-            if (dt_local_new < dt_local(0))
-            {
-              dt_local(0) = dt_local_new;
-            }
-          }
-          
-          
-          // If using MPI, find minimum across partitions
-#ifdef _MPI
-          MPI_Barrier(MPI_COMM_WORLD);
-          MPI_Allgather(&dt_local(0),1,MPI_DOUBLE,dt_local_mpi.get_ptr_cpu(),1,MPI_DOUBLE,MPI_COMM_WORLD);
-          MPI_Barrier(MPI_COMM_WORLD);
-          
-          dt_local(0) = dt_local_mpi.get_min();
-#endif
-        }
-        
-        // For local timestepping, find element local timesteps
-        if (run_input.dt_type == 2)
-        {
-          for (int ic=0; ic<n_eles; ic++)
-          {
-            dt_local(ic) = calc_dt_local(ic);
-          }
-        }
-      }
+      // The time steps of dt_type 1 and 2 are set by CalcTimeStep before the first stage
       
-      double res, rhs;
-      for (int ic=0;ic<n_eles;ic++)
+      double res, rhs, dt;
+      for (int ic=0;ic<n_eles_active;ic++)
       {
+        if (run_input.dt_type == 0)
+          dt = run_input.dt;
+        else if (run_input.dt_type == 1)
+          dt = dt_local(0);
+        else
+          dt = dt_local(ic);
+        
         for (int i=0;i<n_fields;i++)
         {
+          cell_res = 0.;
           for (int inp=0;inp<n_upts_per_ele;inp++)
           {
             rhs = -div_tconf_upts(0)(inp,ic,i)/detjac_upts(inp,ic) + run_input.const_src_term;
-            res = disu_upts(1)(inp,ic,i);
             
-            if (run_input.dt_type == 0)
-              res = rk4a*res + run_input.dt*rhs;
-            else if (run_input.dt_type == 1)
-              res = rk4a*res + dt_local(0)*rhs;
-            else if (run_input.dt_type == 2)
-              res = rk4a*res + dt_local(ic)*rhs;
+            if (acc_res)
+              add_res_norm(cell_res,div_tconf_upts(0)(inp,ic,i)/detjac_upts(inp,ic),run_input.res_norm_type);
             
-            disu_upts(1)(inp,ic,i) = res;
-            disu_upts(0)(inp,ic,i) += rk4b*res;
+            // Embedded error estimate, and the solution to return to if the step is rejected
+            if (run_input.rk_adapt)
+            {
+              if (in_step == 0)
+              {
+                rk_save_upts(inp,ic,i) = disu_upts(0)(inp,ic,i);
+                rk_err_upts(inp,ic,i) = 0.;
+              }
+              rk_err_upts(inp,ic,i) += rk_e*dt*rhs;
+            }
+            
+            // 2N form: residual register
+            if (rk_form == 0)
+            {
+              res = rk_a*disu_upts(1)(inp,ic,i) + dt*rhs;
+              disu_upts(1)(inp,ic,i) = res;
+              disu_upts(0)(inp,ic,i) += rk_b*res;
+            }
+            
+            // 2S* form: the register keeps the solution at the start of the step
+            else
+            {
+              if (in_step == 0)
+                disu_upts(1)(inp,ic,i) = disu_upts(0)(inp,ic,i);
+              disu_upts(0)(inp,ic,i) = rk_a*disu_upts(1)(inp,ic,i) + (1.-rk_a)*disu_upts(0)(inp,ic,i) + rk_b*dt*rhs;
+            }
           }
+          if (acc_res)
+            add_cell_res_norm(res_norm_sum(i),cell_res,run_input.res_norm_type);
         }
       }
       
@@ -923,7 +1166,10 @@ void eles::AdvanceSolution(int in_step, int adv_type) {
       
 #ifdef _GPU
       
-      RK45_update_kernel_wrapper(n_upts_per_ele,n_dims,n_fields,n_eles,disu_upts(0).get_ptr_gpu(),disu_upts(1).get_ptr_gpu(),div_tconf_upts(0).get_ptr_gpu(),detjac_upts.get_ptr_gpu(),rk4a, rk4b,run_input.dt,run_input.const_src_term);
+      if (rk_form != 0 || run_input.rk_adapt || run_input.res_norm_fused)
+        FatalError("Only the 2N schemes without adaptive time stepping or fused residual norms are implemented on the GPU");
+      
+      RK45_update_kernel_wrapper(n_upts_per_ele,n_dims,n_fields,n_eles,disu_upts(0).get_ptr_gpu(),disu_upts(1).get_ptr_gpu(),div_tconf_upts(0).get_ptr_gpu(),detjac_upts.get_ptr_gpu(),rk_a, rk_b,run_input.dt,run_input.const_src_term);
       
 #endif
       
@@ -941,56 +1187,375 @@ void eles::AdvanceSolution(int in_step, int adv_type) {
 
 double eles::calc_dt_local(int in_ele)
 {
-  double lam_inv, lam_inv_new;
-  double lam_visc, lam_visc_new;
+  double lam_inv = 0., lam_visc = 0.;
   double out_dt_local;
   double dt_inv, dt_visc;
+  double rho, u, v, w, vsq, p, c;
+  
+  int stride = n_upts_per_ele*n_eles;
+  double* q = disu_upts(0).get_ptr_cpu(0,in_ele,0);
   
-  // 2-D Elements
-  if (n_dims == 2)
+  // Largest convective wavespeed |V|+c and viscous eigenvalue over the solution points of the element,
+  // in 2D (w = 0) and 3D
+  for (int i=0; i<n_upts_per_ele; i++)
   {
-    double u,v,p,c;
-    
-    lam_inv = 0;
-    lam_visc = 0;
-    
-    // Calculate maximum internal wavespeed per element
-    for (int i=0; i<n_upts_per_ele; i++)
-    {
-      u = disu_upts(0)(i,in_ele,1)/disu_upts(0)(i,in_ele,0);
-      v = disu_upts(0)(i,in_ele,2)/disu_upts(0)(i,in_ele,0);
-      p = (run_input.gamma - 1.0) * (disu_upts(0)(i,in_ele,3) - 0.5*disu_upts(0)(i,in_ele,0)*(u*u+v*v));
-      c = sqrt(run_input.gamma * p/disu_upts(0)(i,in_ele,0));
-      
-      lam_inv_new = sqrt(u*u + v*v) + c;
-      lam_visc_new = 4.0/3.0*run_input.mu_inf/disu_upts(0)(i,in_ele,0);
-      
-      if (lam_inv < lam_inv_new)
-        lam_inv = lam_inv_new;
+    rho = q[i];
+    u = q[i+stride]/rho;
+    v = q[i+2*stride]/rho;
+    w = (n_dims == 3) ? q[i+3*stride]/rho : 0.;
+    vsq = u*u + v*v + w*w;
+    p = (run_input.gamma - 1.0) * (q[i+(n_dims+1)*stride] - 0.5*rho*vsq);
+    c = sqrt(run_input.gamma * p/rho);
+    
+    lam_inv = max(lam_inv,sqrt(vsq) + c);
+    lam_visc = max(lam_visc,4.0/3.0*run_input.mu_inf/rho);
+  }
+  
+  dt_inv = run_input.CFL*h_ref(in_ele)/lam_inv * 1.0/(2.0*order + 1.0);
+  
+  if (viscous)
+    dt_visc = (run_input.CFL * 0.25 * h_ref(in_ele) * h_ref(in_ele))/(lam_visc) * 1.0/(2.0*order+1.0);
+  else
+    dt_visc = 1e16;
+  
+  out_dt_local = min(dt_visc,dt_inv);
+  
+  // With dual time stepping the physical time derivative adds -dual_coeff*u to the pseudo time derivative;
+  // treating it point-implicitly keeps the explicit pseudo time step stable when it exceeds the physical one
+  if (dual_coeff != 0.)
+    out_dt_local = out_dt_local/(1.0+dual_coeff*out_dt_local);
+  
+  return out_dt_local;
+}
 
-      if (lam_visc < lam_visc_new)
-        lam_visc = lam_visc_new;
-    }
+// element time steps of dt_type 2, and smallest element time step
 
-    if (viscous)
-    {
-      dt_visc = (run_input.CFL * 0.25 * h_ref(in_ele) * h_ref(in_ele))/(lam_visc) * 1.0/(2.0*run_input.order+1.0);
-      dt_inv = run_input.CFL*h_ref(in_ele)/lam_inv*1.0/(2.0*run_input.order + 1.0);
-    }
-    else
+double eles::calc_dt(void)
+{
+  double dt_min = 1e12;
+  
+  if (run_input.dt_type == 2)
+  {
+    for (int ic=0; ic<n_eles; ic++)
     {
-      dt_visc = 1e16;
-      dt_inv = run_input.CFL*h_ref(in_ele)/lam_inv * 1.0/(2.0*run_input.order + 1.0);
+      dt_local(ic) = calc_dt_local(ic);
+      dt_min = min(dt_min,dt_local(ic));
     }
-      out_dt_local = min(dt_visc,dt_inv);
   }
-  
-  else if (n_dims == 3)
+  else
   {
-    FatalError("Timestep type is not implemented in 3D yet.");
+    for (int ic=0; ic<n_eles; ic++)
+      dt_min = min(dt_min,calc_dt_local(ic));
   }
   
-  return out_dt_local;
+  return dt_min;
+}
+
+void eles::set_dt_global(double in_dt)
+{
+  dt_local(0) = in_dt;
+}
+
+// scaled embedded error of the last RK step
+
+double eles::calc_rk_error(void)
+{
+  double err = 0.;
+  
+  for (int i=0;i<n_fields;i++)
+    for (int ic=0;ic<n_eles;ic++)
+      for (int inp=0;inp<n_upts_per_ele;inp++)
+        err = max(err,fabs(rk_err_upts(inp,ic,i))/(run_input.rk_tol*max(1.,fabs(disu_upts(0)(inp,ic,i)))));
+  
+  return err;
+}
+
+// restore the solution from before the last RK step
+
+void eles::restore_rk_solution(void)
+{
+  for (int i=0;i<n_fields;i++)
+    for (int ic=0;ic<n_eles;ic++)
+      for (int inp=0;inp<n_upts_per_ele;inp++)
+        disu_upts(0)(inp,ic,i) = rk_save_upts(inp,ic,i);
+}
+
+// time derivative of the solution at the solution points, as used by AdvanceSolution
+
+void eles::calc_rhs_upts(double* out_rhs)
+{
+  int n = 0;
+
+  for (int i=0;i<n_fields;i++)
+    for (int ic=0;ic<n_eles;ic++)
+      for (int inp=0;inp<n_upts_per_ele;inp++)
+        out_rhs[n++] = -div_tconf_upts(0)(inp,ic,i)/detjac_upts(inp,ic) + run_input.const_src_term;
+}
+
+double* eles::get_disu_upts_ptr_cpu(void)
+{
+  return disu_upts(0).get_ptr_cpu();
+}
+
+// add a forcing term to the time derivative; div_tconf_upts holds |J| times minus the time derivative
+
+void eles::add_forcing_upts(double* in_forcing)
+{
+  int n = 0;
+
+  for (int i=0;i<n_fields;i++)
+    for (int ic=0;ic<n_eles;ic++)
+      for (int inp=0;inp<n_upts_per_ele;inp++)
+        div_tconf_upts(0)(inp,ic,i) -= detjac_upts(inp,ic)*in_forcing[n++];
+}
+
+// set the coefficient of the implicit physical time derivative of dual time stepping
+
+void eles::set_dual_time_coeff(double in_coeff)
+{
+  dual_coeff = in_coeff;
+}
+
+double* eles::get_dual_src_upts_ptr_cpu(void)
+{
+  return dual_src_upts.get_ptr_cpu();
+}
+
+// add the BDF physical time derivative to the time derivative, turning the residual into the unsteady one
+
+void eles::add_dual_time_source(void)
+{
+  for (int i=0;i<n_fields;i++)
+    for (int ic=0;ic<n_eles;ic++)
+      for (int inp=0;inp<n_upts_per_ele;inp++)
+        div_tconf_upts(0)(inp,ic,i) -= detjac_upts(inp,ic)*(dual_src_upts(inp,ic,i) - dual_coeff*disu_upts(0)(inp,ic,i));
+}
+
+void eles::set_lts_level(int in_ele, int in_level)
+{
+  lts_level(in_ele) = in_level;
+
+  // Faces without a neighbour (boundaries) share the element's level
+  for (int j=0;j<n_inters_per_ele;j++)
+    lts_nb_level(j,in_ele) = in_level;
+}
+
+int eles::get_lts_level(int in_ele)
+{
+  return lts_level(in_ele);
+}
+
+void eles::set_lts_nb_level(int in_ele, int in_local_inter, int in_level)
+{
+  lts_nb_level(in_local_inter,in_ele) = in_level;
+}
+
+// count the elements of each level, and find the faces whose flux register this element keeps
+
+void eles::setup_lts(int in_n_levels)
+{
+  int i, j, n_reg, fpt;
+
+  if (opp_0_sparse==1 || opp_1_sparse==1 || opp_2_sparse==1 || opp_3_sparse==1 || opp_4_sparse==1 || opp_5_sparse==1 || opp_6_sparse==1)
+    FatalError("Multi-rate time stepping needs the dense operators, set the sparse_* parameters to 0");
+
+  lts_n_eles_level.setup(in_n_levels);
+  lts_n_eles_level.initialize_to_zero();
+
+  for (i=0;i<n_eles;i++) {
+      if (i>0 && lts_level(i)<lts_level(i-1))
+        FatalError("Elements must be numbered by non-decreasing multi-rate level");
+
+      for (j=lts_level(i);j<in_n_levels;j++)
+        lts_n_eles_level(j)++;
+    }
+
+  // An element keeps the register of each face it shares with a finer element; the finer side is never corrected
+  n_reg = 0;
+  for (i=0;i<n_eles;i++)
+    for (j=0;j<n_inters_per_ele;j++)
+      if (lts_nb_level(j,i) < lts_level(i))
+        n_reg++;
+
+  lts_reg_ele.setup(n_reg);
+  lts_reg_inter.setup(n_reg);
+  lts_reg_fpt.setup(n_reg);
+
+  n_reg = 0;
+  for (i=0;i<n_eles;i++) {
+      fpt = 0;
+      for (j=0;j<n_inters_per_ele;j++) {
+          if (lts_nb_level(j,i) < lts_level(i)) {
+              lts_reg_ele(n_reg) = i;
+              lts_reg_inter(n_reg) = j;
+              lts_reg_fpt(n_reg) = fpt;
+              n_reg++;
+            }
+          fpt += n_fpts_per_inter(j);
+        }
+    }
+
+  lts_flux_reg.setup(n_fpts_per_ele,n_eles,n_fields);
+  lts_flux_reg.initialize_to_zero();
+}
+
+void eles::set_lts_active(int in_max_level)
+{
+  if (in_max_level < 0)
+    n_eles_active = n_eles;
+  else
+    n_eles_active = lts_n_eles_level(in_max_level);
+}
+
+void eles::set_lts_dt(double in_dt_base)
+{
+  for (int ic=0;ic<n_eles;ic++)
+    dt_local(ic) = in_dt_base*(1 << lts_level(ic));
+}
+
+void eles::set_lts_stage(int in_max_level, double in_dt_base, double in_weight)
+{
+  lts_max_active = in_max_level;
+  lts_dt_base = in_dt_base;
+  lts_weight = in_weight;
+}
+
+// Flux registers of multi-rate time stepping. Over its step, a coarse element must see the same interface flux as its
+// finer neighbours, which evaluate it at every one of their substeps. The register of a face holds the RK weighted time
+// integral of the fine side's common flux, minus the coarse side's own, both taken from the common flux the interface
+// writes into the coarse element's norm_tconf_fpts (also when the coarse element is not active)
+
+void eles::accumulate_lts_flux_reg(void)
+{
+  int i, j, k, ic, l_nb, n_fpts;
+  double w;
+
+  if (lts_weight == 0.)
+    return;
+
+  for (k=0;k<lts_reg_ele.get_dim(0);k++) {
+      ic = lts_reg_ele(k);
+      l_nb = lts_nb_level(lts_reg_inter(k),ic);
+
+      // Face not evaluated at this substep
+      if (l_nb > lts_max_active)
+        continue;
+
+      w = lts_weight*lts_dt_base*(1 << l_nb);
+      if (lts_level(ic) <= lts_max_active)
+        w -= lts_weight*lts_dt_base*(1 << lts_level(ic));
+
+      n_fpts = n_fpts_per_inter(lts_reg_inter(k));
+      for (i=0;i<n_fields;i++)
+        for (j=lts_reg_fpt(k);j<lts_reg_fpt(k)+n_fpts;j++)
+          lts_flux_reg(j,ic,i) += w*norm_tconf_fpts(j,ic,i);
+    }
+}
+
+// replace the coarse side's flux integral with the fine side's at the end of the step of each coarse element
+
+void eles::apply_lts_flux_reg(int in_max_level)
+{
+  int i, j, k, m, ic, n_fpts;
+  double sum;
+
+  for (k=0;k<lts_reg_ele.get_dim(0);k++) {
+      ic = lts_reg_ele(k);
+
+      if (lts_level(ic) > in_max_level)
+        continue;
+
+      n_fpts = n_fpts_per_inter(lts_reg_inter(k));
+      for (i=0;i<n_fields;i++) {
+          for (m=0;m<n_upts_per_ele;m++) {
+              sum = 0.;
+              for (j=lts_reg_fpt(k);j<lts_reg_fpt(k)+n_fpts;j++)
+                sum += opp_3(m,j)*lts_flux_reg(j,ic,i);
+
+              disu_upts(0)(m,ic,i) -= sum/detjac_upts(m,ic);
+            }
+
+          for (j=lts_reg_fpt(k);j<lts_reg_fpt(k)+n_fpts;j++)
+            lts_flux_reg(j,ic,i) = 0.;
+        }
+    }
+}
+
+// dense product over the active elements; a single call over all fields when every element is active
+
+void eles::dgemm_active(int in_m, int in_k, double in_alpha, double* in_A, double* in_B, double in_beta, double* out_C)
+{
+  int n_cols = (n_eles_active == n_eles) ? n_fields*n_eles : n_eles_active;
+  int n_blocks = (n_eles_active == n_eles) ? 1 : n_fields;
+
+  if (n_eles_active == 0)
+    return;
+
+  for (int i=0;i<n_blocks;i++)
+    {
+#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
+      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,in_m,n_cols,in_k,in_alpha,in_A,in_m,in_B+i*in_k*n_eles,in_k,in_beta,out_C+i*in_m*n_eles,in_m);
+#elif defined _NO_BLAS
+      dgemm(in_m,n_cols,in_k,in_alpha,in_beta,in_A,in_B+i*in_k*n_eles,out_C+i*in_m*n_eles);
+#endif
+    }
+}
+
+// gather over the active elements, for operators that pick a single solution point per row
+
+void eles::gather_active(int in_m, int in_k, int* in_index, double* in_wgt, double* in_B, double in_beta, double* out_C)
+{
+  int i,j,k;
+  double *b, *c;
+
+  for (k=0;k<n_fields;k++)
+    {
+      for (i=0;i<n_eles_active;i++)
+        {
+          b = in_B+(i+k*n_eles)*in_k;
+          c = out_C+(i+k*n_eles)*in_m;
+
+          if (in_beta == 0.)
+            for (j=0;j<in_m;j++)
+              c[j] = in_wgt[j]*b[in_index[j]];
+          else
+            for (j=0;j<in_m;j++)
+              c[j] = in_beta*c[j] + in_wgt[j]*b[in_index[j]];
+        }
+    }
+}
+
+// find the nonzero of each row of an operator; rows with none get weight zero
+
+bool eles::find_injection(array<double>& in_opp, array<int>& out_index, array<double>& out_wgt)
+{
+  int i,j,n_nz;
+  int n_rows = in_opp.get_dim(0);
+  int n_cols = in_opp.get_dim(1);
+  double tol = 1.e-12;
+
+  out_index.setup(n_rows);
+  out_wgt.setup(n_rows);
+
+  for (i=0;i<n_rows;i++)
+    {
+      out_index(i) = 0;
+      out_wgt(i) = 0.;
+      n_nz = 0;
+      for (j=0;j<n_cols;j++)
+        {
+          if (fabs(in_opp(i,j)) > tol)
+            {
+              out_index(i) = j;
+              out_wgt(i) = in_opp(i,j);
+              n_nz++;
+            }
+        }
+      if (n_nz > 1)
+        return false;
+    }
+
+  return true;
 }
 
 // calculate the discontinuous solution at the flux points
@@ -1030,13 +1595,11 @@ void eles::extrapolate_solution(int in_disu_upts_from)
     
     if(opp_0_sparse==0) // dense
     {
-#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
-      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,Arows,Bcols,Acols,1.0,opp_0.get_ptr_cpu(),Astride,disu_upts(in_disu_upts_from).get_ptr_cpu(),Bstride,0.0,disu_fpts.get_ptr_cpu(),Cstride);
-      
-#elif defined _NO_BLAS
-      dgemm(Arows,Bcols,Acols,1.0,0.0,opp_0.get_ptr_cpu(),disu_upts(in_disu_upts_from).get_ptr_cpu(),disu_fpts.get_ptr_cpu());
-      
-#endif
+      dgemm_active(Arows,Acols,1.0,opp_0.get_ptr_cpu(),disu_upts(in_disu_upts_from).get_ptr_cpu(),0.0,disu_fpts.get_ptr_cpu());
+    }
+    else if(opp_0_sparse==2) // flux points at solution points
+    {
+      gather_active(Arows,Acols,opp_0_inject.get_ptr_cpu(),opp_0_inject_wgt.get_ptr_cpu(),disu_upts(in_disu_upts_from).get_ptr_cpu(),0.0,disu_fpts.get_ptr_cpu());
     }
     else if(opp_0_sparse==1) // mkl blas four-array csr format
     {
@@ -1079,7 +1642,18 @@ void eles::evaluate_invFlux(int in_disu_upts_from)
     
     int i,j,k,l,m;
     
-    for(i=0;i<n_eles;i++)
+    // Linear advection: the transformed flux is the transformed wave speed times the solution
+    if (run_input.equation==1)
+    {
+      for(l=0;l<n_dims;l++)
+        for(i=0;i<n_eles_active;i++)
+          for(j=0;j<n_upts_per_ele;j++)
+            tdisf_upts(j,i,0,l)=tws_upts(j,i,l)*disu_upts(in_disu_upts_from)(j,i,0);
+      
+      return;
+    }
+    
+    for(i=0;i<n_eles_active;i++)
     {
       for(j=0;j<n_upts_per_ele;j++)
       {
@@ -1142,23 +1716,32 @@ void eles::extrapolate_totalFlux()
   {
 #ifdef _CPU
     
-    if(opp_1_sparse==0) // dense
+    if(lin_affine) // linear advection-diffusion on affine elements, from the extrapolated solution and gradient
     {
-#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
+      for (int i=0;i<n_eles_active;i++)
+        for (int k=0;k<n_fpts_per_ele;k++)
+          norm_tdisf_fpts(k,i,0)=ntws_fpts(k,i)*disu_fpts(k,i,0);
       
-      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_fpts_per_ele,n_fields*n_eles,n_upts_per_ele,1.0,opp_1(0).get_ptr_cpu(),n_fpts_per_ele,tdisf_upts.get_ptr_cpu(0,0,0,0),n_upts_per_ele,0.0,norm_tdisf_fpts.get_ptr_cpu(),n_fpts_per_ele);
+      if (viscous)
+        for (int m=0;m<n_dims;m++)
+          for (int i=0;i<n_eles_active;i++)
+            for (int k=0;k<n_fpts_per_ele;k++)
+              norm_tdisf_fpts(k,i,0)+=ntdiff_fpts(k,i,m)*grad_disu_fpts(k,i,0,m);
+    }
+    else if(opp_1_sparse==0) // dense
+    {
+      dgemm_active(n_fpts_per_ele,n_upts_per_ele,1.0,opp_1(0).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,0),0.0,norm_tdisf_fpts.get_ptr_cpu());
       for (int i=1;i<n_dims;i++)
       {
-        cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_fpts_per_ele,n_fields*n_eles,n_upts_per_ele,1.0,opp_1(i).get_ptr_cpu(),n_fpts_per_ele,tdisf_upts.get_ptr_cpu(0,0,0,i),n_upts_per_ele,1.0,norm_tdisf_fpts.get_ptr_cpu(),n_fpts_per_ele);
+        dgemm_active(n_fpts_per_ele,n_upts_per_ele,1.0,opp_1(i).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,i),1.0,norm_tdisf_fpts.get_ptr_cpu());
       }
-      
-#elif defined _NO_BLAS
-      dgemm(n_fpts_per_ele,n_fields*n_eles,n_upts_per_ele,1.0,0.0,opp_1(0).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,0),norm_tdisf_fpts.get_ptr_cpu());
-      for (int i=1;i<n_dims;i++)
+    }
+    else if(opp_1_sparse==2) // flux points at solution points
+    {
+      for (int i=0;i<n_dims;i++)
       {
-        dgemm(n_fpts_per_ele,n_fields*n_eles,n_upts_per_ele,1.0,1.0,opp_1(i).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,i),norm_tdisf_fpts.get_ptr_cpu());
+        gather_active(n_fpts_per_ele,n_upts_per_ele,opp_1_inject(i).get_ptr_cpu(),opp_1_inject_wgt(i).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,i),(i==0) ? 0.0 : 1.0,norm_tdisf_fpts.get_ptr_cpu());
       }
-#endif
     }
     else if(opp_1_sparse==1) // mkl blas four-array csr format
     {
@@ -1238,22 +1821,11 @@ void eles::calculate_divergence(int in_div_tconf_upts_to)
     
     if(opp_2_sparse==0) // dense
     {
-#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
-      
-      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_upts_per_ele,n_fields*n_eles,n_upts_per_ele,1.0,opp_2(0).get_ptr_cpu(),n_upts_per_ele,tdisf_upts.get_ptr_cpu(0,0,0,0),n_upts_per_ele,0.0,div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu(),n_upts_per_ele);
-      for (int i=1;i<n_dims;i++)
-      {
-        cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_upts_per_ele,n_fields*n_eles,n_upts_per_ele,1.0,opp_2(i).get_ptr_cpu(),n_upts_per_ele,tdisf_upts.get_ptr_cpu(0,0,0,i),n_upts_per_ele,1.0,div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu(),n_upts_per_ele);
-      }
-      
-#elif defined _NO_BLAS
-      dgemm(n_upts_per_ele,n_fields*n_eles,n_upts_per_ele,1.0,0.0,opp_2(0).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,0),div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu());
+      dgemm_active(n_upts_per_ele,n_upts_per_ele,1.0,opp_2(0).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,0),0.0,div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu());
       for (int i=1;i<n_dims;i++)
       {
-        dgemm(n_upts_per_ele,n_fields*n_eles,n_upts_per_ele,1.0,1.0,opp_2(i).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,i),div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu());
+        dgemm_active(n_upts_per_ele,n_upts_per_ele,1.0,opp_2(i).get_ptr_cpu(),tdisf_upts.get_ptr_cpu(0,0,0,i),1.0,div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu());
       }
-      
-#endif
     }
     else if(opp_2_sparse==1) // mkl blas four-array csr format
     {
@@ -1313,27 +1885,27 @@ void eles::calculate_corrected_divergence(int in_div_tconf_upts_to)
   {
 #ifdef _CPU
     
-#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
-    
-    cblas_daxpy(n_eles*n_fields*n_fpts_per_ele,-1.0,norm_tdisf_fpts.get_ptr_cpu(),1,norm_tconf_fpts.get_ptr_cpu(),1);
-    
-#elif defined _NO_BLAS
-    
-    daxpy(n_eles*n_fields*n_fpts_per_ele,-1.0,norm_tdisf_fpts.get_ptr_cpu(),norm_tconf_fpts.get_ptr_cpu());
-    
-#endif
+    // The flux registers of multi-rate time stepping take the common flux before the discontinuous one is removed
+    if (run_input.dt_type == 3)
+      accumulate_lts_flux_reg();
     
-    if(opp_3_sparse==0) // dense
+    for (int i=0;i<n_fields;i++)
     {
 #if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
       
-      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_upts_per_ele,n_fields*n_eles,n_fpts_per_ele,1.0,opp_3.get_ptr_cpu(),n_upts_per_ele,norm_tconf_fpts.get_ptr_cpu(),n_fpts_per_ele,1.0,div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu(),n_upts_per_ele);
+      cblas_daxpy(n_eles_active*n_fpts_per_ele,-1.0,norm_tdisf_fpts.get_ptr_cpu(0,0,i),1,norm_tconf_fpts.get_ptr_cpu(0,0,i),1);
       
 #elif defined _NO_BLAS
-      dgemm(n_upts_per_ele,n_fields*n_eles,n_fpts_per_ele,1.0,1.0,opp_3.get_ptr_cpu(),norm_tconf_fpts.get_ptr_cpu(),div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu());
+      
+      daxpy(n_eles_active*n_fpts_per_ele,-1.0,norm_tdisf_fpts.get_ptr_cpu(0,0,i),norm_tconf_fpts.get_ptr_cpu(0,0,i));
       
 #endif
     }
+    
+    if(opp_3_sparse==0) // dense
+    {
+      dgemm_active(n_upts_per_ele,n_fpts_per_ele,1.0,opp_3.get_ptr_cpu(),norm_tconf_fpts.get_ptr_cpu(),1.0,div_tconf_upts(in_div_tconf_upts_to).get_ptr_cpu());
+    }
     else if(opp_3_sparse==1) // mkl blas four-array csr format
     {
 #if defined _MKL_BLAS
@@ -1412,17 +1984,9 @@ void eles::calculate_gradient(int in_disu_upts_from)
     
     if(opp_4_sparse==0) // dense
     {
-#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
-      for (int i=0;i<n_dims;i++) {
-        cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,Arows,Bcols,Acols,1.0,opp_4(i).get_ptr_cpu(),Astride,disu_upts(in_disu_upts_from).get_ptr_cpu(),Bstride,0.0,grad_disu_upts.get_ptr_cpu(0,0,0,i),Cstride);
-      }
-      
-#elif defined _NO_BLAS
       for (int i=0;i<n_dims;i++) {
-        dgemm(Arows,Bcols,Acols,1.0,0.0,opp_4(i).get_ptr_cpu(),disu_upts(in_disu_upts_from).get_ptr_cpu(),grad_disu_upts.get_ptr_cpu(0,0,0,i));
+        dgemm_active(Arows,Acols,1.0,opp_4(i).get_ptr_cpu(),disu_upts(in_disu_upts_from).get_ptr_cpu(),0.0,grad_disu_upts.get_ptr_cpu(0,0,0,i));
       }
-      
-#endif
     }
     else if(opp_4_sparse==1) // mkl blas four-array csr format
     {
@@ -1495,19 +2059,10 @@ void eles::correct_gradient(void)
     
     if(opp_5_sparse==0) // dense
     {
-#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
-      
       for (int i=0;i<n_dims;i++)
       {
-        cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,Arows,Bcols,Acols,1.0,opp_5(i).get_ptr_cpu(),Astride,delta_disu_fpts.get_ptr_cpu(),Bstride,1.0,grad_disu_upts.get_ptr_cpu(0,0,0,i),Cstride);
-      }
-      
-#elif defined _NO_BLAS
-      for (int i=0;i<n_dims;i++) {
-        dgemm(Arows,Bcols,Acols,1.0,1.0,opp_5(i).get_ptr_cpu(),delta_disu_fpts.get_ptr_cpu(),grad_disu_upts.get_ptr_cpu(0,0,0,i));
+        dgemm_active(Arows,Acols,1.0,opp_5(i).get_ptr_cpu(),delta_disu_fpts.get_ptr_cpu(),1.0,grad_disu_upts.get_ptr_cpu(0,0,0,i));
       }
-      
-#endif
     }
     else if(opp_5_sparse==1) // mkl blas four-array csr format
     {
@@ -1528,7 +2083,7 @@ void eles::correct_gradient(void)
     double rx,ry,rz,sx,sy,sz,tx,ty,tz;
     double ur,us,ut;
     
-    for (int i=0;i<n_eles;i++)
+    for (int i=0;i<n_eles_active;i++)
     {
       for (int j=0;j<n_upts_per_ele;j++)
       {
@@ -1652,18 +2207,17 @@ void eles::extrapolate_corrected_gradient(void)
     
     if(opp_6_sparse==0) // dense
     {
-#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
-      
       for (int i=0;i<n_dims;i++)
       {
-        cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,Arows,Bcols,Acols,1.0,opp_6.get_ptr_cpu(),Astride,grad_disu_upts.get_ptr_cpu(0,0,0,i),Bstride,0.0,grad_disu_fpts.get_ptr_cpu(0,0,0,i),Cstride);
+        dgemm_active(Arows,Acols,1.0,opp_6.get_ptr_cpu(),grad_disu_upts.get_ptr_cpu(0,0,0,i),0.0,grad_disu_fpts.get_ptr_cpu(0,0,0,i));
       }
-      
-#elif defined _NO_BLAS
-      for (int i=0;i<n_dims;i++) {
-        dgemm(Arows,Bcols,Acols,1.0,0.0,opp_6.get_ptr_cpu(),grad_disu_upts.get_ptr_cpu(0,0,0,i),grad_disu_fpts.get_ptr_cpu(0,0,0,i));
+    }
+    else if(opp_6_sparse==2) // flux points at solution points
+    {
+      for (int i=0;i<n_dims;i++)
+      {
+        gather_active(Arows,Acols,opp_6_inject.get_ptr_cpu(),opp_6_inject_wgt.get_ptr_cpu(),grad_disu_upts.get_ptr_cpu(0,0,0,i),0.0,grad_disu_fpts.get_ptr_cpu(0,0,0,i));
       }
-#endif
     }
     else if(opp_6_sparse==1) // mkl blas four-array csr format
     {
@@ -1990,7 +2544,20 @@ void eles::evaluate_viscFlux(int in_disu_upts_from)
     
     int i,j,k,l,m;
     double detjac;
-    for(i=0;i<n_eles;i++) {
+    
+    // Linear diffusion: add the transformed flux -diff_coeff*JGinv*grad(u)
+    if (run_input.equation==1 && LES == 0 && wall_model == 0)
+    {
+      for(l=0;l<n_dims;l++)
+        for(i=0;i<n_eles_active;i++)
+          for(j=0;j<n_upts_per_ele;j++)
+            for(m=0;m<n_dims;m++)
+              tdisf_upts(j,i,0,l)-=JGinv_upts(j,i,l,m)*run_input.diff_coeff*grad_disu_upts(j,i,0,m);
+      
+      return;
+    }
+    
+    for(i=0;i<n_eles_active;i++) {
       
       // Calculate viscous flux
       for(j=0;j<n_upts_per_ele;j++)
@@ -2152,7 +2719,7 @@ void eles::calc_sgsf_upts(array<double>& temp_u, array<double>& temp_grad_u, dou
     qw = twall(upt,ele,n_fields-1);
     
     // Calculate local rotation matrix
-    Mrot = calc_rotation_matrix(norm);
+    calc_rotation_matrix(norm).swap(Mrot);
     
     // Rotate velocity to surface
     if(n_dims==2) {
@@ -2398,7 +2965,7 @@ void eles::calc_sgsf_upts(array<double>& temp_u, array<double>& temp_grad_u, dou
 /*! If using a RANS or LES near-wall model, calculate distance
  of each solution point to nearest no-slip wall by a brute-force method */
 
-void eles::calc_wall_distance(int n_seg_noslip_inters, int n_tri_noslip_inters, int n_quad_noslip_inters, array< array<double> > loc_noslip_bdy)
+void eles::calc_wall_distance(int n_seg_noslip_inters, int n_tri_noslip_inters, int n_quad_noslip_inters, array< array<double> >& loc_noslip_bdy)
 {
   if(n_eles!=0)
   {
@@ -2498,7 +3065,7 @@ void eles::calc_wall_distance(int n_seg_noslip_inters, int n_tri_noslip_inters,
 
 #ifdef _MPI
 
-void eles::calc_wall_distance_parallel(array<int> n_seg_inters_array, array<int> n_tri_inters_array, array<int> n_quad_inters_array, array< array<double> > loc_noslip_bdy_global, int nproc)
+void eles::calc_wall_distance_parallel(array<int>& n_seg_inters_array, array<int>& n_tri_inters_array, array<int>& n_quad_inters_array, array< array<double> >& loc_noslip_bdy_global, int nproc)
 {
   if(n_eles!=0)
   {
@@ -2899,6 +3466,12 @@ void eles::evaluate_sgsFlux(void)
       
 #endif
     }
+    else if(opp_0_sparse==2) // flux points at solution points
+    {
+      for (int i=0;i<n_dims;i++) {
+        gather_active(Arows,Acols,opp_0_inject.get_ptr_cpu(),opp_0_inject_wgt.get_ptr_cpu(),sgsf_upts.get_ptr_cpu(0,0,0,i),0.0,sgsf_fpts.get_ptr_cpu(0,0,0,i));
+      }
+    }
     else if(opp_0_sparse==1) // mkl blas four-array csr format
     {
 #if defined _MKL_BLAS
@@ -3043,14 +3616,33 @@ void eles::set_ele2global_ele(int in_ele, int in_global_ele)
   ele2global_ele(in_ele) = in_global_ele;
 }
 
+// get global cell number of element
+
+int eles::get_ele2global_ele(int in_ele)
+{
+  return ele2global_ele(in_ele);
+}
+
+// set color of element
+
+void eles::set_ele_color(int in_ele, int in_color)
+{
+  ele_color(in_ele) = in_color;
+}
+
+// get color of element
+
+int eles::get_ele_color(int in_ele)
+{
+  return ele_color(in_ele);
+}
+
 
 // set opp_0 (transformed discontinuous solution at solution points to transformed discontinuous solution at flux points)
 
 void eles::set_opp_0(int in_sparse)
 {
-  int i,j,k;
-  
-  array<double> loc(n_dims);
+  int i,j;
   
   opp_0.setup(n_fpts_per_ele,n_upts_per_ele);
   
@@ -3058,12 +3650,7 @@ void eles::set_opp_0(int in_sparse)
   {
     for(j=0;j<n_fpts_per_ele;j++)
     {
-      for(k=0;k<n_dims;k++)
-      {
-        loc(k)=tloc_fpts(k,j);
-      }
-      
-      opp_0(j,i)=eval_nodal_basis(i,loc);
+      opp_0(j,i)=eval_nodal_basis(i,array_view<double>(tloc_fpts.get_ptr_cpu(0,j),n_dims));
     }
   }
   
@@ -3100,6 +3687,12 @@ void eles::set_opp_0(int in_sparse)
     cout << "ERROR: Invalid sparse matrix form ... " << endl;
   }
   
+#ifdef _CPU
+  // flux points that coincide with solution points (e.g. Gauss-Lobatto points) are injected
+  if(opp_0_sparse==0 && find_injection(opp_0,opp_0_inject,opp_0_inject_wgt))
+    opp_0_sparse=2;
+#endif
+  
   
   
 }
@@ -3108,8 +3701,7 @@ void eles::set_opp_0(int in_sparse)
 
 void eles::set_opp_1(int in_sparse)
 {
-  int i,j,k,l;
-  array<double> loc(n_dims);
+  int i,j,k;
   
   opp_1.setup(n_dims);
   for (int i=0;i<n_dims;i++)
@@ -3121,12 +3713,7 @@ void eles::set_opp_1(int in_sparse)
     {
       for(k=0;k<n_fpts_per_ele;k++)
       {
-        for(l=0;l<n_dims;l++)
-        {
-          loc(l)=tloc_fpts(l,k);
-        }
-        
-        opp_1(i)(k,j)=eval_nodal_basis(j,loc)*tnorm_fpts(i,k);
+        opp_1(i)(k,j)=eval_nodal_basis(j,array_view<double>(tloc_fpts.get_ptr_cpu(0,k),n_dims))*tnorm_fpts(i,k);
       }
     }
     //cout << "opp_1,i =" << i << endl;
@@ -3171,6 +3758,20 @@ void eles::set_opp_1(int in_sparse)
   {
     cout << "ERROR: Invalid sparse matrix form ... " << endl;
   }
+  
+#ifdef _CPU
+  // flux points that coincide with solution points are injected, scaled by the normal
+  if(opp_1_sparse==0)
+  {
+    bool inject = true;
+    opp_1_inject.setup(n_dims);
+    opp_1_inject_wgt.setup(n_dims);
+    for (int i=0;i<n_dims && inject;i++)
+      inject = find_injection(opp_1(i),opp_1_inject(i),opp_1_inject_wgt(i));
+    if(inject)
+      opp_1_sparse=2;
+  }
+#endif
 }
 
 // set opp_2 (transformed discontinuous flux at solution points to divergence of transformed discontinuous flux at solution points)
@@ -3178,9 +3779,7 @@ void eles::set_opp_1(int in_sparse)
 void eles::set_opp_2(int in_sparse)
 {
   
-  int i,j,k,l;
-  
-  array<double> loc(n_dims);
+  int i,j,k;
   
   opp_2.setup(n_dims);
   for (int i=0;i<n_dims;i++)
@@ -3192,12 +3791,7 @@ void eles::set_opp_2(int in_sparse)
     {
       for(k=0;k<n_upts_per_ele;k++)
       {
-        for(l=0;l<n_dims;l++)
-        {
-          loc(l)=loc_upts(l,k);
-        }
-        
-        opp_2(i)(k,j)=eval_d_nodal_basis(j,i,loc);
+        opp_2(i)(k,j)=eval_d_nodal_basis(j,i,array_view<double>(loc_upts.get_ptr_cpu(0,k),n_dims));
       }
     }
     
@@ -3295,9 +3889,7 @@ void eles::set_opp_3(int in_sparse)
 
 void eles::set_opp_4(int in_sparse)
 {
-  int i,j,k,l;
-  
-  array<double> loc(n_dims);
+  int i,j,k;
   
   opp_4.setup(n_dims);
   for (int i=0;i<n_dims;i++)
@@ -3309,12 +3901,7 @@ void eles::set_opp_4(int in_sparse)
     {
       for(k=0; k<n_upts_per_ele; k++)
       {
-        for(l=0; l<n_dims; l++)
-        {
-          loc(l)=loc_upts(l,k);
-        }
-        
-        opp_4(i)(k,j) = eval_d_nodal_basis(j,i,loc);
+        opp_4(i)(k,j) = eval_d_nodal_basis(j,i,array_view<double>(loc_upts.get_ptr_cpu(0,k),n_dims));
       }
     }
   }
@@ -3360,7 +3947,7 @@ void eles::set_opp_4(int in_sparse)
 
 void eles::set_opp_5(int in_sparse)
 {
-  int i,j,k,l;
+  int i,j,k;
   
   array<double> loc(n_dims);
   
@@ -3430,9 +4017,7 @@ void eles::set_opp_5(int in_sparse)
 
 void eles::set_opp_6(int in_sparse)
 {
-  int i,j,k,l,m;
-  
-  array<double> loc(n_dims);
+  int j,l;
   
   opp_6.setup(n_fpts_per_ele, n_upts_per_ele);
   
@@ -3440,11 +4025,7 @@ void eles::set_opp_6(int in_sparse)
   {
     for(l=0; l<n_fpts_per_ele; l++)
     {
-      for(m=0; m<n_dims; m++)
-      {
-        loc(m) = tloc_fpts(m,l);
-      }
-      opp_6(l,j) = eval_nodal_basis(j,loc);
+      opp_6(l,j) = eval_nodal_basis(j,array_view<double>(tloc_fpts.get_ptr_cpu(0,l),n_dims));
     }
   }
   
@@ -3478,15 +4059,19 @@ void eles::set_opp_6(int in_sparse)
   {
     cout << "ERROR: Invalid sparse matrix form ... " << endl;
   }
+  
+#ifdef _CPU
+  // flux points that coincide with solution points are injected
+  if(opp_6_sparse==0 && find_injection(opp_6,opp_6_inject,opp_6_inject_wgt))
+    opp_6_sparse=2;
+#endif
 }
 
 // set opp_p (solution at solution points to solution at plot points)
 
 void eles::set_opp_p(void)
 {
-  int i,j,k;
-  
-  array<double> loc(n_dims);
+  int i,j;
   
   opp_p.setup(n_ppts_per_ele,n_upts_per_ele);
   
@@ -3494,12 +4079,7 @@ void eles::set_opp_p(void)
   {
     for(j=0;j<n_ppts_per_ele;j++)
     {
-      for(k=0;k<n_dims;k++)
-      {
-        loc(k)=loc_ppts(k,j);
-      }
-      
-      opp_p(j,i)=eval_nodal_basis(i,loc);
+      opp_p(j,i)=eval_nodal_basis(i,array_view<double>(loc_ppts.get_ptr_cpu(0,j),n_dims));
     }
   }
   
@@ -3508,9 +4088,7 @@ void eles::set_opp_p(void)
 void eles::set_opp_inters_cubpts(void)
 {
   
-  int i,j,k,l;
-  
-  array<double> loc(n_dims);
+  int i,j,l;
   
   opp_inters_cubpts.setup(n_inters_per_ele);
   
@@ -3525,12 +4103,7 @@ void eles::set_opp_inters_cubpts(void)
     {
       for(j=0;j<n_cubpts_per_inter(l);j++)
       {
-        for(k=0;k<n_dims;k++)
-        {
-          loc(k)=loc_inters_cubpts(l)(k,j);
-        }
-        
-        opp_inters_cubpts(l)(j,i)=eval_nodal_basis(i,loc);
+        opp_inters_cubpts(l)(j,i)=eval_nodal_basis(i,array_view<double>(loc_inters_cubpts(l).get_ptr_cpu(0,j),n_dims));
       }
     }
   }
@@ -3540,20 +4113,14 @@ void eles::set_opp_inters_cubpts(void)
 void eles::set_opp_volume_cubpts(void)
 {
   
-  int i,j,k,l;
-  array<double> loc(n_dims);
+  int i,j;
   opp_volume_cubpts.setup(n_cubpts_per_ele,n_upts_per_ele);
   
   for(i=0;i<n_upts_per_ele;i++)
   {
     for(j=0;j<n_cubpts_per_ele;j++)
     {
-      for(k=0;k<n_dims;k++)
-      {
-        loc(k)=loc_volume_cubpts(k,j);
-      }
-      
-      opp_volume_cubpts(j,i)=eval_nodal_basis(i,loc);
+      opp_volume_cubpts(j,i)=eval_nodal_basis(i,array_view<double>(loc_volume_cubpts.get_ptr_cpu(0,j),n_dims));
     }
   }
 }
@@ -3563,9 +4130,7 @@ void eles::set_opp_volume_cubpts(void)
 
 void eles::set_opp_r(void)
 {
-  int i,j,k;
-  
-  array<double> loc(n_dims);
+  int i,j;
   
   opp_r.setup(n_upts_per_ele,n_upts_per_ele_rest);
   
@@ -3573,10 +4138,25 @@ void eles::set_opp_r(void)
   {
     for(j=0;j<n_upts_per_ele;j++)
     {
-      for(k=0;k<n_dims;k++)
-        loc(k)=loc_upts(k,j);
-      
-      opp_r(j,i)=eval_nodal_basis_restart(i,loc);
+      opp_r(j,i)=eval_nodal_basis_restart(i,array_view<double>(loc_upts.get_ptr_cpu(0,j),n_dims));
+    }
+  }
+}
+
+// set a p-multigrid transfer operator (solution at the solution points of another order to solution at the solution points)
+
+void eles::set_opp_mg(eles* in_donor, array<double>& out_opp_mg)
+{
+  int i,j;
+  int n_upts_donor = in_donor->get_n_upts_per_ele();
+
+  out_opp_mg.setup(n_upts_per_ele,n_upts_donor);
+
+  for(i=0;i<n_upts_donor;i++)
+  {
+    for(j=0;j<n_upts_per_ele;j++)
+    {
+      out_opp_mg(j,i)=in_donor->eval_nodal_basis(i,array_view<double>(loc_upts.get_ptr_cpu(0,j),n_dims));
     }
   }
 }
@@ -3608,112 +4188,214 @@ void eles::calc_pos_ppts(int in_ele, array<double>& out_pos_ppts)
 
 // calculate solution at the plot points
 void eles::calc_disu_ppts(int in_ele, array<double>& out_disu_ppts)
+{
+  // (n_ppts_per_ele,n_fields) has the layout of a block of one element
+  calc_disu_ppts(in_ele,1,out_disu_ppts);
+}
+
+// calculate solution at the plot points of a block of elements, one product with opp_p per field
+void eles::calc_disu_ppts(int in_ele, int in_n_eles, array<double>& out_disu_ppts)
 {
   if (n_eles!=0)
   {
     
-    int i,j,k;
+    int k;
     
-    array<double> disu_upts_plot(n_upts_per_ele,n_fields);
+    array<double>& disu_src = (out_buf < 0) ? disu_upts(0) : disu_upts_out(out_buf);
     
-    for(i=0;i<n_fields;i++)
+    for(k=0;k<n_fields;k++)
     {
-      for(j=0;j<n_upts_per_ele;j++)
-      {
-        disu_upts_plot(j,i)=disu_upts(0)(j,in_ele,i);
-      }
-    }
-    
+      // The solution of consecutive elements is contiguous for each field
+      double* B = disu_src.get_ptr_cpu(0,in_ele,k);
+      double* C = out_disu_ppts.get_ptr_cpu()+k*n_ppts_per_ele*in_n_eles;
+      
 #if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
-    
-    cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_ppts_per_ele,n_fields,n_upts_per_ele,1.0,opp_p.get_ptr_cpu(),n_ppts_per_ele,disu_upts_plot.get_ptr_cpu(),n_upts_per_ele,0.0,out_disu_ppts.get_ptr_cpu(),n_ppts_per_ele);
-    
+      
+      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_ppts_per_ele,in_n_eles,n_upts_per_ele,1.0,opp_p.get_ptr_cpu(),n_ppts_per_ele,B,n_upts_per_ele,0.0,C,n_ppts_per_ele);
+      
 #elif defined _NO_BLAS
-    dgemm(n_ppts_per_ele,n_fields,n_upts_per_ele,1.0,0.0,opp_p.get_ptr_cpu(),disu_upts_plot.get_ptr_cpu(),out_disu_ppts.get_ptr_cpu());
-    
+      
+      dgemm(n_ppts_per_ele,in_n_eles,n_upts_per_ele,1.0,0.0,opp_p.get_ptr_cpu(),B,C);
+      
 #else
-    
-    //HACK (inefficient, but useful if cblas is unavailible)
-    
-    for(i=0;i<n_ppts_per_ele;i++)
-    {
-      for(k=0;k<n_fields;k++)
+      
+      //HACK (inefficient, but useful if cblas is unavailible)
+      
+      int i,j,m;
+      
+      for(m=0;m<in_n_eles;m++)
       {
-        out_disu_ppts(i,k) = 0.;
-        
-        for(j=0;j<n_upts_per_ele;j++)
+        for(i=0;i<n_ppts_per_ele;i++)
         {
-          out_disu_ppts(i,k) += opp_p(i,j)*disu_upts_plot(j,k);
+          C[i+m*n_ppts_per_ele] = 0.;
+          
+          for(j=0;j<n_upts_per_ele;j++)
+          {
+            C[i+m*n_ppts_per_ele] += opp_p(i,j)*B[j+m*n_upts_per_ele];
+          }
         }
       }
-    }
-    
+      
 #endif
+    }
     
   }
 }
 
 // calculate gradient of solution at the plot points
 void eles::calc_grad_disu_ppts(int in_ele, array<double>& out_grad_disu_ppts)
+{
+  // (n_ppts_per_ele,n_fields,n_dims) has the layout of a block of one element
+  calc_grad_disu_ppts(in_ele,1,out_grad_disu_ppts);
+}
+
+// calculate gradient of solution at the plot points of a block of elements, one product with opp_p per field and dimension
+void eles::calc_grad_disu_ppts(int in_ele, int in_n_eles, array<double>& out_grad_disu_ppts)
 {
   if (n_eles!=0)
   {
     
-    int i,j,k,l;
+    int i,k,l;
+    
+    // The gradient is only stored by viscous runs
+    if (!viscous)
+    {
+      for(i=0;i<n_ppts_per_ele*in_n_eles*n_fields*n_dims;i++)
+        out_grad_disu_ppts.get_ptr_cpu()[i] = 0.;
+      return;
+    }
     
-    array<double> grad_disu_upts_temp(n_upts_per_ele,n_fields,n_dims);
+    array<double>& grad_src = (out_buf < 0) ? grad_disu_upts : grad_disu_upts_out(out_buf);
     
-    for(i=0;i<n_fields;i++)
+    for(l=0;l<n_dims;l++)
     {
-      for(j=0;j<n_upts_per_ele;j++)
+      for(k=0;k<n_fields;k++)
       {
-        for(k=0;k<n_dims;k++)
+        double* B = grad_src.get_ptr_cpu(0,in_ele,k,l);
+        double* C = out_grad_disu_ppts.get_ptr_cpu()+(k+l*n_fields)*n_ppts_per_ele*in_n_eles;
+        
+#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
+        
+        cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_ppts_per_ele,in_n_eles,n_upts_per_ele,1.0,opp_p.get_ptr_cpu(),n_ppts_per_ele,B,n_upts_per_ele,0.0,C,n_ppts_per_ele);
+        
+#elif defined _NO_BLAS
+        
+        dgemm(n_ppts_per_ele,in_n_eles,n_upts_per_ele,1.0,0.0,opp_p.get_ptr_cpu(),B,C);
+        
+#else
+        
+        //HACK (inefficient, but useful if cblas is unavailible)
+        
+        int j,m;
+        
+        for(m=0;m<in_n_eles;m++)
         {
-          grad_disu_upts_temp(j,i,k)=grad_disu_upts(j,in_ele,i,k);
+          for(i=0;i<n_ppts_per_ele;i++)
+          {
+            C[i+m*n_ppts_per_ele] = 0.;
+            
+            for(j=0;j<n_upts_per_ele;j++)
+            {
+              C[i+m*n_ppts_per_ele] += opp_p(i,j)*B[j+m*n_upts_per_ele];
+            }
+          }
         }
+        
+#endif
       }
     }
     
-#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
-    
-    for (i=0;i<n_dims;i++) {
-      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,n_ppts_per_ele,n_fields,n_upts_per_ele,1.0,opp_p.get_ptr_cpu(),n_ppts_per_ele,grad_disu_upts_temp.get_ptr_cpu(0,0,i),n_upts_per_ele,0.0,out_grad_disu_ppts.get_ptr_cpu(0,0,i),n_ppts_per_ele);
-    }
+  }
+}
+
+// plot point positions of all elements, computed once as the mesh does not move
+array<double>& eles::get_pos_ppts(void)
+{
+  if (n_eles!=0 && pos_ppts.get_dim(0)!=n_ppts_per_ele)
+  {
+    array<double> pos_ppts_ele(n_ppts_per_ele,n_dims);
     
-#elif defined _NO_BLAS
+    pos_ppts.setup(n_ppts_per_ele,n_eles,n_dims);
     
-    for (i=0;i<n_dims;i++) {
-      dgemm(n_ppts_per_ele,n_fields,n_upts_per_ele,1.0,0.0,opp_p.get_ptr_cpu(),grad_disu_upts_temp.get_ptr_cpu(0,0,i),out_grad_disu_ppts.get_ptr_cpu(0,0,i));
+    for(int i=0;i<n_eles;i++)
+    {
+      calc_pos_ppts(i,pos_ppts_ele);
+      
+      for(int j=0;j<n_dims;j++)
+        for(int k=0;k<n_ppts_per_ele;k++)
+          pos_ppts(k,i,j) = pos_ppts_ele(k,j);
     }
-    
+  }
+  
+  return pos_ppts;
+}
+
+// calculate the solution at points of one element from their precomputed basis weights, one small product for all points and fields
+void eles::calc_disu_weights(int in_ele, int in_n_pts, double* in_weights, int in_ld_weights, double* out_disu, int in_ld_disu)
+{
+  // The fields of one element are n_upts_per_ele*n_eles apart
+  double* B = disu_upts(0).get_ptr_cpu(0,in_ele,0);
+  int ld_B = n_upts_per_ele*n_eles;
+  
+#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
+  
+  cblas_dgemm(CblasColMajor,CblasTrans,CblasNoTrans,in_n_pts,n_fields,n_upts_per_ele,1.0,in_weights,in_ld_weights,B,ld_B,0.0,out_disu,in_ld_disu);
+  
 #else
-    
-    //HACK (inefficient, but useful if cblas is unavailible)
-    
-    for(i=0;i<n_ppts_per_ele;i++)
+  
+  for(int k=0;k<n_fields;k++)
+  {
+    for(int p=0;p<in_n_pts;p++)
     {
-      for(k=0;k<n_fields;k++)
-      {
-        for(l=0;l<n_dims;l++)
-        {
-          out_grad_disu_ppts(i,k,l) = 0.;
-          for(j=0;j<n_upts_per_ele;j++)
-          {
-            out_grad_disu_ppts(i,k,l) += opp_p(i,j)*grad_disu_upts_temp(j,k,l);
-          }
-        }
-      }
+      double sum = 0.;
+      for(int j=0;j<n_upts_per_ele;j++)
+        sum += in_weights[j+p*in_ld_weights]*B[j+k*ld_B];
+      out_disu[p+k*in_ld_disu] = sum;
     }
-    
+  }
+  
 #endif
+}
+
+// allocate the solution snapshots of the background output writer
+void eles::setup_output_buffers(int in_n_bufs)
+{
+  if (n_eles!=0)
+  {
+    disu_upts_out.setup(in_n_bufs);
+    if (viscous)
+      grad_disu_upts_out.setup(in_n_bufs);
     
+    for (int b=0; b<in_n_bufs; b++)
+    {
+      disu_upts_out(b).setup(n_upts_per_ele,n_eles,n_fields);
+      if (viscous)
+        grad_disu_upts_out(b).setup(n_upts_per_ele,n_eles,n_fields,n_dims);
+    }
+  }
+}
+
+// snapshot the solution (copied to the host beforehand on the GPU) for the background output writer
+void eles::stage_output(int in_buf)
+{
+  if (n_eles!=0)
+  {
+    memcpy(disu_upts_out(in_buf).get_ptr_cpu(), disu_upts(0).get_ptr_cpu(), n_upts_per_ele*n_eles*n_fields*sizeof(double));
+    if (viscous)
+      memcpy(grad_disu_upts_out(in_buf).get_ptr_cpu(), grad_disu_upts.get_ptr_cpu(), n_upts_per_ele*n_eles*n_fields*n_dims*sizeof(double));
   }
 }
 
-// calculate diagnostic fields at the plot points
+// select the data read by the plot point and restart routines
+void eles::set_output_buffer(int in_buf)
+{
+  out_buf = in_buf;
+}
+
+// calculate diagnostic fields at the plot points of element in_ele of a block of plot point data
 void eles::calc_diagnostic_fields_ppts(int in_ele, array<double>& in_disu_ppts, array<double>& in_grad_disu_ppts, array<double>& out_diag_field_ppts)
 {
-  int i,j,k,m;
+  int j,k,m;
   double diagfield_upt;
   double u,v,w;
   double irho,pressure,v_sq;
@@ -3727,39 +4409,39 @@ void eles::calc_diagnostic_fields_ppts(int in_ele, array<double>& in_disu_ppts,
     // Compute velocity square
     v_sq = 0.;
     for (m=0;m<n_dims;m++)
-      v_sq += (in_disu_ppts(j,m+1)*in_disu_ppts(j,m+1));
-    v_sq /= in_disu_ppts(j,0)*in_disu_ppts(j,0);
+      v_sq += (in_disu_ppts(j,in_ele,m+1)*in_disu_ppts(j,in_ele,m+1));
+    v_sq /= in_disu_ppts(j,in_ele,0)*in_disu_ppts(j,in_ele,0);
     
     // Compute pressure
-    pressure = (run_input.gamma-1.0)*( in_disu_ppts(j,n_dims+1) - 0.5*in_disu_ppts(j,0)*v_sq);
+    pressure = (run_input.gamma-1.0)*( in_disu_ppts(j,in_ele,n_dims+1) - 0.5*in_disu_ppts(j,in_ele,0)*v_sq);
     
     // compute diagnostic fields
     for (k=0;k<n_diagnostic_fields;k++)
     {
-      irho = 1./in_disu_ppts(j,0);
+      irho = 1./in_disu_ppts(j,in_ele,0);
       
       if (run_input.diagnostic_fields(k)=="u")
-        diagfield_upt = in_disu_ppts(j,1)*irho;
+        diagfield_upt = in_disu_ppts(j,in_ele,1)*irho;
       else if (run_input.diagnostic_fields(k)=="v")
-        diagfield_upt = in_disu_ppts(j,2)*irho;
+        diagfield_upt = in_disu_ppts(j,in_ele,2)*irho;
       else if (run_input.diagnostic_fields(k)=="w")
       {
         if (n_dims==2)
           diagfield_upt = 0.;
         else if (n_dims==3)
-          diagfield_upt = in_disu_ppts(j,3)*irho;
+          diagfield_upt = in_disu_ppts(j,in_ele,3)*irho;
       }
       else if (run_input.diagnostic_fields(k)=="energy")
       {
         if (n_dims==2)
-          diagfield_upt = in_disu_ppts(j,3);
+          diagfield_upt = in_disu_ppts(j,in_ele,3);
         else if (n_dims==3)
-          diagfield_upt = in_disu_ppts(j,4);
+          diagfield_upt = in_disu_ppts(j,in_ele,4);
       }
       // flow properties
       else if (run_input.diagnostic_fields(k)=="mach")
       {
-        diagfield_upt = sqrt( v_sq / (run_input.gamma*pressure/in_disu_ppts(j,0)) );
+        diagfield_upt = sqrt( v_sq / (run_input.gamma*pressure/in_disu_ppts(j,in_ele,0)) );
       }
       else if (run_input.diagnostic_fields(k)=="pressure")
       {
@@ -3768,13 +4450,13 @@ void eles::calc_diagnostic_fields_ppts(int in_ele, array<double>& in_disu_ppts,
       // turbulence metrics
       else if (run_input.diagnostic_fields(k)=="vorticity" || run_input.diagnostic_fields(k)=="q_criterion")
       {
-        u = in_disu_ppts(j,1)*irho;
-        v = in_disu_ppts(j,2)*irho;
+        u = in_disu_ppts(j,in_ele,1)*irho;
+        v = in_disu_ppts(j,in_ele,2)*irho;
         
-        dudx = irho*(in_grad_disu_ppts(j,1,0) - u*in_grad_disu_ppts(j,0,0));
-        dudy = irho*(in_grad_disu_ppts(j,1,1) - u*in_grad_disu_ppts(j,0,1));
-        dvdx = irho*(in_grad_disu_ppts(j,2,0) - v*in_grad_disu_ppts(j,0,0));
-        dvdy = irho*(in_grad_disu_ppts(j,2,1) - v*in_grad_disu_ppts(j,0,1));
+        dudx = irho*(in_grad_disu_ppts(j,in_ele,1,0) - u*in_grad_disu_ppts(j,in_ele,0,0));
+        dudy = irho*(in_grad_disu_ppts(j,in_ele,1,1) - u*in_grad_disu_ppts(j,in_ele,0,1));
+        dvdx = irho*(in_grad_disu_ppts(j,in_ele,2,0) - v*in_grad_disu_ppts(j,in_ele,0,0));
+        dvdy = irho*(in_grad_disu_ppts(j,in_ele,2,1) - v*in_grad_disu_ppts(j,in_ele,0,1));
         
         if (n_dims==2)
         {
@@ -3789,14 +4471,14 @@ void eles::calc_diagnostic_fields_ppts(int in_ele, array<double>& in_disu_ppts,
         }
         else if (n_dims==3)
         {
-          w = in_disu_ppts(j,3)*irho;
+          w = in_disu_ppts(j,in_ele,3)*irho;
           
-          dudz = irho*(in_grad_disu_ppts(j,1,2) - u*in_grad_disu_ppts(j,0,2));
-          dvdz = irho*(in_grad_disu_ppts(j,2,2) - v*in_grad_disu_ppts(j,0,2));
+          dudz = irho*(in_grad_disu_ppts(j,in_ele,1,2) - u*in_grad_disu_ppts(j,in_ele,0,2));
+          dvdz = irho*(in_grad_disu_ppts(j,in_ele,2,2) - v*in_grad_disu_ppts(j,in_ele,0,2));
           
-          dwdx = irho*(in_grad_disu_ppts(j,3,0) - w*in_grad_disu_ppts(j,0,0));
-          dwdy = irho*(in_grad_disu_ppts(j,3,1) - w*in_grad_disu_ppts(j,0,1));
-          dwdz = irho*(in_grad_disu_ppts(j,3,2) - w*in_grad_disu_ppts(j,0,2));
+          dwdx = irho*(in_grad_disu_ppts(j,in_ele,3,0) - w*in_grad_disu_ppts(j,in_ele,0,0));
+          dwdy = irho*(in_grad_disu_ppts(j,in_ele,3,1) - w*in_grad_disu_ppts(j,in_ele,0,1));
+          dwdz = irho*(in_grad_disu_ppts(j,in_ele,3,2) - w*in_grad_disu_ppts(j,in_ele,0,2));
           
           wx = dwdy - dvdz;
           wy = dudz - dwdx;
@@ -4250,6 +4932,11 @@ void eles::set_transforms()
       }
     }
     
+#ifdef _CPU
+    if (run_input.equation==1)
+      set_linear_advection();
+#endif
+    
 #ifdef _GPU
     tdA_fpts.mv_cpu_gpu();
     norm_fpts.mv_cpu_gpu();
@@ -4270,6 +4957,59 @@ void eles::set_transforms()
 }
 
 
+// precompute the flux coefficients of the linear advection-diffusion equation
+
+void eles::set_linear_advection(void)
+{
+  int i,j,k,l,m;
+  bool affine = true;
+  
+  // transformed wave speed at the solution points
+  tws_upts.setup(n_upts_per_ele,n_eles,n_dims);
+  
+  for(l=0;l<n_dims;l++)
+    for(i=0;i<n_eles;i++)
+      for(j=0;j<n_upts_per_ele;j++)
+      {
+        tws_upts(j,i,l)=0.;
+        for(m=0;m<n_dims;m++)
+        {
+          tws_upts(j,i,l)+=JGinv_upts(j,i,l,m)*run_input.wave_speed(m);
+          
+          if (fabs(JGinv_upts(j,i,l,m)-JGinv_upts(0,i,l,m)) > 1.e-12*(1.+fabs(JGinv_upts(0,i,l,m))))
+            affine = false;
+        }
+      }
+  
+  // With a transform constant in each element (affine elements), the flux extrapolation commutes with the metrics:
+  // the normal transformed flux at the flux points is the normal transformed wave speed times the extrapolated
+  // solution, plus the normal transformed diffusion times the extrapolated physical gradient
+  lin_affine = affine;
+  
+  if (lin_affine)
+  {
+    ntws_fpts.setup(n_fpts_per_ele,n_eles);
+    if (viscous)
+      ntdiff_fpts.setup(n_fpts_per_ele,n_eles,n_dims);
+    
+    for(i=0;i<n_eles;i++)
+      for(k=0;k<n_fpts_per_ele;k++)
+      {
+        ntws_fpts(k,i)=0.;
+        for(l=0;l<n_dims;l++)
+          ntws_fpts(k,i)+=tnorm_fpts(l,k)*tws_upts(0,i,l);
+        
+        if (viscous)
+          for(m=0;m<n_dims;m++)
+          {
+            ntdiff_fpts(k,i,m)=0.;
+            for(l=0;l<n_dims;l++)
+              ntdiff_fpts(k,i,m)-=tnorm_fpts(l,k)*JGinv_upts(0,i,l,m)*run_input.diff_coeff;
+          }
+      }
+  }
+}
+
 void eles::set_bdy_ele2ele(void)
 {
   
@@ -4674,7 +5414,7 @@ double* eles::get_grad_disu_fpts_ptr(int in_inter_local_fpt, int in_ele_local_in
 #endif
 }
 
-double* eles::get_normal_disu_fpts_ptr(int in_inter_local_fpt, int in_ele_local_inter, int in_field, int in_ele, array<double> temp_loc, double temp_pos[3])
+double* eles::get_normal_disu_fpts_ptr(int in_inter_local_fpt, int in_ele_local_inter, int in_field, int in_ele, array<double>& temp_loc, double temp_pos[3])
 {
   
   array<double> pos(n_dims);
@@ -4759,7 +5499,7 @@ double* eles::get_sgsf_fpts_ptr(int in_inter_local_fpt, int in_ele_local_inter,
 
 // calculate position
 
-void eles::calc_pos(array<double> in_loc, int in_ele, array<double>& out_pos)
+void eles::calc_pos(array_view<double> in_loc, int in_ele, array<double>& out_pos)
 {
   int i,j;
   
@@ -4777,7 +5517,7 @@ void eles::calc_pos(array<double> in_loc, int in_ele, array<double>& out_pos)
 
 // calculate derivative of position - NEEDS TO BE OPTIMIZED
 
-void eles::calc_d_pos(array<double> in_loc, int in_ele, array<double>& out_d_pos)
+void eles::calc_d_pos(array_view<double> in_loc, int in_ele, array<double>& out_d_pos)
 {
   int i,j,k;
   
@@ -4797,9 +5537,91 @@ void eles::calc_d_pos(array<double> in_loc, int in_ele, array<double>& out_d_pos
   }
 }
 
+// find the reference location of a physical position by Newton iterations on calc_pos
+
+bool eles::calc_loc_of_pos(array<double>& in_pos, int in_ele, array<double>& out_loc)
+{
+  array<double> pos(n_dims), d_pos(n_dims,n_dims), res(n_dims), delta(n_dims);
+  double tol = 1.e-8, det;
+  bool converged = false;
+
+  // start from the centroid of the reference element
+  for (int m=0;m<n_dims;m++)
+    out_loc(m) = 0.;
+  if (ele_type==0 || ele_type==3) { out_loc(0) = -1./3.; out_loc(1) = -1./3.; }
+  else if (ele_type==2) { out_loc(0) = -0.5; out_loc(1) = -0.5; out_loc(2) = -0.5; }
+
+  for (int iter=0;iter<30 && !converged;iter++)
+    {
+      calc_pos(out_loc,in_ele,pos);
+      calc_d_pos(out_loc,in_ele,d_pos);
+
+      for (int m=0;m<n_dims;m++)
+        res(m) = in_pos(m)-pos(m);
+
+      // solve d_pos*delta = res (d_pos(j,k) = dx_j/dr_k) by Cramer's rule
+      if (n_dims==2)
+        {
+          det = d_pos(0,0)*d_pos(1,1)-d_pos(0,1)*d_pos(1,0);
+          if (det==0.)
+            return false;
+          delta(0) = (res(0)*d_pos(1,1)-d_pos(0,1)*res(1))/det;
+          delta(1) = (d_pos(0,0)*res(1)-res(0)*d_pos(1,0))/det;
+        }
+      else
+        {
+          det = d_pos(0,0)*(d_pos(1,1)*d_pos(2,2)-d_pos(1,2)*d_pos(2,1))
+              - d_pos(0,1)*(d_pos(1,0)*d_pos(2,2)-d_pos(1,2)*d_pos(2,0))
+              + d_pos(0,2)*(d_pos(1,0)*d_pos(2,1)-d_pos(1,1)*d_pos(2,0));
+          if (det==0.)
+            return false;
+          for (int k=0;k<3;k++)
+            {
+              // replace column k by the residual
+              double c[3][3];
+              for (int j=0;j<3;j++)
+                for (int l=0;l<3;l++)
+                  c[j][l] = (l==k) ? res(j) : d_pos(j,l);
+              delta(k) = (c[0][0]*(c[1][1]*c[2][2]-c[1][2]*c[2][1])
+                        - c[0][1]*(c[1][0]*c[2][2]-c[1][2]*c[2][0])
+                        + c[0][2]*(c[1][0]*c[2][1]-c[1][1]*c[2][0]))/det;
+            }
+        }
+
+      converged = true;
+      for (int m=0;m<n_dims;m++)
+        {
+          out_loc(m) += delta(m);
+          if (fabs(delta(m)) > 1.e-10)
+            converged = false;
+          // far outside the reference element: the point belongs to another element
+          if (fabs(out_loc(m)) > 10.)
+            return false;
+        }
+    }
+
+  if (!converged)
+    return false;
+
+  // inside the reference element, up to tol
+  if (ele_type==0)
+    return (out_loc(0) >= -1.-tol && out_loc(1) >= -1.-tol && out_loc(0)+out_loc(1) <= tol);
+  else if (ele_type==2)
+    return (out_loc(0) >= -1.-tol && out_loc(1) >= -1.-tol && out_loc(2) >= -1.-tol && out_loc(0)+out_loc(1)+out_loc(2) <= -1.+tol);
+  else if (ele_type==3)
+    return (out_loc(0) >= -1.-tol && out_loc(1) >= -1.-tol && out_loc(0)+out_loc(1) <= tol && fabs(out_loc(2)) <= 1.+tol);
+  else
+    {
+      for (int m=0;m<n_dims;m++)
+        if (fabs(out_loc(m)) > 1.+tol)
+          return false;
+      return true;
+    }
+}
+
 // calculate second derivative of position
 
-void eles::calc_dd_pos(array<double> in_loc, int in_ele, array<double>& out_dd_pos)
+void eles::calc_dd_pos(array_view<double> in_loc, int in_ele, array<double>& out_dd_pos)
 {
   int i,j,k;
   int n_comp;
@@ -4825,6 +5647,13 @@ void eles::calc_dd_pos(array<double> in_loc, int in_ele, array<double>& out_dd_p
   }
 }
 
+// residual norm of a field accumulated by the last step
+
+double eles::get_res_norm_sum(int in_field)
+{
+  return res_norm_sum(in_field);
+}
+
 /*! Calculate residual sum for monitoring purposes */
 double eles::compute_res_upts(int in_norm_type, int in_field) {
   
@@ -4837,20 +5666,124 @@ double eles::compute_res_upts(int in_norm_type, int in_field) {
   for (i=0; i<n_eles; i++) {
     cell_sum=0;
     for (j=0; j<n_upts_per_ele; j++) {
-      if (in_norm_type == 1) {
+      if (in_norm_type == 0) {
+        cell_sum = max(cell_sum, fabs(div_tconf_upts(0)(j, i, in_field)/detjac_upts(j, i)));
+      }
+      else if (in_norm_type == 1) {
         cell_sum += abs(div_tconf_upts(0)(j, i, in_field)/detjac_upts(j, i));
       }
       else if (in_norm_type == 2) {
         cell_sum += div_tconf_upts(0)(j, i, in_field)/detjac_upts(j,i)*div_tconf_upts(0)(j, i, in_field)/detjac_upts(j, i);
       }
     }
-    sum += cell_sum;
+    if (in_norm_type == 0)
+      sum = max(sum, cell_sum);
+    else
+      sum += cell_sum;
   }
   
   return sum;
   
 }
 
+// name an array for the memory report
+
+template <typename T>
+static void tag_array(array<T>& in_array, const string& in_prefix, const char* in_name)
+{
+  in_array.set_tag((in_prefix+in_name).c_str());
+}
+
+// name an array of arrays (and its members) for the memory report
+
+template <typename T>
+static void tag_array(array< array<T> >& in_array, const string& in_prefix, const char* in_name)
+{
+  in_array.set_tag((in_prefix+in_name).c_str());
+  for (int i=0; i<in_array.get_dim(0)*in_array.get_dim(1)*in_array.get_dim(2)*in_array.get_dim(3); i++)
+    in_array.get_ptr_cpu()[i].set_tag((in_prefix+in_name).c_str());
+}
+
+// name the arrays of this element type for the memory report
+
+void eles::tag_arrays(void)
+{
+  const char* ele_names[5] = {"tris", "quads", "tets", "pris", "hexas"};
+  string prefix = string(ele_names[ele_type]) + "/";
+
+  // solution, flux and residual storage
+  tag_array(disu_upts, prefix, "disu_upts");
+  tag_array(disu_upts_out, prefix, "disu_upts_out");
+  tag_array(grad_disu_upts_out, prefix, "grad_disu_upts_out");
+  tag_array(div_tconf_upts, prefix, "div_tconf_upts");
+  tag_array(disu_fpts, prefix, "disu_fpts");
+  tag_array(tdisf_upts, prefix, "tdisf_upts");
+  tag_array(norm_tdisf_fpts, prefix, "norm_tdisf_fpts");
+  tag_array(norm_tconf_fpts, prefix, "norm_tconf_fpts");
+  tag_array(delta_disu_fpts, prefix, "delta_disu_fpts");
+  tag_array(grad_disu_upts, prefix, "grad_disu_upts");
+  tag_array(grad_disu_fpts, prefix, "grad_disu_fpts");
+  tag_array(pos_ppts, prefix, "pos_ppts");
+
+  // LES and wall model
+  tag_array(sgsf_upts, prefix, "sgsf_upts");
+  tag_array(sgsf_fpts, prefix, "sgsf_fpts");
+  tag_array(disuf_upts, prefix, "disuf_upts");
+  tag_array(Lu, prefix, "Lu");
+  tag_array(Le, prefix, "Le");
+  tag_array(uu, prefix, "uu");
+  tag_array(ue, prefix, "ue");
+  tag_array(wall_distance, prefix, "wall_distance");
+  tag_array(twall, prefix, "twall");
+
+  // geometry and transforms
+  tag_array(shape, prefix, "shape");
+  tag_array(n_spts_per_ele, prefix, "n_spts_per_ele");
+  tag_array(ele2global_ele, prefix, "ele2global_ele");
+  tag_array(ele_color, prefix, "ele_color");
+  tag_array(bctype, prefix, "bctype");
+  tag_array(detjac_upts, prefix, "detjac_upts");
+  tag_array(detjac_fpts, prefix, "detjac_fpts");
+  tag_array(JGinv_upts, prefix, "JGinv_upts");
+  tag_array(JGinv_fpts, prefix, "JGinv_fpts");
+  tag_array(tdA_fpts, prefix, "tdA_fpts");
+  tag_array(norm_fpts, prefix, "norm_fpts");
+  tag_array(loc_fpts, prefix, "loc_fpts");
+  tag_array(tgrad_detjac_upts, prefix, "tgrad_detjac_upts");
+  tag_array(tgrad_detjac_fpts, prefix, "tgrad_detjac_fpts");
+  tag_array(vol_detjac_inters_cubpts, prefix, "vol_detjac_inters_cubpts");
+  tag_array(vol_detjac_vol_cubpts, prefix, "vol_detjac_vol_cubpts");
+  tag_array(inter_detjac_inters_cubpts, prefix, "inter_detjac_inters_cubpts");
+  tag_array(norm_inters_cubpts, prefix, "norm_inters_cubpts");
+  tag_array(tws_upts, prefix, "tws_upts");
+  tag_array(ntws_fpts, prefix, "ntws_fpts");
+  tag_array(ntdiff_fpts, prefix, "ntdiff_fpts");
+
+  // timestepping
+  tag_array(h_ref, prefix, "h_ref");
+  tag_array(dt_local, prefix, "dt_local");
+  tag_array(dual_src_upts, prefix, "dual_src_upts");
+  tag_array(rk_err_upts, prefix, "rk_err_upts");
+  tag_array(rk_save_upts, prefix, "rk_save_upts");
+  tag_array(res_norm_sum, prefix, "res_norm_sum");
+  tag_array(lts_level, prefix, "lts_level");
+  tag_array(lts_nb_level, prefix, "lts_nb_level");
+  tag_array(lts_flux_reg, prefix, "lts_flux_reg");
+
+  // element-independent operators
+  tag_array(opp_0, prefix, "operators");
+  tag_array(opp_1, prefix, "operators");
+  tag_array(opp_2, prefix, "operators");
+  tag_array(opp_3, prefix, "operators");
+  tag_array(opp_4, prefix, "operators");
+  tag_array(opp_5, prefix, "operators");
+  tag_array(opp_6, prefix, "operators");
+  tag_array(opp_p, prefix, "operators");
+  tag_array(opp_r, prefix, "operators");
+  tag_array(opp_inters_cubpts, prefix, "operators");
+  tag_array(opp_volume_cubpts, prefix, "operators");
+}
+
 
 array<double> eles::compute_error(int in_norm_type, double& time)
 {
@@ -5320,23 +6253,18 @@ void eles::CalcIntegralQuantities(int n_integral_quantities, array <double>& int
   }
 }
 
-void eles::compute_wall_forces( array<double>& inv_force, array<double>& vis_force,  double& temp_cl, double& temp_cd, ofstream& coeff_file, bool write_forces)
+void eles::compute_wall_forces( array<double>& inv_force, array<double>& vis_force,  double& temp_cl, double& temp_cd, ostream& coeff_file, bool write_forces)
 {
   
   array<double> u_l(n_fields),norm(n_dims);
-  double p_l,v_sq,vn_l;
+  double p_l;
   array<double> grad_u_l(n_fields,n_dims);
-  array<double> dv(n_dims,n_dims);
-  array<double> de(n_dims);
-  array<double> drho(n_dims);
   array<double> taun(n_dims);
-  array<double> tautan(n_dims);
   array<double> Finv(n_dims);
   array<double> Fvis(n_dims);
   array<double> loc(n_dims);
   array<double> pos(n_dims);
-  double inte, mu, rt_ratio, gamma=run_input.gamma;
-  double diag, tauw, taundotn, wgt, detjac;
+  double tauw, wgt, detjac;
   double factor, aoa, aos, cp, cf, cl, cd;
   
   // Need to add a reference area to the input file... Not needed for Cp/Cf,
@@ -5392,61 +6320,9 @@ void eles::compute_wall_forces( array<double>& inv_force, array<double>& vis_for
 
                   calc_pos(loc,ele,pos);
 
-                  // Compute solution at current cubature point
-                  for (int m=0;m<n_fields;m++) {
-                      double value = 0.;
-                      for (int k=0;k<n_upts_per_ele;k++) {
-                          value += opp_inters_cubpts(l)(j,k)*disu_upts(0)(k,ele,m);
-                        }
-                      u_l(m) = value;
-                    }
-
-                  // If viscous, extrapolate the gradient at the cubature points
-                  if (viscous==1)
-                    {
-                      for (int m=0;m<n_fields;m++) {
-                          for (int n=0;n<n_dims;n++) {
-                              double value=0.;
-                              for (int k=0;k<n_upts_per_ele;k++) {
-                                  value += opp_inters_cubpts(l)(j,k)*grad_disu_upts(k,ele,m,n);
-                                }
-                              grad_u_l(m,n) = value;
-                            }
-                        }
-                    }
-
-                  // Get the normal
-                  for (int m=0;m<n_dims;m++)
-                    {
-                      norm(m) = norm_inters_cubpts(l)(j,i,m);
-                    }
-
-                  // Get pressure
-
-                  // Not dual consistent
-                  if (bctype(ele,l)!=16) {
-                      v_sq = 0.;
-                      for (int m=0;m<n_dims;m++)
-                        v_sq += (u_l(m+1)*u_l(m+1));
-                      p_l   = (gamma-1.0)*( u_l(n_dims+1) - 0.5*v_sq/u_l(0));
-                    }
-                  else
-                    {
-                      //Dual consistent approach
-                      vn_l = 0.;
-                      for (int m=0;m<n_dims;m++)
-                        vn_l += u_l(m+1)*norm(m);
-                      vn_l /= u_l(0);
-
-                      for (int m=0;m<n_dims;m++)
-                        u_l(m+1) = u_l(m+1)-(vn_l)*norm(m);
+                  // Get solution, gradient, normal and pressure at the cubature point
+                  calc_wall_state(i,l,j,disu_upts(0),grad_disu_upts,u_l,grad_u_l,norm,p_l);
 
-                      v_sq = 0.;
-                      for (int m=0;m<n_dims;m++)
-                        v_sq += (u_l(m+1)*u_l(m+1));
-                      p_l   = (gamma-1.0)*( u_l(n_dims+1) - 0.5*v_sq/u_l(0));
-                    }
-                  
                   // calculate pressure coefficient at current point on the surface
                   cp = (p_l-run_input.p_c_ic)*factor;
                   
@@ -5474,107 +6350,30 @@ void eles::compute_wall_forces( array<double>& inv_force, array<double>& vis_for
 
                   if (viscous==1)
                     {
-                      // TODO: Have a function that returns tau given u and grad_u
-                      // Computing the n_dims derivatives of rho,u,v,w and ene
-                      for (int m=0;m<n_dims;m++)
-                        {
-                          drho(m) = grad_u_l(0,m);
-                          for (int n=0;n<n_dims;n++)
-                            {
-                              dv(n,m) = 1.0/u_l(0)*(grad_u_l(n+1,m)-drho(m)*u_l(n+1));;
-                            }
-                          de(m) = 1.0/u_l(0)*(grad_u_l(n_dims+1,m)-drho(m)*u_l(n_dims+1));;
-                        }
+                      // wall shear stress and stresses w.r.t. normal
+                      tauw = calc_wall_shear(u_l,grad_u_l,norm,taun);
 
-                      // trace of stress tensor
-                      diag = 0.;
-                      for (int m=0;m<n_dims;m++)
-                        {
-                          diag += dv(m,m);
-                        }
-                      diag /= 3.0;
+                      // coefficient of friction
+                      cf = tauw*factor;
 
-                      // internal energy
-                      inte = u_l(n_dims+1)/u_l(0);
+                      if (write_forces) { coeff_file << " " << setw(18) <<setprecision(12) << cf; }
+
+                      // viscous force
                       for (int m=0;m<n_dims;m++)
                         {
-                          inte -= 0.5*u_l(m+1)*u_l(m+1);
+                          Fvis(m) = -wgt*taun(m)*detjac*factor;
                         }
 
-                      // get viscosity
-                      rt_ratio = (run_input.gamma-1.0)*inte/(run_input.rt_inf);
-                      mu = (run_input.mu_inf)*pow(rt_ratio,1.5)*(1+(run_input.c_sth))/(rt_ratio+(run_input.c_sth));
-                      mu = mu + run_input.fix_vis*(run_input.mu_inf - mu);
-
-                      // Compute the coefficient of friction and wall shear stress
+                      // viscous component of the lift and drag coefficients
                       if (n_dims==2)
                         {
-                          // stresses w.r.t. normal
-                          taun(0) = mu*(2.*(dv(0,0)-diag)*norm(0) + (dv(0,1)+dv(1,0))*norm(1));
-                          taun(1) = mu*(2.*(dv(1,1)-diag)*norm(1) + (dv(0,1)+dv(1,0))*norm(0));
-
-                          // take dot product with normal
-                          taundotn = taun(0)*norm(0)+taun(1)*norm(1);
-                          
-                          // stresses tangent to wall
-                          tautan(0) = taun(0) - taundotn*norm(0);
-                          tautan(1) = taun(1) - taundotn*norm(1);
-
-                          // wall shear stress
-                          tauw = sqrt(pow(tautan(0),2)+pow(tautan(1),2));
-
-                          // coefficient of friction
-                          cf = tauw*factor;
-                          
-                          if (write_forces) { coeff_file << " " << setw(18) <<setprecision(12) << cf; }
-
-                          // viscous force
-                          for (int m=0;m<n_dims;m++)
-                          {
-                            Fvis(m) = -wgt*taun(m)*detjac*factor;
-                          }
-                          
-                          // viscous component of the lift and drag coefficients
-                          
                           cl += -Fvis(0)*sin(aoa) + Fvis(1)*cos(aoa);
                           cd += Fvis(0)*cos(aoa) + Fvis(1)*sin(aoa);
-                          
                         }
-
-                      if (n_dims==3)
+                      else if (n_dims==3)
                         {
-                          // stresses w.r.t. normal
-                          taun(0) = mu*(2.*(dv(0,0)-diag)*norm(0) + (dv(0,1)+dv(1,0))*norm(1) + (dv(0,2)+dv(2,0))*norm(2));
-                          taun(1) = mu*(2.*(dv(1,1)-diag)*norm(1) + (dv(0,1)+dv(1,0))*norm(0) + (dv(1,2)+dv(2,1))*norm(2));
-                          taun(2) = mu*(2.*(dv(2,2)-diag)*norm(2) + (dv(0,2)+dv(2,0))*norm(0) + (dv(1,2)+dv(2,1))*norm(1));
-                          
-                          // take dot product with normal
-                          taundotn = taun(0)*norm(0)+taun(1)*norm(1)+taun(2)*norm(2);
-                          
-                          // stresses tangent to wall
-                          tautan(0) = taun(0) - taundotn*norm(0);
-                          tautan(1) = taun(1) - taundotn*norm(1);
-                          tautan(2) = taun(2) - taundotn*norm(2);
-                          
-                          // wall shear stress
-                          tauw = sqrt(pow(tautan(0),2)+pow(tautan(1),2)+pow(tautan(2),2));
-                          
-                          // coefficient of friction
-                          cf = tauw*factor;
-                          
-                          if (write_forces) { coeff_file << " " << setw(18) <<setprecision(12) << cf; }
-                          
-                          // viscous force
-                          for (int m=0;m<n_dims;m++)
-                            {
-                              Fvis(m) = -wgt*taun(m)*detjac*factor;
-                            }
-
-                          // viscous component of the lift and drag coefficients
-                          
                           cl += -Fvis(0)*sin(aoa) + Fvis(1)*cos(aoa);
                           cd += Fvis(0)*cos(aoa)*cos(aos) + Fvis(1)*sin(aoa) + Fvis(2)*sin(aoa)*cos(aos);
-                          
                         }
                     } // End of if viscous
 
@@ -5594,3 +6393,213 @@ void eles::compute_wall_forces( array<double>& inv_force, array<double>& vis_for
     }
 }
 
+// solution, gradient, outward normal and pressure at a cubature point of a wall interface
+
+void eles::calc_wall_state(int in_bdy_ele, int in_inter, int in_cubpt, array<double>& in_disu, array<double>& in_grad_disu, array<double>& out_u, array<double>& out_grad_u, array<double>& out_norm, double& out_p)
+{
+  int ele = bdy_ele2ele(in_bdy_ele);
+  double v_sq, vn;
+  double gamma=run_input.gamma;
+
+  // Compute solution at current cubature point
+  for (int m=0;m<n_fields;m++) {
+      double value = 0.;
+      for (int k=0;k<n_upts_per_ele;k++) {
+          value += opp_inters_cubpts(in_inter)(in_cubpt,k)*in_disu(k,ele,m);
+        }
+      out_u(m) = value;
+    }
+
+  // If viscous, extrapolate the gradient at the cubature points
+  if (viscous==1)
+    {
+      for (int m=0;m<n_fields;m++) {
+          for (int n=0;n<n_dims;n++) {
+              double value=0.;
+              for (int k=0;k<n_upts_per_ele;k++) {
+                  value += opp_inters_cubpts(in_inter)(in_cubpt,k)*in_grad_disu(k,ele,m,n);
+                }
+              out_grad_u(m,n) = value;
+            }
+        }
+    }
+
+  // Get the normal
+  for (int m=0;m<n_dims;m++)
+    {
+      out_norm(m) = norm_inters_cubpts(in_inter)(in_cubpt,in_bdy_ele,m);
+    }
+
+  // Get pressure
+
+  // Not dual consistent
+  if (bctype(ele,in_inter)!=16) {
+      v_sq = 0.;
+      for (int m=0;m<n_dims;m++)
+        v_sq += (out_u(m+1)*out_u(m+1));
+      out_p = (gamma-1.0)*( out_u(n_dims+1) - 0.5*v_sq/out_u(0));
+    }
+  else
+    {
+      //Dual consistent approach
+      vn = 0.;
+      for (int m=0;m<n_dims;m++)
+        vn += out_u(m+1)*out_norm(m);
+      vn /= out_u(0);
+
+      for (int m=0;m<n_dims;m++)
+        out_u(m+1) = out_u(m+1)-(vn)*out_norm(m);
+
+      v_sq = 0.;
+      for (int m=0;m<n_dims;m++)
+        v_sq += (out_u(m+1)*out_u(m+1));
+      out_p = (gamma-1.0)*( out_u(n_dims+1) - 0.5*v_sq/out_u(0));
+    }
+}
+
+// number of cubature points on the interfaces with a boundary type in in_bctypes
+
+int eles::get_n_surface_pts(array<int>& in_bctypes)
+{
+  int n_pts = 0;
+
+  for (int i=0;i<n_bdy_eles;i++) {
+      int ele = bdy_ele2ele(i);
+      for (int l=0;l<n_inters_per_ele;l++) {
+          for (int b=0;b<in_bctypes.get_dim(0);b++) {
+              if (bctype(ele,l) == in_bctypes(b)) {
+                  n_pts += n_cubpts_per_inter(l);
+                  break;
+                }
+            }
+        }
+    }
+
+  return n_pts;
+}
+
+// position, density, velocity, pressure, Cp and (if viscous) Cf at the cubature points of the selected boundaries
+
+void eles::calc_surface_data(array<int>& in_bctypes, array<double>& out_data)
+{
+  array<double> u_l(n_fields),norm(n_dims);
+  array<double> grad_u_l(n_fields,n_dims);
+  array<double> taun(n_dims);
+  array<double> loc(n_dims);
+  array<double> pos(n_dims);
+  double p_l, factor;
+  int pt = 0;
+
+  // the snapshot being written by the background output writer, or the current solution
+  array<double>& disu_src = (out_buf < 0) ? disu_upts(0) : disu_upts_out(out_buf);
+  array<double>& grad_src = (out_buf < 0 || !viscous) ? grad_disu_upts : grad_disu_upts_out(out_buf);
+
+  // one over the dynamic pressure, as in compute_wall_forces
+  factor = 1.0 / (0.5*run_input.rho_c_ic*(run_input.u_c_ic*run_input.u_c_ic+run_input.v_c_ic*run_input.v_c_ic+run_input.w_c_ic*run_input.w_c_ic));
+
+  for (int i=0;i<n_bdy_eles;i++) {
+      int ele = bdy_ele2ele(i);
+      for (int l=0;l<n_inters_per_ele;l++) {
+
+          bool selected = false;
+          for (int b=0;b<in_bctypes.get_dim(0);b++)
+            if (bctype(ele,l) == in_bctypes(b))
+              selected = true;
+
+          if (!selected)
+            continue;
+
+          for (int j=0;j<n_cubpts_per_inter(l);j++)
+            {
+              for (int m=0;m<n_dims;m++)
+                loc(m) = loc_inters_cubpts(l)(m,j);
+
+              calc_pos(loc,ele,pos);
+
+              calc_wall_state(i,l,j,disu_src,grad_src,u_l,grad_u_l,norm,p_l);
+
+              int v = 0;
+              for (int m=0;m<n_dims;m++)
+                out_data(v++,pt) = pos(m);
+              out_data(v++,pt) = u_l(0);
+              for (int m=0;m<n_dims;m++)
+                out_data(v++,pt) = u_l(m+1)/u_l(0);
+              out_data(v++,pt) = p_l;
+              out_data(v++,pt) = (p_l-run_input.p_c_ic)*factor;
+              if (viscous==1)
+                out_data(v++,pt) = calc_wall_shear(u_l,grad_u_l,norm,taun)*factor;
+
+              pt++;
+            }
+        }
+    }
+}
+
+// viscous stresses w.r.t. the wall normal, returns the wall shear stress
+
+double eles::calc_wall_shear(array<double>& in_u, array<double>& in_grad_u, array<double>& in_norm, array<double>& out_taun)
+{
+  double dv[3][3], drho[3];
+  double inte, mu, rt_ratio, diag, taundotn, tauw;
+  double tautan[3];
+
+  // Computing the n_dims derivatives of rho,u,v,w
+  for (int m=0;m<n_dims;m++)
+    {
+      drho[m] = in_grad_u(0,m);
+      for (int n=0;n<n_dims;n++)
+        {
+          dv[n][m] = 1.0/in_u(0)*(in_grad_u(n+1,m)-drho[m]*in_u(n+1));
+        }
+    }
+
+  // trace of stress tensor
+  diag = 0.;
+  for (int m=0;m<n_dims;m++)
+    {
+      diag += dv[m][m];
+    }
+  diag /= 3.0;
+
+  // internal energy
+  inte = in_u(n_dims+1)/in_u(0);
+  for (int m=0;m<n_dims;m++)
+    {
+      inte -= 0.5*in_u(m+1)*in_u(m+1);
+    }
+
+  // get viscosity
+  rt_ratio = (run_input.gamma-1.0)*inte/(run_input.rt_inf);
+  mu = (run_input.mu_inf)*pow(rt_ratio,1.5)*(1+(run_input.c_sth))/(rt_ratio+(run_input.c_sth));
+  mu = mu + run_input.fix_vis*(run_input.mu_inf - mu);
+
+  // stresses w.r.t. normal
+  if (n_dims==2)
+    {
+      out_taun(0) = mu*(2.*(dv[0][0]-diag)*in_norm(0) + (dv[0][1]+dv[1][0])*in_norm(1));
+      out_taun(1) = mu*(2.*(dv[1][1]-diag)*in_norm(1) + (dv[0][1]+dv[1][0])*in_norm(0));
+    }
+  else
+    {
+      out_taun(0) = mu*(2.*(dv[0][0]-diag)*in_norm(0) + (dv[0][1]+dv[1][0])*in_norm(1) + (dv[0][2]+dv[2][0])*in_norm(2));
+      out_taun(1) = mu*(2.*(dv[1][1]-diag)*in_norm(1) + (dv[0][1]+dv[1][0])*in_norm(0) + (dv[1][2]+dv[2][1])*in_norm(2));
+      out_taun(2) = mu*(2.*(dv[2][2]-diag)*in_norm(2) + (dv[0][2]+dv[2][0])*in_norm(0) + (dv[1][2]+dv[2][1])*in_norm(1));
+    }
+
+  // take dot product with normal
+  taundotn = 0.;
+  for (int m=0;m<n_dims;m++)
+    taundotn += out_taun(m)*in_norm(m);
+
+  // stresses tangent to wall
+  for (int m=0;m<n_dims;m++)
+    tautan[m] = out_taun(m) - taundotn*in_norm(m);
+
+  // wall shear stress
+  tauw = 0.;
+  for (int m=0;m<n_dims;m++)
+    tauw += pow(tautan[m],2);
+
+  return sqrt(tauw);
+}
+
@@ -436,7 +436,7 @@ void eles_hexas::set_volume_cubpts(void)
 }
 
 // Compute the surface jacobian determinant on a face
-double eles_hexas::compute_inter_detjac_inters_cubpts(int in_inter,array<double> d_pos)
+double eles_hexas::compute_inter_detjac_inters_cubpts(int in_inter,array<double>& d_pos)
 {
   double output = 0.;
   double xr, xs, xt;
@@ -845,7 +845,7 @@ void eles_hexas::compute_filter_upts(void)
 //#### helper methods ####
 
 
-int eles_hexas::read_restart_info(ifstream& restart_file)
+int eles_hexas::read_restart_info(istream& restart_file)
 {
 
   string str;
@@ -876,7 +876,7 @@ int eles_hexas::read_restart_info(ifstream& restart_file)
 }
 
 // write restart info
-void eles_hexas::write_restart_info(ofstream& restart_file)        
+void eles_hexas::write_restart_info(ostream& restart_file)        
 {
   restart_file << "HEXAS" << endl;
 
@@ -911,7 +911,7 @@ void eles_hexas::set_vandermonde(void)
 
 // evaluate nodal basis
 
-double eles_hexas::eval_nodal_basis(int in_index, array<double> in_loc)
+double eles_hexas::eval_nodal_basis(int in_index, array_view<double> in_loc)
 {
   int i,j,k;
 
@@ -928,7 +928,7 @@ double eles_hexas::eval_nodal_basis(int in_index, array<double> in_loc)
 
 // evaluate nodal basis using restart points
 //
-double eles_hexas::eval_nodal_basis_restart(int in_index, array<double> in_loc)
+double eles_hexas::eval_nodal_basis_restart(int in_index, array_view<double> in_loc)
 {
   int i,j,k;
 
@@ -945,7 +945,7 @@ double eles_hexas::eval_nodal_basis_restart(int in_index, array<double> in_loc)
 
 // evaluate derivative of nodal basis
 
-double eles_hexas::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in_loc)
+double eles_hexas::eval_d_nodal_basis(int in_index, int in_cpnt, array_view<double> in_loc)
 {
   int i,j,k;
 
@@ -977,7 +977,7 @@ double eles_hexas::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> i
 
 // evaluate nodal shape basis
 
-double eles_hexas::eval_nodal_s_basis(int in_index, array<double> in_loc, int in_n_spts)
+double eles_hexas::eval_nodal_s_basis(int in_index, array_view<double> in_loc, int in_n_spts)
 {
   int i,j,k;
   double nodal_s_basis;
@@ -1048,7 +1048,7 @@ double eles_hexas::eval_nodal_s_basis(int in_index, array<double> in_loc, int in
 
 // evaluate derivative of nodal shape basis
 
-void eles_hexas::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_hexas::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
   int i,j,k;
 
@@ -1144,7 +1144,7 @@ void eles_hexas::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<doub
 
 // evaluate second derivative of nodal shape basis
 
-void eles_hexas::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_hexas::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
   int i,j,k;
 
@@ -1413,5 +1413,33 @@ double eles_hexas::calc_ele_vol(double& detjac)
 /*! Calculate element reference length for timestep calculation */
 double eles_hexas::calc_h_ref_specific(int in_ele)
   {
-    FatalError("Reference length calculation not implemented for this element!")
+    int i, j, m, n_spts_1d;
+    int n_spts = n_spts_per_ele(in_ele);
+    int vert[8];
+    double dist, out_h_ref = 1e12;
+
+    // Vertices among the shape points: the corners of the tensor-product points, or the first eight of the
+    // 20-node hexahedron
+    if (n_spts == 20)
+      for (i=0;i<8;i++)
+        vert[i] = i;
+    else
+      {
+        n_spts_1d = (int) round(pow((double) n_spts,1./3.));
+        for (i=0;i<8;i++)
+          vert[i] = (i%2)*(n_spts_1d-1) + ((i/2)%2)*(n_spts_1d-1)*n_spts_1d + (i/4)*(n_spts_1d-1)*n_spts_1d*n_spts_1d;
+      }
+
+    // Shortest distance between two vertices, the shortest edge unless a face is strongly skewed
+    for (i=0;i<8;i++)
+      for (j=i+1;j<8;j++)
+        {
+          dist = 0.;
+          for (m=0;m<3;m++)
+            dist += pow(shape(m,vert[j],in_ele) - shape(m,vert[i],in_ele),2.0);
+
+          out_h_ref = min(out_h_ref,sqrt(dist));
+        }
+
+    return out_h_ref;
   }
@@ -446,7 +446,7 @@ void eles_pris::set_inters_cubpts(void)
 
 
 // Compute the surface jacobian determinant on a face
-double eles_pris::compute_inter_detjac_inters_cubpts(int in_inter,array<double> d_pos)
+double eles_pris::compute_inter_detjac_inters_cubpts(int in_inter,array<double>& d_pos)
 {
   double output = 0.;
   double xr, xs, xt;
@@ -649,7 +649,7 @@ void eles_pris::set_vandermonde_tri_restart()
   inv_vandermonde_tri_rest = inv_array(vandermonde_tri_rest);
 }
 
-int eles_pris::read_restart_info(ifstream& restart_file)
+int eles_pris::read_restart_info(istream& restart_file)
 {
 
   string str;
@@ -694,7 +694,7 @@ int eles_pris::read_restart_info(ifstream& restart_file)
 
 }
 
-void eles_pris::write_restart_info(ofstream& restart_file)        
+void eles_pris::write_restart_info(ostream& restart_file)        
 {
   restart_file << "PRIS" << endl;
 
@@ -724,7 +724,7 @@ void eles_pris::write_restart_info(ofstream& restart_file)
 
 // evaluate nodal basis
 
-double eles_pris::eval_nodal_basis(int in_index, array<double> in_loc)
+double eles_pris::eval_nodal_basis(int in_index, array_view<double> in_loc)
 {
   double oned_nodal_basis_at_loc;
   double tri_nodal_basis_at_loc;
@@ -753,7 +753,7 @@ double eles_pris::eval_nodal_basis(int in_index, array<double> in_loc)
 
 // evaluate nodal basis for restart
 
-double eles_pris::eval_nodal_basis_restart(int in_index, array<double> in_loc)
+double eles_pris::eval_nodal_basis_restart(int in_index, array_view<double> in_loc)
 {
   double oned_nodal_basis_at_loc;
   double tri_nodal_basis_at_loc;
@@ -781,7 +781,7 @@ double eles_pris::eval_nodal_basis_restart(int in_index, array<double> in_loc)
 
 // evaluate derivative of nodal basis
 
-double eles_pris::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in_loc)
+double eles_pris::eval_d_nodal_basis(int in_index, int in_cpnt, array_view<double> in_loc)
 {
   double out_d_nodal_basis_at_loc;
 
@@ -846,7 +846,7 @@ double eles_pris::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in
 
 // evaluate nodal shape basis
 
-double eles_pris::eval_nodal_s_basis(int in_index, array<double> in_loc, int in_n_spts)
+double eles_pris::eval_nodal_s_basis(int in_index, array_view<double> in_loc, int in_n_spts)
 {
 
   double nodal_s_basis;
@@ -907,7 +907,7 @@ double eles_pris::eval_nodal_s_basis(int in_index, array<double> in_loc, int in_
 
 // evaluate derivative of nodal shape basis
 
-void eles_pris::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_pris::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
 
   if (in_n_spts==6) {
@@ -991,7 +991,7 @@ void eles_pris::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<doubl
 
 // evaluate second derivative of nodal shape basis
 
-void eles_pris::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_pris::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
 
   if (in_n_spts==6)
@@ -1353,7 +1353,35 @@ double eles_pris::calc_ele_vol(double& detjac)
 /*! Calculate element reference length for timestep calculation */
 double eles_pris::calc_h_ref_specific(int in_ele)
   {
-    FatalError("Reference length calculation not implemented for this element!")
+    int i, j, m;
+    double a, b, c, s, dist, out_h_ref = 1e12;
+
+    // Inscribed circle radius of the two triangular faces (vertices 0-2 and 3-5) and length of the three lateral edges
+    for (i=0;i<2;i++)
+      {
+        a = b = c = 0.;
+        for (m=0;m<3;m++)
+          {
+            a += pow(shape(m,3*i,in_ele) - shape(m,3*i+1,in_ele),2.0);
+            b += pow(shape(m,3*i+1,in_ele) - shape(m,3*i+2,in_ele),2.0);
+            c += pow(shape(m,3*i+2,in_ele) - shape(m,3*i,in_ele),2.0);
+          }
+        a = sqrt(a); b = sqrt(b); c = sqrt(c);
+        s = 0.5*(a+b+c);
+
+        out_h_ref = min(out_h_ref,sqrt(((s-a)*(s-b)*(s-c))/s));
+      }
+
+    for (j=0;j<3;j++)
+      {
+        dist = 0.;
+        for (m=0;m<3;m++)
+          dist += pow(shape(m,j+3,in_ele) - shape(m,j,in_ele),2.0);
+
+        out_h_ref = min(out_h_ref,sqrt(dist));
+      }
+
+    return out_h_ref;
   }
 
 
@@ -376,7 +376,7 @@ void eles_quads::set_volume_cubpts(void)
 }
 
 // Compute the surface jacobian determinant on a face
-double eles_quads::compute_inter_detjac_inters_cubpts(int in_inter,array<double> d_pos)
+double eles_quads::compute_inter_detjac_inters_cubpts(int in_inter,array<double>& d_pos)
 {
   double output = 0.;
   double xr, xs;
@@ -683,7 +683,7 @@ void eles_quads::compute_filter_upts(void)
 
 //#### helper methods ####
 
-int eles_quads::read_restart_info(ifstream& restart_file)
+int eles_quads::read_restart_info(istream& restart_file)
 {
 
   string str;
@@ -714,7 +714,7 @@ int eles_quads::read_restart_info(ifstream& restart_file)
 }
 
 //
-void eles_quads::write_restart_info(ofstream& restart_file)        
+void eles_quads::write_restart_info(ostream& restart_file)        
 {
   restart_file << "QUADS" << endl;
 
@@ -747,7 +747,7 @@ void eles_quads::set_vandermonde(void)
 
 // evaluate nodal basis
 
-double eles_quads::eval_nodal_basis(int in_index, array<double> in_loc)
+double eles_quads::eval_nodal_basis(int in_index, array_view<double> in_loc)
 {
   int i,j;
 
@@ -764,7 +764,7 @@ double eles_quads::eval_nodal_basis(int in_index, array<double> in_loc)
 
 // evaluate nodal basis using restart points
 
-double eles_quads::eval_nodal_basis_restart(int in_index, array<double> in_loc)
+double eles_quads::eval_nodal_basis_restart(int in_index, array_view<double> in_loc)
 {
   int i,j;
 
@@ -780,7 +780,7 @@ double eles_quads::eval_nodal_basis_restart(int in_index, array<double> in_loc)
 
 // evaluate derivative of nodal basis
 
-double eles_quads::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in_loc)
+double eles_quads::eval_d_nodal_basis(int in_index, int in_cpnt, array_view<double> in_loc)
 {
   int i,j;
 
@@ -807,7 +807,7 @@ double eles_quads::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> i
 
 // evaluate nodal shape basis
 
-double eles_quads::eval_nodal_s_basis(int in_index, array<double> in_loc, int in_n_spts)
+double eles_quads::eval_nodal_s_basis(int in_index, array_view<double> in_loc, int in_n_spts)
 {
   int i,j;
   double nodal_s_basis;
@@ -852,7 +852,7 @@ double eles_quads::eval_nodal_s_basis(int in_index, array<double> in_loc, int in
 
 // evaluate derivative of nodal shape basis
 
-void eles_quads::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_quads::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
   int i,j;
 
@@ -902,7 +902,7 @@ void eles_quads::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<doub
 
 // evaluate second derivative of nodal shape basis
 
-void eles_quads::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_quads::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
   int i,j;
 
@@ -447,7 +447,7 @@ void eles_tets::set_volume_cubpts(void)
 
 
 // Compute the surface jacobian determinant on a face
-double eles_tets::compute_inter_detjac_inters_cubpts(int in_inter,array<double> d_pos)
+double eles_tets::compute_inter_detjac_inters_cubpts(int in_inter,array<double>& d_pos)
 {
 
   double output = 0.;
@@ -715,6 +715,13 @@ void eles_tets::compute_filter_upts(void)
 
 //#### helper methods ####
 
+// modal basis at the solution points and its inverse
+void eles_tets::get_modal_vandermonde(array<double>& out_vandermonde, array<double>& out_inv_vandermonde)
+{
+  out_vandermonde = vandermonde;
+  out_inv_vandermonde = inv_vandermonde;
+}
+
 // initialize the vandermonde matrix
 void eles_tets::set_vandermonde(void)
 {
@@ -732,18 +739,19 @@ void eles_tets::set_vandermonde(void)
 // initialize the vandermonde matrix
 void eles_tets::set_vandermonde_restart()
 {
-  vandermonde.setup(n_upts_per_ele_rest,n_upts_per_ele_rest);
+  // a local matrix, so that the vandermonde matrix of the solution points is kept
+  array<double> vandermonde_rest(n_upts_per_ele_rest,n_upts_per_ele_rest);
 
   // create the vandermonde matrix
   for (int i=0;i<n_upts_per_ele_rest;i++)
     for (int j=0;j<n_upts_per_ele_rest;j++)
-      vandermonde(i,j) = eval_dubiner_basis_3d(loc_upts_rest(0,i),loc_upts_rest(1,i),loc_upts_rest(2,i),j,order_rest);
+      vandermonde_rest(i,j) = eval_dubiner_basis_3d(loc_upts_rest(0,i),loc_upts_rest(1,i),loc_upts_rest(2,i),j,order_rest);
 
   // Store its inverse
-  inv_vandermonde_rest = inv_array(vandermonde);
+  inv_vandermonde_rest = inv_array(vandermonde_rest);
 }
 
-int eles_tets::read_restart_info(ifstream& restart_file)
+int eles_tets::read_restart_info(istream& restart_file)
 {
   string str;
   // Move to triangle element
@@ -776,7 +784,7 @@ int eles_tets::read_restart_info(ifstream& restart_file)
 }
 
 // write restart info
-void eles_tets::write_restart_info(ofstream& restart_file)
+void eles_tets::write_restart_info(ostream& restart_file)
 {
   restart_file << "TETS" << endl;
 
@@ -799,7 +807,7 @@ void eles_tets::write_restart_info(ofstream& restart_file)
 
 // evaluate nodal basis
 
-double eles_tets::eval_nodal_basis(int in_index, array<double> in_loc)
+double eles_tets::eval_nodal_basis(int in_index, array_view<double> in_loc)
 {
   array<double> dubiner_basis_at_loc(n_upts_per_ele);
   double out_nodal_basis_at_loc;
@@ -818,7 +826,7 @@ double eles_tets::eval_nodal_basis(int in_index, array<double> in_loc)
 
 // evaluate nodal basis
 
-double eles_tets::eval_nodal_basis_restart(int in_index, array<double> in_loc)
+double eles_tets::eval_nodal_basis_restart(int in_index, array_view<double> in_loc)
 {
   array<double> dubiner_basis_at_loc(n_upts_per_ele_rest);
   double out_nodal_basis_at_loc;
@@ -837,7 +845,7 @@ double eles_tets::eval_nodal_basis_restart(int in_index, array<double> in_loc)
 
 // evaluate derivative of nodal basis
 
-double eles_tets::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in_loc)
+double eles_tets::eval_d_nodal_basis(int in_index, int in_cpnt, array_view<double> in_loc)
 {
   array<double> d_dubiner_basis_at_loc(n_upts_per_ele);
   double out_d_nodal_basis_at_loc;
@@ -856,7 +864,7 @@ double eles_tets::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in
 
 // evaluate nodal shape basis
 
-double eles_tets::eval_nodal_s_basis(int in_index, array<double> in_loc, int in_n_spts)
+double eles_tets::eval_nodal_s_basis(int in_index, array_view<double> in_loc, int in_n_spts)
 {
   double nodal_s_basis;
 
@@ -903,7 +911,7 @@ double eles_tets::eval_nodal_s_basis(int in_index, array<double> in_loc, int in_
 
 // evaluate derivative of nodal shape basis
 
-void eles_tets::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_tets::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
 
   if (in_n_spts==4) {
@@ -968,7 +976,7 @@ void eles_tets::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<doubl
 
 // evaluate second derivative of nodal shape basis
 
-void eles_tets::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_tets::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
 
   if (in_n_spts==4)
@@ -1508,5 +1516,32 @@ double eles_tets::calc_ele_vol(double& detjac)
 /*! Calculate element reference length for timestep calculation */
 double eles_tets::calc_h_ref_specific(int in_ele)
   {
-    FatalError("Reference length calculation not implemented for this element!")
+    int i, j, k, m;
+    double d[3][3], n[3], area = 0., vol;
+    int face[4][3] = {{1,2,3},{0,2,3},{0,1,3},{0,1,2}};
+
+    // Inscribed sphere radius 3*volume/surface, from the vertices (the first four shape points)
+    for (i=0;i<3;i++)
+      for (m=0;m<3;m++)
+        d[i][m] = shape(m,i+1,in_ele) - shape(m,0,in_ele);
+
+    vol = fabs(d[0][0]*(d[1][1]*d[2][2]-d[1][2]*d[2][1]) - d[0][1]*(d[1][0]*d[2][2]-d[1][2]*d[2][0]) + d[0][2]*(d[1][0]*d[2][1]-d[1][1]*d[2][0]))/6.;
+
+    for (i=0;i<4;i++)
+      {
+        for (j=0;j<2;j++)
+          for (m=0;m<3;m++)
+            d[j][m] = shape(m,face[i][j+1],in_ele) - shape(m,face[i][0],in_ele);
+
+        for (m=0;m<3;m++)
+          {
+            j = (m+1)%3;
+            k = (m+2)%3;
+            n[m] = d[0][j]*d[1][k] - d[0][k]*d[1][j];
+          }
+
+        area += 0.5*sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+      }
+
+    return 3.*vol/area;
   }
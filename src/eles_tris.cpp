@@ -345,7 +345,7 @@ void eles_tris::set_inters_cubpts(void)
 }
 
 // Compute the surface jacobian determinant on a face
-double eles_tris::compute_inter_detjac_inters_cubpts(int in_inter,array<double> d_pos)
+double eles_tris::compute_inter_detjac_inters_cubpts(int in_inter,array<double>& d_pos)
 {
   double output = 0.;
   double xr, xs, yr, ys;
@@ -473,6 +473,13 @@ void eles_tris::set_tnorm_fpts(void)
 
 //#### helper methods ####
 
+// modal basis at the solution points and its inverse
+void eles_tris::get_modal_vandermonde(array<double>& out_vandermonde, array<double>& out_inv_vandermonde)
+{
+  out_vandermonde = vandermonde;
+  out_inv_vandermonde = inv_vandermonde;
+}
+
 // initialize the vandermonde matrix
 void eles_tris::set_vandermonde(void)
 {
@@ -505,7 +512,7 @@ void eles_tris::set_vandermonde_restart()
 }
 
 /*! read restart info */
-int eles_tris::read_restart_info(ifstream& restart_file)
+int eles_tris::read_restart_info(istream& restart_file)
 {
 
   string str;
@@ -540,7 +547,7 @@ int eles_tris::read_restart_info(ifstream& restart_file)
 }
 
 // write restart info
-void eles_tris::write_restart_info(ofstream& restart_file)
+void eles_tris::write_restart_info(ostream& restart_file)
 {
   restart_file << "TRIS" << endl;
 
@@ -561,7 +568,7 @@ void eles_tris::write_restart_info(ofstream& restart_file)
 }
 
 // evaluate nodal basis
-double eles_tris::eval_nodal_basis(int in_index, array<double> in_loc)
+double eles_tris::eval_nodal_basis(int in_index, array_view<double> in_loc)
 {
   array<double> dubiner_basis_at_loc(n_upts_per_ele);
   double out_nodal_basis_at_loc;
@@ -579,7 +586,7 @@ double eles_tris::eval_nodal_basis(int in_index, array<double> in_loc)
 }
 
 // evaluate nodal basis with restart points
-double eles_tris::eval_nodal_basis_restart(int in_index, array<double> in_loc)
+double eles_tris::eval_nodal_basis_restart(int in_index, array_view<double> in_loc)
 {
   array<double> dubiner_basis_at_loc(n_upts_per_ele_rest);
   double out_nodal_basis_at_loc;
@@ -597,7 +604,7 @@ double eles_tris::eval_nodal_basis_restart(int in_index, array<double> in_loc)
 }
 
 // evaluate derivative of nodal basis
-double eles_tris::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in_loc)
+double eles_tris::eval_d_nodal_basis(int in_index, int in_cpnt, array_view<double> in_loc)
 {
   array<double> d_dubiner_basis_at_loc(n_upts_per_ele);
   double out_d_nodal_basis_at_loc;
@@ -619,7 +626,7 @@ double eles_tris::eval_d_nodal_basis(int in_index, int in_cpnt, array<double> in
 }
 
 // evaluate nodal shape basis
-double eles_tris::eval_nodal_s_basis(int in_index, array<double> in_loc, int in_n_spts)
+double eles_tris::eval_nodal_s_basis(int in_index, array_view<double> in_loc, int in_n_spts)
 {
 
   array<double> nodal_s_basis(in_n_spts,1);
@@ -630,8 +637,8 @@ double eles_tris::eval_nodal_s_basis(int in_index, array<double> in_loc, int in_
 }
 
 // evaluate derivative of nodal shape basis
-//double eles_tris::eval_d_nodal_s_basis(int in_index, int in_cpnt, array<double> in_loc, int in_n_spts)
-void eles_tris::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<double> in_loc, int in_n_spts)
+//double eles_tris::eval_d_nodal_s_basis(int in_index, int in_cpnt, array_view<double> in_loc, int in_n_spts)
+void eles_tris::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
 
   eval_dn_nodal_s_basis(d_nodal_s_basis,in_loc, in_n_spts, 1);
@@ -639,7 +646,7 @@ void eles_tris::eval_d_nodal_s_basis(array<double> &d_nodal_s_basis, array<doubl
 }
 
 // evaluate second derivative of nodal shape basis
-void eles_tris::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array<double> in_loc, int in_n_spts)
+void eles_tris::eval_dd_nodal_s_basis(array<double> &dd_nodal_s_basis, array_view<double> in_loc, int in_n_spts)
 {
 
   eval_dn_nodal_s_basis(dd_nodal_s_basis,in_loc, in_n_spts, 2);
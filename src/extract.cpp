@@ -0,0 +1,398 @@
+/*!
+ * \file extract.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <sys/stat.h>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/extract.h"
+#include "../include/geometry.h"
+#include "../include/output.h"
+#include "../include/error.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+/*! edges of the plot sub-cells, by number of vertices (prisms are stored as hexahedra with repeated vertices) */
+static const int edges_tri[3][2] = {{0,1},{1,2},{2,0}};
+static const int edges_quad[4][2] = {{0,1},{1,2},{2,3},{3,0}};
+static const int edges_tet[6][2] = {{0,1},{1,2},{2,0},{0,3},{1,3},{2,3}};
+static const int edges_hex[12][2] = {{0,1},{1,2},{2,3},{3,0},{4,5},{5,6},{6,7},{7,4},{0,4},{1,5},{2,6},{3,7}};
+
+// #### constructors ####
+
+// default constructor
+
+extractor::extractor() { }
+
+// default destructor
+
+extractor::~extractor() { }
+
+// #### methods ####
+
+// look up the boundary types, index the elements and find the elements cut by each slice
+
+void extractor::setup(struct solution* FlowSol)
+{
+  int n_dims = FlowSol->n_dims;
+  int n_slices = run_input.n_slices;
+  int n_found;
+  struct stat st = {0};
+
+  bctypes.setup(run_input.n_extract_bcs);
+  for (int b=0; b<run_input.n_extract_bcs; b++)
+    bctypes(b) = get_bc_number(run_input.extract_bcs(b));
+
+  // Master node creates the directory of the extracts
+  if (FlowSol->rank == 0 && stat("extract_files", &st) == -1)
+    mkdir("extract_files", 0755);
+
+#ifdef _MPI
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+  if (n_slices == 0)
+    return;
+
+  Index.setup(FlowSol);
+
+  // Normalized planes and the elements they cross
+  slice_norm.setup(n_dims,n_slices);
+  slice_dist.setup(n_slices);
+  slice_items.setup(n_slices);
+
+  array<int> found(max(Index.get_n_items(),1));
+
+  for (int s=0; s<n_slices; s++) {
+      double len = 0.;
+      for (int m=0; m<n_dims; m++)
+        len += run_input.slices(3+m,s)*run_input.slices(3+m,s);
+      if (len == 0.)
+        FatalError("Slice normal must not be zero in the plane of the mesh");
+      len = sqrt(len);
+
+      slice_dist(s) = 0.;
+      for (int m=0; m<n_dims; m++) {
+          slice_norm(m,s) = run_input.slices(3+m,s)/len;
+          slice_dist(s) += slice_norm(m,s)*run_input.slices(m,s);
+        }
+
+      Index.query_plane(slice_norm.get_ptr_cpu(0,s),slice_dist(s),found,n_found);
+
+      slice_items(s).setup(max(n_found,1));
+      for (int k=0; k<n_found; k++)
+        slice_items(s)(k) = found(k);
+      if (n_found == 0)
+        slice_items(s)(0) = -1;
+    }
+}
+
+// write the surface and slice extracts of a step
+
+void extractor::write(int in_file_num, double in_time, struct solution* FlowSol)
+{
+  if (run_input.n_extract_bcs > 0)
+    write_surface(in_file_num, in_time, FlowSol);
+
+  if (run_input.n_slices > 0)
+    write_slices(in_file_num, in_time, FlowSol);
+}
+
+// write the density, velocity, pressure, Cp and Cf at the wall points of the selected boundaries
+
+void extractor::write_surface(int in_file_num, double in_time, struct solution* FlowSol)
+{
+  int n_dims = FlowSol->n_dims;
+  int n_vars = 2*n_dims+3+FlowSol->viscous;
+  int n_pts = 0;
+  array<double> data;
+  ostringstream text;
+  text.precision(15);
+
+  // header (only once in a shared file)
+  if (FlowSol->rank == 0 || !run_input.mpiio_output) {
+      text << "Title = \"HiFiLES Surface\"" << endl;
+      if (n_dims == 2)
+        text << "Variables = \"x\", \"y\", \"rho\", \"u\", \"v\", \"p\", \"cp\"";
+      else
+        text << "Variables = \"x\", \"y\", \"z\", \"rho\", \"u\", \"v\", \"w\", \"p\", \"cp\"";
+      if (FlowSol->viscous)
+        text << ", \"cf\"";
+      text << endl;
+    }
+
+  for (int i=0; i<FlowSol->n_ele_types; i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      n_pts += FlowSol->mesh_eles(i)->get_n_surface_pts(bctypes);
+
+  if (n_pts > 0) {
+      text << "ZONE T = \"surface\", I = " << n_pts << ", DATAPACKING = POINT, SOLUTIONTIME = " << in_time << endl;
+
+      for (int i=0; i<FlowSol->n_ele_types; i++) {
+          if (FlowSol->mesh_eles(i)->get_n_eles() == 0)
+            continue;
+
+          int n_ele_pts = FlowSol->mesh_eles(i)->get_n_surface_pts(bctypes);
+          if (n_ele_pts == 0)
+            continue;
+
+          data.setup(n_vars,n_ele_pts);
+          FlowSol->mesh_eles(i)->calc_surface_data(bctypes,data);
+
+          for (int k=0; k<n_ele_pts; k++) {
+              for (int v=0; v<n_vars; v++)
+                text << data(v,k) << " ";
+              text << endl;
+            }
+        }
+    }
+
+  write_file("extract_files/surf", in_file_num, text.str(), FlowSol);
+}
+
+// write the solution on each slice plane, as line segments (2D) or triangles (3D)
+
+void extractor::write_slices(int in_file_num, double in_time, struct solution* FlowSol)
+{
+  int n_dims = FlowSol->n_dims;
+  int n_fields = (run_input.equation == 0) ? n_dims+2 : 1;
+  array< array<int> > con(FlowSol->n_ele_types);
+  array<double> disu_ppts;
+  ostringstream text;
+  text.precision(15);
+
+  // header (only once in a shared file)
+  if (FlowSol->rank == 0 || !run_input.mpiio_output) {
+      text << "Title = \"HiFiLES Slices\"" << endl;
+      if (n_dims == 2)
+        text << "Variables = \"x\", \"y\"";
+      else
+        text << "Variables = \"x\", \"y\", \"z\"";
+      if (run_input.equation == 0 && n_dims == 2)
+        text << ", \"rho\", \"mom_x\", \"mom_y\", \"ene\"" << endl;
+      else if (run_input.equation == 0)
+        text << ", \"rho\", \"mom_x\", \"mom_y\", \"mom_z\", \"ene\"" << endl;
+      else
+        text << ", \"rho\"" << endl;
+    }
+
+  for (int i=0; i<FlowSol->n_ele_types; i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      FlowSol->mesh_eles(i)->get_connectivity_plot().swap(con(i));
+
+  for (int s=0; s<run_input.n_slices; s++) {
+      ostringstream pts, cells;
+      int n_pts = 0, n_cells = 0;
+      pts.precision(15);
+
+      for (int k=0; k<slice_items(s).get_dim(0); k++) {
+          int item = slice_items(s)(k);
+          if (item < 0)
+            break;
+
+          int i = Index.get_type(item);
+          int n_ppts = FlowSol->mesh_eles(i)->get_n_ppts_per_ele();
+          if (disu_ppts.get_dim(0) != n_ppts || disu_ppts.get_dim(1) != n_fields)
+            disu_ppts.setup(n_ppts,n_fields);
+
+          FlowSol->mesh_eles(i)->calc_disu_ppts(Index.get_ele(item),disu_ppts);
+          cut_element(item,s,con(i),disu_ppts,FlowSol,pts,cells,n_pts,n_cells);
+        }
+
+      if (n_cells > 0) {
+          text << "ZONE T = \"slice " << s << "\", N = " << n_pts << ", E = " << n_cells << ", DATAPACKING = POINT, ZONETYPE = ";
+          text << ((n_dims == 2) ? "FELINESEG" : "FETRIANGLE") << ", SOLUTIONTIME = " << in_time << endl;
+          text << pts.str() << cells.str();
+        }
+    }
+
+  write_file("extract_files/slice", in_file_num, text.str(), FlowSol);
+}
+
+// cut the plot sub-cells of an element with a slice: interpolate position and solution to the edge crossings,
+// and close them into a segment (2D) or a convex polygon split into triangles (3D)
+
+void extractor::cut_element(int in_item, int in_slice, array<int>& in_con, array<double>& in_disu_ppts, struct solution* FlowSol, ostringstream& io_pts, ostringstream& io_cells, int& io_n_pts, int& io_n_cells)
+{
+  int n_dims = FlowSol->n_dims;
+  int n_fields = in_disu_ppts.get_dim(1);
+  int ele = Index.get_ele(in_item);
+  int n_verts = in_con.get_dim(0);
+  int n_sub = in_con.get_dim(1);
+  array<double>& pos = FlowSol->mesh_eles(Index.get_type(in_item))->get_pos_ppts();
+  double* norm = slice_norm.get_ptr_cpu(0,in_slice);
+
+  const int (*edges)[2];
+  int n_edges;
+  if (n_dims == 2 && n_verts == 3) { edges = edges_tri; n_edges = 3; }
+  else if (n_dims == 2) { edges = edges_quad; n_edges = 4; }
+  else if (n_verts == 4) { edges = edges_tet; n_edges = 6; }
+  else { edges = edges_hex; n_edges = 12; }
+
+  // crossings of one sub-cell: position and solution, and the angle in the plane used to order them
+  array<double> cut(n_dims+n_fields,12);
+  double angle[12], e1[3], e2[3], centre[3];
+  int order[12];
+
+  // in-plane basis, for ordering the crossings of a 3D sub-cell
+  if (n_dims == 3) {
+      int a = 0;
+      for (int m=1; m<3; m++)
+        if (fabs(norm[m]) < fabs(norm[a]))
+          a = m;
+      double axis[3] = {0.,0.,0.};
+      axis[a] = 1.;
+      e1[0] = norm[1]*axis[2]-norm[2]*axis[1];
+      e1[1] = norm[2]*axis[0]-norm[0]*axis[2];
+      e1[2] = norm[0]*axis[1]-norm[1]*axis[0];
+      double len = sqrt(e1[0]*e1[0]+e1[1]*e1[1]+e1[2]*e1[2]);
+      for (int m=0; m<3; m++)
+        e1[m] /= len;
+      e2[0] = norm[1]*e1[2]-norm[2]*e1[1];
+      e2[1] = norm[2]*e1[0]-norm[0]*e1[2];
+      e2[2] = norm[0]*e1[1]-norm[1]*e1[0];
+    }
+
+  for (int c=0; c<n_sub; c++) {
+      int n_cut = 0;
+
+      for (int e=0; e<n_edges; e++) {
+          int a = in_con(edges[e][0],c);
+          int b = in_con(edges[e][1],c);
+
+          // repeated vertices of prisms give empty or duplicated edges
+          if (a == b)
+            continue;
+          bool repeated = false;
+          for (int f=0; f<e; f++) {
+              int fa = in_con(edges[f][0],c), fb = in_con(edges[f][1],c);
+              if ((fa == a && fb == b) || (fa == b && fb == a))
+                repeated = true;
+            }
+          if (repeated)
+            continue;
+
+          double da = -slice_dist(in_slice), db = -slice_dist(in_slice);
+          for (int m=0; m<n_dims; m++) {
+              da += norm[m]*pos(a,ele,m);
+              db += norm[m]*pos(b,ele,m);
+            }
+
+          if ((da < 0.) == (db < 0.))
+            continue;
+
+          double w = da/(da-db);
+          for (int m=0; m<n_dims; m++)
+            cut(m,n_cut) = pos(a,ele,m)+w*(pos(b,ele,m)-pos(a,ele,m));
+          for (int v=0; v<n_fields; v++)
+            cut(n_dims+v,n_cut) = in_disu_ppts(a,v)+w*(in_disu_ppts(b,v)-in_disu_ppts(a,v));
+          n_cut++;
+        }
+
+      if ((n_dims == 2 && n_cut < 2) || (n_dims == 3 && n_cut < 3))
+        continue;
+
+      if (n_dims == 2) {
+          // a line crosses a convex sub-cell twice
+          n_cut = 2;
+          for (int k=0; k<n_cut; k++)
+            order[k] = k;
+        }
+      else {
+          // order the crossings around their centre
+          for (int m=0; m<3; m++) {
+              centre[m] = 0.;
+              for (int k=0; k<n_cut; k++)
+                centre[m] += cut(m,k);
+              centre[m] /= n_cut;
+            }
+          for (int k=0; k<n_cut; k++) {
+              double x1 = 0., x2 = 0.;
+              for (int m=0; m<3; m++) {
+                  x1 += (cut(m,k)-centre[m])*e1[m];
+                  x2 += (cut(m,k)-centre[m])*e2[m];
+                }
+              angle[k] = atan2(x2,x1);
+              int l = k;
+              while (l > 0 && angle[order[l-1]] > angle[k]) {
+                  order[l] = order[l-1];
+                  l--;
+                }
+              order[l] = k;
+            }
+        }
+
+      for (int k=0; k<n_cut; k++) {
+          for (int v=0; v<n_dims+n_fields; v++)
+            io_pts << cut(v,order[k]) << " ";
+          io_pts << endl;
+        }
+
+      // Tecplot connectivity is 1-based
+      if (n_dims == 2) {
+          io_cells << io_n_pts+1 << " " << io_n_pts+2 << endl;
+          io_n_cells++;
+        }
+      else {
+          for (int k=1; k<n_cut-1; k++) {
+              io_cells << io_n_pts+1 << " " << io_n_pts+k+1 << " " << io_n_pts+k+2 << endl;
+              io_n_cells++;
+            }
+        }
+      io_n_pts += n_cut;
+    }
+}
+
+// write the text of an extract file, one file per rank or one shared file
+
+void extractor::write_file(const char* in_name, int in_file_num, const string& in_text, struct solution* FlowSol)
+{
+  char file_name_s[100];
+
+#ifdef _MPI
+  if (run_input.mpiio_output) {
+      sprintf(file_name_s,"%s_%.09d.dat",in_name,in_file_num);
+      write_shared_file(file_name_s, in_text, FlowSol);
+      return;
+    }
+#endif
+
+  sprintf(file_name_s,"%s_%.09d_p%.04d.dat",in_name,in_file_num,FlowSol->rank);
+
+  ofstream file(file_name_s);
+  if (!file)
+    FatalError("Unable to open extract file");
+  file << in_text;
+  file.close();
+}
@@ -2356,7 +2356,7 @@ double evalPoly(array<double> p, array<double> coords)
 
 
 void eval_dn_nodal_s_basis(array<double> &dd_nodal_s_basis,
-                           array<double> in_loc, int in_n_spts, int n_deriv)
+                           array_view<double> in_loc, int in_n_spts, int n_deriv)
 {
   /*
     Function that returns the values of the nth derivatives of the shape function
@@ -64,6 +64,7 @@ void SetInput(struct solution* FlowSol) {
   FlowSol->rank               = 0;
   FlowSol->n_steps            = run_input.n_steps;
   FlowSol->adv_type           = run_input.adv_type;
+  FlowSol->rk.setup(run_input.adv_type == 3 ? run_input.rk_scheme : 0);
   FlowSol->viscous            = run_input.viscous;
   FlowSol->plot_freq          = run_input.plot_freq;
   FlowSol->restart_dump_freq  = run_input.restart_dump_freq;
@@ -276,8 +277,22 @@ void GeoPreprocess(struct solution* FlowSol) {
 
   array<double> pos(FlowSol->n_dims);
 
+  // Multi-rate time stepping (dt_type 3) numbers the elements of each type from the smallest cell up, and further
+  // down the faces from the smallest neighbour up, so that the finest levels, advanced most often, come first
+  array<double> c_size(FlowSol->num_eles);
+  array<int> c_order(FlowSol->num_eles);
+
+  for (int i=0;i<FlowSol->num_eles;i++)
+    c_order(i) = i;
+
+  if (run_input.dt_type == 3) {
+      CalcCellSize(xv,c2v,c2n_v,ctype,FlowSol->num_eles,FlowSol->n_dims,c_size);
+      SortBySize(c_size,FlowSol->num_eles,c_order);
+    }
+
   if (FlowSol->rank==0) cout << "setting elements shape" << endl;
-  for (int i=0;i<FlowSol->num_eles;i++) {
+  for (int i_order=0;i_order<FlowSol->num_eles;i_order++) {
+      int i = c_order(i_order);
       if (ctype(i) == 0) //tri
         {
           local_c(i) = tris_count;
@@ -497,6 +512,20 @@ void GeoPreprocess(struct solution* FlowSol) {
         }
     }
 
+  // Color the elements for the implicit solver, which probes the element Jacobians one color at a time.
+  // Viscous residuals also depend on the neighbours of the neighbours, through the corrected gradient.
+  if (run_input.adv_type == 4) {
+      array<int> color;
+      int n_colors;
+
+      ColorElements(f2c, FlowSol->num_inters, FlowSol->num_eles, 1+FlowSol->viscous, color, n_colors);
+
+      for (int i=0;i<FlowSol->num_eles;i++)
+        FlowSol->mesh_eles(ctype(i))->set_ele_color(local_c(i), color(i));
+
+      if (FlowSol->rank==0) cout << "colored elements for the implicit solver, " << n_colors << " colors" << endl;
+    }
+
 #ifdef _MPI
 
 
@@ -695,8 +724,22 @@ void GeoPreprocess(struct solution* FlowSol) {
   int i_tri_bdy=0;
   int i_quad_bdy=0;
 
-  for(int i=0;i<FlowSol->num_inters;i++)
+  array<int> f_order(FlowSol->num_inters);
+
+  for (int i=0;i<FlowSol->num_inters;i++)
+    f_order(i) = i;
+
+  if (run_input.dt_type == 3) {
+      array<double> f_size(FlowSol->num_inters);
+      for (int i=0;i<FlowSol->num_inters;i++)
+        f_size(i) = (f2c(i,1) == -1) ? c_size(f2c(i,0)) : min(c_size(f2c(i,0)),c_size(f2c(i,1)));
+
+      SortBySize(f_size,FlowSol->num_inters,f_order);
+    }
+
+  for(int i_order=0;i_order<FlowSol->num_inters;i_order++)
     {
+      int i = f_order(i_order);
       bctype_f = bctype_c( f2c(i,0),f2loc_f(i,0) );
       ic_l = f2c(i,0);
       ic_r = f2c(i,1);
@@ -2207,6 +2250,137 @@ void repartition_mesh(int &out_n_cells, array<int> &out_c2v, array<int> &out_c2n
 
 #endif
 
+/*! distance-k coloring of the cells through the face graph */
+void ColorElements(array<int>& in_f2c, int in_n_faces, int in_n_cells, int in_distance, array<int>& out_color, int& out_n_colors)
+{
+  // Cell to cell adjacency in compressed row storage, through the faces shared by two local cells
+  array<int> c2c_sta(in_n_cells+1), c2c;
+  int i, j, k, ic, ic_l, ic_r, n_adj = 0;
+
+  for (ic=0;ic<=in_n_cells;ic++)
+    c2c_sta(ic) = 0;
+
+  for (i=0;i<in_n_faces;i++) {
+      ic_l = in_f2c(i,0);
+      ic_r = in_f2c(i,1);
+      if (ic_l != -1 && ic_r != -1 && ic_l != ic_r) {
+          c2c_sta(ic_l+1)++;
+          c2c_sta(ic_r+1)++;
+          n_adj += 2;
+        }
+    }
+
+  for (ic=0;ic<in_n_cells;ic++)
+    c2c_sta(ic+1) += c2c_sta(ic);
+
+  array<int> c2c_count(in_n_cells);
+  c2c.setup(max(n_adj,1));
+  for (ic=0;ic<in_n_cells;ic++)
+    c2c_count(ic) = c2c_sta(ic);
+
+  for (i=0;i<in_n_faces;i++) {
+      ic_l = in_f2c(i,0);
+      ic_r = in_f2c(i,1);
+      if (ic_l != -1 && ic_r != -1 && ic_l != ic_r) {
+          c2c(c2c_count(ic_l)++) = ic_r;
+          c2c(c2c_count(ic_r)++) = ic_l;
+        }
+    }
+
+  // Greedy coloring. forbidden(c) == ic marks color c as taken by a cell in the stencil of ic
+  array<int> forbidden(in_n_cells+1);
+  for (i=0;i<=in_n_cells;i++)
+    forbidden(i) = -1;
+
+  out_color.setup(in_n_cells);
+  for (ic=0;ic<in_n_cells;ic++)
+    out_color(ic) = -1;
+
+  out_n_colors = 0;
+  for (ic=0;ic<in_n_cells;ic++) {
+      for (j=c2c_sta(ic);j<c2c_sta(ic+1);j++) {
+          int ic_n = c2c(j);
+          if (out_color(ic_n) != -1)
+            forbidden(out_color(ic_n)) = ic;
+
+          if (in_distance > 1) {
+              for (k=c2c_sta(ic_n);k<c2c_sta(ic_n+1);k++)
+                if (c2c(k) != ic && out_color(c2c(k)) != -1)
+                  forbidden(out_color(c2c(k))) = ic;
+            }
+        }
+
+      int c = 0;
+      while (forbidden(c) == ic)
+        c++;
+
+      out_color(ic) = c;
+      if (c+1 > out_n_colors)
+        out_n_colors = c+1;
+    }
+}
+
+// entry of a sort by size, ties broken by index for a deterministic order
+struct size_entry
+{
+  double size;
+  int index;
+};
+
+static int compare_size_entries(const void* a, const void* b)
+{
+  const size_entry* e_a = (const size_entry*) a;
+  const size_entry* e_b = (const size_entry*) b;
+
+  if (e_a->size < e_b->size) return -1;
+  if (e_a->size > e_b->size) return 1;
+  return e_a->index - e_b->index;
+}
+
+/*! size of each cell, the smallest distance between two of its corners */
+void CalcCellSize(array<double>& in_xv, array<int>& in_c2v, array<int>& in_c2n_v, array<int>& in_ctype, int in_n_cells, int in_n_dims, array<double>& out_size)
+{
+  const int n_corners[5] = {3, 4, 4, 6, 8};
+  int i, j, k, m, v_j, v_k;
+  double dist;
+
+  for (i=0;i<in_n_cells;i++)
+    {
+      out_size(i) = 1e12;
+      for (j=0;j<n_corners[in_ctype(i)];j++)
+        for (k=j+1;k<n_corners[in_ctype(i)];k++)
+          {
+            get_vert_loc(in_ctype(i),in_c2n_v(i),j,v_j);
+            get_vert_loc(in_ctype(i),in_c2n_v(i),k,v_k);
+
+            dist = 0.;
+            for (m=0;m<in_n_dims;m++)
+              dist += pow(in_xv(in_c2v(i,v_j),m) - in_xv(in_c2v(i,v_k),m),2);
+
+            out_size(i) = min(out_size(i),sqrt(dist));
+          }
+    }
+}
+
+/*! permutation that sorts in_size in increasing order */
+void SortBySize(array<double>& in_size, int in_n, array<int>& out_order)
+{
+  size_entry* entries = new size_entry[in_n];
+
+  for (int i=0;i<in_n;i++)
+    {
+      entries[i].size = in_size(i);
+      entries[i].index = i;
+    }
+
+  qsort(entries,in_n,sizeof(size_entry),compare_size_entries);
+
+  for (int i=0;i<in_n;i++)
+    out_order(i) = entries[i].index;
+
+  delete[] entries;
+}
+
 /*! method to create list of faces from the mesh */
 void CompConnectivity(array<int>& in_c2v, array<int>& in_c2n_v, array<int>& in_ctype, array<int>& out_c2f, array<int>& out_c2e, array<int>& out_f2c, array<int>& out_f2loc_f, array<int>& out_f2v, array<int>& out_f2nv, array<int>& out_rot_tag, array<int>& out_unmatched_faces, int& out_n_unmatched_faces, array<int>& out_icvsta, array<int>& out_icvert, int& out_n_faces, int& out_n_edges, struct solution* FlowSol)
 {
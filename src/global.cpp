@@ -23,9 +23,15 @@
  * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <sys/time.h>
+
 #include "../include/global.h"
 #include "../include/array.h"
 
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
 using namespace std;
 
 input run_input;
@@ -114,3 +120,14 @@ int daxpy(int n, double alpha, double *x, double *y)
   return 0;
 }
 
+/*! Routine to return the wall-clock time in seconds */
+double wall_time(void)
+{
+#ifdef _MPI
+  return MPI_Wtime();
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + 1.e-6*(double)tv.tv_usec;
+#endif
+}
@@ -87,6 +87,42 @@ void input::setup(ifstream& in_run_input_file, int rank)
   wave_speed.setup(3);
   v_wall.setup(3);
   diff_coeff = 0.;
+  monitor_memory = 1;
+  jfnk_krylov_dim = 30;
+  jfnk_lin_tol = 0.05;
+  jfnk_max_cfl_ratio = 1.e4;
+  jfnk_prec_freq = 10;
+  p_multigrid = 0;
+  mg_min_order = 1;
+  mg_n_pre_smooth = 1;
+  mg_n_post_smooth = 1;
+  mg_n_coarse_smooth = 2;
+  dual_time = 0;
+  dual_max_inner = 50;
+  dual_inner_tol = 1.e-3;
+  lts_n_levels = 4;
+  rk_scheme = 1;
+  rk_adapt = 0;
+  rk_tol = 1.e-4;
+  res_norm_fused = 0;
+  async_output = 0;
+  mpiio_output = 0;
+  mpiio_aggregators = 0;
+  extract_freq = 0;
+  n_extract_bcs = 0;
+  n_slices = 0;
+  probe_freq = 0;
+  probe_flush_freq = 100;
+  restart_compression = 0;
+  restart_compression_tol = 1.e-6;
+  vtu_compression = 0;
+  stats_freq = 0;
+  stats_moments = 2;
+  n_stats_homogeneous = 0;
+  checkpoint_interval = 0.;
+  wall_time_limit = 0.;
+  wall_time_margin = 1.;
+  checkpoint_signals = 0;
   
   char buf[BUFSIZ]={""};
   char section_TXT[100];
@@ -218,6 +254,70 @@ void input::setup(ifstream& in_run_input_file, int rank)
     {
       in_run_input_file >> adv_type;
     }
+    else if (!param_name.compare("rk_scheme"))
+    {
+      in_run_input_file >> rk_scheme;
+    }
+    else if (!param_name.compare("rk_adapt"))
+    {
+      in_run_input_file >> rk_adapt;
+    }
+    else if (!param_name.compare("rk_tol"))
+    {
+      in_run_input_file >> rk_tol;
+    }
+    else if (!param_name.compare("jfnk_krylov_dim"))
+    {
+      in_run_input_file >> jfnk_krylov_dim;
+    }
+    else if (!param_name.compare("jfnk_lin_tol"))
+    {
+      in_run_input_file >> jfnk_lin_tol;
+    }
+    else if (!param_name.compare("jfnk_max_cfl_ratio"))
+    {
+      in_run_input_file >> jfnk_max_cfl_ratio;
+    }
+    else if (!param_name.compare("jfnk_prec_freq"))
+    {
+      in_run_input_file >> jfnk_prec_freq;
+    }
+    else if (!param_name.compare("p_multigrid"))
+    {
+      in_run_input_file >> p_multigrid;
+    }
+    else if (!param_name.compare("mg_min_order"))
+    {
+      in_run_input_file >> mg_min_order;
+    }
+    else if (!param_name.compare("mg_n_pre_smooth"))
+    {
+      in_run_input_file >> mg_n_pre_smooth;
+    }
+    else if (!param_name.compare("mg_n_post_smooth"))
+    {
+      in_run_input_file >> mg_n_post_smooth;
+    }
+    else if (!param_name.compare("mg_n_coarse_smooth"))
+    {
+      in_run_input_file >> mg_n_coarse_smooth;
+    }
+    else if (!param_name.compare("dual_time"))
+    {
+      in_run_input_file >> dual_time;
+    }
+    else if (!param_name.compare("dual_max_inner"))
+    {
+      in_run_input_file >> dual_max_inner;
+    }
+    else if (!param_name.compare("dual_inner_tol"))
+    {
+      in_run_input_file >> dual_inner_tol;
+    }
+    else if (!param_name.compare("lts_n_levels"))
+    {
+      in_run_input_file >> lts_n_levels;
+    }
     else if (!param_name.compare("const_src_term"))
     {
       in_run_input_file >> const_src_term;
@@ -230,6 +330,18 @@ void input::setup(ifstream& in_run_input_file, int rank)
     {
       in_run_input_file >> monitor_cp_freq;
     }
+    else if (!param_name.compare("huge_pages"))
+    {
+      in_run_input_file >> huge_pages;
+    }
+    else if (!param_name.compare("numa_policy"))
+    {
+      in_run_input_file >> numa_policy;
+    }
+    else if (!param_name.compare("monitor_memory"))
+    {
+      in_run_input_file >> monitor_memory;
+    }
     else if (!param_name.compare("monitor_integrals_freq"))
     {
       in_run_input_file >> monitor_integrals_freq;
@@ -245,6 +357,10 @@ void input::setup(ifstream& in_run_input_file, int rank)
     {
       in_run_input_file >> res_norm_type;
     }
+    else if (!param_name.compare("res_norm_fused"))
+    {
+      in_run_input_file >> res_norm_fused;
+    }
     else if (!param_name.compare("error_norm_type"))
     {
       in_run_input_file >> error_norm_type;
@@ -445,6 +561,92 @@ void input::setup(ifstream& in_run_input_file, int rank)
     {
       in_run_input_file >> write_type;
     }
+    else if (!param_name.compare("async_output"))
+    {
+      in_run_input_file >> async_output;
+    }
+    else if (!param_name.compare("mpiio_output"))
+    {
+      in_run_input_file >> mpiio_output;
+    }
+    else if (!param_name.compare("mpiio_aggregators"))
+    {
+      in_run_input_file >> mpiio_aggregators;
+    }
+    else if (!param_name.compare("extract_freq"))
+    {
+      in_run_input_file >> extract_freq;
+    }
+    else if (!param_name.compare("n_extract_bcs"))
+    {
+      in_run_input_file >> n_extract_bcs;
+      extract_bcs.setup(n_extract_bcs);
+      for (int i=0;i<n_extract_bcs;i++)
+        in_run_input_file >> extract_bcs(i);
+    }
+    else if (!param_name.compare("probe_freq"))
+    {
+      in_run_input_file >> probe_freq;
+    }
+    else if (!param_name.compare("probe_flush_freq"))
+    {
+      in_run_input_file >> probe_flush_freq;
+    }
+    else if (!param_name.compare("probe_file"))
+    {
+      in_run_input_file >> probe_file;
+    }
+    else if (!param_name.compare("restart_compression"))
+    {
+      in_run_input_file >> restart_compression;
+    }
+    else if (!param_name.compare("restart_compression_tol"))
+    {
+      in_run_input_file >> restart_compression_tol;
+    }
+    else if (!param_name.compare("vtu_compression"))
+    {
+      in_run_input_file >> vtu_compression;
+    }
+    else if (!param_name.compare("stats_freq"))
+    {
+      in_run_input_file >> stats_freq;
+    }
+    else if (!param_name.compare("stats_moments"))
+    {
+      in_run_input_file >> stats_moments;
+    }
+    else if (!param_name.compare("checkpoint_interval"))
+    {
+      in_run_input_file >> checkpoint_interval;
+    }
+    else if (!param_name.compare("wall_time_limit"))
+    {
+      in_run_input_file >> wall_time_limit;
+    }
+    else if (!param_name.compare("wall_time_margin"))
+    {
+      in_run_input_file >> wall_time_margin;
+    }
+    else if (!param_name.compare("checkpoint_signals"))
+    {
+      in_run_input_file >> checkpoint_signals;
+    }
+    else if (!param_name.compare("n_stats_homogeneous"))
+    {
+      in_run_input_file >> n_stats_homogeneous;
+      stats_homogeneous.setup(n_stats_homogeneous);
+      for (int i=0;i<n_stats_homogeneous;i++)
+        in_run_input_file >> stats_homogeneous(i);
+    }
+    else if (!param_name.compare("n_slices"))
+    {
+      in_run_input_file >> n_slices;
+      slices.setup(6,n_slices);
+      for (int i=0;i<n_slices;i++)
+        for (int j=0;j<6;j++)
+          in_run_input_file >> slices(j,i);
+    }
     else if (!param_name.compare("tau"))
     {
       in_run_input_file >> tau;
@@ -618,6 +820,101 @@ void input::setup(ifstream& in_run_input_file, int rank)
     if (ic_form==0 || ic_form==1)
       FatalError("Initial condition not supported with Advection-Diffusion equation");
   }
+
+  if (rk_adapt)
+  {
+    if (adv_type != 3 || rk_scheme == 0)
+      FatalError("Adaptive time stepping needs a multi-stage scheme, use adv_type 3 and rk_scheme 1 to 5");
+    if (dt_type != 0 || p_multigrid || dual_time)
+      FatalError("Adaptive time stepping controls the user-supplied time step, use dt_type 0 without p_multigrid or dual_time");
+  }
+  
+  if (res_norm_fused)
+  {
+#ifdef _GPU
+    FatalError("Fused residual norms are not implemented on the GPU, use res_norm_fused 0");
+#endif
+    if ((adv_type != 0 && adv_type != 3) || p_multigrid || dual_time || dt_type == 3)
+      FatalError("Fused residual norms are accumulated by the explicit time step, use adv_type 0 or 3 without p_multigrid, dual_time or dt_type 3");
+    if (res_norm_type < 0 || res_norm_type > 2)
+      FatalError("res_norm_type not recognized");
+  }
+  
+  if (write_type == 2)
+  {
+#ifndef _TECIO
+    FatalError("write_type 2 requires HiFiLES to be compiled with TecIO (-D_TECIO)");
+#endif
+    if (mpiio_output)
+      FatalError("Tecplot binary files are written by TecIO on each rank, mpiio_output is not available with write_type 2");
+  }
+  
+  if (mpiio_output)
+  {
+#ifndef _MPI
+    FatalError("mpiio_output requires HiFiLES to be compiled with MPI (-D_MPI)");
+#endif
+    if (async_output)
+      FatalError("mpiio_output writes collectively from the time loop, it cannot be combined with async_output");
+    if (mpiio_aggregators < 0)
+      FatalError("mpiio_aggregators must be 0 (MPI default) or a number of ranks");
+  }
+  
+  if (extract_freq)
+  {
+    if (extract_freq < 0)
+      FatalError("extract_freq must be 0 (off) or a number of steps");
+    if (n_extract_bcs == 0 && n_slices == 0)
+      FatalError("extract_freq needs surfaces (n_extract_bcs) or slices (n_slices) to extract");
+    if (n_extract_bcs > 0 && equation != 0)
+      FatalError("Surface extracts hold the pressure and wall stresses of the NS equation, use equation 0");
+    for (int i=0;i<n_slices;i++)
+      if (slices(3,i)*slices(3,i)+slices(4,i)*slices(4,i)+slices(5,i)*slices(5,i) == 0.)
+        FatalError("Slice normal must not be zero");
+  }
+  
+  if (probe_freq)
+  {
+    if (probe_freq < 0)
+      FatalError("probe_freq must be 0 (off) or a number of steps");
+    if (probe_file.empty())
+      FatalError("probe_freq needs a list of probe positions in probe_file");
+    if (probe_flush_freq < 1)
+      FatalError("probe_flush_freq must be at least one sample");
+  }
+  
+  if (restart_compression || vtu_compression)
+  {
+#ifndef _ZLIB
+    FatalError("Compressed output requires HiFiLES to be compiled with zlib (-D_ZLIB)");
+#endif
+    if (restart_compression < 0 || restart_compression > 2)
+      FatalError("restart_compression not recognized");
+    if (restart_compression == 2 && (restart_compression_tol < 1.e-14 || restart_compression_tol >= 1.))
+      FatalError("restart_compression_tol must be a relative error between 1e-14 and 1");
+    if (vtu_compression < 0 || vtu_compression > 1)
+      FatalError("vtu_compression not recognized");
+  }
+  
+  if (stats_freq)
+  {
+    if (stats_freq < 0)
+      FatalError("stats_freq must be 0 (off) or a number of steps");
+    if (stats_moments < 1 || stats_moments > 2)
+      FatalError("stats_moments must be 1 (means) or 2 (means and Reynolds stresses)");
+    if (n_stats_homogeneous < 0 || n_stats_homogeneous > 2)
+      FatalError("n_stats_homogeneous must be between 0 and 2 directions");
+    for (int i=0;i<n_stats_homogeneous;i++)
+      if (stats_homogeneous(i) < 0 || stats_homogeneous(i) > 2)
+        FatalError("stats_homogeneous directions are 0 (x), 1 (y) or 2 (z)");
+  }
+  
+  if (checkpoint_interval < 0. || wall_time_limit < 0.)
+    FatalError("checkpoint_interval and wall_time_limit must be 0 (off) or a number of minutes");
+  if (wall_time_limit > 0. && (wall_time_margin < 0. || wall_time_margin >= wall_time_limit))
+    FatalError("wall_time_margin must be a number of minutes below wall_time_limit");
+  if (checkpoint_signals < 0 || checkpoint_signals > 1)
+    FatalError("checkpoint_signals not recognized");
   
   
   if (rank==0)
@@ -79,6 +79,10 @@ void int_inters::setup(int in_n_inters,int in_inter_type)
         {
           grad_disu_fpts_r.setup(n_fpts_per_inter,n_inters,n_fields,n_dims);
         }
+
+      ele_type_r.setup(n_inters);
+      ele_r.setup(n_inters);
+      local_inter_r.setup(n_inters);
 }
 
 // set interior interface
@@ -87,6 +91,13 @@ void int_inters::set_interior(int in_inter, int in_ele_type_l, int in_ele_type_r
   int i,j,k;
   int i_rhs,j_rhs;
 
+      ele_type_l(in_inter) = in_ele_type_l;
+      ele_l(in_inter) = in_ele_l;
+      local_inter_l(in_inter) = in_local_inter_l;
+      ele_type_r(in_inter) = in_ele_type_r;
+      ele_r(in_inter) = in_ele_r;
+      local_inter_r(in_inter) = in_local_inter_r;
+
       get_lut(rot_tag);
 
       for(i=0;i<n_fields;i++)
@@ -137,6 +148,26 @@ void int_inters::set_interior(int in_inter, int in_ele_type_l, int in_ele_type_r
         }
 }
 
+// multi-rate levels of the faces and of the neighbours of their elements
+
+void int_inters::set_lts_levels(struct solution* FlowSol)
+{
+  int level_l, level_r;
+
+  lts_level.setup(n_inters);
+
+  for (int i=0;i<n_inters;i++)
+    {
+      level_l = FlowSol->mesh_eles(ele_type_l(i))->get_lts_level(ele_l(i));
+      level_r = FlowSol->mesh_eles(ele_type_r(i))->get_lts_level(ele_r(i));
+
+      lts_level(i) = min(level_l,level_r);
+
+      FlowSol->mesh_eles(ele_type_l(i))->set_lts_nb_level(ele_l(i),local_inter_l(i),level_r);
+      FlowSol->mesh_eles(ele_type_r(i))->set_lts_nb_level(ele_r(i),local_inter_r(i),level_l);
+    }
+}
+
 // move all from cpu to gpu
 
 void int_inters::mv_all_cpu_gpu(void)
@@ -178,12 +209,55 @@ void int_inters::calculate_common_invFlux(void)
 {
 
 #ifdef _CPU
+  // Linear advection: Lax-Friedrich flux and LDG common solution without temporaries
+  if (run_input.equation==1 && run_input.riemann_solve_type==1 && (!viscous || run_input.vis_riemann_solve_type==0))
+    {
+      double u_l, u_r, u_av, u_diff, norm_speed, fn0, pen_fact, u_c0;
+
+      for(int i=0;i<n_inters_active;i++)
+        {
+          for(int j=0;j<n_fpts_per_inter;j++)
+            {
+              u_l = (*disu_fpts_l(j,i,0));
+              u_r = (*disu_fpts_r(j,i,0));
+              u_av = 0.5*(u_l+u_r);
+              u_diff = (u_l-u_r);
+
+              norm_speed = 0.;
+              fn0 = 0.;
+              for (int m=0;m<n_dims;m++)
+                {
+                  norm_speed += run_input.wave_speed(m)*(*norm_fpts(j,i,m));
+                  fn0 += run_input.wave_speed(m)*(*norm_fpts(j,i,m))*u_av;
+                }
+              fn0 += 0.5*run_input.lambda*abs(norm_speed)*u_diff;
+
+              (*norm_tconf_fpts_l(j,i,0))=fn0*(*tdA_fpts_l(j,i));
+              (*norm_tconf_fpts_r(j,i,0))=-fn0*(*tdA_fpts_r(j,i));
+
+              if(viscous)
+                {
+                  pen_fact = run_input.pen_fact;
+                  if (n_dims==2 && ((*norm_fpts(j,i,0))+(*norm_fpts(j,i,1))) <0.)
+                    pen_fact = -pen_fact;
+                  if (n_dims==3 && ((*norm_fpts(j,i,0))+(*norm_fpts(j,i,1))+sqrt(2.)*(*norm_fpts(j,i,2))) <0.)
+                    pen_fact = -pen_fact;
+
+                  u_c0 = 0.5*(u_l + u_r) - pen_fact*(u_l - u_r);
+                  *delta_disu_fpts_l(j,i,0) = (u_c0 - u_l);
+                  *delta_disu_fpts_r(j,i,0) = (u_c0 - u_r);
+                }
+            }
+        }
+      return;
+    }
+
   array<double> norm(n_dims), fn(n_fields);
 
   //viscous
   array<double> u_c(n_fields);
 
-  for(int i=0;i<n_inters;i++)
+  for(int i=0;i<n_inters_active;i++)
     {
       for(int j=0;j<n_fpts_per_inter;j++)
         {
@@ -272,9 +346,50 @@ void int_inters::calculate_common_viscFlux(void)
 {
 
 #ifdef _CPU
+  // Linear diffusion: LDG flux of f = -diff_coeff*grad(u) without temporaries
+  if (run_input.equation==1 && !LES && run_input.vis_riemann_solve_type==0)
+    {
+      double f_l[3], f_r[3], f_c[3], norm[3];
+      double pen_fact, jump, fn0;
+
+      for(int i=0;i<n_inters_active;i++)
+        {
+          for(int j=0;j<n_fpts_per_inter;j++)
+            {
+              for (int m=0;m<n_dims;m++)
+                {
+                  norm[m] = *norm_fpts(j,i,m);
+                  f_l[m] = -run_input.diff_coeff*(*grad_disu_fpts_l(j,i,0,m));
+                  f_r[m] = -run_input.diff_coeff*(*grad_disu_fpts_r(j,i,0,m));
+                }
+
+              pen_fact = run_input.pen_fact;
+              if (n_dims==2 && (norm[0]+norm[1]) <0.)
+                pen_fact = -pen_fact;
+              if (n_dims==3 && (norm[0]+norm[1]+sqrt(2.)*norm[2]) <0.)
+                pen_fact = -pen_fact;
+
+              jump = norm[0]*(f_l[0] - f_r[0]);
+              for (int m=1;m<n_dims;m++)
+                jump += norm[m]*(f_l[m] - f_r[m]);
+
+              for (int m=0;m<n_dims;m++)
+                f_c[m] = 0.5*(f_l[m] + f_r[m]) + pen_fact*norm[m]*jump + run_input.tau*norm[m]*((*disu_fpts_l(j,i,0)) - (*disu_fpts_r(j,i,0)));
+
+              fn0 = f_c[0]*norm[0];
+              for (int m=1;m<n_dims;m++)
+                fn0 += f_c[m]*norm[m];
+
+              (*norm_tconf_fpts_l(j,i,0))+=  fn0*(*tdA_fpts_l(j,i));
+              (*norm_tconf_fpts_r(j,i,0))+= -fn0*(*tdA_fpts_r(j,i));
+            }
+        }
+      return;
+    }
+
   array<double> norm(n_dims), fn(n_fields);
 
-  for(int i=0;i<n_inters;i++)
+  for(int i=0;i<n_inters_active;i++)
     {
       for(int j=0;j<n_fpts_per_inter;j++)
         {
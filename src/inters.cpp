@@ -63,6 +63,7 @@ inters::~inters() { }
 void inters::setup_inters(int in_n_inters, int in_inters_type)
 {
   n_inters    = in_n_inters;
+  n_inters_active = in_n_inters;
   inters_type = in_inters_type;
 
   if(inters_type==0) // segs
@@ -157,6 +158,10 @@ void inters::setup_inters(int in_n_inters, int in_inters_type)
 
       lut.setup(n_fpts_per_inter);
 
+      ele_type_l.setup(n_inters);
+      ele_l.setup(n_inters);
+      local_inter_l.setup(n_inters);
+
       // For Roe flux computation
       v_l.setup(n_dims);
       v_r.setup(n_dims);
@@ -164,6 +169,33 @@ void inters::setup_inters(int in_n_inters, int in_inters_type)
       du.setup(n_fields);
 }
 
+// make the face levels non-decreasing, so that the faces of each level and below form a prefix; a face
+// evaluated more often than its sides need costs work but changes nothing
+
+void inters::setup_lts(int in_n_levels)
+{
+  int i, j;
+
+  for (i=n_inters-2;i>=0;i--)
+    if (lts_level(i) > lts_level(i+1))
+      lts_level(i) = lts_level(i+1);
+
+  lts_n_inters_level.setup(in_n_levels);
+  lts_n_inters_level.initialize_to_zero();
+
+  for (i=0;i<n_inters;i++)
+    for (j=lts_level(i);j<in_n_levels;j++)
+      lts_n_inters_level(j)++;
+}
+
+void inters::set_lts_active(int in_max_level)
+{
+  if (in_max_level < 0)
+    n_inters_active = n_inters;
+  else
+    n_inters_active = lts_n_inters_level(in_max_level);
+}
+
 // get look up table for flux point connectivity based on rotation tag
 void inters::get_lut(int in_rot_tag)
 {
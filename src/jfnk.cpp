@@ -0,0 +1,682 @@
+/*!
+ * \file jfnk.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cmath>
+#include <string.h>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/jfnk.h"
+#include "../include/solver.h"
+#include "../include/error.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+// LU factorization with partial pivoting of the n x n column-major matrix a, in place
+
+static void lu_factor(double* a, int* piv, int n)
+{
+  int i, j, k, p;
+  double max_val, temp;
+
+  for (k=0;k<n;k++)
+    {
+      p = k;
+      max_val = fabs(a[k+n*k]);
+      for (i=k+1;i<n;i++)
+        if (fabs(a[i+n*k]) > max_val) {
+            max_val = fabs(a[i+n*k]);
+            p = i;
+          }
+
+      if (max_val == 0.0)
+        FatalError("Singular element block in the implicit solver preconditioner");
+
+      piv[k] = p;
+      if (p != k)
+        for (j=0;j<n;j++) {
+            temp = a[k+n*j];
+            a[k+n*j] = a[p+n*j];
+            a[p+n*j] = temp;
+          }
+
+      for (i=k+1;i<n;i++)
+        a[i+n*k] /= a[k+n*k];
+
+      for (j=k+1;j<n;j++) {
+          temp = a[k+n*j];
+          if (temp != 0.0)
+            for (i=k+1;i<n;i++)
+              a[i+n*j] -= a[i+n*k]*temp;
+        }
+    }
+}
+
+// solve a x = b with the factors from lu_factor; x holds b on input
+
+static void lu_solve(double* a, int* piv, int n, double* x)
+{
+  int i, k;
+  double temp;
+
+  for (k=0;k<n;k++)
+    if (piv[k] != k) {
+        temp = x[k];
+        x[k] = x[piv[k]];
+        x[piv[k]] = temp;
+      }
+
+  for (k=0;k<n;k++)
+    for (i=k+1;i<n;i++)
+      x[i] -= a[i+n*k]*x[k];
+
+  for (k=n-1;k>=0;k--) {
+      x[k] /= a[k+n*k];
+      for (i=0;i<k;i++)
+        x[i] -= a[i+n*k]*x[k];
+    }
+}
+
+// #### constructors ####
+
+// default constructor
+
+jfnk::jfnk()
+{
+  n_ele_types = 0;
+}
+
+// default destructor
+
+jfnk::~jfnk() { }
+
+// #### methods ####
+
+// allocate storage
+
+void jfnk::setup(struct solution* FlowSol)
+{
+#ifdef _GPU
+  FatalError("The implicit solver (adv_type 4) is only implemented on the CPU");
+#endif
+
+  int i, ic, max_block = 1;
+
+  if (run_input.jfnk_krylov_dim < 1)
+    FatalError("jfnk_krylov_dim must be at least 1");
+
+  if (run_input.dt_type != 0 && run_input.CFL <= 0.0)
+    FatalError("The implicit solver needs a positive CFL to set the initial pseudo time step");
+
+  n_ele_types = FlowSol->n_ele_types;
+  krylov_dim = run_input.jfnk_krylov_dim;
+
+  n_upts.setup(n_ele_types);
+  n_eles.setup(n_ele_types);
+  n_fields.setup(n_ele_types);
+
+  u0.setup(n_ele_types);
+  f0.setup(n_ele_types);
+  work.setup(n_ele_types);
+  krylov.setup(n_ele_types);
+  dtau.setup(n_ele_types);
+  jac_blocks.setup(n_ele_types);
+  lu_blocks.setup(n_ele_types);
+  lu_pivots.setup(n_ele_types);
+
+  n_colors = 0;
+  for (i=0;i<n_ele_types;i++) {
+      n_eles(i) = FlowSol->mesh_eles(i)->get_n_eles();
+      n_upts(i) = 0;
+      n_fields(i) = 0;
+
+      if (n_eles(i) == 0)
+        continue;
+
+      n_upts(i) = FlowSol->mesh_eles(i)->get_n_upts_per_ele();
+      n_fields(i) = FlowSol->mesh_eles(i)->get_n_fields();
+
+      int n_block = n_upts(i)*n_fields(i);
+      if (n_block > max_block)
+        max_block = n_block;
+
+      u0(i).setup(n_upts(i),n_eles(i),n_fields(i));
+      f0(i).setup(n_upts(i),n_eles(i),n_fields(i));
+      work(i).setup(n_upts(i),n_eles(i),n_fields(i),2);
+      krylov(i).setup(n_upts(i),n_eles(i),n_fields(i),krylov_dim+1);
+      dtau(i).setup(n_eles(i));
+
+      u0(i).set_tag("jfnk/state");
+      f0(i).set_tag("jfnk/state");
+      work(i).set_tag("jfnk/state");
+      dtau(i).set_tag("jfnk/state");
+      krylov(i).set_tag("jfnk/krylov");
+
+      if (run_input.jfnk_prec_freq > 0) {
+          jac_blocks(i).setup(n_block,n_block,n_eles(i));
+          lu_blocks(i).setup(n_block,n_block,n_eles(i));
+          lu_pivots(i).setup(n_block,n_eles(i));
+
+          jac_blocks(i).set_tag("jfnk/preconditioner");
+          lu_blocks(i).set_tag("jfnk/preconditioner");
+          lu_pivots(i).set_tag("jfnk/preconditioner");
+        }
+
+      for (ic=0;ic<n_eles(i);ic++)
+        if (FlowSol->mesh_eles(i)->get_ele_color(ic)+1 > n_colors)
+          n_colors = FlowSol->mesh_eles(i)->get_ele_color(ic)+1;
+    }
+
+  block_rhs.setup(max_block);
+
+  hessenberg.setup(krylov_dim+1,krylov_dim);
+  givens_c.setup(krylov_dim);
+  givens_s.setup(krylov_dim);
+  gmres_g.setup(krylov_dim+1);
+  gmres_y.setup(krylov_dim);
+  gmres_h.setup(krylov_dim+1);
+
+  cfl_ratio = 1.0;
+  res_norm_old = -1.0;
+  n_steps = 0;
+  jac_age = -1;
+  f0_valid = 0;
+}
+
+void jfnk::get_solution(array< array<double> >& out_u, int in_col, struct solution* FlowSol)
+{
+  for (int i=0;i<n_ele_types;i++)
+    if (n_eles(i) != 0)
+      memcpy(out_u(i).get_ptr_cpu(0,0,0,in_col), FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu(), n_upts(i)*n_eles(i)*n_fields(i)*sizeof(double));
+}
+
+void jfnk::set_solution(array< array<double> >& in_u, int in_col, struct solution* FlowSol)
+{
+  for (int i=0;i<n_ele_types;i++)
+    if (n_eles(i) != 0)
+      memcpy(FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu(), in_u(i).get_ptr_cpu(0,0,0,in_col), n_upts(i)*n_eles(i)*n_fields(i)*sizeof(double));
+}
+
+void jfnk::calc_rhs(array< array<double> >& out_f, int in_col, struct solution* FlowSol, int in_mpi_exchange)
+{
+  CalcResidual(FlowSol, in_mpi_exchange);
+
+  for (int i=0;i<n_ele_types;i++)
+    if (n_eles(i) != 0)
+      FlowSol->mesh_eles(i)->calc_rhs_upts(out_f(i).get_ptr_cpu(0,0,0,in_col));
+}
+
+double jfnk::dot(array< array<double> >& in_a, int in_col_a, array< array<double> >& in_b, int in_col_b)
+{
+  double sum = 0.0;
+
+  for (int i=0;i<n_ele_types;i++) {
+      if (n_eles(i) == 0)
+        continue;
+
+      double* a = in_a(i).get_ptr_cpu(0,0,0,in_col_a);
+      double* b = in_b(i).get_ptr_cpu(0,0,0,in_col_b);
+      int n = n_upts(i)*n_eles(i)*n_fields(i);
+
+      for (int k=0;k<n;k++)
+        sum += a[k]*b[k];
+    }
+
+#ifdef _MPI
+  double sum_global;
+  MPI_Allreduce(&sum, &sum_global, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  sum = sum_global;
+#endif
+
+  return sum;
+}
+
+void jfnk::dot_krylov(array< array<double> >& in_w, int in_col_w, int in_n, double* out_h)
+{
+  int j, k;
+
+  for (j=0;j<in_n;j++)
+    gmres_h(j) = 0.0;
+
+  for (int i=0;i<n_ele_types;i++) {
+      if (n_eles(i) == 0)
+        continue;
+
+      double* w = in_w(i).get_ptr_cpu(0,0,0,in_col_w);
+      int n = n_upts(i)*n_eles(i)*n_fields(i);
+
+      for (j=0;j<in_n;j++) {
+          double* v = krylov(i).get_ptr_cpu(0,0,0,j);
+          double sum = 0.0;
+          for (k=0;k<n;k++)
+            sum += w[k]*v[k];
+          gmres_h(j) += sum;
+        }
+    }
+
+#ifdef _MPI
+  MPI_Allreduce(gmres_h.get_ptr_cpu(), out_h, in_n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#else
+  for (j=0;j<in_n;j++)
+    out_h[j] = gmres_h(j);
+#endif
+}
+
+// pseudo time step of each element, following dt_type, scaled by the current CFL ratio
+
+void jfnk::calc_dtau(struct solution* FlowSol)
+{
+  int i, ic;
+  double dt_min = 1e12;
+
+  for (i=0;i<n_ele_types;i++)
+    for (ic=0;ic<n_eles(i);ic++) {
+        if (run_input.dt_type == 0)
+          dtau(i)(ic) = run_input.dt;
+        else if (run_input.dt_type == 1 || run_input.dt_type == 2)
+          dtau(i)(ic) = FlowSol->mesh_eles(i)->calc_dt_local(ic);
+        else
+          FatalError("ERROR: dt_type not recognized!");
+
+        if (dtau(i)(ic) < dt_min)
+          dt_min = dtau(i)(ic);
+      }
+
+  if (run_input.dt_type == 1) {
+#ifdef _MPI
+      double dt_min_global;
+      MPI_Allreduce(&dt_min, &dt_min_global, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+      dt_min = dt_min_global;
+#endif
+      for (i=0;i<n_ele_types;i++)
+        for (ic=0;ic<n_eles(i);ic++)
+          dtau(i)(ic) = dt_min;
+    }
+
+  for (i=0;i<n_ele_types;i++)
+    for (ic=0;ic<n_eles(i);ic++)
+      dtau(i)(ic) *= cfl_ratio;
+}
+
+// Finite-difference the diagonal blocks of dR/du. All elements of one color are perturbed together:
+// no two of them share a residual stencil, so each sees only its own perturbation. The neighbouring
+// partitions keep the state of the last exchange (u0), so the probes need no communication.
+
+void jfnk::calc_jacobian_blocks(struct solution* FlowSol)
+{
+  int i, ic, j, r, c, max_block = 0;
+
+  for (i=0;i<n_ele_types;i++)
+    if (n_upts(i)*n_fields(i) > max_block)
+      max_block = n_upts(i)*n_fields(i);
+
+  for (c=0;c<n_colors;c++) {
+      for (j=0;j<max_block;j++) {
+
+          // perturb unknown j of every element of color c
+          for (i=0;i<n_ele_types;i++) {
+              if (j >= n_upts(i)*n_fields(i))
+                continue;
+
+              double* u = FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu();
+              int inp = j%n_upts(i), k = j/n_upts(i);
+
+              for (ic=0;ic<n_eles(i);ic++)
+                if (FlowSol->mesh_eles(i)->get_ele_color(ic) == c)
+                  u[inp+n_upts(i)*(ic+n_eles(i)*k)] += 1.e-7*(1.0+fabs(u0(i)(inp,ic,k)));
+            }
+
+          calc_rhs(work, 0, FlowSol, 0);
+
+          // column j of the blocks, and restore the state
+          for (i=0;i<n_ele_types;i++) {
+              int n_block = n_upts(i)*n_fields(i);
+              if (j >= n_block)
+                continue;
+
+              double* u = FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu();
+              int inp = j%n_upts(i), k = j/n_upts(i);
+
+              for (ic=0;ic<n_eles(i);ic++) {
+                  if (FlowSol->mesh_eles(i)->get_ele_color(ic) != c)
+                    continue;
+
+                  int n = inp+n_upts(i)*(ic+n_eles(i)*k);
+                  double h = u[n]-u0(i)(inp,ic,k);
+                  double* jac = jac_blocks(i).get_ptr_cpu(0,j,ic);
+
+                  for (r=0;r<n_block;r++) {
+                      int inp_r = r%n_upts(i), k_r = r/n_upts(i);
+                      jac[r] = (work(i)(inp_r,ic,k_r,0)-f0(i)(inp_r,ic,k_r))/h;
+                    }
+
+                  u[n] = u0(i)(inp,ic,k);
+                }
+            }
+        }
+    }
+}
+
+void jfnk::factorize_blocks(void)
+{
+  for (int i=0;i<n_ele_types;i++) {
+      int n_block = n_upts(i)*n_fields(i);
+
+      for (int ic=0;ic<n_eles(i);ic++) {
+          double* jac = jac_blocks(i).get_ptr_cpu(0,0,ic);
+          double* lu = lu_blocks(i).get_ptr_cpu(0,0,ic);
+
+          for (int k=0;k<n_block*n_block;k++)
+            lu[k] = -jac[k];
+
+          for (int r=0;r<n_block;r++)
+            lu[r+n_block*r] += 1.0/dtau(i)(ic);
+
+          lu_factor(lu, lu_pivots(i).get_ptr_cpu(0,ic), n_block);
+        }
+    }
+}
+
+void jfnk::apply_preconditioner(array< array<double> >& in_v, int in_col_v, array< array<double> >& out_z, int in_col_z)
+{
+  int i, ic, k, inp, r;
+
+  for (i=0;i<n_ele_types;i++) {
+      int n_block = n_upts(i)*n_fields(i);
+
+      for (ic=0;ic<n_eles(i);ic++) {
+
+          // Without a preconditioner, scale by the pseudo time step
+          if (run_input.jfnk_prec_freq <= 0) {
+              for (k=0;k<n_fields(i);k++)
+                for (inp=0;inp<n_upts(i);inp++)
+                  out_z(i)(inp,ic,k,in_col_z) = dtau(i)(ic)*in_v(i)(inp,ic,k,in_col_v);
+              continue;
+            }
+
+          for (r=0;r<n_block;r++)
+            block_rhs(r) = in_v(i)(r%n_upts(i),ic,r/n_upts(i),in_col_v);
+
+          lu_solve(lu_blocks(i).get_ptr_cpu(0,0,ic), lu_pivots(i).get_ptr_cpu(0,ic), n_block, block_rhs.get_ptr_cpu());
+
+          for (r=0;r<n_block;r++)
+            out_z(i)(r%n_upts(i),ic,r/n_upts(i),in_col_z) = block_rhs(r);
+        }
+    }
+}
+
+// w = z/dtau - (R(u0 + eps*z) - R(u0))/eps
+
+void jfnk::apply_operator(array< array<double> >& in_z, int in_col_z, array< array<double> >& out_w, int in_col_w, struct solution* FlowSol)
+{
+  int i, ic, k, inp;
+  double norm_z = sqrt(dot(in_z, in_col_z, in_z, in_col_z));
+
+  if (norm_z == 0.0) {
+      for (i=0;i<n_ele_types;i++)
+        for (k=0;k<n_fields(i);k++)
+          for (ic=0;ic<n_eles(i);ic++)
+            for (inp=0;inp<n_upts(i);inp++)
+              out_w(i)(inp,ic,k,in_col_w) = 0.0;
+      return;
+    }
+
+  double eps = sqrt(1.e-16*(1.0+norm_u0))/norm_z;
+
+  for (i=0;i<n_ele_types;i++) {
+      if (n_eles(i) == 0)
+        continue;
+
+      double* u = FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu();
+      double* a = u0(i).get_ptr_cpu();
+      double* z = in_z(i).get_ptr_cpu(0,0,0,in_col_z);
+      int n = n_upts(i)*n_eles(i)*n_fields(i);
+
+      for (k=0;k<n;k++)
+        u[k] = a[k]+eps*z[k];
+    }
+
+  calc_rhs(out_w, in_col_w, FlowSol);
+
+  for (i=0;i<n_ele_types;i++)
+    for (k=0;k<n_fields(i);k++)
+      for (ic=0;ic<n_eles(i);ic++)
+        for (inp=0;inp<n_upts(i);inp++)
+          out_w(i)(inp,ic,k,in_col_w) = in_z(i)(inp,ic,k,in_col_z)/dtau(i)(ic)
+              - (out_w(i)(inp,ic,k,in_col_w)-f0(i)(inp,ic,k))/eps;
+}
+
+void jfnk::advance(struct solution* FlowSol)
+{
+  int i, j, k, it, pass, n_its = 0;
+  double lin_res = 0.0;
+
+  // State and time derivative at the start of the step. The time derivative is left over from the
+  // end of the previous step, unless that step was rejected or this is the first one
+  get_solution(u0, 0, FlowSol);
+  if (!f0_valid)
+    calc_rhs(f0, 0, FlowSol);
+
+  double res_norm = sqrt(dot(f0, 0, f0, 0));
+  norm_u0 = sqrt(dot(u0, 0, u0, 0));
+
+  // Switched evolution relaxation: grow the pseudo time step as the residual drops
+  if (res_norm_old > 0.0 && res_norm > 0.0)
+    cfl_ratio = min(run_input.jfnk_max_cfl_ratio, max(1.e-3, cfl_ratio*res_norm_old/res_norm));
+
+  calc_dtau(FlowSol);
+
+  // Block-Jacobi preconditioner. The element Jacobians are reused for jfnk_prec_freq steps,
+  // but the blocks are shifted by the current pseudo time step every step
+  if (run_input.jfnk_prec_freq > 0) {
+      if (jac_age < 0 || jac_age >= run_input.jfnk_prec_freq) {
+          calc_jacobian_blocks(FlowSol);
+          jac_age = 0;
+        }
+      jac_age++;
+      factorize_blocks();
+    }
+
+  // Right-preconditioned GMRES for (I/dtau - dR/du) du = R(u0), starting from du = 0
+  if (res_norm > 0.0) {
+
+      for (i=0;i<n_ele_types;i++)
+        for (k=0;k<n_fields(i);k++)
+          for (int ic=0;ic<n_eles(i);ic++)
+            for (int inp=0;inp<n_upts(i);inp++)
+              krylov(i)(inp,ic,k,0) = f0(i)(inp,ic,k)/res_norm;
+
+      for (j=0;j<=krylov_dim;j++)
+        gmres_g(j) = 0.0;
+      gmres_g(0) = res_norm;
+
+      for (it=0;it<krylov_dim;it++) {
+
+          apply_preconditioner(krylov, it, work, 0);
+          apply_operator(work, 0, work, 1, FlowSol);
+
+          // Classical Gram-Schmidt, applied twice to keep the basis orthogonal with one
+          // reduction per pass
+          for (j=0;j<=it;j++)
+            hessenberg(j,it) = 0.0;
+
+          for (pass=0;pass<2;pass++) {
+              dot_krylov(work, 1, it+1, gmres_y.get_ptr_cpu());
+
+              for (j=0;j<=it;j++) {
+                  hessenberg(j,it) += gmres_y(j);
+
+                  for (i=0;i<n_ele_types;i++) {
+                      if (n_eles(i) == 0)
+                        continue;
+
+                      double* w = work(i).get_ptr_cpu(0,0,0,1);
+                      double* v = krylov(i).get_ptr_cpu(0,0,0,j);
+                      int n = n_upts(i)*n_eles(i)*n_fields(i);
+
+                      for (k=0;k<n;k++)
+                        w[k] -= gmres_y(j)*v[k];
+                    }
+                }
+            }
+
+          double h_next = sqrt(dot(work, 1, work, 1));
+          hessenberg(it+1,it) = h_next;
+
+          if (h_next > 0.0)
+            for (i=0;i<n_ele_types;i++) {
+                if (n_eles(i) == 0)
+                  continue;
+
+                double* w = work(i).get_ptr_cpu(0,0,0,1);
+                double* v = krylov(i).get_ptr_cpu(0,0,0,it+1);
+                int n = n_upts(i)*n_eles(i)*n_fields(i);
+
+                for (k=0;k<n;k++)
+                  v[k] = w[k]/h_next;
+              }
+
+          // Apply the previous Givens rotations to the new column, then eliminate its subdiagonal
+          for (j=0;j<it;j++) {
+              double temp = givens_c(j)*hessenberg(j,it) + givens_s(j)*hessenberg(j+1,it);
+              hessenberg(j+1,it) = -givens_s(j)*hessenberg(j,it) + givens_c(j)*hessenberg(j+1,it);
+              hessenberg(j,it) = temp;
+            }
+
+          double r = sqrt(hessenberg(it,it)*hessenberg(it,it) + hessenberg(it+1,it)*hessenberg(it+1,it));
+          givens_c(it) = hessenberg(it,it)/r;
+          givens_s(it) = hessenberg(it+1,it)/r;
+          hessenberg(it,it) = r;
+          hessenberg(it+1,it) = 0.0;
+
+          gmres_g(it+1) = -givens_s(it)*gmres_g(it);
+          gmres_g(it) = givens_c(it)*gmres_g(it);
+
+          n_its = it+1;
+          lin_res = fabs(gmres_g(it+1))/res_norm;
+
+          if (lin_res <= run_input.jfnk_lin_tol || h_next == 0.0)
+            break;
+        }
+
+      // du = M^-1 V y, where H y = g
+      for (j=n_its-1;j>=0;j--) {
+          gmres_y(j) = gmres_g(j);
+          for (k=j+1;k<n_its;k++)
+            gmres_y(j) -= hessenberg(j,k)*gmres_y(k);
+          gmres_y(j) /= hessenberg(j,j);
+        }
+
+      for (i=0;i<n_ele_types;i++) {
+          if (n_eles(i) == 0)
+            continue;
+
+          double* w = work(i).get_ptr_cpu(0,0,0,1);
+          int n = n_upts(i)*n_eles(i)*n_fields(i);
+
+          for (k=0;k<n;k++)
+            w[k] = 0.0;
+
+          for (j=0;j<n_its;j++) {
+              double* v = krylov(i).get_ptr_cpu(0,0,0,j);
+              for (k=0;k<n;k++)
+                w[k] += gmres_y(j)*v[k];
+            }
+        }
+
+      apply_preconditioner(work, 1, work, 0);
+    }
+  else {
+      for (i=0;i<n_ele_types;i++)
+        for (k=0;k<n_fields(i);k++)
+          for (int ic=0;ic<n_eles(i);ic++)
+            for (int inp=0;inp<n_upts(i);inp++)
+              work(i)(inp,ic,k,0) = 0.0;
+    }
+
+  // Newton update, and the time derivative at the new state for the next step and the monitors
+  int bad_state = 0;
+
+  for (i=0;i<n_ele_types;i++) {
+      if (n_eles(i) == 0)
+        continue;
+
+      double* u = FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu();
+      double* a = u0(i).get_ptr_cpu();
+      double* du = work(i).get_ptr_cpu(0,0,0,0);
+      int n = n_upts(i)*n_eles(i)*n_fields(i);
+
+      for (k=0;k<n;k++)
+        u[k] = a[k]+du[k];
+
+      // negative density
+      if (run_input.equation == 0)
+        for (k=0;k<n_upts(i)*n_eles(i);k++)
+          if (!(u[k] > 0.0))
+            bad_state = 1;
+    }
+
+#ifdef _MPI
+  int bad_state_global;
+  MPI_Allreduce(&bad_state, &bad_state_global, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  bad_state = bad_state_global;
+#endif
+
+  double res_norm_new = 0.0;
+  if (!bad_state) {
+      calc_rhs(f0, 0, FlowSol);
+      res_norm_new = sqrt(dot(f0, 0, f0, 0));
+      if (!(res_norm_new < 1.e300))
+        bad_state = 1;
+    }
+
+  n_steps++;
+
+  if (bad_state) {
+      // Reject the step and retry from the old state with a smaller pseudo time step
+      set_solution(u0, 0, FlowSol);
+      calc_rhs(f0, 0, FlowSol);
+      f0_valid = 1;
+      cfl_ratio *= 0.1;
+      res_norm_old = -1.0;
+
+      if (FlowSol->rank == 0)
+        cout << "Implicit step " << n_steps << " rejected, CFL ratio reduced to " << cfl_ratio << endl;
+    }
+  else {
+      f0_valid = 1;
+      res_norm_old = res_norm;
+
+      if (FlowSol->rank == 0 && (n_steps == 1 || n_steps%run_input.monitor_res_freq == 0))
+        cout << "Implicit step " << n_steps << ": CFL ratio " << cfl_ratio
+             << ", " << n_its << " GMRES iterations, linear residual " << lin_res
+             << ", residual " << res_norm << " -> " << res_norm_new << endl;
+    }
+}
@@ -0,0 +1,203 @@
+/*!
+ * \file lsrk.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include "../include/lsrk.h"
+#include "../include/error.h"
+
+using namespace std;
+
+// #### constructors ####
+
+// default constructor
+
+lsrk::lsrk()
+{
+  scheme = 0;
+  form = 0;
+  n_stages = 0;
+  order = 0;
+  err_prev = 1.;
+}
+
+// default destructor
+
+lsrk::~lsrk() { }
+
+// #### methods ####
+
+// set up the tables of a scheme
+
+void lsrk::setup(int in_scheme)
+{
+  int i, j;
+
+  scheme = in_scheme;
+
+  if (scheme == 0) // forward Euler
+    {
+      double a_s[1] = {0.};
+      double b_s[1] = {1.};
+      double e_s[1] = {0.};
+
+      form = 0; n_stages = 1; order = 1;
+      a.setup(n_stages); b.setup(n_stages); e.setup(n_stages);
+      for (i=0;i<n_stages;i++) { a(i) = a_s[i]; b(i) = b_s[i]; e(i) = e_s[i]; }
+    }
+  else if (scheme == 1) // RK45, five-stage fourth-order 2N scheme of Carpenter and Kennedy
+    {
+      double a_s[5] = {0.0, -0.417890474499852, -1.192151694642677, -1.697784692471528, -1.514183444257156};
+      double b_s[5] = {0.149659021999229, 0.379210312999627, 0.822955029386982, 0.699450455949122, 0.153057247968152};
+      double e_s[5] = {-0.1062156451002365, 0.2283796527200146, -0.1616895166655637, 0.03620463719967271, 0.003320871846113987};
+
+      form = 0; n_stages = 5; order = 4;
+      a.setup(n_stages); b.setup(n_stages); e.setup(n_stages);
+      for (i=0;i<n_stages;i++) { a(i) = a_s[i]; b(i) = b_s[i]; e(i) = e_s[i]; }
+    }
+  else if (scheme == 2) // three-stage third-order 2N scheme of Williamson
+    {
+      double a_s[3] = {0., -5./9., -153./128.};
+      double b_s[3] = {1./3., 15./16., 8./15.};
+      double e_s[3] = {0.01092896174863378, -0.01967213114754113, 0.008743169398906847};
+
+      form = 0; n_stages = 3; order = 3;
+      a.setup(n_stages); b.setup(n_stages); e.setup(n_stages);
+      for (i=0;i<n_stages;i++) { a(i) = a_s[i]; b(i) = b_s[i]; e(i) = e_s[i]; }
+    }
+  else if (scheme == 3) // three-stage third-order SSP scheme of Shu and Osher, SSP coefficient 1
+    {
+      double a_s[3] = {0., 3./4., 1./3.};
+      double b_s[3] = {1., 1./4., 2./3.};
+      double e_s[3] = {-1./6., -1./6., 1./3.};
+
+      form = 1; n_stages = 3; order = 3;
+      a.setup(n_stages); b.setup(n_stages); e.setup(n_stages);
+      for (i=0;i<n_stages;i++) { a(i) = a_s[i]; b(i) = b_s[i]; e(i) = e_s[i]; }
+    }
+  else if (scheme == 4) // four-stage third-order SSP scheme, SSP coefficient 2
+    {
+      double a_s[4] = {0., 0., 2./3., 0.};
+      double b_s[4] = {1./2., 1./2., 1./6., 1./2.};
+      double e_s[4] = {-1./12., -1./12., -1./12., 1./4.};
+
+      form = 1; n_stages = 4; order = 3;
+      a.setup(n_stages); b.setup(n_stages); e.setup(n_stages);
+      for (i=0;i<n_stages;i++) { a(i) = a_s[i]; b(i) = b_s[i]; e(i) = e_s[i]; }
+    }
+  else if (scheme == 5) // fourteen-stage fourth-order 2N scheme of Niegemann, Diehl and Busch, optimized for DG spectra
+    {
+      double a_s[14] = {0., -0.7188012108672410, -0.7785331173421570, -0.0053282796654044, -0.8552979934029281,
+                        -3.9564138245774565, -1.5780575380587385, -2.0837094552574054, -0.7483334182761610,
+                        -0.7032861106563359, 0.0013917096117681, -0.0932075369637460, -0.9514200470875948,
+                        -7.1151571693922548};
+      double b_s[14] = {0.0367762454319673, 0.3136296607553959, 0.1531848691869027, 0.0030097086818182,
+                        0.3326293790646110, 0.2440251405350864, 0.3718879239592277, 0.6204126221582444,
+                        0.1524043173028741, 0.0760894927419266, 0.0077604214040978, 0.0024647284755382,
+                        0.0780348340049386, 5.5059777270269628};
+      double e_s[14] = {-0.1326325047296411, 0.1933365425802963, -0.08108449525447523, 4.575687873607972,
+                        -5.42191787607918, 1.410212951865227, -0.8157543835592385, 0.3568690603157803,
+                        -0.06423850670316703, 0.09620705986742059, -3.531635449955687, 37.13393741650464,
+                        -39.16367628731743, 5.44468859885748};
+
+      form = 0; n_stages = 14; order = 4;
+      a.setup(n_stages); b.setup(n_stages); e.setup(n_stages);
+      for (i=0;i<n_stages;i++) { a(i) = a_s[i]; b(i) = b_s[i]; e(i) = e_s[i]; }
+    }
+  else
+    FatalError("Low-storage RK scheme not recognized");
+
+  // Weight of each stage's time derivative in the complete step, from the update u - u_0 as a combination of them
+  array<double> du(n_stages), res(n_stages);
+  du.initialize_to_zero();
+  res.initialize_to_zero();
+
+  for (i=0;i<n_stages;i++)
+    for (j=0;j<n_stages;j++)
+      {
+        if (form == 0) {
+            res(j) = a(i)*res(j) + (i == j ? 1. : 0.);
+            du(j) += b(i)*res(j);
+          }
+        else
+          du(j) = (1.-a(i))*du(j) + (i == j ? b(i) : 0.);
+      }
+
+  weight.setup(n_stages);
+  for (i=0;i<n_stages;i++)
+    weight(i) = du(i);
+}
+
+int lsrk::get_n_stages(void)
+{
+  return n_stages;
+}
+
+int lsrk::get_order(void)
+{
+  return order;
+}
+
+int lsrk::get_form(void)
+{
+  return form;
+}
+
+double lsrk::get_a(int in_stage)
+{
+  return a(in_stage);
+}
+
+double lsrk::get_b(int in_stage)
+{
+  return b(in_stage);
+}
+
+double lsrk::get_e(int in_stage)
+{
+  return e(in_stage);
+}
+
+double lsrk::get_weight(int in_stage)
+{
+  return weight(in_stage);
+}
+
+// PI step size controller for an error of order dt^order (Gustafsson). The term in the previous error damps the
+// oscillation between accepted and rejected steps when the step is limited by stability rather than accuracy
+
+double lsrk::calc_new_dt(double in_dt, double in_err)
+{
+  double fac, err = max(in_err,1.e-10);
+
+  // Rejected: shrink from this error alone
+  if (in_err > 1.)
+    return max(0.2,min(1.,0.9*pow(err,-1./order)))*in_dt;
+
+  fac = 0.9*pow(err,-0.7/order)*pow(err_prev,0.4/order);
+  err_prev = err;
+
+  return min(2.,max(0.2,fac))*in_dt;
+}
@@ -0,0 +1,163 @@
+/*!
+ * \file mem_pool.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#ifdef _NUMA
+#include <numa.h>
+#endif
+
+#include "../include/mem_pool.h"
+#include "../include/error.h"
+
+// size classes: MEM_ALIGNMENT, 2*MEM_ALIGNMENT, ..., MEM_POOL_MAX_BYTES
+#define MEM_N_CLASSES 11
+
+// number of bytes carved into blocks at once when a size class runs empty
+#define MEM_SLAB_BYTES 262144
+
+// Zero-initialized static storage, as arrays are created during static initialization.
+// Each thread (e.g. the background output writer) recycles blocks through its own free lists,
+// so that they need no lock; a block freed by another thread than its allocator simply moves over.
+static __thread void* mem_free_list[MEM_N_CLASSES];
+static size_t mem_reserved;
+static int mem_huge_pages;
+
+// aligned block straight from the system
+static void* mem_system_alloc(size_t in_bytes, size_t in_alignment)
+{
+  void* ptr;
+
+  if (posix_memalign(&ptr, in_alignment, in_bytes) != 0)
+    FatalError("Out of memory");
+
+  return ptr;
+}
+
+// size class of an allocation of in_bytes bytes
+static int mem_size_class(size_t in_bytes)
+{
+  int i = 0;
+  size_t class_bytes = MEM_ALIGNMENT;
+
+  while (class_bytes < in_bytes) {
+    class_bytes *= 2;
+    i++;
+  }
+
+  return i;
+}
+
+void* mem_pool_alloc(size_t in_bytes)
+{
+  void* ptr;
+
+  if (in_bytes > MEM_POOL_MAX_BYTES) {
+    if (mem_huge_pages && in_bytes >= MEM_HUGE_PAGE_BYTES) {
+      // Round up to whole huge pages so that no small page is left at the end of the block
+      size_t huge_bytes = ((in_bytes+MEM_HUGE_PAGE_BYTES-1)/MEM_HUGE_PAGE_BYTES)*MEM_HUGE_PAGE_BYTES;
+      ptr = mem_system_alloc(huge_bytes, MEM_HUGE_PAGE_BYTES);
+#ifdef MADV_HUGEPAGE
+      madvise(ptr, huge_bytes, MADV_HUGEPAGE);
+#endif
+      return ptr;
+    }
+    return mem_system_alloc(in_bytes, MEM_ALIGNMENT);
+  }
+
+  int c = mem_size_class(in_bytes);
+
+  if (mem_free_list[c] == NULL) {
+    // Carve a new slab into blocks of this class and thread them onto the free list
+    size_t class_bytes = ((size_t) MEM_ALIGNMENT) << c;
+    size_t n_blocks = MEM_SLAB_BYTES/class_bytes;
+    char* slab = (char*) mem_system_alloc(n_blocks*class_bytes, MEM_ALIGNMENT);
+
+    for (size_t i=0; i<n_blocks; i++) {
+      *(void**)(slab+i*class_bytes) = mem_free_list[c];
+      mem_free_list[c] = slab+i*class_bytes;
+    }
+    __sync_fetch_and_add(&mem_reserved, n_blocks*class_bytes);
+  }
+
+  ptr = mem_free_list[c];
+  mem_free_list[c] = *(void**)ptr;
+
+  return ptr;
+}
+
+void mem_pool_free(void* in_ptr, size_t in_bytes)
+{
+  if (in_ptr == NULL)
+    return;
+
+  if (in_bytes > MEM_POOL_MAX_BYTES) {
+    free(in_ptr);
+    return;
+  }
+
+  int c = mem_size_class(in_bytes);
+  *(void**)in_ptr = mem_free_list[c];
+  mem_free_list[c] = in_ptr;
+}
+
+void mem_pool_set_huge_pages(int in_huge_pages)
+{
+  mem_huge_pages = in_huge_pages;
+}
+
+void mem_pool_set_numa_policy(int in_policy, int in_local_rank)
+{
+  if (in_policy == 0)
+    return;
+
+#ifdef _NUMA
+  if (numa_available() < 0)
+    FatalError("numa_policy is set but NUMA is not available on this system");
+
+  if (in_policy == 1) {
+    numa_set_interleave_mask(numa_all_nodes_ptr);
+  }
+  else if (in_policy == 2) {
+    int node = in_local_rank%(numa_max_node()+1);
+
+    // Keep the rank on the node that holds its pages, as the scheduler is free to move it otherwise
+    if (numa_run_on_node(node) != 0)
+      FatalError("Unable to run on the requested NUMA node");
+    numa_set_preferred(node);
+  }
+  else {
+    FatalError("numa_policy not recognized");
+  }
+#else
+  FatalError("numa_policy requires HiFiLES to be compiled with NUMA support (-D_NUMA)");
+#endif
+}
+
+size_t mem_pool_reserved_bytes(void)
+{
+  return mem_reserved;
+}
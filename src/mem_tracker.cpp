@@ -0,0 +1,120 @@
+/*!
+ * \file mem_tracker.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/mem_tracker.h"
+#include "../include/error.h"
+
+// Zero-initialized static storage; no constructors run, so arrays built during static
+// initialization (e.g. members of run_input) can be tracked safely
+static char mem_tag_names[MAX_MEM_TAGS][MAX_MEM_TAG_LEN];
+static size_t mem_tag_current[MAX_MEM_TAGS];
+static size_t mem_tag_max[MAX_MEM_TAGS];
+static int mem_n_registered_tags;
+static size_t mem_current;
+static size_t mem_max;
+
+// Set on helper threads (the background output writer), whose temporary arrays are not accounted
+static __thread int mem_untracked;
+
+int mem_tag_id(const char* in_name)
+{
+  int i;
+
+  if (mem_n_registered_tags == 0) {
+    strcpy(mem_tag_names[0], "untagged");
+    mem_n_registered_tags = 1;
+  }
+
+  for (i=0; i<mem_n_registered_tags; i++)
+    if (!strncmp(mem_tag_names[i], in_name, MAX_MEM_TAG_LEN-1))
+      return i;
+
+  if (mem_n_registered_tags == MAX_MEM_TAGS)
+    FatalError("Too many memory tags, increase MAX_MEM_TAGS");
+
+  strncpy(mem_tag_names[mem_n_registered_tags], in_name, MAX_MEM_TAG_LEN-1);
+  return mem_n_registered_tags++;
+}
+
+void mem_track_alloc(int in_tag, size_t in_bytes)
+{
+  if (mem_untracked)
+    return;
+
+  mem_tag_current[in_tag] += in_bytes;
+  if (mem_tag_current[in_tag] > mem_tag_max[in_tag])
+    mem_tag_max[in_tag] = mem_tag_current[in_tag];
+
+  mem_current += in_bytes;
+  if (mem_current > mem_max)
+    mem_max = mem_current;
+}
+
+void mem_track_free(int in_tag, size_t in_bytes)
+{
+  if (mem_untracked)
+    return;
+
+  mem_tag_current[in_tag] -= in_bytes;
+  mem_current -= in_bytes;
+}
+
+void mem_track_ignore_thread(void)
+{
+  mem_untracked = 1;
+}
+
+int mem_n_tags(void)
+{
+  return (mem_n_registered_tags == 0) ? 1 : mem_n_registered_tags;
+}
+
+const char* mem_tag_name(int in_tag)
+{
+  return (in_tag == 0) ? "untagged" : mem_tag_names[in_tag];
+}
+
+size_t mem_tag_bytes(int in_tag)
+{
+  return mem_tag_current[in_tag];
+}
+
+size_t mem_tag_peak(int in_tag)
+{
+  return mem_tag_max[in_tag];
+}
+
+size_t mem_total_bytes(void)
+{
+  return mem_current;
+}
+
+size_t mem_total_peak(void)
+{
+  return mem_max;
+}
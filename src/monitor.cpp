@@ -0,0 +1,205 @@
+/*!
+ * \file monitor.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cmath>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/monitor.h"
+#include "../include/output.h"
+#include "../include/error.h"
+
+using namespace std;
+
+#ifdef _MPI
+
+// layout of the buffer seen by the reduction operator: the first n_sum_op of n_buf_op entries are summed
+
+static int n_sum_op = 0;
+static int n_buf_op = 0;
+
+// reduction operator of the monitoring buffer
+
+static void monitor_reduce(void* in, void* inout, int* len, MPI_Datatype* type)
+{
+  double* a = (double*) in;
+  double* b = (double*) inout;
+
+  for (int n=0; n<*len; n++, a+=n_buf_op, b+=n_buf_op) {
+    for (int i=0; i<n_sum_op; i++)
+      b[i] += a[i];
+    for (int i=n_sum_op; i<n_buf_op; i++)
+      b[i] = max(b[i], a[i]);
+  }
+}
+
+#endif
+
+// #### constructors ####
+
+// default constructor
+
+monitor::monitor()
+{
+  n_dims = 0;
+  n_fields = 0;
+  n_integral_quantities = 0;
+  n_sum = 0;
+  file_num = 0;
+  time = 0.;
+  pending = false;
+  overlap = true;
+}
+
+// default destructor
+
+monitor::~monitor() { }
+
+// #### methods ####
+
+// size the buffer and set up the reduction
+
+void monitor::setup(struct solution* FlowSol)
+{
+  n_dims = FlowSol->n_dims;
+  n_fields = (run_input.equation == 1) ? 1 : n_dims+2;
+  n_integral_quantities = run_input.n_integral_quantities;
+
+  int n_buf = 2*n_dims + 2 + n_integral_quantities + 1 + n_fields;
+
+  // The body force of the periodic channel, from the reduced viscous force, is needed by the next step
+  overlap = !(run_input.equation==0 && run_input.forcing==1 && n_dims==3);
+
+  // The residuals of the infinity norm are the only maxima
+  n_sum = (run_input.res_norm_type == 0) ? n_buf - n_fields : n_buf;
+
+  buf.setup(n_buf);
+  buf_global.setup(n_buf);
+  buf.initialize_to_zero();
+  buf_global.initialize_to_zero();
+
+#ifdef _MPI
+
+  n_sum_op = n_sum;
+  n_buf_op = n_buf;
+
+  MPI_Type_contiguous(n_buf, MPI_DOUBLE, &buf_type);
+  MPI_Type_commit(&buf_type);
+  MPI_Op_create(&monitor_reduce, 1, &buf_op);
+
+#endif
+}
+
+// compute the local monitoring quantities and start their reduction
+
+void monitor::start(int in_file_num, struct solution* FlowSol)
+{
+  int i, n = 0;
+
+  if (pending)
+    FatalError("The previous monitoring reduction has not been finished");
+
+  // Forces on this rank's walls (writes the cp files of this step)
+  CalcForces(in_file_num, FlowSol);
+
+  for (i=0; i<n_dims; i++) buf(n++) = FlowSol->inv_force(i);
+  for (i=0; i<n_dims; i++) buf(n++) = FlowSol->vis_force(i);
+  buf(n++) = FlowSol->coeff_lift;
+  buf(n++) = FlowSol->coeff_drag;
+
+  // Integral quantities of this rank's elements
+  CalcIntegralQuantities(in_file_num, FlowSol);
+
+  for (i=0; i<n_integral_quantities; i++) buf(n++) = FlowSol->integral_quantities(i);
+
+  // Number of solution points, then the residual sums (or maxima)
+  buf(n) = CalcResidualSums(buf.get_ptr_cpu(n+1), FlowSol);
+
+  file_num = in_file_num;
+  time = FlowSol->time;
+  pending = true;
+
+#ifdef _MPI
+
+  MPI_Iallreduce(buf.get_ptr_cpu(), buf_global.get_ptr_cpu(), 1, buf_type, buf_op, MPI_COMM_WORLD, &request);
+
+#else
+
+  for (i=0; i<buf.get_dim(0); i++) buf_global(i) = buf(i);
+
+#endif
+}
+
+// complete the pending reduction and write the convergence history
+
+void monitor::finish(clock_t init, ofstream* write_hist, struct solution* FlowSol)
+{
+  int i, n = 0;
+
+  if (!pending)
+    return;
+
+#ifdef _MPI
+
+  MPI_Wait(&request, MPI_STATUS_IGNORE);
+
+#endif
+
+  pending = false;
+
+  for (i=0; i<n_dims; i++) FlowSol->inv_force(i) = buf_global(n++);
+  for (i=0; i<n_dims; i++) FlowSol->vis_force(i) = buf_global(n++);
+  FlowSol->coeff_lift = buf_global(n++);
+  FlowSol->coeff_drag = buf_global(n++);
+
+  for (i=0; i<n_integral_quantities; i++) FlowSol->integral_quantities(i) = buf_global(n++);
+
+  CalcNormResidual(buf_global.get_ptr_cpu(n+1), buf_global(n), FlowSol);
+
+  // Calculate body forcing, if running periodic channel, from the total viscous force
+  if(run_input.equation==0 and run_input.forcing==1 and n_dims==3) {
+    for(i=0; i<FlowSol->n_ele_types; i++)
+      FlowSol->mesh_eles(i)->calc_body_force_upts(FlowSol->vis_force, FlowSol->body_force);
+  }
+
+  HistoryOutput(file_num, time, init, write_hist, FlowSol);
+
+  if (FlowSol->rank == 0) cout << endl;
+}
+
+// get whether a reduction is pending
+
+bool monitor::get_pending(void)
+{
+  return pending;
+}
+
+// get whether the reduction may overlap with the following step
+
+bool monitor::get_overlap(void)
+{
+  return overlap;
+}
@@ -177,6 +177,10 @@ void mpi_inters::set_mpi(int in_inter, int in_ele_type_l, int in_ele_l, int in_l
   int i,j,k;
   int i_rhs,j_rhs;
 
+      ele_type_l(in_inter) = in_ele_type_l;
+      ele_l(in_inter) = in_ele_l;
+      local_inter_l(in_inter) = in_local_inter_l;
+
       get_lut(rot_tag);
 
       for(j=0;j<n_fpts_per_inter;j++)
@@ -237,6 +241,43 @@ void mpi_inters::set_mpi(int in_inter, int in_ele_type_l, int in_ele_l, int in_l
 }
 
 
+// exchange the multi-rate levels across the partition boundaries; the faces themselves are evaluated at every substep
+
+void mpi_inters::set_lts_levels(struct solution* FlowSol)
+{
+  int i;
+
+  if (n_inters==0)
+    return;
+
+  array<int> level_out(n_inters), level_in(n_inters);
+
+  for (i=0;i<n_inters;i++)
+    level_out(i) = FlowSol->mesh_eles(ele_type_l(i))->get_lts_level(ele_l(i));
+
+#ifdef _MPI
+  int sk = 0;
+  int request_count = 0;
+  for (int p=0;p<nproc;p++) {
+      if (Nout_proc(p)) {
+          MPI_Isend(level_out.get_ptr_cpu(sk),Nout_proc(p),MPI_INT,p,inters_type*10000+p   ,MPI_COMM_WORLD,&mpi_out_requests[request_count]);
+          MPI_Irecv(level_in.get_ptr_cpu(sk),Nout_proc(p),MPI_INT,p,inters_type*10000+rank,MPI_COMM_WORLD,&mpi_in_requests[request_count]);
+          sk+=Nout_proc(p);
+          request_count++;
+        }
+    }
+
+  MPI_Waitall(request_count,mpi_in_requests,MPI_STATUSES_IGNORE);
+  MPI_Waitall(request_count,mpi_out_requests,MPI_STATUSES_IGNORE);
+#else
+  for (i=0;i<n_inters;i++)
+    level_in(i) = level_out(i);
+#endif
+
+  for (i=0;i<n_inters;i++)
+    FlowSol->mesh_eles(ele_type_l(i))->set_lts_nb_level(ele_l(i),local_inter_l(i),level_in(i));
+}
+
 void mpi_inters::send_solution()
 {
 
@@ -0,0 +1,306 @@
+/*!
+ * \file multigrid.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cmath>
+
+#if defined _ACCELERATE_BLAS
+#include <Accelerate/Accelerate.h>
+#endif
+
+#if defined _MKL_BLAS
+#include "mkl.h"
+#include "mkl_spblas.h"
+#endif
+
+#if defined _STANDARD_BLAS
+extern "C"
+{
+#include "cblas.h"
+}
+#endif
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/multigrid.h"
+#include "../include/geometry.h"
+#include "../include/solver.h"
+#include "../include/error.h"
+
+using namespace std;
+
+// #### constructors ####
+
+// default constructor
+
+p_multigrid::p_multigrid()
+{
+  n_levels = 0;
+}
+
+// default destructor
+
+p_multigrid::~p_multigrid()
+{
+  for (int l=1;l<n_levels;l++)
+    delete level_sol(l);
+}
+
+// #### methods ####
+
+// build the coarse levels
+
+void p_multigrid::setup(struct solution* FlowSol)
+{
+#ifdef _GPU
+  FatalError("p-multigrid is only implemented on the CPU");
+#endif
+
+  int i, j, l, ic;
+  int order = run_input.order;
+  double c_tri = run_input.c_tri;
+
+  if (FlowSol->adv_type != 0 && FlowSol->adv_type != 3)
+    FatalError("p-multigrid smooths with the explicit RK schemes, use adv_type 0 or 3");
+
+  if (run_input.mg_min_order < 0 || run_input.mg_min_order >= order)
+    FatalError("mg_min_order must be at least 0 and lower than order");
+
+  n_levels = order-run_input.mg_min_order+1;
+  n_ele_types = FlowSol->n_ele_types;
+  n_rk_steps = FlowSol->rk.get_n_stages();
+
+  level_sol.setup(n_levels);
+  level_sol(0) = FlowSol;
+
+  // Each coarse level repeats the preprocessing at its order, so it gets its own elements,
+  // interfaces and MPI buffers, while the mesh and partition are the same as on the fine level
+  for (l=1;l<n_levels;l++)
+    {
+      run_input.order = order-l;
+      if (FlowSol->rank==0) cout << endl << "p-multigrid: setting up level " << l << ", order " << run_input.order << endl;
+
+      level_sol(l) = new solution;
+      SetInput(level_sol(l));
+      GeoPreprocess(level_sol(l));
+
+      for (i=0;i<n_ele_types;i++) {
+          int n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+          if (level_sol(l)->mesh_eles(i)->get_n_eles() != n_eles)
+            FatalError("p-multigrid level was partitioned differently from the fine level");
+
+          for (ic=0;ic<n_eles;ic++)
+            if (level_sol(l)->mesh_eles(i)->get_ele2global_ele(ic) != FlowSol->mesh_eles(i)->get_ele2global_ele(ic))
+              FatalError("p-multigrid level was partitioned differently from the fine level");
+
+          // The initial condition is overwritten by the first restriction, but also sets the element reference lengths
+          if (n_eles != 0) {
+              level_sol(l)->mesh_eles(i)->set_ics(FlowSol->time);
+              level_sol(l)->mesh_eles(i)->set_disu_upts_to_zero_other_levels();
+            }
+        }
+
+      level_sol(l)->time = FlowSol->time;
+      level_sol(l)->ini_iter = FlowSol->ini_iter;
+    }
+
+  // Restore the fine level inputs changed by the coarse preprocessing
+  run_input.order = order;
+  run_input.c_tri = c_tri;
+
+  opp_restrict.setup(n_levels,n_ele_types);
+  opp_prolong.setup(n_levels,n_ele_types);
+  forcing.setup(n_levels,n_ele_types);
+  u_restricted.setup(n_levels,n_ele_types);
+  rhs.setup(n_levels,n_ele_types);
+
+  for (l=0;l<n_levels;l++)
+    for (i=0;i<n_ele_types;i++)
+      {
+        eles* ele = level_sol(l)->mesh_eles(i);
+        if (ele->get_n_eles() == 0)
+          continue;
+
+        int n_dofs = ele->get_n_upts_per_ele()*ele->get_n_eles()*ele->get_n_fields();
+
+        rhs(l,i).setup(n_dofs);
+        rhs(l,i).set_tag("pmg/state");
+
+        if (l > 0) {
+            eles* finer = level_sol(l-1)->mesh_eles(i);
+
+            ele->set_opp_mg(finer,opp_restrict(l,i));
+            finer->set_opp_mg(ele,opp_prolong(l,i));
+            opp_restrict(l,i).set_tag("pmg/operators");
+            opp_prolong(l,i).set_tag("pmg/operators");
+
+            forcing(l,i).setup(n_dofs);
+            u_restricted(l,i).setup(n_dofs);
+            forcing(l,i).set_tag("pmg/state");
+            u_restricted(l,i).set_tag("pmg/state");
+            for (j=0;j<n_dofs;j++)
+              forcing(l,i)(j) = 0.;
+          }
+      }
+
+  if (FlowSol->rank==0) cout << endl << "p-multigrid: " << n_levels << " levels, orders " << order << " to " << run_input.mg_min_order << endl;
+}
+
+// one V-cycle
+
+void p_multigrid::cycle(struct solution* FlowSol)
+{
+  v_cycle(0);
+
+  for (int l=1;l<n_levels;l++)
+    level_sol(l)->time = FlowSol->time;
+}
+
+// FAS V-cycle: the coarse level solves R_c(u_c) + f_c = 0 with f_c = I R(u) - R_c(I u), starting from u_c = I u
+
+void p_multigrid::v_cycle(int in_level)
+{
+  int i, j, n_dofs, n_cols;
+  struct solution* sol = level_sol(in_level);
+  struct solution* coarse;
+
+  if (in_level == n_levels-1) {
+      smooth(in_level,run_input.mg_n_coarse_smooth);
+      return;
+    }
+
+  smooth(in_level,run_input.mg_n_pre_smooth);
+
+  // Time derivative on this level, then the coarse solution and forcing
+  calc_residual(in_level,1);
+  for (i=0;i<n_ele_types;i++)
+    if (sol->mesh_eles(i)->get_n_eles() != 0)
+      sol->mesh_eles(i)->calc_rhs_upts(rhs(in_level,i).get_ptr_cpu());
+
+  coarse = level_sol(in_level+1);
+  for (i=0;i<n_ele_types;i++)
+    if (sol->mesh_eles(i)->get_n_eles() != 0) {
+        n_cols = sol->mesh_eles(i)->get_n_eles()*sol->mesh_eles(i)->get_n_fields();
+        n_dofs = u_restricted(in_level+1,i).get_dim(0);
+
+        transfer(opp_restrict(in_level+1,i),sol->mesh_eles(i)->get_disu_upts_ptr_cpu(),coarse->mesh_eles(i)->get_disu_upts_ptr_cpu(),n_cols,1.0,0.0);
+
+        double* u_c = coarse->mesh_eles(i)->get_disu_upts_ptr_cpu();
+        for (j=0;j<n_dofs;j++)
+          u_restricted(in_level+1,i)(j) = u_c[j];
+      }
+
+  calc_residual(in_level+1,0);
+  for (i=0;i<n_ele_types;i++)
+    if (coarse->mesh_eles(i)->get_n_eles() != 0) {
+        n_cols = coarse->mesh_eles(i)->get_n_eles()*coarse->mesh_eles(i)->get_n_fields();
+
+        coarse->mesh_eles(i)->calc_rhs_upts(forcing(in_level+1,i).get_ptr_cpu());
+        transfer(opp_restrict(in_level+1,i),rhs(in_level,i).get_ptr_cpu(),forcing(in_level+1,i).get_ptr_cpu(),n_cols,1.0,-1.0);
+      }
+
+  v_cycle(in_level+1);
+
+  // Prolongate the coarse correction u_c - I u
+  for (i=0;i<n_ele_types;i++)
+    if (sol->mesh_eles(i)->get_n_eles() != 0) {
+        n_cols = sol->mesh_eles(i)->get_n_eles()*sol->mesh_eles(i)->get_n_fields();
+        n_dofs = u_restricted(in_level+1,i).get_dim(0);
+
+        double* u_c = coarse->mesh_eles(i)->get_disu_upts_ptr_cpu();
+        for (j=0;j<n_dofs;j++)
+          u_restricted(in_level+1,i)(j) = u_c[j]-u_restricted(in_level+1,i)(j);
+
+        transfer(opp_prolong(in_level+1,i),u_restricted(in_level+1,i).get_ptr_cpu(),sol->mesh_eles(i)->get_disu_upts_ptr_cpu(),n_cols,1.0,1.0);
+      }
+
+  smooth(in_level,run_input.mg_n_post_smooth);
+}
+
+// RK steps on one level
+
+void p_multigrid::smooth(int in_level, int in_n_steps)
+{
+  int i, j, n;
+  struct solution* sol = level_sol(in_level);
+
+  for (n=0;n<in_n_steps;n++)
+    {
+      CalcTimeStep(sol);
+
+      for (i=0;i<n_rk_steps;i++)
+        {
+          calc_residual(in_level,1);
+
+          for (j=0;j<n_ele_types;j++)
+            if (sol->mesh_eles(j)->get_n_eles() != 0)
+              sol->mesh_eles(j)->AdvanceSolution(i,sol->adv_type);
+        }
+    }
+}
+
+// time derivative on one level, with the physical time derivative of dual time stepping and optionally the FAS forcing
+
+void p_multigrid::calc_residual(int in_level, int in_add_forcing)
+{
+  struct solution* sol = level_sol(in_level);
+
+  CalcResidual(sol);
+
+  for (int j=0;j<n_ele_types;j++)
+    if (sol->mesh_eles(j)->get_n_eles() != 0) {
+        if (run_input.dual_time)
+          sol->mesh_eles(j)->add_dual_time_source();
+        if (in_add_forcing && in_level > 0)
+          sol->mesh_eles(j)->add_forcing_upts(forcing(in_level,j).get_ptr_cpu());
+      }
+}
+
+// coefficient of the implicit physical time derivative on every level; the explicit part is left to the FAS forcing
+
+void p_multigrid::set_dual_time_coeff(double in_coeff)
+{
+  for (int l=0;l<n_levels;l++)
+    for (int j=0;j<n_ele_types;j++)
+      if (level_sol(l)->mesh_eles(j)->get_n_eles() != 0)
+        level_sol(l)->mesh_eles(j)->set_dual_time_coeff(in_coeff);
+}
+
+// apply a transfer operator to every element and field; the solution layout (n_upts_per_ele, n_eles, n_fields)
+// is a column-major matrix with n_eles*n_fields columns
+
+void p_multigrid::transfer(array<double>& in_opp, double* in_from, double* out_to, int in_n_cols, double in_alpha, double in_beta)
+{
+  int Arows = in_opp.get_dim(0);
+  int Acols = in_opp.get_dim(1);
+
+#if defined _ACCELERATE_BLAS || defined _MKL_BLAS || defined _STANDARD_BLAS
+  cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,Arows,in_n_cols,Acols,in_alpha,in_opp.get_ptr_cpu(),Arows,in_from,Acols,in_beta,out_to,Arows);
+
+#elif defined _NO_BLAS
+  dgemm(Arows,in_n_cols,Acols,in_alpha,in_beta,in_opp.get_ptr_cpu(),in_from,out_to);
+
+#endif
+}
@@ -0,0 +1,265 @@
+/*!
+ * \file multirate.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cmath>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/multirate.h"
+#include "../include/solver.h"
+#include "../include/error.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+// #### constructors ####
+
+// default constructor
+
+multirate::multirate()
+{
+  n_ele_types = 0;
+  n_levels = 1;
+  n_rk_steps = 1;
+}
+
+// default destructor
+
+multirate::~multirate() { }
+
+// #### methods ####
+
+// bin the elements and set up the coupling between levels
+
+void multirate::setup(struct solution* FlowSol)
+{
+#ifdef _GPU
+  FatalError("Multi-rate time stepping is only implemented on the CPU");
+#endif
+
+  int i, ic, n_eles, level, max_level = 0;
+  double dt_min = 1e12;
+
+  if (FlowSol->adv_type != 0 && FlowSol->adv_type != 3)
+    FatalError("Multi-rate time stepping advances the explicit RK schemes, use adv_type 0 or 3");
+
+  if (run_input.p_multigrid || run_input.dual_time)
+    FatalError("Multi-rate time stepping cannot be combined with p_multigrid or dual_time");
+
+  if (run_input.LES || run_input.wall_model)
+    FatalError("Multi-rate time stepping is not implemented for LES or wall models");
+
+  if (run_input.lts_n_levels < 1)
+    FatalError("lts_n_levels must be at least 1");
+
+  n_ele_types = FlowSol->n_ele_types;
+  n_rk_steps = FlowSol->rk.get_n_stages();
+
+  // Weight of each stage's time derivative in the complete step, for the flux registers
+  rk_weight.setup(n_rk_steps);
+  for (i=0;i<n_rk_steps;i++)
+    rk_weight(i) = FlowSol->rk.get_weight(i);
+
+  // Smallest local time step of the initial solution
+  for (i=0;i<n_ele_types;i++)
+    for (ic=0;ic<FlowSol->mesh_eles(i)->get_n_eles();ic++)
+      dt_min = min(dt_min,FlowSol->mesh_eles(i)->calc_dt_local(ic));
+
+#ifdef _MPI
+  double dt_min_global;
+  MPI_Allreduce(&dt_min,&dt_min_global,1,MPI_DOUBLE,MPI_MIN,MPI_COMM_WORLD);
+  dt_min = dt_min_global;
+#endif
+
+  // Level of each element from its local time step. The elements of each type are numbered by size, and a level
+  // that decreases along them is lowered to keep the levels non-decreasing, so the active elements form a prefix
+  for (i=0;i<n_ele_types;i++) {
+      n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+      array<int> ele_level(max(n_eles,1));
+
+      for (ic=0;ic<n_eles;ic++) {
+          level = (int) floor(log(FlowSol->mesh_eles(i)->calc_dt_local(ic)/dt_min)/log(2.)+1e-12);
+          ele_level(ic) = max(0,min(level,run_input.lts_n_levels-1));
+        }
+
+      for (ic=n_eles-2;ic>=0;ic--)
+        ele_level(ic) = min(ele_level(ic),ele_level(ic+1));
+
+      for (ic=0;ic<n_eles;ic++) {
+          FlowSol->mesh_eles(i)->set_lts_level(ic,ele_level(ic));
+          max_level = max(max_level,ele_level(ic));
+        }
+    }
+
+#ifdef _MPI
+  int max_level_global;
+  MPI_Allreduce(&max_level,&max_level_global,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+  max_level = max_level_global;
+#endif
+
+  n_levels = max_level+1;
+
+  // Levels of the faces, and of the neighbours of each element
+  for (i=0;i<FlowSol->n_int_inter_types;i++) {
+      FlowSol->mesh_int_inters(i).set_lts_levels(FlowSol);
+      FlowSol->mesh_int_inters(i).setup_lts(n_levels);
+    }
+
+  for (i=0;i<FlowSol->n_bdy_inter_types;i++) {
+      FlowSol->mesh_bdy_inters(i).set_lts_levels(FlowSol);
+      FlowSol->mesh_bdy_inters(i).setup_lts(n_levels);
+    }
+
+#ifdef _MPI
+  if (FlowSol->nproc>1)
+    for (i=0;i<FlowSol->n_mpi_inter_types;i++)
+      FlowSol->mesh_mpi_inters(i).set_lts_levels(FlowSol);
+#endif
+
+  for (i=0;i<n_ele_types;i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      FlowSol->mesh_eles(i)->setup_lts(n_levels);
+
+  // Report the number of elements of each level
+  array<int> n_eles_level(n_levels);
+  n_eles_level.initialize_to_zero();
+
+  for (i=0;i<n_ele_types;i++)
+    for (ic=0;ic<FlowSol->mesh_eles(i)->get_n_eles();ic++)
+      n_eles_level(FlowSol->mesh_eles(i)->get_lts_level(ic))++;
+
+#ifdef _MPI
+  array<int> n_eles_level_global(n_levels);
+  MPI_Allreduce(n_eles_level.get_ptr_cpu(),n_eles_level_global.get_ptr_cpu(),n_levels,MPI_INT,MPI_SUM,MPI_COMM_WORLD);
+  n_eles_level = n_eles_level_global;
+#endif
+
+  if (FlowSol->rank == 0) {
+      cout << "Multi-rate time stepping with " << n_levels << " levels:" << endl;
+      for (i=0;i<n_levels;i++)
+        cout << "  level " << i << " (step " << (1 << i) << "*dt_base): " << n_eles_level(i) << " elements" << endl;
+    }
+}
+
+// one macro step
+
+double multirate::advance(struct solution* FlowSol)
+{
+  int i, k, s, max_level, end_level;
+  int n_substeps = 1 << (n_levels-1);
+  double dt_base = calc_dt_base(FlowSol);
+
+  for (i=0;i<n_ele_types;i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      FlowSol->mesh_eles(i)->set_lts_dt(dt_base);
+
+  for (k=0;k<n_substeps;k++)
+    {
+      // Levels whose step starts at this substep, and levels whose step ends with it
+      max_level = 0;
+      while (max_level+1 < n_levels && k%(1 << (max_level+1)) == 0)
+        max_level++;
+
+      end_level = 0;
+      while (end_level+1 < n_levels && (k+1)%(1 << (end_level+1)) == 0)
+        end_level++;
+
+      set_active(FlowSol, max_level);
+
+      for (s=0;s<n_rk_steps;s++)
+        {
+          for (i=0;i<n_ele_types;i++)
+            if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+              FlowSol->mesh_eles(i)->set_lts_stage(max_level, dt_base, rk_weight(s));
+
+          CalcResidual(FlowSol);
+
+          for (i=0;i<n_ele_types;i++)
+            FlowSol->mesh_eles(i)->AdvanceSolution(s, FlowSol->adv_type);
+        }
+
+      FlowSol->time += dt_base;
+
+      // Correct the levels whose step is complete with their flux registers, and bring the solution at the flux
+      // points of everything just updated up to date, for the neighbours that keep advancing
+      set_active(FlowSol, max(max_level,end_level));
+
+      for (i=0;i<n_ele_types;i++)
+        if (FlowSol->mesh_eles(i)->get_n_eles() != 0) {
+            FlowSol->mesh_eles(i)->apply_lts_flux_reg(end_level);
+            FlowSol->mesh_eles(i)->extrapolate_solution(0);
+          }
+    }
+
+  // Leave all elements and faces active for the monitoring and output
+  set_active(FlowSol, -1);
+
+  for (i=0;i<n_ele_types;i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      FlowSol->mesh_eles(i)->set_lts_stage(-1, 0., 0.);
+
+  return n_substeps*dt_base;
+}
+
+// restrict the elements and faces to the active levels
+
+void multirate::set_active(struct solution* FlowSol, int in_max_level)
+{
+  int i;
+
+  for (i=0;i<n_ele_types;i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      FlowSol->mesh_eles(i)->set_lts_active(in_max_level);
+
+  for (i=0;i<FlowSol->n_int_inter_types;i++)
+    FlowSol->mesh_int_inters(i).set_lts_active(in_max_level);
+
+  for (i=0;i<FlowSol->n_bdy_inter_types;i++)
+    FlowSol->mesh_bdy_inters(i).set_lts_active(in_max_level);
+}
+
+// base step: the smallest local time step of an element over its level's multiple of it
+
+double multirate::calc_dt_base(struct solution* FlowSol)
+{
+  int i, ic;
+  double dt_base = 1e12;
+
+  for (i=0;i<n_ele_types;i++)
+    for (ic=0;ic<FlowSol->mesh_eles(i)->get_n_eles();ic++)
+      dt_base = min(dt_base,FlowSol->mesh_eles(i)->calc_dt_local(ic)/(1 << FlowSol->mesh_eles(i)->get_lts_level(ic)));
+
+#ifdef _MPI
+  double dt_base_global;
+  MPI_Allreduce(&dt_base,&dt_base_global,1,MPI_DOUBLE,MPI_MIN,MPI_COMM_WORLD);
+  dt_base = dt_base_global;
+#endif
+
+  return dt_base;
+}
@@ -26,6 +26,9 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <climits>
+#include <cstring>
+#include <algorithm>
 
 // Used for making sub-directories
 #include <sys/types.h>
@@ -41,6 +44,8 @@
 #include "../include/funcs.h"
 #include "../include/error.h"
 #include "../include/solution.h"
+#include "../include/mem_tracker.h"
+#include "../include/compression.h"
 
 #ifdef _TECIO
 #include "TECIO.h"
@@ -63,38 +68,327 @@ using namespace std;
 #define MAX_E_PER_C 12
 #define MAX_V_PER_C 27
 
-// method to write out a tecplot file
-void write_tec(int in_file_num, struct solution* FlowSol)
+// number of elements interpolated to the plot points at once
+#define PLOT_BLOCK_ELES 512
+
+// corner vertices (1-based) of the plot sub-elements of the elements of one type, in Tecplot order
+
+void calc_tec_connectivity(eles* in_eles, array<int>& out_conn)
 {
-  int i,j,k,l,m;
+  int j,k,l;
+  int n_cells = 0;
+  int* cell;
 
   int vertex_0, vertex_1, vertex_2, vertex_3, vertex_4, vertex_5, vertex_6, vertex_7;
 
-  int p_res=run_input.p_res; // HACK
+  int p_res=run_input.p_res;
+  int ele_type = in_eles->get_ele_type();
+  int n_eles = in_eles->get_n_eles();
+
+  // Prisms are written as degenerate bricks
+  if(ele_type==0)
+    out_conn.setup(3,n_eles*in_eles->get_n_peles_per_ele());
+  else if(ele_type==1 || ele_type==2)
+    out_conn.setup(4,n_eles*in_eles->get_n_peles_per_ele());
+  else
+    out_conn.setup(8,n_eles*in_eles->get_n_peles_per_ele());
+
+  if(ele_type==0) // tri
+    {
+      for (j=0;j<n_eles;j++)
+        {
+          for(k=0;k<p_res-1;k++) // look to right from each point
+            {
+              for(l=0;l<p_res-k-1;l++)
+                {
+                  vertex_0=l+(k*(p_res+1))-((k*(k+1))/2);
+                  vertex_1=vertex_0+1;
+                  vertex_2=l+((k+1)*(p_res+1))-(((k+1)*(k+2))/2);
+                  vertex_0+=j*(p_res*(p_res+1)/2);
+                  vertex_1+=j*(p_res*(p_res+1)/2);
+                  vertex_2+=j*(p_res*(p_res+1)/2);
+
+                  cell = out_conn.get_ptr_cpu(0,n_cells++);
+                  cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1;
+                }
+            }
+
+          for(k=0;k<p_res-2;k++) //  look to left from each point
+            {
+              for(l=1;l<p_res-k-1;l++)
+                {
+                  vertex_0=l+(k*(p_res+1))-((k*(k+1))/2);
+                  vertex_1=l+((k+1)*(p_res+1))-(((k+1)*(k+2))/2);
+                  vertex_2=l-1+((k+1)*(p_res+1))-(((k+1)*(k+2))/2);
+
+                  vertex_0+=j*(p_res*(p_res+1)/2);
+                  vertex_1+=j*(p_res*(p_res+1)/2);
+                  vertex_2+=j*(p_res*(p_res+1)/2);
+
+                  cell = out_conn.get_ptr_cpu(0,n_cells++);
+                  cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1;
+                }
+            }
+        }
+
+    }
+  else if(ele_type==1) // quad
+    {
+      for (j=0;j<n_eles;j++)
+        {
+          for(k=0;k<p_res-1;k++)
+            {
+              for(l=0;l<p_res-1;l++)
+                {
+                  vertex_0=l+(p_res*k);
+                  vertex_1=vertex_0+1;
+                  vertex_2=vertex_0+p_res+1;
+                  vertex_3=vertex_0+p_res;
+
+                  vertex_0 += j*p_res*p_res;
+                  vertex_1 += j*p_res*p_res;
+                  vertex_2 += j*p_res*p_res;
+                  vertex_3 += j*p_res*p_res;
+
+                  cell = out_conn.get_ptr_cpu(0,n_cells++);
+                  cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1; cell[3] = vertex_3+1;
+                }
+            }
+        }
+    }
+  else if (ele_type==2) // tet
+    {
+      int temp = (p_res)*(p_res+1)*(p_res+2)/6;
+
+      for (int m=0;m<n_eles;m++)
+        {
+
+          for(int k=0;k<p_res-1;k++)
+            {
+              for(int j=0;j<p_res-1-k;j++)
+                {
+                  for(int i=0;i<p_res-1-k-j;i++)
+                    {
+
+                      vertex_0 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + j*(p_res-k) - (j-1)*j/2 + i;
+
+                      vertex_1 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + j*(p_res-k) - (j-1)*j/2 + i + 1;
+
+                      vertex_2 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + (j+1)*(p_res-k) - (j)*(j+1)/2 + i;
+
+                      vertex_3 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + j*(p_res-(k+1)) - (j-1)*j/2 + i;
+
+                      vertex_0+=m*temp;
+                      vertex_1+=m*temp;
+                      vertex_2+=m*temp;
+                      vertex_3+=m*temp;
+
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1; cell[3] = vertex_3+1;
+
+                    }
+                }
+            }
+
+          for(int k=0;k<p_res-2;k++)
+            {
+              for(int j=0;j<p_res-2-k;j++)
+                {
+                  for(int i=0;i<p_res-2-k-j;i++)
+                    {
+
+                      vertex_0 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + j*(p_res-k) - (j-1)*j/2 + i + 1;
+
+                      vertex_1 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + (j+1)*(p_res-k) - (j)*(j+1)/2 + i + 1;
+                      vertex_2 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + j*(p_res-(k+1)) - (j-1)*j/2 + i + 1;
+                      vertex_3 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j+1)*(p_res-(k+1)) - (j)*(j+1)/2 + (i-1) + 1;
+                      vertex_4 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j)*(p_res-(k+1)) - (j-1)*(j)/2 + (i-1) + 1;
+                      vertex_5 = temp - (p_res-(k))*(p_res+1-(k))*(p_res+2-(k))/6 + (j+1)*(p_res-(k)) - (j)*(j+1)/2 + (i-1) + 1;
+
+                      vertex_0+=m*temp;
+                      vertex_1+=m*temp;
+                      vertex_2+=m*temp;
+                      vertex_3+=m*temp;
+                      vertex_4+=m*temp;
+                      vertex_5+=m*temp;
+
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1; cell[3] = vertex_5+1;
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_0+1; cell[1] = vertex_2+1; cell[2] = vertex_4+1; cell[3] = vertex_5+1;
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_2+1; cell[1] = vertex_3+1; cell[2] = vertex_4+1; cell[3] = vertex_5+1;
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_1+1; cell[1] = vertex_2+1; cell[2] = vertex_3+1; cell[3] = vertex_5+1;
+                    }
+                }
+            }
+
+          for(int k=0;k<p_res-3;k++)
+            {
+              for(int j=0;j<p_res-3-k;j++)
+                {
+                  for(int i=0;i<p_res-3-k-j;i++)
+                    {
+
+                      vertex_0 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + (j+1)*(p_res-k) - (j)*(j+1)/2 + i + 1;
+                      vertex_1 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j)*(p_res-(k+1)) - (j-1)*(j)/2 + i + 1;
+                      vertex_2 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j+1)*(p_res-(k+1)) - (j)*(j+1)/2 + i ;
+                      vertex_3 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j+1)*(p_res-(k+1)) - (j)*(j+1)/2 + i + 1;
+
+                      vertex_0+=m*temp;
+                      vertex_1+=m*temp;
+                      vertex_2+=m*temp;
+                      vertex_3+=m*temp;
+
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1; cell[3] = vertex_3+1;
+                    }
+                }
+            }
+        }
+
+    }
+  else if (ele_type==3) // prisms
+    {
+      int temp = (p_res)*(p_res+1)/2;
+
+      for (int m=0;m<n_eles;m++)
+        {
+
+          for (int l=0;l<p_res-1;l++)
+            {
+              for(int j=0;j<p_res-1;j++) // look to right from each point
+                {
+                  for(int k=0;k<p_res-j-1;k++)
+                    {
+                      vertex_0=k+(j*(p_res+1))-((j*(j+1))/2) + l*temp;
+                      vertex_1=vertex_0+1;
+                      vertex_2=k+((j+1)*(p_res+1))-(((j+1)*(j+2))/2) + l*temp;
+
+                      vertex_3 = vertex_0 + temp;
+                      vertex_4 = vertex_1 + temp;
+                      vertex_5 = vertex_2 + temp;
+
+                      vertex_0+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_1+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_2+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_3+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_4+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_5+=m*(p_res*(p_res+1)/2*p_res);
+
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1; cell[3] = vertex_2+1; cell[4] = vertex_3+1; cell[5] = vertex_4+1; cell[6] = vertex_5+1; cell[7] = vertex_5+1;
+                    }
+                }
+            }
+
+          for (int l=0;l<p_res-1;l++)
+            {
+              for(int j=0;j<p_res-2;j++) //  look to left from each point
+                {
+                  for(int k=1;k<p_res-j-1;k++)
+                    {
+                      vertex_0=k+(j*(p_res+1))-((j*(j+1))/2) + l*temp;
+                      vertex_1=k+((j+1)*(p_res+1))-(((j+1)*(j+2))/2) + l*temp;
+                      vertex_2=k-1+((j+1)*(p_res+1))-(((j+1)*(j+2))/2) + l*temp;
+
+                      vertex_3 = vertex_0 + temp;
+                      vertex_4 = vertex_1 + temp;
+                      vertex_5 = vertex_2 + temp;
+
+                      vertex_0+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_1+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_2+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_3+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_4+=m*(p_res*(p_res+1)/2*p_res);
+                      vertex_5+=m*(p_res*(p_res+1)/2*p_res);
+
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1; cell[3] = vertex_2+1; cell[4] = vertex_3+1; cell[5] = vertex_4+1; cell[6] = vertex_5+1; cell[7] = vertex_5+1;
+                    }
+                }
+            }
+        }
+    }
+  else if(ele_type==4) // hexa
+    {
+      for (int j=0;j<n_eles;j++)
+        {
+          for(int k=0;k<p_res-1;k++)
+            {
+              for(int l=0;l<p_res-1;l++)
+                {
+                  for(int m=0;m<p_res-1;m++)
+                    {
+                      vertex_0=m+(p_res*l)+(p_res*p_res*k);
+                      vertex_1=vertex_0+1;
+                      vertex_2=vertex_0+p_res+1;
+                      vertex_3=vertex_0+p_res;
+
+                      vertex_4=vertex_0+p_res*p_res;
+                      vertex_5=vertex_4+1;
+                      vertex_6=vertex_4+p_res+1;
+                      vertex_7=vertex_4+p_res;
+
+                      vertex_0 += j*p_res*p_res*p_res;
+                      vertex_1 += j*p_res*p_res*p_res;
+                      vertex_2 += j*p_res*p_res*p_res;
+                      vertex_3 += j*p_res*p_res*p_res;
+                      vertex_4 += j*p_res*p_res*p_res;
+                      vertex_5 += j*p_res*p_res*p_res;
+                      vertex_6 += j*p_res*p_res*p_res;
+                      vertex_7 += j*p_res*p_res*p_res;
+
+                      cell = out_conn.get_ptr_cpu(0,n_cells++);
+                      cell[0] = vertex_0+1; cell[1] = vertex_1+1; cell[2] = vertex_2+1; cell[3] = vertex_3+1; cell[4] = vertex_4+1; cell[5] = vertex_5+1; cell[6] = vertex_6+1; cell[7] = vertex_7+1;
+                    }
+                }
+            }
+        }
+    }
+  else
+    {
+      FatalError("ERROR: Invalid element type ... ");
+    }
+}
+
+// method to write out a tecplot file
+void write_tec(int in_file_num, double in_time, struct solution* FlowSol)
+{
+  int i,j,k,l,m;
 
-  array<double> pos_ppts_temp;
   array<double> disu_ppts_temp;
   array<double> grad_disu_ppts_temp;
   array<double> diag_ppts_temp;
+  array<int> tec_conn;
   int n_ppts_per_ele;
   int n_dims = FlowSol->n_dims;
   int n_fields;
   int n_diag_fields;
   int num_pts, num_elements;
+  int n_eles, n_block, n_eles_block, j0, jb;
 
   char  file_name_s[50] ;
   char *file_name;
   string fields("");
 
-  ofstream write_tec;
+  // with mpiio_output the zones of each rank are formatted in memory and written to one shared file
+  ofstream tec_file;
+  ostringstream tec_text;
+  ostream& write_tec = run_input.mpiio_output ? (ostream&) tec_text : (ostream&) tec_file;
   write_tec.precision(15);
 
   // number of additional diagnostic fields
   n_diag_fields = run_input.n_diagnostic_fields;
 
 #ifdef _MPI
-  MPI_Barrier(MPI_COMM_WORLD);
-  sprintf(file_name_s,"Mesh_%.09d_p%.04d.plt",in_file_num,FlowSol->rank);
+  // No MPI calls from the background output writer, see output_writer
+  if (!run_input.async_output && !run_input.mpiio_output) MPI_Barrier(MPI_COMM_WORLD);
+  if (run_input.mpiio_output)
+    sprintf(file_name_s,"Mesh_%.09d.plt",in_file_num);
+  else
+    sprintf(file_name_s,"Mesh_%.09d_p%.04d.plt",in_file_num,FlowSol->rank);
   if (FlowSol->rank==0) cout << "Writing Tecplot file number " << in_file_num << " ...." << endl;
 #else
   sprintf(file_name_s,"Mesh_%.09d_p%.04d.plt",in_file_num,0);
@@ -102,10 +396,12 @@ void write_tec(int in_file_num, struct solution* FlowSol)
 #endif
 
   file_name = &file_name_s[0];
-  write_tec.open(file_name);
+  if (!run_input.mpiio_output)
+    tec_file.open(file_name);
 
-  // write header
-  write_tec << "Title = \"HiFiLES Solution\"" << endl;
+  // write header (only once in a shared file)
+  if (FlowSol->rank==0 || !run_input.mpiio_output)
+    write_tec << "Title = \"HiFiLES Solution\"" << endl;
 
   // string of field names
   if (run_input.equation==0)
@@ -151,7 +447,8 @@ void write_tec(int in_file_num, struct solution* FlowSol)
     }
 
   // write field names to file
-  write_tec << fields << endl;
+  if (FlowSol->rank==0 || !run_input.mpiio_output)
+    write_tec << fields << endl;
 
   int time_iter = 0;
 
@@ -164,9 +461,12 @@ void write_tec(int in_file_num, struct solution* FlowSol)
           num_pts = (FlowSol->mesh_eles(i)->get_n_eles())*n_ppts_per_ele;
           num_elements = (FlowSol->mesh_eles(i)->get_n_eles())*(FlowSol->mesh_eles(i)->get_n_peles_per_ele());
 
-          pos_ppts_temp.setup(n_ppts_per_ele,n_dims);
-          disu_ppts_temp.setup(n_ppts_per_ele,n_fields);
-          grad_disu_ppts_temp.setup(n_ppts_per_ele,n_fields,n_dims);
+          n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+          n_block = min(n_eles,PLOT_BLOCK_ELES);
+
+          disu_ppts_temp.setup(n_ppts_per_ele,n_block,n_fields);
+          if(n_diag_fields > 0)
+            grad_disu_ppts_temp.setup(n_ppts_per_ele,n_block,n_fields,n_dims);
           diag_ppts_temp.setup(n_ppts_per_ele,n_diag_fields);
 
           // write element specific header
@@ -197,316 +497,257 @@ void write_tec(int in_file_num, struct solution* FlowSol)
 
           if(time_iter == 0)
             {
-              write_tec <<"SolutionTime=" << FlowSol->time << endl;
+              write_tec <<"SolutionTime=" << in_time << endl;
               time_iter = 1;
             }
 
-          // write element specific data
+          // write element specific data, interpolated to the plot points a block of elements at a time
+
+          array<double>& pos_ppts = FlowSol->mesh_eles(i)->get_pos_ppts();
 
-          for(j=0;j<FlowSol->mesh_eles(i)->get_n_eles();j++)
+          for(j0=0;j0<n_eles;j0+=n_block)
             {
-              FlowSol->mesh_eles(i)->calc_pos_ppts(j,pos_ppts_temp);
-              FlowSol->mesh_eles(i)->calc_disu_ppts(j,disu_ppts_temp);
-              FlowSol->mesh_eles(i)->calc_grad_disu_ppts(j,grad_disu_ppts_temp);
+              n_eles_block = min(n_block,n_eles-j0);
 
-              /*! Calculate the diagnostic fields at the plot points */
-              if(n_diag_fields > 0)
+              // The last block may be shorter, and the plot point data is sized to the block
+              if(n_eles_block < n_block)
                 {
-                  FlowSol->mesh_eles(i)->calc_diagnostic_fields_ppts(j,disu_ppts_temp,grad_disu_ppts_temp,diag_ppts_temp);
+                  disu_ppts_temp.setup(n_ppts_per_ele,n_eles_block,n_fields);
+                  if(n_diag_fields > 0)
+                    grad_disu_ppts_temp.setup(n_ppts_per_ele,n_eles_block,n_fields,n_dims);
                 }
 
-              for(k=0;k<n_ppts_per_ele;k++)
+              FlowSol->mesh_eles(i)->calc_disu_ppts(j0,n_eles_block,disu_ppts_temp);
+              if(n_diag_fields > 0)
+                FlowSol->mesh_eles(i)->calc_grad_disu_ppts(j0,n_eles_block,grad_disu_ppts_temp);
+
+              for(jb=0;jb<n_eles_block;jb++)
                 {
-                  for(l=0;l<n_dims;l++)
+                  j = j0+jb;
+
+                  /*! Calculate the diagnostic fields at the plot points */
+                  if(n_diag_fields > 0)
                     {
-                      write_tec << pos_ppts_temp(k,l) << " ";
+                      FlowSol->mesh_eles(i)->calc_diagnostic_fields_ppts(jb,disu_ppts_temp,grad_disu_ppts_temp,diag_ppts_temp);
                     }
 
-                  for(l=0;l<n_fields;l++)
+                  for(k=0;k<n_ppts_per_ele;k++)
                     {
-                      if ( isnan(disu_ppts_temp(k,l))) {
-                          FatalError("Nan in tecplot file, exiting");
-                        }
-                      else {
-                          write_tec << disu_ppts_temp(k,l) << " ";
+                      for(l=0;l<n_dims;l++)
+                        {
+                          write_tec << pos_ppts(k,j,l) << " ";
                         }
-                    }
 
-                  /*! Write out optional diagnostic fields */
-                  for(l=0;l<n_diag_fields;l++)
-                    {
-                      if ( isnan(diag_ppts_temp(k,l))) {
-                          FatalError("Nan in tecplot file, exiting");
+                      for(l=0;l<n_fields;l++)
+                        {
+                          if ( isnan(disu_ppts_temp(k,jb,l))) {
+                              FatalError("Nan in tecplot file, exiting");
+                            }
+                          else {
+                              write_tec << disu_ppts_temp(k,jb,l) << " ";
+                            }
                         }
-                      else {
-                          write_tec << diag_ppts_temp(k,l) << " ";
+
+                      /*! Write out optional diagnostic fields */
+                      for(l=0;l<n_diag_fields;l++)
+                        {
+                          if ( isnan(diag_ppts_temp(k,l))) {
+                              FatalError("Nan in tecplot file, exiting");
+                            }
+                          else {
+                              write_tec << diag_ppts_temp(k,l) << " ";
+                            }
                         }
-                    }
 
-                  write_tec << endl;
+                      write_tec << endl;
+                    }
                 }
             }
 
           // write element specific connectivity
 
-          if(FlowSol->mesh_eles(i)->get_ele_type()==0) // tri
+          calc_tec_connectivity(FlowSol->mesh_eles(i),tec_conn);
+
+          for(j=0;j<num_elements;j++)
             {
-              for (j=0;j<FlowSol->mesh_eles(i)->get_n_eles();j++)
-                {
-                  for(k=0;k<p_res-1;k++) // look to right from each point
-                    {
-                      for(l=0;l<p_res-k-1;l++)
-                        {
-                          vertex_0=l+(k*(p_res+1))-((k*(k+1))/2);
-                          vertex_1=vertex_0+1;
-                          vertex_2=l+((k+1)*(p_res+1))-(((k+1)*(k+2))/2);
-                          vertex_0+=j*(p_res*(p_res+1)/2);
-                          vertex_1+=j*(p_res*(p_res+1)/2);
-                          vertex_2+=j*(p_res*(p_res+1)/2);
-
-                          write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1  << endl;
-                        }
-                    }
+              write_tec << tec_conn(0,j);
+              for(k=1;k<tec_conn.get_dim(0);k++)
+                write_tec << " " << tec_conn(k,j);
+              write_tec << endl;
+            }
+        }
+    }
 
-                  for(k=0;k<p_res-2;k++) //  look to left from each point
-                    {
-                      for(l=1;l<p_res-k-1;l++)
-                        {
-                          vertex_0=l+(k*(p_res+1))-((k*(k+1))/2);
-                          vertex_1=l+((k+1)*(p_res+1))-(((k+1)*(k+2))/2);
-                          vertex_2=l-1+((k+1)*(p_res+1))-(((k+1)*(k+2))/2);
+#ifdef _MPI
+  if (run_input.mpiio_output)
+    write_shared_file(file_name, tec_text.str(), FlowSol);
+  else
+    tec_file.close();
 
-                          vertex_0+=j*(p_res*(p_res+1)/2);
-                          vertex_1+=j*(p_res*(p_res+1)/2);
-                          vertex_2+=j*(p_res*(p_res+1)/2);
+  if (!run_input.async_output && !run_input.mpiio_output) MPI_Barrier(MPI_COMM_WORLD);
+  if (FlowSol->rank==0) cout << "Done writing Tecplot file number " << in_file_num << " ...." << endl;
+#else
+  tec_file.close();
 
-                          write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1  << endl;
-                        }
-                    }
-                }
+  cout << "Done writing Tecplot file number " << in_file_num << " ...." << endl;
+#endif
 
-            }
-          else if(FlowSol->mesh_eles(i)->get_ele_type()==1) // quad
-            {
-              for (j=0;j<FlowSol->mesh_eles(i)->get_n_eles();j++)
-                {
-                  for(k=0;k<p_res-1;k++)
-                    {
-                      for(l=0;l<p_res-1;l++)
-                        {
-                          vertex_0=l+(p_res*k);
-                          vertex_1=vertex_0+1;
-                          vertex_2=vertex_0+p_res+1;
-                          vertex_3=vertex_0+p_res;
+}
 
-                          vertex_0 += j*p_res*p_res;
-                          vertex_1 += j*p_res*p_res;
-                          vertex_2 += j*p_res*p_res;
-                          vertex_3 += j*p_res*p_res;
+// method to write out a Tecplot binary file through TecIO, one finite-element zone per element type of the rank
 
-                          write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1 << " " <<  vertex_3+1  << endl;
-                        }
-                    }
-                }
-            }
-          else if (FlowSol->mesh_eles(i)->get_ele_type()==2) // tet
-            {
-              int temp = (p_res)*(p_res+1)*(p_res+2)/6;
+void write_tec_bin(int in_file_num, double in_time, struct solution* FlowSol)
+{
+#ifdef _TECIO
+  int n_dims = FlowSol->n_dims;
+  int n_fields, n_diag_fields, n_ppts_per_ele;
+  int n_eles, n_block, n_eles_block, j0, jb, j;
+  char file_name_s[50], zone_title[50];
+  string variables;
 
-              for (int m=0;m<FlowSol->mesh_eles(i)->get_n_eles();m++)
-                {
+  array<double> disu_ppts_temp;
+  array<double> grad_disu_ppts_temp;
+  array<double> diag_ppts_temp;
+  array<double> values;
+  array<int> tec_conn;
 
-                  for(int k=0;k<p_res-1;k++)
-                    {
-                      for(int j=0;j<p_res-1-k;j++)
-                        {
-                          for(int i=0;i<p_res-1-k-j;i++)
-                            {
+  INTEGER4 file_type = 0, debug = 0, is_double = 1;
+  INTEGER4 zone_type, num_pts, num_elements, zero = 0, strand, is_block = 1;
 
-                              vertex_0 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + j*(p_res-k) - (j-1)*j/2 + i;
+  n_diag_fields = run_input.n_diagnostic_fields;
 
-                              vertex_1 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + j*(p_res-k) - (j-1)*j/2 + i + 1;
+#ifdef _MPI
+  // No MPI calls from the background output writer, see output_writer
+  if (!run_input.async_output) MPI_Barrier(MPI_COMM_WORLD);
+  if (FlowSol->rank==0) cout << "Writing Tecplot binary file number " << in_file_num << " ...." << endl;
+#else
+  cout << "Writing Tecplot binary file number " << in_file_num << " on rank " << FlowSol->rank << endl;
+#endif
 
-                              vertex_2 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + (j+1)*(p_res-k) - (j)*(j+1)/2 + i;
+  sprintf(file_name_s,"Mesh_%.09d_p%.04d.plt",in_file_num,FlowSol->rank);
 
-                              vertex_3 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + j*(p_res-(k+1)) - (j-1)*j/2 + i;
+  // Variable names, as in the ASCII files
+  if (n_dims == 2)
+    variables = "x,y";
+  else
+    variables = "x,y,z";
+  if (run_input.equation == 0) {
+      if (n_dims == 2)
+        variables += ",rho,mom_x,mom_y,ene";
+      else
+        variables += ",rho,mom_x,mom_y,mom_z,ene";
+    }
+  else {
+      variables += ",rho";
+    }
+  for (int m=0; m<n_diag_fields; m++)
+    variables += "," + run_input.diagnostic_fields(m);
 
-                              vertex_0+=m*temp;
-                              vertex_1+=m*temp;
-                              vertex_2+=m*temp;
-                              vertex_3+=m*temp;
+  if (TECINI111((char*) "HiFiLES Solution", (char*) variables.c_str(), file_name_s, (char*) ".", &file_type, &debug, &is_double) != 0)
+    FatalError("Unable to open Tecplot binary file");
 
-                              write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1  << " " << vertex_3+1 << endl;
+  for (int i=0; i<FlowSol->n_ele_types; i++) {
+      eles* ele = FlowSol->mesh_eles(i);
 
-                            }
-                        }
-                    }
+      if (ele->get_n_eles() == 0)
+        continue;
 
-                  for(int k=0;k<p_res-2;k++)
-                    {
-                      for(int j=0;j<p_res-2-k;j++)
-                        {
-                          for(int i=0;i<p_res-2-k-j;i++)
-                            {
-
-                              vertex_0 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + j*(p_res-k) - (j-1)*j/2 + i + 1;
-
-                              vertex_1 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + (j+1)*(p_res-k) - (j)*(j+1)/2 + i + 1;
-                              vertex_2 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + j*(p_res-(k+1)) - (j-1)*j/2 + i + 1;
-                              vertex_3 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j+1)*(p_res-(k+1)) - (j)*(j+1)/2 + (i-1) + 1;
-                              vertex_4 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j)*(p_res-(k+1)) - (j-1)*(j)/2 + (i-1) + 1;
-                              vertex_5 = temp - (p_res-(k))*(p_res+1-(k))*(p_res+2-(k))/6 + (j+1)*(p_res-(k)) - (j)*(j+1)/2 + (i-1) + 1;
-
-                              vertex_0+=m*temp;
-                              vertex_1+=m*temp;
-                              vertex_2+=m*temp;
-                              vertex_3+=m*temp;
-                              vertex_4+=m*temp;
-                              vertex_5+=m*temp;
-
-                              write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1  << " " << vertex_5+1 << endl;
-                              write_tec << vertex_0+1  << " " <<  vertex_2+1  << " " <<  vertex_4+1  << " " << vertex_5+1 << endl;
-                              write_tec << vertex_2+1  << " " <<  vertex_3+1  << " " <<  vertex_4+1  << " " << vertex_5+1 << endl;
-                              write_tec << vertex_1+1  << " " <<  vertex_2+1  << " " <<  vertex_3+1  << " " << vertex_5+1 << endl;
-                            }
-                        }
-                    }
+      n_fields = ele->get_n_fields();
+      n_ppts_per_ele = ele->get_n_ppts_per_ele();
+      n_eles = ele->get_n_eles();
+      num_pts = n_eles*n_ppts_per_ele;
+      num_elements = n_eles*ele->get_n_peles_per_ele();
 
-                  for(int k=0;k<p_res-3;k++)
-                    {
-                      for(int j=0;j<p_res-3-k;j++)
-                        {
-                          for(int i=0;i<p_res-3-k-j;i++)
-                            {
+      if (ele->get_ele_type() == 0) zone_type = 2; // FETRIANGLE
+      else if (ele->get_ele_type() == 1) zone_type = 3; // FEQUADRILATERAL
+      else if (ele->get_ele_type() == 2) zone_type = 4; // FETETRAHEDRON
+      else zone_type = 5; // FEBRICK, prisms as degenerate bricks
 
-                              vertex_0 = temp - (p_res-k)*(p_res+1-k)*(p_res+2-k)/6 + (j+1)*(p_res-k) - (j)*(j+1)/2 + i + 1;
-                              vertex_1 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j)*(p_res-(k+1)) - (j-1)*(j)/2 + i + 1;
-                              vertex_2 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j+1)*(p_res-(k+1)) - (j)*(j+1)/2 + i ;
-                              vertex_3 = temp - (p_res-(k+1))*(p_res+1-(k+1))*(p_res+2-(k+1))/6 + (j+1)*(p_res-(k+1)) - (j)*(j+1)/2 + i + 1;
+      // One strand per element type and rank, so that Tecplot animates the zones of successive files
+      strand = 1+ele->get_ele_type()+5*FlowSol->rank;
 
-                              vertex_0+=m*temp;
-                              vertex_1+=m*temp;
-                              vertex_2+=m*temp;
-                              vertex_3+=m*temp;
+      sprintf(zone_title,"type %d rank %d",ele->get_ele_type(),FlowSol->rank);
 
-                              write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1  << " " << vertex_3+1 << endl;
-                            }
-                        }
-                    }
-                }
+      if (TECZNE111(zone_title, &zone_type, &num_pts, &num_elements, &zero, &zero, &zero, &zero, &in_time, &strand, &zero, &is_block,
+                    &zero, &zero, &zero, &zero, &zero, NULL, NULL, NULL, &zero) != 0)
+        FatalError("Unable to write Tecplot binary zone");
+
+      // Coordinates, straight from the plot point positions (n_ppts_per_ele x n_eles per dimension)
+      array<double>& pos_ppts = ele->get_pos_ppts();
+
+      for (int l=0; l<n_dims; l++)
+        if (TECDAT111(&num_pts, pos_ppts.get_ptr_cpu(0,0,l), &is_double) != 0)
+          FatalError("Unable to write Tecplot binary data");
+
+      // Solution and diagnostic fields, interpolated to the plot points a block of elements at a time
+      values.setup(num_pts,n_fields+n_diag_fields);
+
+      n_block = min(n_eles,PLOT_BLOCK_ELES);
+      disu_ppts_temp.setup(n_ppts_per_ele,n_block,n_fields);
+      if (n_diag_fields > 0)
+        grad_disu_ppts_temp.setup(n_ppts_per_ele,n_block,n_fields,n_dims);
+      diag_ppts_temp.setup(n_ppts_per_ele,n_diag_fields);
+
+      for (j0=0; j0<n_eles; j0+=n_block) {
+          n_eles_block = min(n_block,n_eles-j0);
 
+          if (n_eles_block < n_block) {
+              disu_ppts_temp.setup(n_ppts_per_ele,n_eles_block,n_fields);
+              if (n_diag_fields > 0)
+                grad_disu_ppts_temp.setup(n_ppts_per_ele,n_eles_block,n_fields,n_dims);
             }
-          else if (FlowSol->mesh_eles(i)->get_ele_type()==3) // prisms
-            {
-              int temp = (p_res)*(p_res+1)/2;
 
-              for (int m=0;m<FlowSol->mesh_eles(i)->get_n_eles();m++)
-                {
+          ele->calc_disu_ppts(j0,n_eles_block,disu_ppts_temp);
+          if (n_diag_fields > 0)
+            ele->calc_grad_disu_ppts(j0,n_eles_block,grad_disu_ppts_temp);
 
-                  for (int l=0;l<p_res-1;l++)
-                    {
-                      for(int j=0;j<p_res-1;j++) // look to right from each point
-                        {
-                          for(int k=0;k<p_res-j-1;k++)
-                            {
-                              vertex_0=k+(j*(p_res+1))-((j*(j+1))/2) + l*temp;
-                              vertex_1=vertex_0+1;
-                              vertex_2=k+((j+1)*(p_res+1))-(((j+1)*(j+2))/2) + l*temp;
-
-                              vertex_3 = vertex_0 + temp;
-                              vertex_4 = vertex_1 + temp;
-                              vertex_5 = vertex_2 + temp;
-
-                              vertex_0+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_1+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_2+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_3+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_4+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_5+=m*(p_res*(p_res+1)/2*p_res);
-
-                              write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1  << " " << vertex_2+1 << " " << vertex_3+1 << " " << vertex_4+1 << " " << vertex_5+1 << " " << vertex_5+1 << endl;
-                            }
-                        }
-                    }
+          for (jb=0; jb<n_eles_block; jb++) {
+              j = j0+jb;
 
-                  for (int l=0;l<p_res-1;l++)
-                    {
-                      for(int j=0;j<p_res-2;j++) //  look to left from each point
-                        {
-                          for(int k=1;k<p_res-j-1;k++)
-                            {
-                              vertex_0=k+(j*(p_res+1))-((j*(j+1))/2) + l*temp;
-                              vertex_1=k+((j+1)*(p_res+1))-(((j+1)*(j+2))/2) + l*temp;
-                              vertex_2=k-1+((j+1)*(p_res+1))-(((j+1)*(j+2))/2) + l*temp;
-
-                              vertex_3 = vertex_0 + temp;
-                              vertex_4 = vertex_1 + temp;
-                              vertex_5 = vertex_2 + temp;
-
-                              vertex_0+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_1+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_2+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_3+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_4+=m*(p_res*(p_res+1)/2*p_res);
-                              vertex_5+=m*(p_res*(p_res+1)/2*p_res);
-
-                              write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1  << " " << vertex_2+1 << " " << vertex_3+1 << " " << vertex_4+1 << " " << vertex_5+1 << " " << vertex_5+1 << endl;
-                            }
-                        }
+              if (n_diag_fields > 0)
+                ele->calc_diagnostic_fields_ppts(jb,disu_ppts_temp,grad_disu_ppts_temp,diag_ppts_temp);
+
+              for (int k=0; k<n_ppts_per_ele; k++) {
+                  for (int l=0; l<n_fields; l++) {
+                      if (isnan(disu_ppts_temp(k,jb,l)))
+                        FatalError("Nan in tecplot file, exiting");
+                      values(k+j*n_ppts_per_ele,l) = disu_ppts_temp(k,jb,l);
                     }
-                }
-            }
-          else if(FlowSol->mesh_eles(i)->get_ele_type()==4) // hexa
-            {
-              for (int j=0;j<FlowSol->mesh_eles(i)->get_n_eles();j++)
-                {
-                  for(int k=0;k<p_res-1;k++)
-                    {
-                      for(int l=0;l<p_res-1;l++)
-                        {
-                          for(int m=0;m<p_res-1;m++)
-                            {
-                              vertex_0=m+(p_res*l)+(p_res*p_res*k);
-                              vertex_1=vertex_0+1;
-                              vertex_2=vertex_0+p_res+1;
-                              vertex_3=vertex_0+p_res;
-
-                              vertex_4=vertex_0+p_res*p_res;
-                              vertex_5=vertex_4+1;
-                              vertex_6=vertex_4+p_res+1;
-                              vertex_7=vertex_4+p_res;
-
-                              vertex_0 += j*p_res*p_res*p_res;
-                              vertex_1 += j*p_res*p_res*p_res;
-                              vertex_2 += j*p_res*p_res*p_res;
-                              vertex_3 += j*p_res*p_res*p_res;
-                              vertex_4 += j*p_res*p_res*p_res;
-                              vertex_5 += j*p_res*p_res*p_res;
-                              vertex_6 += j*p_res*p_res*p_res;
-                              vertex_7 += j*p_res*p_res*p_res;
-
-                              write_tec << vertex_0+1  << " " <<  vertex_1+1  << " " <<  vertex_2+1 << " " <<  vertex_3+1  << " " << vertex_4+1 << " " << vertex_5+1 << " " << vertex_6+1 << " " << vertex_7+1 <<endl;
-                            }
-                        }
+                  for (int l=0; l<n_diag_fields; l++) {
+                      if (isnan(diag_ppts_temp(k,l)))
+                        FatalError("Nan in tecplot file, exiting");
+                      values(k+j*n_ppts_per_ele,n_fields+l) = diag_ppts_temp(k,l);
                     }
                 }
             }
-          else
-            {
-              FatalError("ERROR: Invalid element type ... ");
-            }
         }
+
+      for (int l=0; l<n_fields+n_diag_fields; l++)
+        if (TECDAT111(&num_pts, values.get_ptr_cpu(0,l), &is_double) != 0)
+          FatalError("Unable to write Tecplot binary data");
+
+      // Connectivity of the plot sub-elements, in one call
+      calc_tec_connectivity(ele,tec_conn);
+
+      if (TECNOD111(tec_conn.get_ptr_cpu()) != 0)
+        FatalError("Unable to write Tecplot binary connectivity");
     }
 
-  write_tec.close();
+  if (TECEND111() != 0)
+    FatalError("Unable to close Tecplot binary file");
 
 #ifdef _MPI
-  MPI_Barrier(MPI_COMM_WORLD);
-  if (FlowSol->rank==0) cout << "Done writing Tecplot file number " << in_file_num << " ...." << endl;
+  if (!run_input.async_output) MPI_Barrier(MPI_COMM_WORLD);
+  if (FlowSol->rank==0) cout << "Done writing Tecplot binary file number " << in_file_num << " ...." << endl;
 #else
-  cout << "Done writing Tecplot file number " << in_file_num << " ...." << endl;
+  cout << "Done writing Tecplot binary file number " << in_file_num << " ...." << endl;
 #endif
 
+#else
+  // input already rejects write_type 2 without TecIO, this catches direct calls
+  (void) in_file_num; (void) in_time; (void) FlowSol;
+  FatalError("write_type 2 requires HiFiLES to be compiled with TecIO (-D_TECIO)");
+#endif
 }
 
 /*! Method to write out a Paraview .vtu file.
@@ -541,9 +782,9 @@ void write_vtu(int in_file_num, struct solution* FlowSol)
   int n_verts;
   /*! Element type */
   int ele_type;
+  /*! No. of elements interpolated at once, in the current block, first of the block, index in the block */
+  int n_block, n_eles_block, j0, jb;
 
-  /*! Plot point coordinates */
-  array<double> pos_ppts_temp;
   /*! Solution data at plot points */
   array<double> disu_ppts_temp;
   /*! Solution gradient data at plot points */
@@ -554,6 +795,13 @@ void write_vtu(int in_file_num, struct solution* FlowSol)
   /*! Plot sub-element connectivity array (node IDs) */
   array<int> con;
 
+  /*! Values of the DataArray being written */
+  array<double> vtu_values;
+  array<int> vtu_cells;
+
+  /*! DataArrays are written as text, or as zlib-compressed binary data with vtu_compression */
+  const char* vtu_format = run_input.vtu_compression ? "binary" : "ascii";
+
   /*! VTK element types (different to HiFiLES element type) */
   /*! tri, quad, tet, prism (undefined), hex */
   /*! See vtkCellType.h for full list */
@@ -568,8 +816,10 @@ void write_vtu(int in_file_num, struct solution* FlowSol)
   char *pvtu;
   char *dumpnum;
 
-  /*! Output files */
-  ofstream write_vtu;
+  /*! Output files (with mpiio_output the pieces of each rank are formatted in memory and written to one shared file) */
+  ofstream vtu_file;
+  ostringstream vtu_text;
+  ostream& write_vtu = run_input.mpiio_output ? (ostream&) vtu_text : (ostream&) vtu_file;
   write_vtu.precision(15);
   ofstream write_pvtu;
   write_pvtu.precision(15);
@@ -584,10 +834,16 @@ void write_vtu(int in_file_num, struct solution* FlowSol)
   n_proc   = FlowSol->nproc;
   /*! Dump number */
   sprintf(dumpnum_s,"Mesh_%.09d",in_file_num);
-  /*! Each rank writes a .vtu file in a subdirectory named 'dumpnum_s' created by master process */
-  sprintf(vtu_s,"Mesh_%.09d/Mesh_%.09d_%d.vtu",in_file_num,in_file_num,my_rank);
-  /*! On rank 0, write a .pvtu file to gather data from all .vtu files */
-  sprintf(pvtu_s,"Mesh_%.09d.pvtu",in_file_num);
+  if (run_input.mpiio_output) {
+      /*! All ranks write their pieces into a single .vtu file */
+      sprintf(vtu_s,"Mesh_%.09d.vtu",in_file_num);
+    }
+  else {
+      /*! Each rank writes a .vtu file in a subdirectory named 'dumpnum_s' created by master process */
+      sprintf(vtu_s,"Mesh_%.09d/Mesh_%.09d_%d.vtu",in_file_num,in_file_num,my_rank);
+      /*! On rank 0, write a .pvtu file to gather data from all .vtu files */
+      sprintf(pvtu_s,"Mesh_%.09d.pvtu",in_file_num);
+    }
 
 #else
 
@@ -604,8 +860,8 @@ void write_vtu(int in_file_num, struct solution* FlowSol)
 
 #ifdef _MPI
 
-  /*! Master node creates a subdirectory to store .vtu files */
-  if (my_rank == 0) {
+  /*! Master node creates a subdirectory to store .vtu files (every rank when written in the background, as there is no barrier then) */
+  if ((my_rank == 0 || run_input.async_output) && !run_input.mpiio_output) {
       struct stat st = {0};
       if (stat(dumpnum, &st) == -1) {
           mkdir(dumpnum, 0755);
@@ -614,8 +870,11 @@ void write_vtu(int in_file_num, struct solution* FlowSol)
       //remove(strcat(dumpnum,"/*.vtu"));
     }
 
+  if (my_rank == 0 && run_input.mpiio_output)
+    cout << "Writing Paraview dump number " << dumpnum << " ...." << endl;
+
   /*! Master node writes the .pvtu file */
-  if (my_rank == 0) {
+  if (my_rank == 0 && !run_input.mpiio_output) {
       cout << "Writing Paraview dump number " << dumpnum << " ...." << endl;
 
       write_pvtu.open(pvtu);
@@ -663,16 +922,19 @@ void write_vtu(int in_file_num, struct solution* FlowSol)
 #ifdef _MPI
 
   /*! Wait for all processes to get to this point, otherwise there won't be a directory to put .vtus into */
-  MPI_Barrier(MPI_COMM_WORLD);
+  if (!run_input.async_output && !run_input.mpiio_output) MPI_Barrier(MPI_COMM_WORLD);
 
 #endif
 
-  /*! Each process writes its own .vtu file */
-  write_vtu.open(vtu);
-  /*! File header */
-  write_vtu << "<?xml version=\"1.0\" ?>" << endl;
-  write_vtu << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\" compressor=\"vtkZLibDataCompressor\">" << endl;
-  write_vtu << "	<UnstructuredGrid>" << endl;
+  /*! Each process writes its own .vtu file (or its pieces of the shared file) */
+  if (!run_input.mpiio_output)
+    vtu_file.open(vtu);
+  /*! File header (only once in a shared file) */
+  if (my_rank == 0 || !run_input.mpiio_output) {
+      write_vtu << "<?xml version=\"1.0\" ?>" << endl;
+      write_vtu << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\" compressor=\"vtkZLibDataCompressor\">" << endl;
+      write_vtu << "	<UnstructuredGrid>" << endl;
+    }
 
   /*! Loop over element types */
   for(i=0;i<FlowSol->n_ele_types;i++)
@@ -699,180 +961,243 @@ void write_vtu(int in_file_num, struct solution* FlowSol)
           /*! no. of dimensions */
           n_dims = FlowSol->mesh_eles(i)->get_n_dims();
 
-          /*! Temporary array of plot point coordinates */
-          pos_ppts_temp.setup(n_points,n_dims);
+          /*! Plot point coordinates, computed at the first output */
+          array<double>& pos_ppts = FlowSol->mesh_eles(i)->get_pos_ppts();
 
-          /*! Temporary solution array at plot points */
-          disu_ppts_temp.setup(n_points,n_fields);
+          /*! Temporary solution array at plot points of a block of elements */
+          n_block = min(n_eles,PLOT_BLOCK_ELES);
+          disu_ppts_temp.setup(n_points,n_block,n_fields);
 
           if(n_diag_fields > 0) {
-            /*! Temporary solution array at plot points */
-            grad_disu_ppts_temp.setup(n_points,n_fields,n_dims);
+            /*! Temporary solution gradient array at plot points of a block of elements */
+            grad_disu_ppts_temp.setup(n_points,n_block,n_fields,n_dims);
 
             /*! Temporary diagnostic field array at plot points */
             diag_ppts_temp.setup(n_points,n_diag_fields);
           }
 
           con.setup(n_verts,n_cells);
-          con = FlowSol->mesh_eles(i)->get_connectivity_plot();
+          FlowSol->mesh_eles(i)->get_connectivity_plot().swap(con);
 
-          /*! Loop over individual elements and write their data as a separate VTK DataArray */
-          for(j=0;j<n_eles;j++)
+          vtu_values.setup(3*n_points);
+          vtu_cells.setup(n_verts*n_cells);
+
+          /*! Interpolate the solution to the plot points a block of elements at a time */
+          for(j0=0;j0<n_eles;j0+=n_block)
             {
-              write_vtu << "		<Piece NumberOfPoints=\"" << n_points << "\" NumberOfCells=\"" << n_cells << "\">" << endl;
+              n_eles_block = min(n_block,n_eles-j0);
+
+              /*! The last block may be shorter, and the plot point data is sized to the block */
+              if(n_eles_block < n_block) {
+                disu_ppts_temp.setup(n_points,n_eles_block,n_fields);
+                if(n_diag_fields > 0)
+                  grad_disu_ppts_temp.setup(n_points,n_eles_block,n_fields,n_dims);
+              }
 
               /*! Calculate the prognostic (solution) fields at the plot points */
-              FlowSol->mesh_eles(i)->calc_disu_ppts(j,disu_ppts_temp);
+              FlowSol->mesh_eles(i)->calc_disu_ppts(j0,n_eles_block,disu_ppts_temp);
 
-              if(n_diag_fields > 0) {
-                /*! Calculate the gradient of the prognostic fields at the plot points */
-                FlowSol->mesh_eles(i)->calc_grad_disu_ppts(j,grad_disu_ppts_temp);
+              /*! Calculate the gradient of the prognostic fields at the plot points */
+              if(n_diag_fields > 0)
+                FlowSol->mesh_eles(i)->calc_grad_disu_ppts(j0,n_eles_block,grad_disu_ppts_temp);
 
-                /*! Calculate the diagnostic fields at the plot points */
-                FlowSol->mesh_eles(i)->calc_diagnostic_fields_ppts(j,disu_ppts_temp,grad_disu_ppts_temp,diag_ppts_temp);
-              }
+              /*! Loop over individual elements and write their data as a separate VTK DataArray */
+              for(jb=0;jb<n_eles_block;jb++)
+                {
+                  j = j0+jb;
 
-              /*! write out solution to file */
-              write_vtu << "			<PointData>" << endl;
+                  write_vtu << "		<Piece NumberOfPoints=\"" << n_points << "\" NumberOfCells=\"" << n_cells << "\">" << endl;
 
-              /*! density */
-              write_vtu << "				<DataArray type= \"Float32\" Name=\"Density\" format=\"ascii\">" << endl;
-              for(k=0;k<n_points;k++)
-                {
-                  write_vtu << disu_ppts_temp(k,0) << " ";
-                }
-              write_vtu << endl;
-              write_vtu << "				</DataArray>" << endl;
+                  /*! Calculate the diagnostic fields at the plot points */
+                  if(n_diag_fields > 0)
+                    FlowSol->mesh_eles(i)->calc_diagnostic_fields_ppts(jb,disu_ppts_temp,grad_disu_ppts_temp,diag_ppts_temp);
 
-              /*! velocity */
-              write_vtu << "				<DataArray type= \"Float32\" NumberOfComponents=\"3\" Name=\"Velocity\" format=\"ascii\">" << endl;
-              for(k=0;k<n_points;k++)
-                {
-                  /*! Divide momentum components by density to obtain velocity components */
-                  write_vtu << disu_ppts_temp(k,1)/disu_ppts_temp(k,0) << " " << disu_ppts_temp(k,2)/disu_ppts_temp(k,0) << " ";
+                  /*! write out solution to file */
+                  write_vtu << "			<PointData>" << endl;
 
-                  /*! In 2D the z-component of velocity is not stored, but Paraview needs it so write a 0. */
-                  if(n_dims==2)
+                  /*! density */
+                  write_vtu << "				<DataArray type= \"Float32\" Name=\"Density\" format=\"" << vtu_format << "\">" << endl;
+                  for(k=0;k<n_points;k++)
                     {
-                      write_vtu << 0.0 << " ";
+                      vtu_values(k) = disu_ppts_temp(k,jb,0);
                     }
-                  /*! In 3D just write the z-component of velocity */
-                  else
+                  write_vtu_floats(write_vtu,vtu_values,n_points);
+                  write_vtu << "				</DataArray>" << endl;
+
+                  /*! velocity */
+                  write_vtu << "				<DataArray type= \"Float32\" NumberOfComponents=\"3\" Name=\"Velocity\" format=\"" << vtu_format << "\">" << endl;
+                  for(k=0;k<n_points;k++)
                     {
-                      write_vtu << disu_ppts_temp(k,3)/disu_ppts_temp(k,0) << " ";
+                      /*! Divide momentum components by density to obtain velocity components */
+                      vtu_values(3*k) = disu_ppts_temp(k,jb,1)/disu_ppts_temp(k,jb,0);
+                      vtu_values(3*k+1) = disu_ppts_temp(k,jb,2)/disu_ppts_temp(k,jb,0);
+
+                      /*! In 2D the z-component of velocity is not stored, but Paraview needs it so write a 0. */
+                      if(n_dims==2)
+                        {
+                          vtu_values(3*k+2) = 0.0;
+                        }
+                      /*! In 3D just write the z-component of velocity */
+                      else
+                        {
+                          vtu_values(3*k+2) = disu_ppts_temp(k,jb,3)/disu_ppts_temp(k,jb,0);
+                        }
                     }
-                }
-              write_vtu << endl;
-              write_vtu << "				</DataArray>" << endl;
+                  write_vtu_floats(write_vtu,vtu_values,3*n_points);
+                  write_vtu << "				</DataArray>" << endl;
 
-              /*! energy */
-              write_vtu << "				<DataArray type= \"Float32\" Name=\"Energy\" format=\"ascii\">" << endl;
-              for(k=0;k<n_points;k++)
-                {
-                  /*! In 2D energy is the 4th solution component */
-                  if(n_dims==2)
+                  /*! energy */
+                  write_vtu << "				<DataArray type= \"Float32\" Name=\"Energy\" format=\"" << vtu_format << "\">" << endl;
+                  for(k=0;k<n_points;k++)
                     {
-                      write_vtu << disu_ppts_temp(k,3)/disu_ppts_temp(k,0) << " ";
+                      /*! In 2D energy is the 4th solution component, in 3D the 5th */
+                      vtu_values(k) = disu_ppts_temp(k,jb,n_dims+1)/disu_ppts_temp(k,jb,0);
                     }
-                  /*! In 3D energy is the 5th solution component */
-                  else
+                  write_vtu_floats(write_vtu,vtu_values,n_points);
+                  write_vtu << "				</DataArray>" << endl;
+
+                  /*! Write out optional diagnostic fields */
+                  for(m=0;m<n_diag_fields;m++)
                     {
-                      write_vtu << disu_ppts_temp(k,4)/disu_ppts_temp(k,0) << " ";
+                      write_vtu << "				<DataArray type= \"Float32\" Name=\"" << run_input.diagnostic_fields(m) << "\" format=\"" << vtu_format << "\">" << endl;
+                      for(k=0;k<n_points;k++)
+                        {
+                          vtu_values(k) = diag_ppts_temp(k,m);
+                        }
+                      write_vtu_floats(write_vtu,vtu_values,n_points);
+                      write_vtu << "				</DataArray>" << endl;
                     }
-                }
-              write_vtu << endl;
-              write_vtu << "				</DataArray>" << endl;
 
-              /*! Write out optional diagnostic fields */
-              for(m=0;m<n_diag_fields;m++)
-                {
-                  write_vtu << "				<DataArray type= \"Float32\" Name=\"" << run_input.diagnostic_fields(m) << "\" format=\"ascii\">" << endl;
+                  /*! finish writing PointData object */
+                  write_vtu << "			</PointData>" << endl;
+
+                  /*! write out the plot coordinates */
+                  write_vtu << "			<Points>" << endl;
+                  write_vtu << "				<DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"" << vtu_format << "\">" << endl;
+
+                  /*! Loop over plot points in element */
                   for(k=0;k<n_points;k++)
                     {
-                      write_vtu << diag_ppts_temp(k,m) << " ";
-                    }
+                      for(l=0;l<n_dims;l++)
+                        {
+                          vtu_values(3*k+l) = pos_ppts(k,j,l);
+                        }
 
-                  /*! End the line and finish writing DataArray object */
-                  write_vtu << endl;
+                      /*! If 2D, write a 0 as the z-component */
+                      if(n_dims==2)
+                        {
+                          vtu_values(3*k+2) = 0.0;
+                        }
+                    }
+                  write_vtu_floats(write_vtu,vtu_values,3*n_points);
                   write_vtu << "				</DataArray>" << endl;
-                }
+                  write_vtu << "			</Points>" << endl;
 
-              /*! finish writing PointData object */
-              write_vtu << "			</PointData>" << endl;
+                  /*! write out Cell data: connectivity, offsets, element types */
+                  write_vtu << "			<Cells>" << endl;
 
-              /*! Calculate the plot coordinates */
-              FlowSol->mesh_eles(i)->calc_pos_ppts(j,pos_ppts_temp);
-
-              /*! write out the plot coordinates */
-              write_vtu << "			<Points>" << endl;
-              write_vtu << "				<DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"ascii\">" << endl;
-
-              /*! Loop over plot points in element */
-              for(k=0;k<n_points;k++)
-                {
-                  for(l=0;l<n_dims;l++)
+                  /*! Write connectivity array */
+                  write_vtu << "				<DataArray type=\"Int32\" Name=\"connectivity\" format=\"" << vtu_format << "\">" << endl;
+                  for(k=0;k<n_cells;k++)
                     {
-                      write_vtu << pos_ppts_temp(k,l) << " ";
+                      for(l=0;l<n_verts;l++)
+                        {
+                          vtu_cells(k*n_verts+l) = con(l,k);
+                        }
                     }
+                  write_vtu_ints(write_vtu,vtu_cells,n_cells*n_verts,n_verts,0);
+                  write_vtu << "				</DataArray>" << endl;
 
-                  /*! If 2D, write a 0 as the z-component */
-                  if(n_dims==2)
+                  /*! Write cell numbers */
+                  write_vtu << "				<DataArray type=\"Int32\" Name=\"offsets\" format=\"" << vtu_format << "\">" << endl;
+                  for(k=0;k<n_cells;k++)
                     {
-                      write_vtu << "0 ";
+                      vtu_cells(k) = (k+1)*n_verts;
                     }
-                }
-
-              write_vtu << endl;
-              write_vtu << "				</DataArray>" << endl;
-              write_vtu << "			</Points>" << endl;
-
-              /*! write out Cell data: connectivity, offsets, element types */
-              write_vtu << "			<Cells>" << endl;
-
-              /*! Write connectivity array */
-              write_vtu << "				<DataArray type=\"Int32\" Name=\"connectivity\" format=\"ascii\">" << endl;
+                  write_vtu_ints(write_vtu,vtu_cells,n_cells,n_cells,0);
+                  write_vtu << "				</DataArray>" << endl;
 
-              for(k=0;k<n_cells;k++)
-                {
-                  for(l=0;l<n_verts;l++)
+                  /*! Write VTK element type */
+                  write_vtu << "				<DataArray type=\"UInt8\" Name=\"types\" format=\"" << vtu_format << "\">" << endl;
+                  for(k=0;k<n_cells;k++)
                     {
-                      write_vtu << con(l,k) << " ";
+                      vtu_cells(k) = vtktypes[i];
                     }
-                  write_vtu << endl;
-                }
-              write_vtu << "				</DataArray>" << endl;
-
-              /*! Write cell numbers */
-              write_vtu << "				<DataArray type=\"Int32\" Name=\"offsets\" format=\"ascii\">" << endl;
-              for(k=0;k<n_cells;k++)
-                {
-                  write_vtu << (k+1)*n_verts << " ";
-                }
-              write_vtu << endl;
-              write_vtu << "				</DataArray>" << endl;
+                  write_vtu_ints(write_vtu,vtu_cells,n_cells,n_cells,1);
+                  write_vtu << "				</DataArray>" << endl;
 
-              /*! Write VTK element type */
-              write_vtu << "				<DataArray type=\"UInt8\" Name=\"types\" format=\"ascii\">" << endl;
-              for(k=0;k<n_cells;k++)
-                {
-                  write_vtu << vtktypes[i] << " ";
+                  /*! Write cell and piece footers */
+                  write_vtu << "			</Cells>" << endl;
+                  write_vtu << "		</Piece>" << endl;
                 }
-              write_vtu << endl;
-              write_vtu << "				</DataArray>" << endl;
-
-              /*! Write cell and piece footers */
-              write_vtu << "			</Cells>" << endl;
-              write_vtu << "		</Piece>" << endl;
             }
         }
     }
 
-  /*! Write footer of file */
-  write_vtu << "	</UnstructuredGrid>" << endl;
-  write_vtu << "</VTKFile>" << endl;
+  /*! Write footer of file (only once in a shared file) */
+  if (my_rank == n_proc-1 || !run_input.mpiio_output) {
+      write_vtu << "	</UnstructuredGrid>" << endl;
+      write_vtu << "</VTKFile>" << endl;
+    }
+
+#ifdef _MPI
+  if (run_input.mpiio_output) {
+      write_shared_file(vtu, vtu_text.str(), FlowSol);
+      return;
+    }
+#endif
 
   /*! Close the .vtu file */
-  write_vtu.close();
+  vtu_file.close();
+}
+
+// write the values of a Float32 DataArray, as text or compressed binary
+
+void write_vtu_floats(ostream& write_vtu, array<double>& in_values, int in_n_values)
+{
+  int k;
+
+  if (run_input.vtu_compression)
+    {
+      array<float> values(in_n_values);
+      for(k=0;k<in_n_values;k++)
+        values(k) = in_values(k);
+      write_vtu_binary(write_vtu,(char*) values.get_ptr_cpu(),in_n_values*sizeof(float));
+    }
+  else
+    {
+      for(k=0;k<in_n_values;k++)
+        write_vtu << in_values(k) << " ";
+      write_vtu << endl;
+    }
+}
+
+// write the values of an Int32 (or UInt8) DataArray, as text with in_n_per_line values per line or compressed binary
+
+void write_vtu_ints(ostream& write_vtu, array<int>& in_values, int in_n_values, int in_n_per_line, int in_uint8)
+{
+  int k;
+
+  if (run_input.vtu_compression && in_uint8)
+    {
+      array<unsigned char> values(in_n_values);
+      for(k=0;k<in_n_values;k++)
+        values(k) = in_values(k);
+      write_vtu_binary(write_vtu,(char*) values.get_ptr_cpu(),in_n_values);
+    }
+  else if (run_input.vtu_compression)
+    {
+      write_vtu_binary(write_vtu,(char*) in_values.get_ptr_cpu(),in_n_values*sizeof(int));
+    }
+  else
+    {
+      for(k=0;k<in_n_values;k++)
+        {
+          write_vtu << in_values(k) << " ";
+          if ((k+1)%in_n_per_line == 0 || k == in_n_values-1)
+            write_vtu << endl;
+        }
+    }
 }
 
 void write_restart(int in_file_num, struct solution* FlowSol)
@@ -881,11 +1206,18 @@ void write_restart(int in_file_num, struct solution* FlowSol)
   char file_name_s[50];
   char *file_name;
   ofstream restart_file;
+  ostringstream restart_text;
   restart_file.precision(15);
+  restart_text.precision(15);
 
+  /*! With mpiio_output the part of each rank is formatted in memory, and all parts go to one shared file */
+  ostream& restart_out = run_input.mpiio_output ? (ostream&) restart_text : (ostream&) restart_file;
 
 #ifdef _MPI
-  sprintf(file_name_s,"Rest_%.09d_p%.04d.dat",in_file_num,FlowSol->rank);
+  if (run_input.mpiio_output)
+    sprintf(file_name_s,"Rest_%.09d.dat",in_file_num);
+  else
+    sprintf(file_name_s,"Rest_%.09d_p%.04d.dat",in_file_num,FlowSol->rank);
   if (FlowSol->rank==0) cout << "Writing Restart file number " << in_file_num << " ...." << endl;
 #else
   sprintf(file_name_s,"Rest_%.09d_p%.04d.dat",in_file_num,0);
@@ -894,29 +1226,153 @@ void write_restart(int in_file_num, struct solution* FlowSol)
 
 
   file_name = &file_name_s[0];
-  restart_file.open(file_name);
+  if (!run_input.mpiio_output)
+    restart_file.open(file_name);
 
-  restart_file << &time << endl;
+  restart_out << &time << endl;
   //header
   for (int i=0;i<FlowSol->n_ele_types;i++) {
       if (FlowSol->mesh_eles(i)->get_n_eles()!=0) {
 
-          FlowSol->mesh_eles(i)->write_restart_info(restart_file);
-          FlowSol->mesh_eles(i)->write_restart_data(restart_file);
+          FlowSol->mesh_eles(i)->write_restart_info(restart_out);
+          FlowSol->mesh_eles(i)->write_restart_data(restart_out);
 
         }
     }
 
+#ifdef _MPI
+  if (run_input.mpiio_output) {
+      write_shared_restart(file_name, restart_text.str(), FlowSol);
+      return;
+    }
+#endif
+
   restart_file.close();
 
 }
 
+#ifdef _MPI
+
+// open a shared output file for a collective write, with the collective buffering hints
+
+static void open_shared_file(const char* in_file_name, MPI_File& out_file)
+{
+  MPI_Info info;
+  char hint_s[20];
+
+  /*! Collective buffering: the data is shipped to a few aggregator ranks, which alone touch the file system */
+  MPI_Info_create(&info);
+  MPI_Info_set(info, (char*) "romio_cb_write", (char*) "enable");
+  if (run_input.mpiio_aggregators > 0) {
+      sprintf(hint_s, "%d", run_input.mpiio_aggregators);
+      MPI_Info_set(info, (char*) "cb_nodes", hint_s);
+    }
+
+  if (MPI_File_open(MPI_COMM_WORLD, (char*) in_file_name, MPI_MODE_WRONLY | MPI_MODE_CREATE, info, &out_file) != MPI_SUCCESS)
+    FatalError("Unable to open shared output file");
+
+  MPI_Info_free(&info);
+}
+
+// write the text of every rank into one file, in rank order, with a collective MPI-IO write
+
+void write_shared_file(const char* in_file_name, const string& in_text, struct solution* FlowSol)
+{
+  MPI_File file;
+  long long length = in_text.size(), offset = 0, total;
+
+  if (in_text.size() > (size_t) INT_MAX)
+    FatalError("The part of a shared output file written by one rank exceeds 2 GB");
+
+  /*! Offset of this rank's part, and the size of the file (to truncate an older, longer file) */
+  MPI_Exscan(&length, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+  if (FlowSol->rank == 0)
+    offset = 0;
+  MPI_Allreduce(&length, &total, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  open_shared_file(in_file_name, file);
+
+  MPI_File_set_size(file, (MPI_Offset) total);
+  MPI_File_write_at_all(file, (MPI_Offset) offset, (void*) in_text.data(), (int) length, MPI_CHAR, MPI_STATUS_IGNORE);
+
+  MPI_File_close(&file);
+}
+
+// write the restart text of every rank into one file, behind an index of the sections and of the section holding each cell
+
+void write_shared_restart(const char* in_file_name, const string& in_text, struct solution* FlowSol)
+{
+  MPI_File file;
+  MPI_Datatype cells_type;
+  MPI_Offset index_offset, cells_offset, data_offset;
+  char header_s[SHARED_RESTART_HEADER_BYTES+1];
+  long long section[2], total;
+  int i, n_cells_local, max_cell = -1, n_cells;
+  array<int> cells, cell_sections;
+
+  if (in_text.size() > (size_t) INT_MAX)
+    FatalError("The part of a shared output file written by one rank exceeds 2 GB");
+
+  /*! The number of cells of the mesh, to size the cell map */
+  n_cells_local = get_global_cells(cells, FlowSol);
+  if (n_cells_local > 0)
+    max_cell = cells(n_cells_local-1);
+  MPI_Allreduce(&max_cell, &n_cells, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  n_cells++;
+
+  index_offset = SHARED_RESTART_HEADER_BYTES;
+  cells_offset = index_offset + 2*sizeof(long long)*(MPI_Offset) FlowSol->nproc;
+  data_offset = cells_offset + sizeof(int)*(MPI_Offset) n_cells;
+
+  /*! Offset and size of this rank's section */
+  section[0] = 0;
+  section[1] = in_text.size();
+  MPI_Exscan(&section[1], &section[0], 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+  if (FlowSol->rank == 0)
+    section[0] = 0;
+  section[0] += data_offset;
+  MPI_Allreduce(&section[1], &total, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  open_shared_file(in_file_name, file);
+  MPI_File_set_size(file, data_offset + (MPI_Offset) total);
+
+  if (FlowSol->rank == 0) {
+      sprintf(header_s, "restart_index %d %d", FlowSol->nproc, n_cells);
+      for (i=strlen(header_s);i<SHARED_RESTART_HEADER_BYTES-1;i++)
+        header_s[i] = ' ';
+      header_s[SHARED_RESTART_HEADER_BYTES-1] = '\n';
+      MPI_File_write_at(file, 0, header_s, SHARED_RESTART_HEADER_BYTES, MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+
+  MPI_File_write_at_all(file, index_offset + 2*sizeof(long long)*(MPI_Offset) FlowSol->rank, section, 2, MPI_LONG_LONG, MPI_STATUS_IGNORE);
+
+  /*! This rank's entries of the cell map, written through a view of its cells */
+  cell_sections.setup(max(n_cells_local,1));
+  for (i=0;i<n_cells_local;i++)
+    cell_sections(i) = FlowSol->rank;
+
+  MPI_Type_create_indexed_block(n_cells_local, 1, cells.get_ptr_cpu(), MPI_INT, &cells_type);
+  MPI_Type_commit(&cells_type);
+  MPI_File_set_view(file, cells_offset, MPI_INT, cells_type, (char*) "native", MPI_INFO_NULL);
+  MPI_File_write_all(file, cell_sections.get_ptr_cpu(), n_cells_local, MPI_INT, MPI_STATUS_IGNORE);
+  MPI_File_set_view(file, 0, MPI_BYTE, MPI_BYTE, (char*) "native", MPI_INFO_NULL);
+  MPI_Type_free(&cells_type);
+
+  MPI_File_write_at_all(file, (MPI_Offset) section[0], (void*) in_text.data(), (int) section[1], MPI_CHAR, MPI_STATUS_IGNORE);
+
+  MPI_File_close(&file);
+}
+
+#endif
+
 void CalcForces(int in_file_num, struct solution* FlowSol) {
   
   char file_name_s[50], *file_name;
   char forcedir_s[50], *forcedir;
   struct stat st = {0};
-  ofstream coeff_file;
+  ofstream cp_file;
+  ostringstream cp_text;
+  ostream& coeff_file = run_input.mpiio_output ? (ostream&) cp_text : (ostream&) cp_file;
   bool write_dir, write_forces;
   array<double> temp_inv_force(FlowSol->n_dims);
   array<double> temp_vis_force(FlowSol->n_dims);
@@ -951,13 +1407,26 @@ void CalcForces(int in_file_num, struct solution* FlowSol) {
         }
     }
 
+  // the shared cp file is opened by every rank, so the directory must exist first
+  if (run_input.mpiio_output && write_dir)
+    MPI_Barrier(MPI_COMM_WORLD);
+
   if (write_forces)
     {
-      sprintf(file_name_s,"force_files/cp_%.09d_p%.04d.dat",in_file_num,my_rank);
-      file_name = &file_name_s[0];
-    
-      // open files for writing
-      coeff_file.open(file_name);
+      if (run_input.mpiio_output)
+        {
+          // all ranks append their wall points to one file
+          sprintf(file_name_s,"force_files/cp_%.09d.dat",in_file_num);
+          file_name = &file_name_s[0];
+        }
+      else
+        {
+          sprintf(file_name_s,"force_files/cp_%.09d_p%.04d.dat",in_file_num,my_rank);
+          file_name = &file_name_s[0];
+
+          // open files for writing
+          cp_file.open(file_name);
+        }
     }
 
 #else
@@ -976,7 +1445,7 @@ void CalcForces(int in_file_num, struct solution* FlowSol) {
       file_name = &file_name_s[0];
     
       // open file for writing
-      coeff_file.open(file_name);
+      cp_file.open(file_name);
     }
 
 #endif
@@ -1012,40 +1481,14 @@ void CalcForces(int in_file_num, struct solution* FlowSol) {
     }
   
 #ifdef _MPI
-
-  array<double> inv_force_global(FlowSol->n_dims);
-  array<double> vis_force_global(FlowSol->n_dims);
-  double coeff_lift_global=0.0;
-  double coeff_drag_global=0.0;
-
-  for (int m=0;m<FlowSol->n_dims;m++) {
-      inv_force_global(m) = 0.;
-      vis_force_global(m) = 0.;
-      MPI_Reduce(&FlowSol->inv_force(m),&inv_force_global(m),1,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD);
-      MPI_Reduce(&FlowSol->vis_force(m),&vis_force_global(m),1,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD);
-    }
-
-  MPI_Reduce(&FlowSol->coeff_lift,&coeff_lift_global,1,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD);
-  MPI_Reduce(&FlowSol->coeff_drag,&coeff_drag_global,1,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD);
-  
-  for (int m=0;m<FlowSol->n_dims;m++)
+  if (write_forces && run_input.mpiio_output)
     {
-      FlowSol->inv_force(m) = inv_force_global(m);
-      FlowSol->vis_force(m) = vis_force_global(m);
+      write_shared_file(file_name, cp_text.str(), FlowSol);
+      return;
     }
-  
-  FlowSol->coeff_lift = coeff_lift_global;
-  FlowSol->coeff_drag = coeff_drag_global;
-
 #endif
 
-  // Calculate body forcing, if running periodic channel, and add to viscous flux
-  if(run_input.equation==0 and run_input.forcing==1 and FlowSol->n_dims==3) {
-    for(int i=0;i<FlowSol->n_ele_types;i++)
-      FlowSol->mesh_eles(i)->calc_body_force_upts(FlowSol->vis_force, FlowSol->body_force);
-  }
-
-  if (write_forces) { coeff_file.close(); }
+  if (write_forces) { cp_file.close(); }
 }
 
 // Calculate integral diagnostic quantities
@@ -1053,30 +1496,20 @@ void CalcIntegralQuantities(int in_file_num, struct solution* FlowSol) {
 
   int nintq = run_input.n_integral_quantities;
 
+  // initialize to zero
+  for(int j=0;j<nintq;++j)
+    {
+      FlowSol->integral_quantities(j) = 0.0;
+    }
+
   // Loop over element types
   for(int i=0;i<FlowSol->n_ele_types;i++)
     {
       if (FlowSol->mesh_eles(i)->get_n_eles()!=0)
         {
-          // initialize to zero
-          for(int j=0;j<nintq;++j)
-            {
-              FlowSol->integral_quantities(j) = 0.0;
-            }
           FlowSol->mesh_eles(i)->CalcIntegralQuantities(nintq, FlowSol->integral_quantities);
         }
     }
-
-#ifdef _MPI
-
-  array<double> integral_quantities_global(nintq);
-  for(int j=0;j<nintq;++j)
-    {
-      integral_quantities_global(j) = 0.0;
-      MPI_Reduce(&FlowSol->integral_quantities(j),&integral_quantities_global(j),1,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD);
-      FlowSol->integral_quantities(j) = integral_quantities_global(j);
-    }
-#endif
   
 }
 
@@ -1247,42 +1680,56 @@ void compute_error(int in_file_num, struct solution* FlowSol)
 
 }
 
-void CalcNormResidual(struct solution* FlowSol) {
+int CalcResidualSums(double* out_sums, struct solution* FlowSol) {
   
   int i, j, n_upts = 0, n_fields;
-  double sum[5] = {0.0, 0.0, 0.0, 0.0, 0.0}, norm[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+  double cell_sum;
   
-  if (FlowSol->n_dims==2) n_fields = 4;
+  if (run_input.equation==1) n_fields = 1;
+  else if (FlowSol->n_dims==2) n_fields = 4;
   else n_fields = 5;
   
+  if (run_input.res_norm_type < 0 || run_input.res_norm_type > 2)
+    FatalError("norm_type not recognized");
+  
+  for(j=0; j<n_fields; j++) out_sums[j] = 0.0;
+  
   for(i=0; i<FlowSol->n_ele_types; i++) {
     if (FlowSol->mesh_eles(i)->get_n_eles() != 0) {
-      FlowSol->mesh_eles(i)->cp_div_tconf_upts_gpu_cpu();
+      // The fused norms were accumulated on the host by the last RK stage
+      if (!run_input.res_norm_fused)
+        FlowSol->mesh_eles(i)->cp_div_tconf_upts_gpu_cpu();
       n_upts += FlowSol->mesh_eles(i)->get_n_eles()*FlowSol->mesh_eles(i)->get_n_upts_per_ele();
-      for(j=0; j<n_fields; j++)
-        sum[j] += FlowSol->mesh_eles(i)->compute_res_upts(run_input.res_norm_type, j);
+      for(j=0; j<n_fields; j++) {
+        if (run_input.res_norm_fused)
+          cell_sum = FlowSol->mesh_eles(i)->get_res_norm_sum(j);
+        else
+          cell_sum = FlowSol->mesh_eles(i)->compute_res_upts(run_input.res_norm_type, j);
+        
+        if (run_input.res_norm_type==0) out_sums[j] = max(out_sums[j], cell_sum);
+        else out_sums[j] += cell_sum;
+      }
     }
   }
   
-#ifdef _MPI
-  
-  int n_upts_global = 0;
-  double sum_global[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
-  MPI_Reduce(&n_upts, &n_upts_global, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
-  MPI_Reduce(sum, sum_global, 5, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  return n_upts;
+}
+
+void CalcNormResidual(double* in_sums, double in_n_upts, struct solution* FlowSol) {
   
-  n_upts = n_upts_global;
-  for(i=0; i<n_fields; i++) sum[i] = sum_global[i];
+  int i, n_fields;
   
-#endif
+  if (run_input.equation==1) n_fields = 1;
+  else if (FlowSol->n_dims==2) n_fields = 4;
+  else n_fields = 5;
   
   if (FlowSol->rank == 0) {
     
     // Compute the norm
     for(i=0; i<n_fields; i++) {
-      if (run_input.res_norm_type==1) { FlowSol->norm_residual(i) = sum[i] / n_upts; } // L1 norm
-      else if (run_input.res_norm_type==2) { FlowSol->norm_residual(i) = sqrt(sum[i]) / n_upts; } // L2 norm
-      else FatalError("norm_type not recognized");
+      if (run_input.res_norm_type==0) { FlowSol->norm_residual(i) = in_sums[i]; } // Infinity norm
+      else if (run_input.res_norm_type==1) { FlowSol->norm_residual(i) = in_sums[i] / in_n_upts; } // L1 norm
+      else { FlowSol->norm_residual(i) = sqrt(in_sums[i]) / in_n_upts; } // L2 norm
       
       if (isnan(FlowSol->norm_residual(i))) {
         FatalError("NaN residual encountered. Exiting");
@@ -1291,16 +1738,16 @@ void CalcNormResidual(struct solution* FlowSol) {
   }
 }
 
-void HistoryOutput(int in_file_num, clock_t init, ofstream *write_hist, struct solution* FlowSol) {
+void HistoryOutput(int in_file_num, double in_time, clock_t init, ofstream *write_hist, struct solution* FlowSol) {
   
   int i, n_fields;
   clock_t final;
   // TODO: write heads when starting from a restart file
   bool open_hist, write_heads;
   int n_diags = run_input.n_integral_quantities;
-  double in_time = FlowSol->time;
   
-  if (FlowSol->n_dims==2) n_fields = 4;
+  if (run_input.equation==1) n_fields = 1;
+  else if (FlowSol->n_dims==2) n_fields = 4;
   else n_fields = 5;
   
   // set write flag
@@ -1340,7 +1787,9 @@ void HistoryOutput(int in_file_num, clock_t init, ofstream *write_hist, struct s
     
     // Write the header
     if (write_heads) {
-      if (FlowSol->n_dims==2) cout << "\n  Iter       Res[Rho]   Res[RhoVelx]   Res[RhoVely]      Res[RhoE]       Fx_Total       Fy_Total" << endl;
+      if (run_input.equation==1 && FlowSol->n_dims==2) cout << "\n  Iter         Res[u]       Fx_Total       Fy_Total" << endl;
+      else if (run_input.equation==1) cout << "\n  Iter         Res[u]       Fx_Total       Fy_Total       Fz_Total" << endl;
+      else if (FlowSol->n_dims==2) cout << "\n  Iter       Res[Rho]   Res[RhoVelx]   Res[RhoVely]      Res[RhoE]       Fx_Total       Fy_Total" << endl;
       else cout <<  "\n  Iter       Res[Rho]   Res[RhoVelx]   Res[RhoVely]   Res[RhoVelz]      Res[RhoE]       Fx_Total       Fy_Total       Fz_Total" << endl;
     }
     
@@ -1376,6 +1825,117 @@ void HistoryOutput(int in_file_num, clock_t init, ofstream *write_hist, struct s
   }
 }
 
+void MemoryReport(const char* in_stage, struct solution* FlowSol)
+{
+  int i, j, n_tags, n_tags_min, n_tags_max;
+  const int n_groups = FlowSol->n_ele_types+1; // one group per element type, plus everything else
+  const double MB = 1024.*1024.;
+
+  // Name the element arrays so that their storage is charged to "<type>/<array>"
+  for (i=0; i<FlowSol->n_ele_types; i++)
+    FlowSol->mesh_eles(i)->tag_arrays();
+
+  n_tags = mem_n_tags();
+
+  // Local bytes per tag and per group, degrees of freedom per element type, and high-water mark
+  array<double> tag_bytes(n_tags), group_bytes(n_groups), group_dofs(n_groups), peak(1);
+
+  for (i=0; i<n_tags; i++)
+    tag_bytes(i) = (double) mem_tag_bytes(i);
+
+  group_bytes.initialize_to_zero();
+  group_dofs.initialize_to_zero();
+  for (j=0; j<FlowSol->n_ele_types; j++) {
+    group_dofs(j) = (double) FlowSol->mesh_eles(j)->get_n_eles()*FlowSol->mesh_eles(j)->get_n_upts_per_ele()*FlowSol->mesh_eles(j)->get_n_fields();
+  }
+  const char* group_names[5] = {"tris/", "quads/", "tets/", "pris/", "hexas/"};
+  for (i=0; i<n_tags; i++) {
+    int group = n_groups-1;
+    for (j=0; j<FlowSol->n_ele_types; j++)
+      if (!strncmp(mem_tag_name(i), group_names[j], strlen(group_names[j])))
+        group = j;
+    group_bytes(group) += tag_bytes(i);
+  }
+  peak(0) = (double) mem_total_peak();
+
+  array<double> tag_bytes_global(n_tags), group_bytes_global(n_groups), group_dofs_global(n_groups), peak_max(1), peak_sum(1);
+
+#ifdef _MPI
+  // Tags are registered in the same order on every rank (by tag_arrays), so they can be summed by id
+  MPI_Allreduce(&n_tags, &n_tags_min, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&n_tags, &n_tags_max, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if (n_tags_min == n_tags_max)
+    MPI_Reduce(tag_bytes.get_ptr_cpu(), tag_bytes_global.get_ptr_cpu(), n_tags, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  else
+    tag_bytes_global = tag_bytes;
+  MPI_Reduce(group_bytes.get_ptr_cpu(), group_bytes_global.get_ptr_cpu(), n_groups, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  MPI_Reduce(group_dofs.get_ptr_cpu(), group_dofs_global.get_ptr_cpu(), n_groups, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  MPI_Reduce(peak.get_ptr_cpu(), peak_max.get_ptr_cpu(), 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(peak.get_ptr_cpu(), peak_sum.get_ptr_cpu(), 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+#else
+  n_tags_min = n_tags_max = n_tags;
+  tag_bytes_global = tag_bytes;
+  group_bytes_global = group_bytes;
+  group_dofs_global = group_dofs;
+  peak_max = peak;
+  peak_sum = peak;
+#endif
+
+  if (FlowSol->rank == 0) {
+    const char* group_labels[6] = {"tris", "quads", "tets", "pris", "hexas", "other"};
+    double total = 0., total_dofs = 0.;
+
+    cout << endl << "Memory report (" << in_stage << "), all ranks:" << endl;
+    printf("  %-10s %14s %14s %12s\n", "group", "MB", "DOFs", "bytes/DOF");
+    for (j=0; j<n_groups; j++) {
+      total += group_bytes_global(j);
+      total_dofs += group_dofs_global(j);
+      if (j < n_groups-1 && group_dofs_global(j) == 0.)
+        continue;
+      if (j < n_groups-1)
+        printf("  %-10s %14.3f %14.0f %12.1f\n", group_labels[j], group_bytes_global(j)/MB, group_dofs_global(j), group_bytes_global(j)/group_dofs_global(j));
+      else
+        printf("  %-10s %14.3f\n", group_labels[j], group_bytes_global(j)/MB);
+    }
+    printf("  %-10s %14.3f %14.0f %12.1f\n", "total", total/MB, total_dofs, (total_dofs > 0.) ? total/total_dofs : 0.);
+    printf("  peak: %.3f MB summed over ranks, %.3f MB on the largest rank\n", peak_sum(0)/MB, peak_max(0)/MB);
+    printf("  small-array pool on rank 0: %.3f MB reserved\n", mem_pool_reserved_bytes()/MB);
+
+    if (run_input.monitor_memory == 2) {
+      if (n_tags_min != n_tags_max)
+        cout << "  per-array breakdown (rank 0 only, memory tags differ between ranks):" << endl;
+      else
+        cout << "  per-array breakdown:" << endl;
+      for (i=0; i<n_tags; i++)
+        if (tag_bytes_global(i) >= 1024.) // skip placeholder (unused) arrays
+          printf("    %-40s %14.3f MB\n", mem_tag_name(i), tag_bytes_global(i)/MB);
+    }
+  }
+}
+
+void TimingOutput(int in_n_steps, double in_t_loop, double in_t_residual, double in_t_update, double in_t_monitor, double in_t_plot, double in_t_restart, struct solution* FlowSol)
+{
+  int i;
+  const int n_timers = 6;
+  const char* timer_names[n_timers] = {"total", "residual", "update", "monitor", "plot", "restart"};
+  double timers[n_timers] = {in_t_loop, in_t_residual, in_t_update, in_t_monitor, in_t_plot, in_t_restart};
+  double timers_max[n_timers];
+
+#ifdef _MPI
+  // The slowest rank sets the pace, so report the maximum over all ranks
+  MPI_Reduce(timers, timers_max, n_timers, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+#else
+  for (i=0; i<n_timers; i++)
+    timers_max[i] = timers[i];
+#endif
+
+  if (FlowSol->rank == 0) {
+    cout << endl << "Timing summary: " << in_n_steps << " steps, wall-clock seconds (max over ranks)" << endl;
+    for (i=0; i<n_timers; i++)
+      printf("timer %-10s %14.6f\n", timer_names[i], timers_max[i]);
+  }
+}
+
 void check_stability(struct solution* FlowSol)
 {
   int n_fields;
@@ -0,0 +1,235 @@
+/*!
+ * \file output_writer.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/output_writer.h"
+#include "../include/output.h"
+#include "../include/mem_tracker.h"
+#include "../include/error.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+// entry point of the writer thread
+
+static void* output_writer_thread(void* in_writer)
+{
+  ((output_writer*) in_writer)->run();
+  return NULL;
+}
+
+// #### constructors ####
+
+// default constructor
+
+output_writer::output_writer()
+{
+  sol = NULL;
+  active = false;
+  stop = false;
+  n_queued = 0;
+  for (int b=0; b<N_OUTPUT_BUFFERS; b++)
+    buf_state[b] = 0;
+}
+
+// default destructor
+
+output_writer::~output_writer()
+{
+  finish();
+}
+
+// #### methods ####
+
+// allocate the snapshots and start the writer thread
+
+void output_writer::setup(struct solution* FlowSol)
+{
+  sol = FlowSol;
+
+  if (run_input.extract_freq)
+    Extract.setup(FlowSol);
+
+  if (!run_input.async_output)
+    return;
+
+#ifdef _MPI
+  // The writer thread makes no MPI calls, but other threads may only exist next to MPI from this level on
+  int thread_level;
+  MPI_Query_thread(&thread_level);
+  if (thread_level < MPI_THREAD_FUNNELED)
+    FatalError("async_output needs an MPI library that provides MPI_THREAD_FUNNELED");
+#endif
+
+  // The plot point positions are cached here, as the arrays of the writer thread are not accounted (see run)
+  for (int i=0; i<FlowSol->n_ele_types; i++) {
+    FlowSol->mesh_eles(i)->setup_output_buffers(N_OUTPUT_BUFFERS);
+    FlowSol->mesh_eles(i)->get_pos_ppts();
+  }
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&cond, NULL);
+  stop = false;
+
+  if (pthread_create(&thread, NULL, output_writer_thread, this) != 0)
+    FatalError("Unable to start the output writer thread");
+  active = true;
+}
+
+// write a plot or restart file, or queue a snapshot of the solution for the writer thread
+
+void output_writer::write(int in_file_num, int in_type, struct solution* FlowSol)
+{
+  int b;
+
+  if (!active) {
+    if (in_type == 1) write_restart(in_file_num, FlowSol);
+    else if (in_type == 2) Extract.write(in_file_num, FlowSol->time, FlowSol);
+    else if (FlowSol->write_type == 0) write_vtu(in_file_num, FlowSol);
+    else if (FlowSol->write_type == 1) write_tec(in_file_num, FlowSol->time, FlowSol);
+    else if (FlowSol->write_type == 2) write_tec_bin(in_file_num, FlowSol->time, FlowSol);
+    else FatalError("ERROR: Trying to write unrecognized file format ... ");
+    return;
+  }
+
+  if (in_type == 0 && (FlowSol->write_type < 0 || FlowSol->write_type > 2))
+    FatalError("ERROR: Trying to write unrecognized file format ... ");
+
+  pthread_mutex_lock(&lock);
+
+  // A snapshot of this step not yet picked up by the writer serves both the plot and restart file
+  for (b=0; b<N_OUTPUT_BUFFERS; b++) {
+    if (buf_state[b] == 1 && buf_file_num[b] == in_file_num) {
+      if (in_type == 1) buf_restart[b] = true;
+      else if (in_type == 2) buf_extract[b] = true;
+      else buf_plot[b] = true;
+      pthread_mutex_unlock(&lock);
+      return;
+    }
+  }
+
+  // Back-pressure: wait for the writer to free a snapshot
+  while (true) {
+    for (b=0; b<N_OUTPUT_BUFFERS; b++)
+      if (buf_state[b] == 0)
+        break;
+    if (b < N_OUTPUT_BUFFERS)
+      break;
+    pthread_cond_wait(&cond, &lock);
+  }
+
+  pthread_mutex_unlock(&lock);
+
+  // Free snapshots are only touched by this thread, so the copy needs no lock
+  for (int i=0; i<FlowSol->n_ele_types; i++)
+    FlowSol->mesh_eles(i)->stage_output(b);
+
+  pthread_mutex_lock(&lock);
+  buf_file_num[b] = in_file_num;
+  buf_time[b] = FlowSol->time;
+  buf_plot[b] = (in_type == 0);
+  buf_restart[b] = (in_type == 1);
+  buf_extract[b] = (in_type == 2);
+  buf_seq[b] = n_queued++;
+  buf_state[b] = 1;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+}
+
+// wait for the pending files and stop the writer thread
+
+void output_writer::finish(void)
+{
+  if (!active)
+    return;
+
+  pthread_mutex_lock(&lock);
+  stop = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+
+  pthread_join(thread, NULL);
+  active = false;
+
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&lock);
+}
+
+// write the queued snapshots in the order they were taken, until stopped with an empty queue
+
+void output_writer::run(void)
+{
+  int b, next;
+
+  // The pool keeps free lists per thread; the temporaries of this thread are left out of the memory report
+  mem_track_ignore_thread();
+
+  pthread_mutex_lock(&lock);
+
+  while (true) {
+    next = -1;
+    for (b=0; b<N_OUTPUT_BUFFERS; b++)
+      if (buf_state[b] == 1 && (next < 0 || buf_seq[b] < buf_seq[next]))
+        next = b;
+
+    if (next < 0) {
+      if (stop)
+        break;
+      pthread_cond_wait(&cond, &lock);
+      continue;
+    }
+
+    buf_state[next] = 2;
+    pthread_mutex_unlock(&lock);
+
+    for (int i=0; i<sol->n_ele_types; i++)
+      sol->mesh_eles(i)->set_output_buffer(next);
+
+    if (buf_plot[next]) {
+      if (sol->write_type == 0) write_vtu(buf_file_num[next], sol);
+      else if (sol->write_type == 1) write_tec(buf_file_num[next], buf_time[next], sol);
+      else write_tec_bin(buf_file_num[next], buf_time[next], sol);
+    }
+    if (buf_restart[next])
+      write_restart(buf_file_num[next], sol);
+    if (buf_extract[next])
+      Extract.write(buf_file_num[next], buf_time[next], sol);
+
+    for (int i=0; i<sol->n_ele_types; i++)
+      sol->mesh_eles(i)->set_output_buffer(-1);
+
+    pthread_mutex_lock(&lock);
+    buf_state[next] = 0;
+    pthread_cond_broadcast(&cond);
+  }
+
+  pthread_mutex_unlock(&lock);
+}
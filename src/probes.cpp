@@ -0,0 +1,277 @@
+/*!
+ * \file probes.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <climits>
+#include <sys/stat.h>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/probes.h"
+#include "../include/error.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+/*! relative growth of the element bounding boxes when looking for the elements of a probe (for curved elements) */
+#define PROBE_BOX_TOL 1.e-2
+
+// orders probes by element type, then element
+
+struct probe_ele_less
+{
+  const int* type;
+  const int* ele;
+
+  bool operator()(int a, int b) const
+  {
+    return type[a] < type[b] || (type[a] == type[b] && ele[a] < ele[b]);
+  }
+};
+
+// #### constructors ####
+
+// default constructor
+
+probes::probes()
+{
+  n_fields = 0;
+  n_probes = 0;
+  n_groups = 0;
+  n_buffered = 0;
+}
+
+// default destructor
+
+probes::~probes() { }
+
+// #### methods ####
+
+// read the probe list, locate the probes and precompute their weights
+
+void probes::setup(struct solution* FlowSol)
+{
+  int n_dims = FlowSol->n_dims;
+  int n_all, n_values, n_found, max_upts;
+  double value;
+  char file_name_s[100];
+  struct stat st = {0};
+
+  n_fields = (run_input.equation == 0) ? n_dims+2 : 1;
+
+  // Read the probe positions, n_dims coordinates each
+  ifstream list(run_input.probe_file.c_str());
+  if (!list)
+    FatalError("Unable to open probe_file");
+
+  n_values = 0;
+  while (list >> value)
+    n_values++;
+  if (n_values == 0 || n_values % n_dims != 0)
+    FatalError("probe_file must hold n_dims coordinates per probe");
+  n_all = n_values/n_dims;
+
+  array<double> all_pos(n_dims,n_all);
+  list.clear();
+  list.seekg(0);
+  for (int p=0; p<n_all; p++)
+    for (int m=0; m<n_dims; m++)
+      list >> all_pos(m,p);
+  list.close();
+
+  // Locate the probes: candidate elements from the index, then the reference location by Newton iterations
+  Index.setup(FlowSol);
+
+  array<int> found(max(Index.get_n_items(),1));
+  array<int> owner(n_all), all_type(n_all), all_ele(n_all);
+  array<double> all_loc(n_dims,n_all);
+  array<double> pos(n_dims), loc(n_dims);
+
+  for (int p=0; p<n_all; p++) {
+      owner(p) = INT_MAX;
+      for (int m=0; m<n_dims; m++)
+        pos(m) = all_pos(m,p);
+
+      Index.query_point(pos.get_ptr_cpu(),PROBE_BOX_TOL,found,n_found);
+
+      for (int k=0; k<n_found; k++) {
+          int i = Index.get_type(found(k));
+          int ele = Index.get_ele(found(k));
+          if (FlowSol->mesh_eles(i)->calc_loc_of_pos(pos,ele,loc)) {
+              owner(p) = FlowSol->rank;
+              all_type(p) = i;
+              all_ele(p) = ele;
+              for (int m=0; m<n_dims; m++)
+                all_loc(m,p) = loc(m);
+              break;
+            }
+        }
+    }
+
+  // A probe on a partition boundary belongs to the lowest rank holding it
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE,owner.get_ptr_cpu(),n_all,MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+#endif
+
+  if (FlowSol->rank == 0)
+    for (int p=0; p<n_all; p++)
+      if (owner(p) == INT_MAX)
+        cout << "WARNING: probe " << p << " is outside the mesh and is skipped" << endl;
+
+  // Probes of this rank, ordered by element so that the probes of an element are evaluated together
+  n_probes = 0;
+  for (int p=0; p<n_all; p++)
+    if (owner(p) == FlowSol->rank)
+      n_probes++;
+
+  if (n_probes > 0) {
+      array<int> order(n_probes);
+      int q = 0;
+      for (int p=0; p<n_all; p++)
+        if (owner(p) == FlowSol->rank)
+          order(q++) = p;
+
+      probe_ele_less less;
+      less.type = all_type.get_ptr_cpu();
+      less.ele = all_ele.get_ptr_cpu();
+      sort(order.get_ptr_cpu(),order.get_ptr_cpu()+n_probes,less);
+
+      max_upts = 0;
+      for (int i=0; i<FlowSol->n_ele_types; i++)
+        if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+          max_upts = max(max_upts,FlowSol->mesh_eles(i)->get_n_upts_per_ele());
+
+      probe_id.setup(n_probes);
+      probe_type.setup(n_probes);
+      probe_ele.setup(n_probes);
+      probe_pos.setup(n_dims,n_probes);
+      weights.setup(max_upts,n_probes);
+      group_first.setup(n_probes+1);
+
+      n_groups = 0;
+      for (q=0; q<n_probes; q++) {
+          int p = order(q);
+          probe_id(q) = p;
+          probe_type(q) = all_type(p);
+          probe_ele(q) = all_ele(p);
+          for (int m=0; m<n_dims; m++) {
+              probe_pos(m,q) = all_pos(m,p);
+              loc(m) = all_loc(m,p);
+            }
+
+          for (int j=0; j<max_upts; j++)
+            weights(j,q) = 0.;
+          for (int j=0; j<FlowSol->mesh_eles(probe_type(q))->get_n_upts_per_ele(); j++)
+            weights(j,q) = FlowSol->mesh_eles(probe_type(q))->eval_nodal_basis(j,loc);
+
+          if (q == 0 || probe_type(q) != probe_type(q-1) || probe_ele(q) != probe_ele(q-1))
+            group_first(n_groups++) = q;
+        }
+      group_first(n_groups) = n_probes;
+
+      samples.setup(n_probes,n_fields,run_input.probe_flush_freq);
+      sample_step.setup(run_input.probe_flush_freq);
+      sample_time.setup(run_input.probe_flush_freq);
+    }
+
+  // Master node creates the directory of the probe files
+  if (FlowSol->rank == 0 && stat("probe_files", &st) == -1)
+    mkdir("probe_files", 0755);
+
+#ifdef _MPI
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+  if (n_probes == 0)
+    return;
+
+  // File header
+  sprintf(file_name_s,"probe_files/probes_%.09d_p%.04d.bin",FlowSol->ini_iter,FlowSol->rank);
+  file_name = file_name_s;
+
+  ofstream file(file_name.c_str(), ios::binary | ios::trunc);
+  if (!file)
+    FatalError("Unable to open probe file");
+
+  file.write((char*) &n_dims, sizeof(int));
+  file.write((char*) &n_fields, sizeof(int));
+  file.write((char*) &n_probes, sizeof(int));
+  for (int q=0; q<n_probes; q++) {
+      file.write((char*) probe_id.get_ptr_cpu(q), sizeof(int));
+      file.write((char*) probe_pos.get_ptr_cpu(0,q), n_dims*sizeof(double));
+    }
+  file.close();
+}
+
+// evaluate the solution at the probes, one product per element holding probes
+
+void probes::sample(int in_step, struct solution* FlowSol)
+{
+  if (n_probes == 0)
+    return;
+
+  double* out = samples.get_ptr_cpu(0,0,n_buffered);
+
+  for (int g=0; g<n_groups; g++) {
+      int q = group_first(g);
+      int n = group_first(g+1)-q;
+
+      FlowSol->mesh_eles(probe_type(q))->calc_disu_weights(probe_ele(q),n,weights.get_ptr_cpu(0,q),weights.get_dim(0),out+q,n_probes);
+    }
+
+  sample_step(n_buffered) = in_step;
+  sample_time(n_buffered) = FlowSol->time;
+  n_buffered++;
+
+  if (n_buffered == run_input.probe_flush_freq)
+    flush();
+}
+
+// append the buffered samples to the file
+
+void probes::flush(void)
+{
+  if (n_probes == 0 || n_buffered == 0)
+    return;
+
+  ofstream file(file_name.c_str(), ios::binary | ios::app);
+  if (!file)
+    FatalError("Unable to open probe file");
+
+  for (int s=0; s<n_buffered; s++) {
+      file.write((char*) sample_step.get_ptr_cpu(s), sizeof(int));
+      file.write((char*) sample_time.get_ptr_cpu(s), sizeof(double));
+      file.write((char*) samples.get_ptr_cpu(0,0,s), n_probes*n_fields*sizeof(double));
+    }
+  file.close();
+
+  n_buffered = 0;
+}
@@ -26,6 +26,9 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <climits>
+#include <cstdio>
+#include <algorithm>
 
 #include "../include/global.h"
 #include "../include/array.h"
@@ -53,6 +56,9 @@
 
 using namespace std;
 
+// wall-clock seconds spent in CalcResidual, over all calls
+static double residual_time = 0.0;
+
 #define MAX_V_PER_F 4
 #define MAX_F_PER_C 6
 #define MAX_E_PER_C 12
@@ -62,11 +68,12 @@ using namespace std;
 #define MULTI_ZONE
 //#define SINGLE_ZONE
 
-void CalcResidual(struct solution* FlowSol) {
+void CalcResidual(struct solution* FlowSol, int in_mpi_exchange) {
 
   int in_disu_upts_from = 0;        /*!< Define... */
   int in_div_tconf_upts_to = 0;     /*!< Define... */
   int i;                            /*!< Loop iterator */
+  double t_start = wall_time();
 
   /*! If at first RK step and using certain LES models, compute some model-related quantities. */
   if(run_input.LES==1 && in_disu_upts_from==0) {
@@ -82,7 +89,7 @@ void CalcResidual(struct solution* FlowSol) {
 
 #ifdef _MPI
   /*! Send the solution at the flux points across the MPI interfaces. */
-  if (FlowSol->nproc>1)
+  if (FlowSol->nproc>1 && in_mpi_exchange)
     for(i=0; i<FlowSol->n_mpi_inter_types; i++)
       FlowSol->mesh_mpi_inters(i).send_solution();
 #endif
@@ -114,8 +121,9 @@ void CalcResidual(struct solution* FlowSol) {
 #ifdef _MPI
   /*! Send the previously computed values across the MPI interfaces. */
   if (FlowSol->nproc>1) {
-      for(i=0; i<FlowSol->n_mpi_inter_types; i++)
-        FlowSol->mesh_mpi_inters(i).receive_solution();
+      if (in_mpi_exchange)
+        for(i=0; i<FlowSol->n_mpi_inter_types; i++)
+          FlowSol->mesh_mpi_inters(i).receive_solution();
 
       for(i=0; i<FlowSol->n_mpi_inter_types; i++)
         FlowSol->mesh_mpi_inters(i).calculate_common_invFlux();
@@ -132,7 +140,7 @@ void CalcResidual(struct solution* FlowSol) {
 
 #ifdef _MPI
       /*! Send the corrected value and SGS flux across the MPI interface. */
-      if (FlowSol->nproc>1) {
+      if (FlowSol->nproc>1 && in_mpi_exchange) {
           for(i=0; i<FlowSol->n_mpi_inter_types; i++)
             FlowSol->mesh_mpi_inters(i).send_corrected_gradient();
 
@@ -173,12 +181,14 @@ void CalcResidual(struct solution* FlowSol) {
 #if _MPI
       /*! Evaluate the MPI interfaces. */
       if (FlowSol->nproc>1) {
-          for(i=0; i<FlowSol->n_mpi_inter_types; i++)
-            FlowSol->mesh_mpi_inters(i).receive_corrected_gradient();
-
-          if (run_input.LES) {
+          if (in_mpi_exchange) {
             for(i=0; i<FlowSol->n_mpi_inter_types; i++)
-            FlowSol->mesh_mpi_inters(i).receive_sgsf_fpts();
+              FlowSol->mesh_mpi_inters(i).receive_corrected_gradient();
+
+            if (run_input.LES) {
+              for(i=0; i<FlowSol->n_mpi_inter_types; i++)
+              FlowSol->mesh_mpi_inters(i).receive_sgsf_fpts();
+            }
           }
 
           for(i=0; i<FlowSol->n_mpi_inter_types; i++)
@@ -191,6 +201,84 @@ void CalcResidual(struct solution* FlowSol) {
   for(i=0; i<FlowSol->n_ele_types; i++)
     FlowSol->mesh_eles(i)->calculate_corrected_divergence(in_div_tconf_upts_to);
 
+  residual_time += wall_time()-t_start;
+}
+
+// Wall-clock time spent in CalcResidual so far
+
+double CalcResidualTime(void) {
+  return residual_time;
+}
+
+// Time steps from the CFL number. The global minimum is taken with a single reduction per step over all element
+// types and partitions, so mixed meshes advance every element type with the same step
+
+double CalcTimeStep(struct solution* FlowSol)
+{
+  double dt = 1e12;
+
+  if (run_input.dt_type != 1 && run_input.dt_type != 2)
+    return run_input.dt;
+
+#ifdef _CPU
+  int i;
+
+  for(i=0; i<FlowSol->n_ele_types; i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      dt = min(dt,FlowSol->mesh_eles(i)->calc_dt());
+
+  if (run_input.dt_type == 2)
+    return run_input.dt;
+
+#ifdef _MPI
+  double dt_global;
+  MPI_Allreduce(&dt,&dt_global,1,MPI_DOUBLE,MPI_MIN,MPI_COMM_WORLD);
+  dt = dt_global;
+#endif
+
+  for(i=0; i<FlowSol->n_ele_types; i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      FlowSol->mesh_eles(i)->set_dt_global(dt);
+
+  return dt;
+#else
+  return run_input.dt;
+#endif
+}
+
+// Accept the RK step if its embedded error, scaled by rk_tol*max(1,|u|), is at most one at every solution point. The
+// maximum rather than an average catches an instability while it is still confined to a few elements
+
+double AdaptTimeStep(struct solution* FlowSol)
+{
+  int i;
+  double dt_step = run_input.dt;
+  double err = 0.;
+
+  for(i=0; i<FlowSol->n_ele_types; i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+      err = max(err,FlowSol->mesh_eles(i)->calc_rk_error());
+
+#ifdef _MPI
+  double err_global;
+  MPI_Allreduce(&err,&err_global,1,MPI_DOUBLE,MPI_MAX,MPI_COMM_WORLD);
+  err = err_global;
+#endif
+
+  if (err > 1.) {
+      for(i=0; i<FlowSol->n_ele_types; i++)
+        if (FlowSol->mesh_eles(i)->get_n_eles() != 0)
+          FlowSol->mesh_eles(i)->restore_rk_solution();
+
+      if (FlowSol->rank == 0)
+        cout << "Step rejected, error " << err << " at dt " << run_input.dt << endl;
+
+      dt_step = 0.;
+    }
+
+  run_input.dt = FlowSol->rk.calc_new_dt(run_input.dt, err);
+
+  return dt_step;
 }
 
 #ifdef _MPI
@@ -280,7 +368,7 @@ double* get_grad_disu_fpts_ptr(int in_ele_type, int in_ele, int in_local_inter,
 }
 
 // get pointer to the discontinuous solution (close normal) at a flux point
-double* get_normal_disu_fpts_ptr(int in_ele_type, int in_ele, int in_local_inter, int in_field, int in_fpt, struct solution* FlowSol, array<double> temp_loc, double temp_pos[3])
+double* get_normal_disu_fpts_ptr(int in_ele_type, int in_ele, int in_local_inter, int in_field, int in_fpt, struct solution* FlowSol, array<double>& temp_loc, double temp_pos[3])
 {
   return FlowSol->mesh_eles(in_ele_type)->get_normal_disu_fpts_ptr(in_fpt,in_local_inter,in_field,in_ele, temp_loc, temp_pos);
 }
@@ -332,6 +420,13 @@ void read_restart(int in_file_num, int in_n_files, struct solution* FlowSol)
   ifstream restart_file;
   restart_file.precision(15);
 
+  // A shared restart file written with mpiio_output holds one section per writing rank
+  if (read_shared_restart(in_file_num, FlowSol))
+    {
+      cout << "Rank=" << FlowSol->rank << " Done reading restart files" << endl;
+      return;
+    }
+
   // Open the restart files and read info
 
   for (int i=0;i<FlowSol->n_ele_types;i++) {
@@ -380,3 +475,166 @@ void read_restart(int in_file_num, int in_n_files, struct solution* FlowSol)
   cout << "Rank=" << FlowSol->rank << " Done reading restart files" << endl;
 }
 
+// read the info and the data of this rank's element types from one section of a shared restart file
+
+static void read_restart_part(const string& in_text, array<int>& info_found, struct solution* FlowSol)
+{
+  for (int i=0;i<FlowSol->n_ele_types;i++) {
+      if (FlowSol->mesh_eles(i)->get_n_eles()!=0) {
+
+          // a fresh stream per element type, so that a type missing from the section does not hide the next ones
+          if (!info_found(i)) {
+              istringstream section(in_text);
+              section >> FlowSol->time;
+              info_found(i) = FlowSol->mesh_eles(i)->read_restart_info(section);
+            }
+
+          if (info_found(i)) {
+              istringstream section(in_text);
+              FlowSol->mesh_eles(i)->read_restart_data(section);
+            }
+        }
+    }
+}
+
+// read a shared restart file, collectively in parallel: each rank reads the sections that hold its own cells
+
+bool read_shared_restart(int in_file_num, struct solution* FlowSol)
+{
+  char file_name_s[50], header_s[SHARED_RESTART_HEADER_BYTES+1];
+  string keyword, section_text;
+  int i, n_sections, n_cells, n_needed, n_rounds;
+  long long n_bytes;
+  array<long long> index;
+  array<int> needed, info_found(FlowSol->n_ele_types);
+
+  sprintf(file_name_s,"Rest_%.09d.dat",in_file_num);
+  header_s[SHARED_RESTART_HEADER_BYTES] = '\0';
+
+#ifdef _MPI
+  MPI_File file;
+
+  if (MPI_File_open(MPI_COMM_WORLD, file_name_s, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+    return false;
+
+  /*! The header and the section index are small: rank 0 reads them and broadcasts them */
+  if (FlowSol->rank == 0)
+    MPI_File_read_at(file, 0, header_s, SHARED_RESTART_HEADER_BYTES, MPI_CHAR, MPI_STATUS_IGNORE);
+  MPI_Bcast(header_s, SHARED_RESTART_HEADER_BYTES, MPI_CHAR, 0, MPI_COMM_WORLD);
+#else
+  ifstream file(file_name_s, ios::binary);
+
+  if (!file)
+    return false;
+
+  file.read(header_s, SHARED_RESTART_HEADER_BYTES);
+#endif
+
+  istringstream header(header_s);
+  if (!(header >> keyword >> n_sections >> n_cells) || keyword != "restart_index" || n_sections < 1 || n_cells < 0)
+    FatalError("Corrupt header in shared restart file");
+
+  index.setup(2,n_sections);
+
+#ifdef _MPI
+  if (FlowSol->rank == 0)
+    MPI_File_read_at(file, SHARED_RESTART_HEADER_BYTES, index.get_ptr_cpu(), 2*n_sections, MPI_LONG_LONG, MPI_STATUS_IGNORE);
+  MPI_Bcast(index.get_ptr_cpu(), 2*n_sections, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+  /*! The section holding each cell of this rank, read collectively through a view of this rank's cells */
+  array<int> cells, cell_sections;
+  MPI_Datatype cells_type;
+  MPI_Offset cells_offset = SHARED_RESTART_HEADER_BYTES + 2*sizeof(long long)*(MPI_Offset) n_sections;
+  int n_cells_local = get_global_cells(cells, FlowSol);
+
+  if (n_cells_local > 0 && cells(n_cells_local-1) >= n_cells)
+    FatalError("The shared restart file was written for a different mesh");
+
+  cell_sections.setup(max(n_cells_local,1));
+  MPI_Type_create_indexed_block(n_cells_local, 1, cells.get_ptr_cpu(), MPI_INT, &cells_type);
+  MPI_Type_commit(&cells_type);
+  MPI_File_set_view(file, cells_offset, MPI_INT, cells_type, (char*) "native", MPI_INFO_NULL);
+  MPI_File_read_all(file, cell_sections.get_ptr_cpu(), n_cells_local, MPI_INT, MPI_STATUS_IGNORE);
+  MPI_File_set_view(file, 0, MPI_BYTE, MPI_BYTE, (char*) "native", MPI_INFO_NULL);
+  MPI_Type_free(&cells_type);
+
+  sort(cell_sections.get_ptr_cpu(), cell_sections.get_ptr_cpu()+n_cells_local);
+  n_needed = unique(cell_sections.get_ptr_cpu(), cell_sections.get_ptr_cpu()+n_cells_local) - cell_sections.get_ptr_cpu();
+  needed.setup(max(n_needed,1));
+  for (i=0;i<n_needed;i++)
+    needed(i) = cell_sections(i);
+
+  /*! Every rank takes part in each collective read, with an empty read once it has all its sections */
+  MPI_Allreduce(&n_needed, &n_rounds, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#else
+  file.read((char*) index.get_ptr_cpu(), 2*sizeof(long long)*n_sections);
+
+  /*! A single process holds all the cells */
+  n_needed = n_rounds = n_sections;
+  needed.setup(n_sections);
+  for (i=0;i<n_sections;i++)
+    needed(i) = i;
+#endif
+
+  for (i=0;i<FlowSol->n_ele_types;i++)
+    info_found(i) = 0;
+
+  for (i=0;i<n_rounds;i++)
+    {
+      n_bytes = 0;
+      if (i < n_needed) {
+          if (needed(i) < 0 || needed(i) >= n_sections)
+            FatalError("Corrupt cell index in shared restart file");
+          n_bytes = index(1,needed(i));
+          if (n_bytes > (long long) INT_MAX)
+            FatalError("A section of the shared restart file exceeds 2 GB");
+        }
+      section_text.resize(n_bytes);
+
+#ifdef _MPI
+      MPI_File_read_at_all(file, (MPI_Offset) (i < n_needed ? index(0,needed(i)) : 0), (void*) section_text.data(), (int) n_bytes, MPI_CHAR, MPI_STATUS_IGNORE);
+#else
+      file.seekg(index(0,needed(i)));
+      file.read(&section_text[0], n_bytes);
+      if (file.gcount() != n_bytes)
+        FatalError("Truncated section in shared restart file");
+#endif
+
+      if (i < n_needed)
+        read_restart_part(section_text, info_found, FlowSol);
+    }
+
+#ifdef _MPI
+  MPI_File_close(&file);
+#else
+  file.close();
+#endif
+
+  for (i=0;i<FlowSol->n_ele_types;i++)
+    if (FlowSol->mesh_eles(i)->get_n_eles()!=0 && !info_found(i))
+      FatalError("The shared restart file does not hold the cells of this rank");
+
+  return true;
+}
+
+// sorted global indices of the cells of this rank
+
+int get_global_cells(array<int>& out_cells, struct solution* FlowSol)
+{
+  int i, j, n_cells = 0;
+
+  for (i=0;i<FlowSol->n_ele_types;i++)
+    n_cells += FlowSol->mesh_eles(i)->get_n_eles();
+
+  out_cells.setup(max(n_cells,1));
+  n_cells = 0;
+  for (i=0;i<FlowSol->n_ele_types;i++)
+    for (j=0;j<FlowSol->mesh_eles(i)->get_n_eles();j++)
+      out_cells(n_cells++) = FlowSol->mesh_eles(i)->get_ele2global_ele(j);
+
+  /*! MPI file views need increasing displacements */
+  sort(out_cells.get_ptr_cpu(), out_cells.get_ptr_cpu()+n_cells);
+
+  return n_cells;
+}
+
@@ -0,0 +1,730 @@
+/*!
+ * \file statistics.cpp
+ * \author - Original code: SD++ developed by Patrice Castonguay, Antony Jameson,
+ *                          Peter Vincent, David Williams (alphabetical by surname).
+ *         - Current development: Aerospace Computing Laboratory (ACL)
+ *                                Aero/Astro Department. Stanford University.
+ * \version 0.1.0
+ *
+ * High Fidelity Large Eddy Simulation (HiFiLES) Code.
+ * Copyright (C) 2014 Aerospace Computing Laboratory (ACL).
+ *
+ * HiFiLES is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HiFiLES is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with HiFiLES.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <sys/stat.h>
+
+#include "../include/global.h"
+#include "../include/array.h"
+#include "../include/statistics.h"
+#include "../include/funcs.h"
+#include "../include/error.h"
+
+#ifdef _MPI
+#include "mpi.h"
+#endif
+
+using namespace std;
+
+/*! resolution of the positions that tell the bins apart, relative to the extent of the mesh */
+#define STATS_BIN_TOL 1.e-6
+
+/*! names of the element types in the statistics files, as in the restart files */
+static const char* stats_ele_names[5] = {"TRIS","QUADS","TETS","PRIS","HEXAS"};
+
+// orders points by their position, rounded to tol
+
+struct stats_pos_less
+{
+  const double* pos;
+  int stride;
+  int n_dims;
+  double tol;
+
+  bool operator()(int a, int b) const
+  {
+    for (int m=0; m<n_dims; m++) {
+        long long ka = llround(pos[a*stride+m]/tol);
+        long long kb = llround(pos[b*stride+m]/tol);
+        if (ka != kb)
+          return ka < kb;
+      }
+    return false;
+  }
+};
+
+// #### constructors ####
+
+// default constructor
+
+statistics::statistics()
+{
+  n_dims = 0;
+  n_fields = 0;
+  n_vars = 0;
+  n_cov = 0;
+  n_samples = 0;
+  n_bins = 0;
+  bin_tol = 0.;
+  n_prev_bins = 0;
+  n_prev_samples = 0;
+}
+
+// default destructor
+
+statistics::~statistics() { }
+
+// #### methods ####
+
+// choose the variables, allocate the moments and read those of the restart step
+
+void statistics::setup(struct solution* FlowSol)
+{
+  struct stat st = {0};
+  int k;
+
+  n_dims = FlowSol->n_dims;
+
+  for (int h=0; h<run_input.n_stats_homogeneous; h++)
+    if (run_input.stats_homogeneous(h) >= n_dims)
+      FatalError("stats_homogeneous direction beyond the dimensions of the mesh");
+
+  // Primitive variables and velocity covariances of the Navier-Stokes equations, the scalar and its variance otherwise
+  if (run_input.equation == 0) {
+      n_fields = n_dims+2;
+      n_vars = n_dims+2;
+      var_names.setup(n_vars);
+      var_names(0) = "rho";
+      var_names(1) = "u";
+      var_names(2) = "v";
+      if (n_dims == 3)
+        var_names(3) = "w";
+      var_names(n_vars-1) = "p";
+
+      n_cov = (run_input.stats_moments == 2) ? n_dims*(n_dims+1)/2 : 0;
+      cov_a.setup(max(n_cov,1));
+      cov_b.setup(max(n_cov,1));
+      k = 0;
+      for (int a=0; a<n_dims && n_cov; a++)
+        for (int b=a; b<n_dims; b++) {
+            cov_a(k) = 1+a;
+            cov_b(k) = 1+b;
+            k++;
+          }
+    }
+  else {
+      n_fields = 1;
+      n_vars = 1;
+      var_names.setup(1);
+      var_names(0) = "u";
+
+      n_cov = (run_input.stats_moments == 2) ? 1 : 0;
+      cov_a.setup(1);
+      cov_b.setup(1);
+      cov_a(0) = 0;
+      cov_b(0) = 0;
+    }
+
+  vars.setup(n_vars);
+  n_samples = 0;
+
+  // Master node creates the directory of the statistics files
+  if (FlowSol->rank == 0 && stat("stats_files", &st) == -1)
+    mkdir("stats_files", 0755);
+
+#ifdef _MPI
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+  if (run_input.n_stats_homogeneous == 0) {
+      mean.setup(FlowSol->n_ele_types);
+      m2.setup(FlowSol->n_ele_types);
+
+      for (int i=0; i<FlowSol->n_ele_types; i++) {
+          int n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+          int n_upts = FlowSol->mesh_eles(i)->get_n_upts_per_ele();
+
+          if (n_eles == 0)
+            continue;
+
+          mean(i).setup(n_vars,n_upts,n_eles);
+          mean(i).initialize_to_zero();
+          if (n_cov) {
+              m2(i).setup(n_cov,n_upts,n_eles);
+              m2(i).initialize_to_zero();
+            }
+        }
+
+      if (run_input.restart_flag)
+        read_points(FlowSol->ini_iter, FlowSol);
+    }
+  else {
+      setup_bins(FlowSol);
+
+      if (run_input.restart_flag)
+        read_bins(FlowSol->ini_iter, FlowSol);
+    }
+}
+
+// primitive variables of one solution point
+
+void statistics::calc_vars(double* in_disu, int in_stride, double* out_vars)
+{
+  if (run_input.equation == 0) {
+      double rho = in_disu[0];
+      double ke = 0.;
+
+      out_vars[0] = rho;
+      for (int m=0; m<n_dims; m++) {
+          out_vars[1+m] = in_disu[(1+m)*in_stride]/rho;
+          ke += out_vars[1+m]*out_vars[1+m];
+        }
+      out_vars[n_dims+1] = (run_input.gamma-1.)*(in_disu[(n_dims+1)*in_stride]-0.5*rho*ke);
+    }
+  else {
+      out_vars[0] = in_disu[0];
+    }
+}
+
+// update the moments with the current solution (Welford's algorithm; for bins, the moments of the sample combined with Chan's formula)
+
+void statistics::sample(struct solution* FlowSol)
+{
+  n_samples++;
+
+  if (run_input.n_stats_homogeneous == 0) {
+      double r = (n_samples-1.)/n_samples;
+
+      for (int i=0; i<FlowSol->n_ele_types; i++) {
+          int n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+          int n_upts = FlowSol->mesh_eles(i)->get_n_upts_per_ele();
+          double* disu = FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu();
+
+          for (int e=0; e<n_eles; e++)
+            for (int j=0; j<n_upts; j++) {
+                double* mu = mean(i).get_ptr_cpu(0,j,e);
+
+                calc_vars(disu+j+n_upts*e,n_upts*n_eles,vars.get_ptr_cpu());
+
+                // Deviations from the previous mean; those from the new mean are (n-1)/n times smaller
+                if (n_cov) {
+                    double* s = m2(i).get_ptr_cpu(0,j,e);
+                    for (int c=0; c<n_cov; c++)
+                      s[c] += r*(vars(cov_a(c))-mu[cov_a(c)])*(vars(cov_b(c))-mu[cov_b(c)]);
+                  }
+                for (int v=0; v<n_vars; v++)
+                  mu[v] += (vars(v)-mu[v])/n_samples;
+              }
+        }
+    }
+  else {
+      batch_mean.initialize_to_zero();
+      batch_m2.initialize_to_zero();
+
+      // Mean of the sample over the points of each bin, then the sums of products of the deviations from it
+      for (int pass=0; pass<2; pass++) {
+          for (int i=0; i<FlowSol->n_ele_types; i++) {
+              int n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+              int n_upts = FlowSol->mesh_eles(i)->get_n_upts_per_ele();
+              double* disu = FlowSol->mesh_eles(i)->get_disu_upts_ptr_cpu();
+
+              for (int e=0; e<n_eles; e++)
+                for (int j=0; j<n_upts; j++) {
+                    int b = bin_of_upt(i)(j,e);
+
+                    calc_vars(disu+j+n_upts*e,n_upts*n_eles,vars.get_ptr_cpu());
+
+                    if (pass == 0) {
+                        for (int v=0; v<n_vars; v++)
+                          batch_mean(v,b) += vars(v);
+                      }
+                    else {
+                        for (int c=0; c<n_cov; c++)
+                          batch_m2(c,b) += (vars(cov_a(c))-batch_mean(cov_a(c),b))*(vars(cov_b(c))-batch_mean(cov_b(c),b));
+                      }
+                  }
+            }
+
+          if (pass == 0)
+            for (int b=0; b<n_bins; b++)
+              for (int v=0; v<n_vars; v++)
+                batch_mean(v,b) /= bin_n_pts(b);
+        }
+
+      // Combine with the previous samples, (n_samples-1)*n_pts values of each bin
+      for (int b=0; b<n_bins; b++) {
+          double n_b = bin_n_pts(b);
+          double n_a = (n_samples-1.)*n_b;
+          double f = n_a*n_b/(n_a+n_b);
+
+          for (int c=0; c<n_cov; c++)
+            bin_m2(c,b) += batch_m2(c,b)+f*(batch_mean(cov_a(c),b)-bin_mean(cov_a(c),b))*(batch_mean(cov_b(c),b)-bin_mean(cov_b(c),b));
+          for (int v=0; v<n_vars; v++)
+            bin_mean(v,b) += (batch_mean(v,b)-bin_mean(v,b))*n_b/(n_a+n_b);
+        }
+    }
+}
+
+// write the statistics of step in_file_num
+
+void statistics::write(int in_file_num, struct solution* FlowSol)
+{
+  if (run_input.n_stats_homogeneous == 0)
+    write_points(in_file_num, FlowSol);
+  else
+    write_bins(in_file_num, FlowSol);
+}
+
+// one file per rank: text header, then per element type a line (name, elements, points) and per element its
+// global id (int) and the positions, means and covariances (double) of its solution points
+
+void statistics::write_points(int in_file_num, struct solution* FlowSol)
+{
+  char file_name_s[100];
+  array<double> pos(n_dims);
+  array<double> buf(n_dims+n_vars+n_cov);
+
+  sprintf(file_name_s,"stats_files/Stats_%.09d_p%.04d.dat",in_file_num,FlowSol->rank);
+
+  ofstream file(file_name_s, ios::binary | ios::trunc);
+  if (!file)
+    FatalError("Unable to open statistics file");
+
+  file << "HiFiLES statistics" << endl;
+  file << "n_samples " << n_samples << endl;
+  file << "variables";
+  for (int v=0; v<n_vars; v++)
+    file << " " << var_names(v);
+  file << endl << "covariances";
+  for (int c=0; c<n_cov; c++)
+    file << " " << var_names(cov_a(c)) << var_names(cov_b(c));
+  file << endl;
+
+  for (int i=0; i<FlowSol->n_ele_types; i++) {
+      int n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+      int n_upts = FlowSol->mesh_eles(i)->get_n_upts_per_ele();
+
+      if (n_eles == 0)
+        continue;
+
+      file << stats_ele_names[FlowSol->mesh_eles(i)->get_ele_type()] << " " << n_eles << " " << n_upts << endl;
+
+      for (int e=0; e<n_eles; e++) {
+          int id = FlowSol->mesh_eles(i)->get_ele2global_ele(e);
+          file.write((char*) &id, sizeof(int));
+
+          for (int j=0; j<n_upts; j++) {
+              FlowSol->mesh_eles(i)->calc_pos_upt(j,e,pos);
+              for (int m=0; m<n_dims; m++)
+                buf(m) = pos(m);
+              for (int v=0; v<n_vars; v++)
+                buf(n_dims+v) = mean(i)(v,j,e);
+              for (int c=0; c<n_cov; c++)
+                buf(n_dims+n_vars+c) = (n_samples > 0) ? m2(i)(c,j,e)/n_samples : 0.;
+              file.write((char*) buf.get_ptr_cpu(), (n_dims+n_vars+n_cov)*sizeof(double));
+            }
+        }
+    }
+
+  file.close();
+}
+
+// read the per-rank statistics of a restart (same partition), the elements matched by their global id
+
+void statistics::read_points(int in_file_num, struct solution* FlowSol)
+{
+  char file_name_s[100];
+  int found, n_read, n_eles_read, n_upts_read;
+  string str;
+  array<double> buf(n_dims+n_vars+n_cov);
+
+  sprintf(file_name_s,"stats_files/Stats_%.09d_p%.04d.dat",in_file_num,FlowSol->rank);
+
+  ifstream file(file_name_s, ios::binary);
+
+  // Start afresh unless every rank has its file
+  found = file ? 1 : 0;
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE,&found,1,MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+#endif
+  if (!found) {
+      if (FlowSol->rank == 0)
+        cout << "No statistics of step " << in_file_num << ", starting new statistics" << endl;
+      return;
+    }
+
+  getline(file,str);
+  if (str != "HiFiLES statistics")
+    FatalError("Unrecognized statistics file");
+  file >> str >> n_samples;
+
+  file >> str;
+  n_read = 0;
+  while (file.peek() != '\n') {
+      file >> str;
+      n_read++;
+    }
+  if (n_read != n_vars)
+    FatalError("Statistics of the restart are of another equation");
+
+  file >> str;
+  n_read = 0;
+  while (file.peek() != '\n') {
+      file >> str;
+      n_read++;
+    }
+  if (n_read != n_cov)
+    FatalError("stats_moments differs from the statistics of the restart");
+
+  while (file >> str >> n_eles_read >> n_upts_read) {
+      int i;
+      file.get();
+
+      for (i=0; i<FlowSol->n_ele_types; i++)
+        if (FlowSol->mesh_eles(i)->get_n_eles() != 0 && str == stats_ele_names[FlowSol->mesh_eles(i)->get_ele_type()])
+          break;
+      if (i == FlowSol->n_ele_types)
+        FatalError("Element type of the restart statistics not in this partition");
+
+      int n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+      if (n_upts_read != FlowSol->mesh_eles(i)->get_n_upts_per_ele())
+        FatalError("Statistics of the restart are of another order");
+
+      array<int> ele2global(n_eles);
+      for (int e=0; e<n_eles; e++)
+        ele2global(e) = FlowSol->mesh_eles(i)->get_ele2global_ele(e);
+
+      for (int k=0; k<n_eles_read; k++) {
+          int id;
+          file.read((char*) &id, sizeof(int));
+
+          int e = index_locate_int(id,ele2global.get_ptr_cpu(),n_eles);
+          if (e == -1)
+            FatalError("Statistics of the restart are of another partition");
+
+          for (int j=0; j<n_upts_read; j++) {
+              file.read((char*) buf.get_ptr_cpu(), (n_dims+n_vars+n_cov)*sizeof(double));
+              for (int v=0; v<n_vars; v++)
+                mean(i)(v,j,e) = buf(n_dims+v);
+              for (int c=0; c<n_cov; c++)
+                m2(i)(c,j,e) = buf(n_dims+n_vars+c)*n_samples;
+            }
+        }
+
+      if (!file)
+        FatalError("Statistics file of the restart is truncated");
+    }
+
+  file.close();
+}
+
+// group the solution points of this rank into bins of equal non-homogeneous coordinates
+
+void statistics::setup_bins(struct solution* FlowSol)
+{
+  int n_pts, p;
+  double extent;
+  array<double> pos(n_dims), pos_min(n_dims), pos_max(n_dims);
+
+  // Resolution of the positions, from the extent of the mesh
+  n_pts = 0;
+  for (int m=0; m<n_dims; m++) {
+      pos_min(m) = 1.e30;
+      pos_max(m) = -1.e30;
+    }
+  for (int i=0; i<FlowSol->n_ele_types; i++)
+    for (int e=0; e<FlowSol->mesh_eles(i)->get_n_eles(); e++)
+      for (int j=0; j<FlowSol->mesh_eles(i)->get_n_upts_per_ele(); j++) {
+          FlowSol->mesh_eles(i)->calc_pos_upt(j,e,pos);
+          for (int m=0; m<n_dims; m++) {
+              pos_min(m) = min(pos_min(m),pos(m));
+              pos_max(m) = max(pos_max(m),pos(m));
+            }
+          n_pts++;
+        }
+
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE,pos_min.get_ptr_cpu(),n_dims,MPI_DOUBLE,MPI_MIN,MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE,pos_max.get_ptr_cpu(),n_dims,MPI_DOUBLE,MPI_MAX,MPI_COMM_WORLD);
+#endif
+
+  extent = 0.;
+  for (int m=0; m<n_dims; m++)
+    extent = max(extent,pos_max(m)-pos_min(m));
+  bin_tol = STATS_BIN_TOL*extent;
+
+  // Positions of the points, homogeneous coordinates set to 0
+  array<double> all_pos(n_dims,max(n_pts,1));
+  array<int> order(max(n_pts,1)), bin_of_pt(max(n_pts,1));
+
+  bin_of_upt.setup(FlowSol->n_ele_types);
+  p = 0;
+  for (int i=0; i<FlowSol->n_ele_types; i++) {
+      int n_eles = FlowSol->mesh_eles(i)->get_n_eles();
+      int n_upts = FlowSol->mesh_eles(i)->get_n_upts_per_ele();
+
+      if (n_eles != 0)
+        bin_of_upt(i).setup(n_upts,n_eles);
+
+      for (int e=0; e<n_eles; e++)
+        for (int j=0; j<n_upts; j++) {
+            FlowSol->mesh_eles(i)->calc_pos_upt(j,e,pos);
+            for (int m=0; m<n_dims; m++)
+              all_pos(m,p) = pos(m);
+            for (int h=0; h<run_input.n_stats_homogeneous; h++)
+              all_pos(run_input.stats_homogeneous(h),p) = 0.;
+            order(p) = p;
+            p++;
+          }
+    }
+
+  // Sort the points by position, a new bin at every change
+  stats_pos_less less;
+  less.pos = all_pos.get_ptr_cpu();
+  less.stride = n_dims;
+  less.n_dims = n_dims;
+  less.tol = bin_tol;
+  sort(order.get_ptr_cpu(),order.get_ptr_cpu()+n_pts,less);
+
+  n_bins = 0;
+  for (int q=0; q<n_pts; q++) {
+      if (q == 0 || less(order(q-1),order(q)))
+        n_bins++;
+      bin_of_pt(order(q)) = n_bins-1;
+    }
+
+  bin_pos.setup(n_dims,max(n_bins,1));
+  bin_n_pts.setup(max(n_bins,1));
+  bin_n_pts.initialize_to_zero();
+  for (p=0; p<n_pts; p++) {
+      int b = bin_of_pt(p);
+      if (bin_n_pts(b)++ == 0)
+        for (int m=0; m<n_dims; m++)
+          bin_pos(m,b) = all_pos(m,p);
+    }
+
+  p = 0;
+  for (int i=0; i<FlowSol->n_ele_types; i++)
+    for (int e=0; e<FlowSol->mesh_eles(i)->get_n_eles(); e++)
+      for (int j=0; j<FlowSol->mesh_eles(i)->get_n_upts_per_ele(); j++)
+        bin_of_upt(i)(j,e) = bin_of_pt(p++);
+
+  bin_mean.setup(n_vars,max(n_bins,1));
+  bin_m2.setup(max(n_cov,1),max(n_bins,1));
+  batch_mean.setup(n_vars,max(n_bins,1));
+  batch_m2.setup(max(n_cov,1),max(n_bins,1));
+  bin_mean.initialize_to_zero();
+  bin_m2.initialize_to_zero();
+}
+
+// combine record in_b (position, count, means, sums of products of deviations) into inout_a
+
+void statistics::merge_records(double* inout_a, double* in_b)
+{
+  double n_a = inout_a[n_dims];
+  double n_b = in_b[n_dims];
+  double* mean_a = inout_a+n_dims+1;
+  double* mean_b = in_b+n_dims+1;
+
+  if (n_b == 0.)
+    return;
+
+  for (int c=0; c<n_cov; c++)
+    mean_a[n_vars+c] += mean_b[n_vars+c]+n_a*n_b/(n_a+n_b)*(mean_b[cov_a(c)]-mean_a[cov_a(c)])*(mean_b[cov_b(c)]-mean_a[cov_b(c)]);
+  for (int v=0; v<n_vars; v++)
+    mean_a[v] += (mean_b[v]-mean_a[v])*n_b/(n_a+n_b);
+  inout_a[n_dims] = n_a+n_b;
+}
+
+// merge the bins of all ranks and of the restart on the master node, and write them to one file: text header,
+// then per bin its position (homogeneous coordinates 0), number of values, means and covariances (double)
+
+void statistics::write_bins(int in_file_num, struct solution* FlowSol)
+{
+  int rec_len = n_dims+1+n_vars+n_cov;
+  int n_local = (n_samples > 0) ? n_bins : 0;
+  int n_all, n_out;
+  char file_name_s[100];
+
+  // Records of this rank
+  array<double> local(rec_len,max(n_local,1));
+  for (int b=0; b<n_local; b++) {
+      for (int m=0; m<n_dims; m++)
+        local(m,b) = bin_pos(m,b);
+      local(n_dims,b) = (double) n_samples*bin_n_pts(b);
+      for (int v=0; v<n_vars; v++)
+        local(n_dims+1+v,b) = bin_mean(v,b);
+      for (int c=0; c<n_cov; c++)
+        local(n_dims+1+n_vars+c,b) = bin_m2(c,b);
+    }
+
+  // Gather them on the master node, after the bins of the restart
+#ifdef _MPI
+  array<int> counts(FlowSol->nproc), displs(FlowSol->nproc);
+  int n_send = n_local*rec_len;
+
+  MPI_Gather(&n_send,1,MPI_INT,counts.get_ptr_cpu(),1,MPI_INT,0,MPI_COMM_WORLD);
+
+  n_all = n_prev_bins;
+  if (FlowSol->rank == 0)
+    for (int r=0; r<FlowSol->nproc; r++) {
+        displs(r) = n_all*rec_len;
+        n_all += counts(r)/rec_len;
+      }
+
+  array<double> records(rec_len,max(n_all,1));
+  MPI_Gatherv(local.get_ptr_cpu(),n_send,MPI_DOUBLE,records.get_ptr_cpu(),counts.get_ptr_cpu(),displs.get_ptr_cpu(),MPI_DOUBLE,0,MPI_COMM_WORLD);
+
+  if (FlowSol->rank != 0)
+    return;
+#else
+  n_all = n_prev_bins+n_local;
+  array<double> records(rec_len,max(n_all,1));
+  for (int b=0; b<n_local; b++)
+    for (int k=0; k<rec_len; k++)
+      records(k,n_prev_bins+b) = local(k,b);
+#endif
+
+  for (int b=0; b<n_prev_bins; b++)
+    for (int k=0; k<rec_len; k++)
+      records(k,b) = prev_records(k,b);
+
+  // Sort by position and merge the records of equal positions
+  array<int> order(max(n_all,1));
+  for (int b=0; b<n_all; b++)
+    order(b) = b;
+
+  stats_pos_less less;
+  less.pos = records.get_ptr_cpu();
+  less.stride = rec_len;
+  less.n_dims = n_dims;
+  less.tol = bin_tol;
+  sort(order.get_ptr_cpu(),order.get_ptr_cpu()+n_all,less);
+
+  array<double> merged(rec_len,max(n_all,1));
+  n_out = 0;
+  for (int q=0; q<n_all; q++) {
+      if (q == 0 || less(order(q-1),order(q))) {
+          for (int k=0; k<rec_len; k++)
+            merged(k,n_out) = records(k,order(q));
+          n_out++;
+        }
+      else {
+          merge_records(merged.get_ptr_cpu(0,n_out-1),records.get_ptr_cpu(0,order(q)));
+        }
+    }
+
+  // Covariances from the sums of products of deviations
+  for (int b=0; b<n_out; b++)
+    for (int c=0; c<n_cov; c++)
+      merged(n_dims+1+n_vars+c,b) /= merged(n_dims,b);
+
+  sprintf(file_name_s,"stats_files/Stats_%.09d.dat",in_file_num);
+
+  ofstream file(file_name_s, ios::binary | ios::trunc);
+  if (!file)
+    FatalError("Unable to open statistics file");
+
+  file << "HiFiLES statistics" << endl;
+  file << "n_samples " << n_prev_samples+n_samples << endl;
+  file << "variables";
+  for (int v=0; v<n_vars; v++)
+    file << " " << var_names(v);
+  file << endl << "covariances";
+  for (int c=0; c<n_cov; c++)
+    file << " " << var_names(cov_a(c)) << var_names(cov_b(c));
+  file << endl << "homogeneous";
+  for (int h=0; h<run_input.n_stats_homogeneous; h++)
+    file << " " << run_input.stats_homogeneous(h);
+  file << endl << "BINS " << n_out << " " << n_dims << endl;
+  file.write((char*) merged.get_ptr_cpu(), (long) n_out*rec_len*sizeof(double));
+  file.close();
+}
+
+// read the merged bins of a restart on the master node
+
+void statistics::read_bins(int in_file_num, struct solution* FlowSol)
+{
+  int rec_len = n_dims+1+n_vars+n_cov;
+  int n_read, n_dims_read;
+  char file_name_s[100];
+  string str;
+
+  if (FlowSol->rank != 0)
+    return;
+
+  sprintf(file_name_s,"stats_files/Stats_%.09d.dat",in_file_num);
+
+  ifstream file(file_name_s, ios::binary);
+  if (!file) {
+      cout << "No statistics of step " << in_file_num << ", starting new statistics" << endl;
+      return;
+    }
+
+  getline(file,str);
+  if (str != "HiFiLES statistics")
+    FatalError("Unrecognized statistics file");
+  file >> str >> n_prev_samples;
+
+  file >> str;
+  n_read = 0;
+  while (file.peek() != '\n') {
+      file >> str;
+      n_read++;
+    }
+  if (n_read != n_vars)
+    FatalError("Statistics of the restart are of another equation");
+
+  file >> str;
+  n_read = 0;
+  while (file.peek() != '\n') {
+      file >> str;
+      n_read++;
+    }
+  if (n_read != n_cov)
+    FatalError("stats_moments differs from the statistics of the restart");
+
+  file >> str;
+  n_read = 0;
+  while (file.peek() != '\n') {
+      int h;
+      file >> h;
+      if (n_read >= run_input.n_stats_homogeneous || h != run_input.stats_homogeneous(n_read))
+        FatalError("stats_homogeneous differs from the statistics of the restart");
+      n_read++;
+    }
+  if (n_read != run_input.n_stats_homogeneous)
+    FatalError("stats_homogeneous differs from the statistics of the restart");
+
+  file >> str >> n_prev_bins >> n_dims_read;
+  file.get();
+  if (n_dims_read != n_dims)
+    FatalError("Statistics of the restart are of another dimension");
+
+  prev_records.setup(rec_len,max(n_prev_bins,1));
+  file.read((char*) prev_records.get_ptr_cpu(), (long) n_prev_bins*rec_len*sizeof(double));
+  if (!file)
+    FatalError("Statistics file of the restart is truncated");
+  file.close();
+
+  // Back to sums of products of deviations
+  for (int b=0; b<n_prev_bins; b++)
+    for (int c=0; c<n_cov; c++)
+      prev_records(n_dims+1+n_vars+c,b) *= prev_records(n_dims,b);
+}
@@ -27,6 +27,10 @@ class testcase:
     self.test_iter = 1
     self.test_vals = []  
 
+    # Optional config file of a run that writes the restart file read by cfg_file. It is
+    # run first in the same directory, and only the output of cfg_file is checked
+    self.restart_cfg_file = ""
+
     # These can be optionally varied 
     self.HiFiLES_dir     = "/home/fpalacios"
     self.HiFiLES_exec    = "default" 
@@ -50,24 +54,33 @@ class testcase:
     command_base = "%s %s %s > outputfile"%(self.mpi_cmd, self.HiFiLES_exec, self.cfg_file)
     command      = "%s"%(command_base)
 
-    # Run HiFiLES
+    # Run HiFiLES, after the run writing the restart file if there is one
+    commands = [command]
+    if self.restart_cfg_file:
+      restart_cfg = os.path.join(os.environ['HIFILES_HOME'], self.cfg_dir, self.restart_cfg_file)
+      commands.insert(0, "%s %s %s > outputfile_restart"%(self.mpi_cmd, self.HiFiLES_exec, restart_cfg))
+
     os.chdir(os.path.join('./',self.cfg_dir)) 
     start   = datetime.datetime.now()
     print("\nPath at terminal when executing this file")
-    print(command)
-    process = subprocess.Popen(command, shell=True)  # This line launches HiFiLES
-
-    while process.poll() is None:
-      time.sleep(0.1)
-      now = datetime.datetime.now()
-      if (now - start).seconds> self.timeout:
-        try:
-          process.kill()
-          os.system('killall %s' % self.HiFiLES_exec)   # In case of parallel execution
-        except AttributeError: # popen.kill apparently fails on some versions of subprocess... the killall command should take care of things!
-          pass
-        timed_out = True
-        passed    = False
+    for command in commands:
+      print(command)
+      process = subprocess.Popen(command, shell=True)  # This line launches HiFiLES
+
+      while process.poll() is None:
+        time.sleep(0.1)
+        now = datetime.datetime.now()
+        if (now - start).seconds> self.timeout:
+          try:
+            process.kill()
+            os.system('killall %s' % self.HiFiLES_exec)   # In case of parallel execution
+          except AttributeError: # popen.kill apparently fails on some versions of subprocess... the killall command should take care of things!
+            pass
+          timed_out = True
+          passed    = False
+
+      if timed_out:
+        break
 
     # Examine the output
     f = open('outputfile','r')
@@ -192,6 +205,32 @@ if __name__=="__main__":
     
   os.chdir(os.environ['HIFILES_HOME'])
 
+  ##########################
+  ###  Performance mode  ###
+  ##########################
+
+  # With --perf (or --perf-update to store a new baseline for this machine) the
+  # phase timers are checked instead of the solution values
+  if '--perf' in sys.argv or '--perf-update' in sys.argv:
+    sys.path.append(os.path.join(os.environ['HIFILES_HOME'], 'testcases'))
+    from perf_regression import perfcase, run_perf_tests
+
+    perf_cases = []
+    for tag, cfg_dir, cfg_file, n_steps in [('cylinder', 'testcases/navier-stokes/cylinder', 'input_cylinder_visc', 200),
+                                            ('flatplate', 'testcases/navier-stokes/flatplate', 'input_flatplate_a', 200),
+                                            ('tgv', 'testcases/navier-stokes/Taylor_Green_vortex', 'input_TGV_SD_hex', 50)]:
+      case          = perfcase(tag)
+      case.cfg_dir  = cfg_dir
+      case.cfg_file = cfg_file
+      case.n_steps  = n_steps
+      case.mpi_cmd  = "mpiexec -np 2"
+      perf_cases.append(case)
+
+    if run_perf_tests(perf_cases, 'parallel'):
+      sys.exit(0)
+    else:
+      sys.exit(1)
+
   ##########################
   ###  Compressible N-S  ###
   ##########################
@@ -220,8 +259,24 @@ if __name__=="__main__":
   sqcyl.tol          = 0.00001
   passed2            = sqcyl.run_test()
 
+  ##########################
+  ###  Restart files     ###
+  ##########################
 
-  if (passed1 and passed2):
+  # Cylinder, 10 steps continued from a shared restart file (mpiio_output 1) written at step 10
+  shared              = testcase('shared_restart')
+  shared.cfg_dir      = "testcases/navier-stokes/cylinder/"
+  shared.cfg_file     = "input_cylinder_visc_shared_continue"
+  shared.restart_cfg_file = "input_cylinder_visc_shared_write"
+  shared.test_iter    = 20
+  shared.test_vals    = [0.184525,1.181264,0.253261,10.526736,16.975348,-0.099556]
+  shared.mpi_cmd      = "mpiexec -np 2"
+  shared.HiFiLES_exec = "HiFiLES"
+  shared.timeout      = 1600
+  shared.tol          = 0.00001
+  passed3             = shared.run_test()
+
+  if (passed1 and passed2 and passed3):
     sys.exit(0)
   else:
     sys.exit(1)
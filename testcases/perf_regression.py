@@ -0,0 +1,218 @@
+#!/usr/bin/env python
+
+# \file perf_regression.py
+# \brief Performance regression testing of HiFiLES examples against a stored per-machine baseline
+# \author - Original code: Aniket C. Aranake, Alejandro Campos, Thomas D. Economon.
+#         - Current development: Aerospace Computing Laboratory (ACL) directed
+#                                by Prof. Jameson. (Aero/Astro Dept. Stanford University).
+# \version 1.0.0
+#
+# HiFiLES (High Fidelity Large Eddy Simulation).
+# Copyright (C) 2013 Aerospace Computing Laboratory.
+#
+# Used by serial_regression.py and parallel_regression.py when called with --perf.
+# Each case is run for a fixed number of steps, and the phase timers printed by the
+# solver at exit ("timer <phase> <seconds>") are compared with the baseline stored in
+# testcases/perf_baselines/<hostname>_<serial/parallel>.dat. Run with --perf-update to
+# (re)write the baseline for this machine.
+
+import sys, time, os, subprocess, datetime, socket, tempfile
+
+class perfcase:
+
+  def __init__(self,tag_in):
+
+    self.tag = tag_in    # Input, string tag that identifies this case in the baseline file
+
+    # Configuration file path/filename
+    self.cfg_dir  = "/home/fpalacios"
+    self.cfg_file = "default.cfg"
+
+    # Number of time steps to run (overrides n_steps in the config file)
+    self.n_steps = 100
+
+    # These can be optionally varied
+    self.HiFiLES_exec = "HiFiLES"
+    self.mpi_cmd      = ""
+    self.timeout      = 1600
+    self.n_repeat     = 3      # the fastest of n_repeat runs is kept, to filter out machine noise
+    self.tol          = 0.10   # relative slowdown that is flagged as a failure
+    self.min_time     = 0.5    # timers below this many seconds in the baseline are reported but not checked
+
+  def run(self):
+
+    # Write a temporary copy of the config file with the number of steps fixed
+    cfg_path = os.path.join(os.environ['HIFILES_HOME'], self.cfg_dir)
+    cfg_file = self.do_adjust_steps(cfg_path)
+
+    # The solver output, which holds the timers, also goes to the temporary directory
+    fd, out_file = tempfile.mkstemp(prefix="%s."%self.tag, suffix=".perfout")
+    os.close(fd)
+
+    exec_path = os.path.join("$HIFILES_RUN", self.HiFiLES_exec)
+    command   = ("%s %s %s > %s"%(self.mpi_cmd, exec_path, cfg_file, out_file)).strip()
+
+    cwd = os.getcwd()
+    os.chdir(cfg_path)
+
+    try:
+      timers = {}
+      for n in range(self.n_repeat):
+        print(command)
+        start   = datetime.datetime.now()
+        process = subprocess.Popen(command, shell=True)
+        while process.poll() is None:
+          time.sleep(0.1)
+          if (datetime.datetime.now() - start).seconds > self.timeout:
+            try:
+              process.kill()
+              os.system('killall %s' % self.HiFiLES_exec)
+            except AttributeError:
+              pass
+            print('ERROR: Execution timed out. timeout=%d'%self.timeout)
+            return None
+
+        run_timers = self.read_timers(out_file)
+        if not run_timers:
+          print('ERROR: No timing summary found in the output of %s'%self.tag)
+          return None
+
+        for name in run_timers:
+          if name not in timers or run_timers[name] < timers[name]:
+            timers[name] = run_timers[name]
+
+      return timers
+    finally:
+      os.chdir(cwd)
+      os.remove(cfg_file)
+      os.remove(out_file)
+
+  def read_timers(self,filename):
+
+    timers = {}
+    f = open(filename,'r')
+    for line in f.readlines():
+      raw_data = line.split()
+      if len(raw_data) == 3 and raw_data[0] == 'timer':
+        try:
+          timers[raw_data[1]] = float(raw_data[2])
+        except ValueError:
+          continue
+    f.close()
+    return timers
+
+  def do_adjust_steps(self,cfg_path):
+
+    # HiFiLES config files hold the parameter name on one line and its value on the next
+    file_in = open(os.path.join(cfg_path, self.cfg_file), 'r')
+    lines   = file_in.readlines()
+    file_in.close()
+
+    # The copy goes to the temporary directory, not next to the testcase inputs; the
+    # mesh and other files named in it are still found relative to the run directory
+    fd, cfg_file = tempfile.mkstemp(prefix="%s."%self.cfg_file, suffix=".perftest")
+    file_out = os.fdopen(fd,'w')
+    i = 0
+    while i < len(lines):
+      file_out.write(lines[i])
+      if lines[i].split() and lines[i].split()[0] == "n_steps" and i+1 < len(lines):
+        file_out.write("%d\n"%self.n_steps)
+        i += 1
+      i += 1
+    file_out.close()
+    return cfg_file
+
+def baseline_file(mode):
+  host = socket.gethostname().split('.')[0]
+  return os.path.join(os.environ['HIFILES_HOME'], 'testcases', 'perf_baselines', '%s_%s.dat'%(host, mode))
+
+def read_baseline(filename):
+
+  baseline = {}
+  if not os.path.exists(filename):
+    return baseline
+  f = open(filename,'r')
+  for line in f.readlines():
+    raw_data = line.split()
+    if len(raw_data) != 4 or raw_data[0].startswith('#'):
+      continue
+    baseline[(raw_data[0], raw_data[1])] = (int(raw_data[2]), float(raw_data[3]))
+  f.close()
+  return baseline
+
+def write_baseline(filename, baseline):
+
+  if not os.path.exists(os.path.dirname(filename)):
+    os.makedirs(os.path.dirname(filename))
+  f = open(filename,'w')
+  f.write('# HiFiLES performance baseline, written %s\n'%time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime()))
+  f.write('# case timer n_steps seconds\n')
+  for key in sorted(baseline.keys()):
+    f.write('%s %s %d %f\n'%(key[0], key[1], baseline[key][0], baseline[key][1]))
+  f.close()
+
+def run_perf_tests(cases, mode):
+  '''Run each case, compare its timers with the stored baseline and return True if nothing slowed down.
+     With --perf-update on the command line the measured timers replace the baseline instead.'''
+
+  update   = '--perf-update' in sys.argv
+  filename = baseline_file(mode)
+  baseline = read_baseline(filename)
+  passed   = True
+
+  if not baseline and not update:
+    print('No performance baseline found at %s, rerun with --perf-update to create it'%filename)
+    return False
+
+  for case in cases:
+    timers = case.run()
+
+    print('=========================================================\n')
+
+    if timers is None:
+      print('%s: FAILED'%case.tag)
+      passed = False
+      continue
+
+    case_passed = True
+    for name in sorted(timers.keys()):
+      key = (case.tag, name)
+      if update:
+        baseline[key] = (case.n_steps, timers[name])
+        print('%-10s %-10s %12.6f s (stored)'%(case.tag, name, timers[name]))
+        continue
+
+      if key not in baseline:
+        print('%-10s %-10s %12.6f s (no baseline)'%(case.tag, name, timers[name]))
+        continue
+
+      n_steps, t_ref = baseline[key]
+      if n_steps != case.n_steps:
+        print('%-10s %-10s baseline was recorded with n_steps=%d, not %d'%(case.tag, name, n_steps, case.n_steps))
+        case_passed = False
+        continue
+
+      status = ''
+      if t_ref >= case.min_time and timers[name] > (1.0+case.tol)*t_ref:
+        status = '<-- SLOWER than baseline by more than %d%%'%int(100*case.tol)
+        case_passed = False
+      change = 0.0
+      if t_ref > 0.0:
+        change = 100.0*(timers[name]-t_ref)/t_ref
+      print('%-10s %-10s %12.6f s  baseline %12.6f s  %+7.1f%% %s'%(case.tag, name, timers[name], t_ref, change, status))
+
+    if not update:
+      if case_passed:
+        print('%s: PASSED'%case.tag)
+      else:
+        print('%s: FAILED'%case.tag)
+    passed = passed and case_passed
+
+  if update:
+    if passed:
+      write_baseline(filename, baseline)
+      print('Performance baseline written to %s'%filename)
+    else:
+      print('Some cases failed to run, the performance baseline was not updated')
+
+  return passed
@@ -27,6 +27,10 @@ class testcase:
     self.test_iter = 1
     self.test_vals = []  
 
+    # Optional config file of a run that writes the restart file read by cfg_file. It is
+    # run first in the same directory, and only the output of cfg_file is checked
+    self.restart_cfg_file = ""
+
     # These can be optionally varied 
     self.HiFiLES_dir     = "/home/fpalacios"
     self.HiFiLES_exec    = "default" 
@@ -50,24 +54,33 @@ class testcase:
     command_base = "%s %s > outputfile"%(self.HiFiLES_exec, self.cfg_file)
     command      = "%s"%(command_base)
 
-    # Run HiFiLES
+    # Run HiFiLES, after the run writing the restart file if there is one
+    commands = [command]
+    if self.restart_cfg_file:
+      restart_cfg = os.path.join(os.environ['HIFILES_HOME'], self.cfg_dir, self.restart_cfg_file)
+      commands.insert(0, "%s %s > outputfile_restart"%(self.HiFiLES_exec, restart_cfg))
+
     os.chdir(os.path.join('./',self.cfg_dir)) 
     start   = datetime.datetime.now()
     print("\nPath at terminal when executing this file")
-    print(command)
-    process = subprocess.Popen(command, shell=True)  # This line launches HiFiLES
-
-    while process.poll() is None:
-      time.sleep(0.1)
-      now = datetime.datetime.now()
-      if (now - start).seconds> self.timeout:
-        try:
-          process.kill()
-          os.system('killall %s' % self.HiFiLES_exec)   # In case of parallel execution
-        except AttributeError: # popen.kill apparently fails on some versions of subprocess... the killall command should take care of things!
-          pass
-        timed_out = True
-        passed    = False
+    for command in commands:
+      print(command)
+      process = subprocess.Popen(command, shell=True)  # This line launches HiFiLES
+
+      while process.poll() is None:
+        time.sleep(0.1)
+        now = datetime.datetime.now()
+        if (now - start).seconds> self.timeout:
+          try:
+            process.kill()
+            os.system('killall %s' % self.HiFiLES_exec)   # In case of parallel execution
+          except AttributeError: # popen.kill apparently fails on some versions of subprocess... the killall command should take care of things!
+            pass
+          timed_out = True
+          passed    = False
+
+      if timed_out:
+        break
 
     # Examine the output
     f = open('outputfile','r')
@@ -188,6 +201,31 @@ if __name__=="__main__":
 
   os.chdir(os.environ['HIFILES_HOME'])
 
+  ##########################
+  ###  Performance mode  ###
+  ##########################
+
+  # With --perf (or --perf-update to store a new baseline for this machine) the
+  # phase timers are checked instead of the solution values
+  if '--perf' in sys.argv or '--perf-update' in sys.argv:
+    sys.path.append(os.path.join(os.environ['HIFILES_HOME'], 'testcases'))
+    from perf_regression import perfcase, run_perf_tests
+
+    perf_cases = []
+    for tag, cfg_dir, cfg_file, n_steps in [('cylinder', 'testcases/navier-stokes/cylinder', 'input_cylinder_visc', 200),
+                                            ('flatplate', 'testcases/navier-stokes/flatplate', 'input_flatplate_a', 200),
+                                            ('tgv', 'testcases/navier-stokes/Taylor_Green_vortex', 'input_TGV_SD_hex', 50)]:
+      case          = perfcase(tag)
+      case.cfg_dir  = cfg_dir
+      case.cfg_file = cfg_file
+      case.n_steps  = n_steps
+      perf_cases.append(case)
+
+    if run_perf_tests(perf_cases, 'serial'):
+      sys.exit(0)
+    else:
+      sys.exit(1)
+
   ##########################
   ###  Compressible N-S  ###
   ##########################
@@ -214,7 +252,65 @@ if __name__=="__main__":
   tgv.tol          = 0.00001
   passed2          = tgv.run_test()
 
-  if (passed1 and passed2):
+  ##########################
+  ###  Implicit solvers  ###
+  ##########################
+
+  # Cylinder, Jacobian-free Newton-Krylov (adv_type 4) with local pseudo time steps
+  jfnk              = testcase('jfnk')
+  jfnk.cfg_dir      = "testcases/euler/cylinder"
+  jfnk.cfg_file     = "input_cylinder_inv_jfnk"
+  jfnk.test_iter    = 40
+  jfnk.test_vals    = [0.00013945,0.00083579,0.00085518,0.00837693,-0.49119023,0.51219455]
+  jfnk.HiFiLES_exec = "HiFiLES"
+  jfnk.timeout      = 1600
+  jfnk.tol          = 0.00001
+  passed3           = jfnk.run_test()
+
+  ##########################
+  ###  Time stepping     ###
+  ##########################
+
+  # Cylinder, multi-rate local time stepping (dt_type 3) with four rate levels
+  lts              = testcase('lts')
+  lts.cfg_dir      = "testcases/euler/cylinder"
+  lts.cfg_file     = "input_cylinder_inv_lts"
+  lts.test_iter    = 200
+  lts.test_vals    = [0.00275349,0.00988446,0.00924035,0.18136050,-0.09026145,0.10487016]
+  lts.HiFiLES_exec = "HiFiLES"
+  lts.timeout      = 1600
+  lts.tol          = 0.00001
+  passed4          = lts.run_test()
+
+  ##########################
+  ###  Restart files     ###
+  ##########################
+
+  # Cylinder, 10 steps continued from a lossless compressed restart file (restart_compression 1) written at step 10
+  compressed              = testcase('compressed_restart')
+  compressed.cfg_dir      = "testcases/navier-stokes/cylinder"
+  compressed.cfg_file     = "input_cylinder_visc_compressed_continue"
+  compressed.restart_cfg_file = "input_cylinder_visc_compressed_write"
+  compressed.test_iter    = 20
+  compressed.test_vals    = [0.18452499,1.18126409,0.25326125,10.52673598,16.97534806,-0.09955596]
+  compressed.HiFiLES_exec = "HiFiLES"
+  compressed.timeout      = 1600
+  compressed.tol          = 0.00001
+  passed5                 = compressed.run_test()
+
+  # Same, from a lossy compressed restart file (restart_compression 2)
+  lossy              = testcase('lossy_restart')
+  lossy.cfg_dir      = "testcases/navier-stokes/cylinder"
+  lossy.cfg_file     = "input_cylinder_visc_lossy_continue"
+  lossy.restart_cfg_file = "input_cylinder_visc_lossy_write"
+  lossy.test_iter    = 20
+  lossy.test_vals    = [0.18452528,1.18126472,0.25326112,10.52673673,16.97534539,-0.09955706]
+  lossy.HiFiLES_exec = "HiFiLES"
+  lossy.timeout      = 1600
+  lossy.tol          = 0.00001
+  passed6            = lossy.run_test()
+
+  if (passed1 and passed2 and passed3 and passed4 and passed5 and passed6):
     sys.exit(0)
   else:
     sys.exit(1)